@@ -3,6 +3,8 @@ option(VEIL_ENABLE_WARNINGS_AS_ERRORS "Treat warnings as errors" ON)
 option(VEIL_ENABLE_SANITIZERS "Enable Address/Undefined sanitizers" ON)
 option(VEIL_ENABLE_CLANG_TIDY "Run clang-tidy during build if available" ON)
 option(VEIL_USE_SYSTEM_SODIUM "Prefer system-provided libsodium" OFF)
+option(VEIL_ENABLE_ALLOCATION_TRACKING
+       "Replace global operator new to count allocations per subsystem (benchmark builds)" OFF)
 
 set(CMAKE_POSITION_INDEPENDENT_CODE ON)
 
@@ -23,6 +25,11 @@ if(VEIL_ENABLE_SANITIZERS)
   endif()
 endif()
 
+if(VEIL_ENABLE_ALLOCATION_TRACKING AND VEIL_ENABLE_SANITIZERS)
+  message(WARNING "Allocation tracking replaces the sanitizer allocator's operator new; "
+                  "disable VEIL_ENABLE_SANITIZERS for meaningful benchmark numbers")
+endif()
+
 if(VEIL_ENABLE_CLANG_TIDY)
   find_program(CLANG_TIDY_EXE NAMES clang-tidy)
   if(CLANG_TIDY_EXE)
@@ -157,14 +157,43 @@ bool load_config_file(const std::string& path, ClientConfig& config, std::error_
         config.tunnel.tun.netmask = value;
       } else if (key == "mtu") {
         config.tunnel.tun.mtu = std::stoi(value);
+      } else if (key == "ecn") {
+        config.tunnel.ecn = (value == "true" || value == "1" || value == "yes");
+      } else if (key == "ordered_delivery") {
+        config.tunnel.transport.ordered_delivery =
+            (value == "true" || value == "1" || value == "yes");
+      } else if (key == "reorder_timeout_ms") {
+        config.tunnel.transport.reorder_timeout = std::chrono::milliseconds(std::stoi(value));
+      } else if (key == "streams_per_band") {
+        config.tunnel.streams.streams_per_band = static_cast<std::uint32_t>(std::stoul(value));
+      } else if (key == "flow_control") {
+        config.tunnel.transport.flow_control.enabled =
+            (value == "true" || value == "1" || value == "yes");
+      } else if (key == "fec") {
+        config.tunnel.transport.fec.enabled = (value == "true" || value == "1" || value == "yes");
+      } else if (key == "fec_block_size") {
+        config.tunnel.transport.fec.block_size = std::stoul(value);
+      } else if (key == "fec_block_timeout_ms") {
+        config.tunnel.transport.fec.block_timeout = std::chrono::milliseconds(std::stoi(value));
       }
     } else if (section == "crypto") {
       if (key == "preshared_key_file") {
         config.tunnel.key_file = value;
+      } else if (key == "worker_threads") {
+        config.tunnel.crypto_workers = static_cast<std::size_t>(std::stoul(value));
       }
     } else if (section == "obfuscation") {
       if (key == "profile_seed_file") {
         config.tunnel.obfuscation_seed_file = value;
+      } else if (key == "timing_jitter_ms") {
+        config.tunnel.timing_jitter = std::chrono::milliseconds(std::stoi(value));
+      } else if (key == "dpi_mode") {
+        config.tunnel.dpi_mode = obfuscation::dpi_mode_from_string(value);
+        if (!config.tunnel.dpi_mode) {
+          ec = std::make_error_code(std::errc::invalid_argument);
+          LOG_ERROR("Unknown dpi_mode: {}", value);
+          return false;
+        }
       }
     } else if (section == "routing") {
       if (key == "default_route") {
@@ -184,6 +213,23 @@ bool load_config_file(const std::string& path, ClientConfig& config, std::error_
             config.routes.push_back(route);
           }
         }
+      } else if (key == "routed_subnets") {
+        std::istringstream iss(value);
+        std::string item;
+        while (std::getline(iss, item, ',')) {
+          const auto first = item.find_first_not_of(' ');
+          if (first == std::string::npos) {
+            continue;
+          }
+          item = item.substr(first, item.find_last_not_of(' ') - first + 1);
+          const auto prefix = tun::parse_ip_prefix(item);
+          if (!prefix) {
+            ec = std::make_error_code(std::errc::invalid_argument);
+            LOG_ERROR("Invalid routed subnet: {}", item);
+            return false;
+          }
+          config.tunnel.routed_subnets.push_back(*prefix);
+        }
       }
     } else if (section == "connection") {
       if (key == "reconnect_interval_ms") {
@@ -191,6 +237,18 @@ bool load_config_file(const std::string& path, ClientConfig& config, std::error_
       } else if (key == "auto_reconnect") {
         config.tunnel.auto_reconnect = (value == "true" || value == "1" || value == "yes");
       }
+    } else if (section == "qos") {
+      if (key == "uplink_rate_bytes_per_sec") {
+        config.tunnel.uplink_rate_bytes_per_sec = std::stoull(value);
+      } else if (key == "txtime") {
+        config.tunnel.uplink_txtime = (value == "true" || value == "1" || value == "yes");
+      } else if (key == "queue_target_ms") {
+        config.tunnel.uplink_queue.target = std::chrono::milliseconds(std::stoi(value));
+      } else if (key == "queue_limit_bytes") {
+        config.tunnel.uplink_queue.limit_bytes = static_cast<std::size_t>(std::stoull(value));
+      } else if (key == "ecn") {
+        config.tunnel.uplink_queue.ecn = (value == "true" || value == "1" || value == "yes");
+      }
     } else if (section == "daemon") {
       if (key == "pid_file") {
         config.pid_file = value;
@@ -229,6 +287,27 @@ bool validate_config(const ClientConfig& config, std::string& error) {
     return false;
   }
 
+  if (config.tunnel.streams.streams_per_band == 0 || config.tunnel.streams.streams_per_band > 65536) {
+    error = "streams_per_band must be between 1 and 65536";
+    return false;
+  }
+
+  if (config.tunnel.transport.fec.block_size == 0 ||
+      config.tunnel.transport.fec.block_size > mux::kFecMaxSpan) {
+    error = "fec_block_size must be between 1 and 64";
+    return false;
+  }
+
+  if (config.tunnel.uplink_queue.target.count() <= 0) {
+    error = "queue_target_ms must be positive";
+    return false;
+  }
+
+  if (config.tunnel.timing_jitter.count() < 0 || config.tunnel.timing_jitter.count() > 1000) {
+    error = "timing_jitter_ms must be between 0 and 1000";
+    return false;
+  }
+
   return true;
 }
 
@@ -11,6 +11,7 @@
 
 #include "common/crypto/random.h"
 #include "common/crypto/secure_buffer.h"
+#include "common/utils/allocation_tracker.h"
 
 namespace {
 void ensure_sodium_ready() {
@@ -346,36 +347,69 @@ std::vector<std::uint8_t> aead_encrypt(std::span<const std::uint8_t, kAeadKeyLen
                                        std::span<const std::uint8_t, kNonceLen> nonce,
                                        std::span<const std::uint8_t> aad,
                                        std::span<const std::uint8_t> plaintext) {
+  VEIL_ALLOCATION_SCOPE(kCrypto);
+  std::vector<std::uint8_t> ciphertext(plaintext.size() + kAeadTagLen);
+  ciphertext.resize(aead_encrypt_into(key, nonce, aad, plaintext, ciphertext));
+  return ciphertext;
+}
+
+std::size_t aead_encrypt_into(std::span<const std::uint8_t, kAeadKeyLen> key,
+                              std::span<const std::uint8_t, kNonceLen> nonce,
+                              std::span<const std::uint8_t> aad,
+                              std::span<const std::uint8_t> plaintext,
+                              std::span<std::uint8_t> out) {
   ensure_sodium_ready();
-  std::vector<std::uint8_t> ciphertext(plaintext.size() + crypto_aead_chacha20poly1305_ietf_ABYTES);
+  static_assert(kAeadTagLen == crypto_aead_chacha20poly1305_ietf_ABYTES);
+  if (out.size() < plaintext.size() + kAeadTagLen) {
+    throw std::length_error("ciphertext buffer too small");
+  }
   unsigned long long out_len = 0;
   const auto rc = crypto_aead_chacha20poly1305_ietf_encrypt(
-      ciphertext.data(), &out_len, plaintext.data(), plaintext.size(), aad.data(), aad.size(),
-      nullptr, nonce.data(), key.data());
+      out.data(), &out_len, plaintext.data(), plaintext.size(), aad.data(), aad.size(), nullptr,
+      nonce.data(), key.data());
   if (rc != 0) {
     throw std::runtime_error("encryption failed");
   }
-  ciphertext.resize(out_len);
-  return ciphertext;
+  return static_cast<std::size_t>(out_len);
 }
 
 std::optional<std::vector<std::uint8_t>> aead_decrypt(
     std::span<const std::uint8_t, kAeadKeyLen> key, std::span<const std::uint8_t, kNonceLen> nonce,
     std::span<const std::uint8_t> aad, std::span<const std::uint8_t> ciphertext) {
+  VEIL_ALLOCATION_SCOPE(kCrypto);
   ensure_sodium_ready();
   if (ciphertext.size() < crypto_aead_chacha20poly1305_ietf_ABYTES) {
     return std::nullopt;
   }
   std::vector<std::uint8_t> plaintext(ciphertext.size() - crypto_aead_chacha20poly1305_ietf_ABYTES);
+  const auto length = aead_decrypt_into(key, nonce, aad, ciphertext, plaintext);
+  if (!length) {
+    return std::nullopt;
+  }
+  plaintext.resize(*length);
+  return plaintext;
+}
+
+std::optional<std::size_t> aead_decrypt_into(std::span<const std::uint8_t, kAeadKeyLen> key,
+                                             std::span<const std::uint8_t, kNonceLen> nonce,
+                                             std::span<const std::uint8_t> aad,
+                                             std::span<const std::uint8_t> ciphertext,
+                                             std::span<std::uint8_t> out) {
+  ensure_sodium_ready();
+  if (ciphertext.size() < kAeadTagLen) {
+    return std::nullopt;
+  }
+  if (out.size() < ciphertext.size() - kAeadTagLen) {
+    throw std::length_error("plaintext buffer too small");
+  }
   unsigned long long out_len = 0;
   const auto rc = crypto_aead_chacha20poly1305_ietf_decrypt(
-      plaintext.data(), &out_len, nullptr, ciphertext.data(), ciphertext.size(), aad.data(),
-      aad.size(), nonce.data(), key.data());
+      out.data(), &out_len, nullptr, ciphertext.data(), ciphertext.size(), aad.data(), aad.size(),
+      nonce.data(), key.data());
   if (rc != 0) {
     return std::nullopt;
   }
-  plaintext.resize(out_len);
-  return plaintext;
+  return static_cast<std::size_t>(out_len);
 }
 
 }  // namespace veil::crypto
@@ -15,6 +15,7 @@ inline constexpr std::size_t kSharedSecretSize = 32;
 inline constexpr std::size_t kHmacSha256Len = 32;
 inline constexpr std::size_t kAeadKeyLen = 32;
 inline constexpr std::size_t kNonceLen = 12;
+inline constexpr std::size_t kAeadTagLen = 16;
 
 struct KeyPair {
   std::array<std::uint8_t, kX25519PublicKeySize> public_key{};
@@ -68,8 +69,24 @@ std::vector<std::uint8_t> aead_encrypt(std::span<const std::uint8_t, kAeadKeyLen
                                        std::span<const std::uint8_t, kNonceLen> nonce,
                                        std::span<const std::uint8_t> aad,
                                        std::span<const std::uint8_t> plaintext);
+// Encrypt into `out`, which must hold plaintext.size() + kAeadTagLen
+// bytes, so a caller can seal straight into its packet buffer; `out` may
+// start at plaintext.data() to seal in place. Returns the bytes written.
+std::size_t aead_encrypt_into(std::span<const std::uint8_t, kAeadKeyLen> key,
+                              std::span<const std::uint8_t, kNonceLen> nonce,
+                              std::span<const std::uint8_t> aad,
+                              std::span<const std::uint8_t> plaintext,
+                              std::span<std::uint8_t> out);
 std::optional<std::vector<std::uint8_t>> aead_decrypt(
     std::span<const std::uint8_t, kAeadKeyLen> key, std::span<const std::uint8_t, kNonceLen> nonce,
     std::span<const std::uint8_t> aad, std::span<const std::uint8_t> ciphertext);
+// Decrypt into `out`, which must hold ciphertext.size() - kAeadTagLen
+// bytes and may start at ciphertext.data() to open in place. Returns the
+// plaintext length, or nothing if authentication fails.
+std::optional<std::size_t> aead_decrypt_into(std::span<const std::uint8_t, kAeadKeyLen> key,
+                                             std::span<const std::uint8_t, kNonceLen> nonce,
+                                             std::span<const std::uint8_t> aad,
+                                             std::span<const std::uint8_t> ciphertext,
+                                             std::span<std::uint8_t> out);
 
 }  // namespace veil::crypto
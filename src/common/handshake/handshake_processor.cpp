@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "common/crypto/random.h"
+#include "common/utils/allocation_tracker.h"
 namespace {
 // Internal magic bytes used inside encrypted payload (not visible to DPI)
 constexpr std::array<std::uint8_t, 2> kMagic{'H', 'S'};
@@ -187,6 +188,7 @@ HandshakeInitiator::~HandshakeInitiator() {
 }
 
 std::vector<std::uint8_t> HandshakeInitiator::create_init() {
+  VEIL_ALLOCATION_SCOPE(kHandshake);
   ephemeral_ = crypto::generate_x25519_keypair();
   init_timestamp_ms_ = to_millis(now_fn_());
   init_sent_ = true;
@@ -229,6 +231,7 @@ std::vector<std::uint8_t> HandshakeInitiator::create_init() {
 
 std::optional<HandshakeSession> HandshakeInitiator::consume_response(
     std::span<const std::uint8_t> response) {
+  VEIL_ALLOCATION_SCOPE(kHandshake);
   if (!init_sent_) {
     return std::nullopt;
   }
@@ -331,13 +334,25 @@ HandshakeResponder::HandshakeResponder(std::vector<std::uint8_t> psk,
                                        std::chrono::milliseconds skew_tolerance,
                                        utils::TokenBucket rate_limiter,
                                        std::function<Clock::time_point()> now_fn)
+    : HandshakeResponder(std::move(psk), skew_tolerance, std::move(rate_limiter),
+                         std::make_shared<HandshakeReplayCache>(), std::move(now_fn)) {}
+
+HandshakeResponder::HandshakeResponder(std::vector<std::uint8_t> psk,
+                                       std::chrono::milliseconds skew_tolerance,
+                                       utils::TokenBucket rate_limiter,
+                                       std::shared_ptr<HandshakeReplayCache> replay_cache,
+                                       std::function<Clock::time_point()> now_fn)
     : psk_(std::move(psk)),
       skew_tolerance_(skew_tolerance),
       rate_limiter_(std::move(rate_limiter)),
+      replay_cache_(std::move(replay_cache)),
       now_fn_(std::move(now_fn)) {
   if (psk_.empty()) {
     throw std::invalid_argument("psk required");
   }
+  if (!replay_cache_) {
+    throw std::invalid_argument("replay cache required");
+  }
 }
 
 HandshakeResponder::~HandshakeResponder() {
@@ -349,6 +364,7 @@ HandshakeResponder::~HandshakeResponder() {
 
 std::optional<HandshakeResponder::Result> HandshakeResponder::handle_init(
     std::span<const std::uint8_t> init_bytes) {
+  VEIL_ALLOCATION_SCOPE(kHandshake);
   // Rate limit before attempting decryption (prevents DoS via decrypt operations)
   if (!rate_limiter_.allow()) {
     return std::nullopt;
@@ -397,7 +413,7 @@ std::optional<HandshakeResponder::Result> HandshakeResponder::handle_init(
 
   // Check replay cache BEFORE validating HMAC (anti-probing requirement)
   // If this (timestamp, ephemeral_key) pair was seen before, silently drop
-  if (replay_cache_.mark_and_check(init_ts, init_pub)) {
+  if (replay_cache_->mark_and_check(init_ts, init_pub)) {
     sodium_memzero(handshake_key.data(), handshake_key.size());
     return std::nullopt;  // Replay detected - silently ignore
   }
@@ -4,6 +4,7 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <span>
 #include <vector>
@@ -65,6 +66,14 @@ class HandshakeResponder {
                      utils::TokenBucket rate_limiter,
                      std::function<Clock::time_point()> now_fn = Clock::now);
 
+  // Use a replay cache shared with other responders. A responder is not
+  // thread-safe, but one responder per worker thread over a shared cache
+  // catches a replayed INIT whichever thread receives it.
+  HandshakeResponder(std::vector<std::uint8_t> psk, std::chrono::milliseconds skew_tolerance,
+                     utils::TokenBucket rate_limiter,
+                     std::shared_ptr<HandshakeReplayCache> replay_cache,
+                     std::function<Clock::time_point()> now_fn = Clock::now);
+
   /// SECURITY: Destructor clears all sensitive key material
   ~HandshakeResponder();
 
@@ -72,17 +81,19 @@ class HandshakeResponder {
   HandshakeResponder(const HandshakeResponder&) = delete;
   HandshakeResponder& operator=(const HandshakeResponder&) = delete;
 
-  // Disable move (contains non-movable replay cache with mutex)
+  // Disable move (key material is wiped in place by the destructor)
   HandshakeResponder(HandshakeResponder&&) = delete;
   HandshakeResponder& operator=(HandshakeResponder&&) = delete;
 
   std::optional<Result> handle_init(std::span<const std::uint8_t> init_bytes);
 
+  const HandshakeReplayCache& replay_cache() const { return *replay_cache_; }
+
  private:
   std::vector<std::uint8_t> psk_;
   std::chrono::milliseconds skew_tolerance_;
   utils::TokenBucket rate_limiter_;
-  HandshakeReplayCache replay_cache_;
+  std::shared_ptr<HandshakeReplayCache> replay_cache_;
   std::function<Clock::time_point()> now_fn_;
 };
 
@@ -16,7 +16,17 @@ HandshakeReplayCache::HandshakeReplayCache(std::size_t capacity,
 bool HandshakeReplayCache::mark_and_check(
     std::uint64_t timestamp_ms,
     const std::array<std::uint8_t, crypto::kX25519PublicKeySize>& ephemeral_key) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  lookups_.fetch_add(1, std::memory_order_relaxed);
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    const auto wait_start = std::chrono::steady_clock::now();
+    lock.lock();
+    contended_.fetch_add(1, std::memory_order_relaxed);
+    wait_ns_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - wait_start)
+                           .count(),
+                       std::memory_order_relaxed);
+  }
 
   // Cleanup expired entries periodically (every ~100 insertions on average)
   // This is a simple heuristic to avoid cleanup overhead on every call
@@ -88,6 +98,20 @@ void HandshakeReplayCache::clear() {
   cache_map_.clear();
 }
 
+HandshakeReplayCache::Stats HandshakeReplayCache::stats() const {
+  return Stats{
+      .lookups = lookups_.load(std::memory_order_relaxed),
+      .contended = contended_.load(std::memory_order_relaxed),
+      .wait_time = std::chrono::nanoseconds(wait_ns_.load(std::memory_order_relaxed)),
+  };
+}
+
+void HandshakeReplayCache::reset_stats() {
+  lookups_.store(0, std::memory_order_relaxed);
+  contended_.store(0, std::memory_order_relaxed);
+  wait_ns_.store(0, std::memory_order_relaxed);
+}
+
 void HandshakeReplayCache::evict_lru() {
   // Assumes mutex is already held by caller
   if (lru_list_.empty()) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <list>
@@ -40,6 +41,17 @@ namespace veil::handshake {
  */
 class HandshakeReplayCache {
  public:
+  /**
+   * Lock contention counters for mark_and_check().
+   */
+  struct Stats {
+    std::uint64_t lookups{0};
+    // Lookups that found the mutex held by another thread.
+    std::uint64_t contended{0};
+    // Total time contended lookups spent waiting for the mutex.
+    std::chrono::nanoseconds wait_time{0};
+  };
+
   /**
    * Entry identifier combining timestamp and ephemeral public key.
    * This uniquely identifies each handshake INIT message.
@@ -118,6 +130,17 @@ class HandshakeReplayCache {
    */
   void clear();
 
+  /**
+   * Get lock contention counters. Uncontended lookups cost one try_lock;
+   * only contended ones read the clock.
+   */
+  [[nodiscard]] Stats stats() const;
+
+  /**
+   * Reset lock contention counters.
+   */
+  void reset_stats();
+
  private:
   using LruList = std::list<CacheKey>;
   using LruIterator = LruList::iterator;
@@ -134,6 +157,10 @@ class HandshakeReplayCache {
   CacheMap cache_map_;         // Maps CacheKey -> position in LRU list
 
   mutable std::mutex mutex_;   // Protects all internal state
+
+  std::atomic<std::uint64_t> lookups_{0};
+  std::atomic<std::uint64_t> contended_{0};
+  std::atomic<std::int64_t> wait_ns_{0};
 };
 
 }  // namespace veil::handshake
@@ -0,0 +1,234 @@
+#include "common/metrics/perf_baseline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <nlohmann/json.hpp>
+#include <numbers>
+#include <utility>
+
+using json = nlohmann::json;
+
+namespace veil::metrics {
+
+namespace {
+
+constexpr int kBaselineVersion = 1;
+
+// Inverse of the standard normal CDF (Acklam's rational approximation,
+// relative error below 1.2e-9).
+double normal_quantile(double p) {
+  constexpr double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                          1.383577518672690e+02,  -3.066479806614716e+01, 2.506628277459239e+00};
+  constexpr double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                          6.680131188771972e+01,  -1.328068155288572e+01};
+  constexpr double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                          -2.549732539343734e+00, 4.374664141464968e+00,  2.938163982698783e+00};
+  constexpr double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                          3.754408661907416e+00};
+  constexpr double kLow = 0.02425;
+
+  if (p < kLow) {
+    const double q = std::sqrt(-2.0 * std::log(p));
+    return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+           ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+  }
+  if (p > 1.0 - kLow) {
+    return -normal_quantile(1.0 - p);
+  }
+  const double q = p - 0.5;
+  const double r = q * q;
+  return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+         (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+const char* direction_name(Direction direction) {
+  return direction == Direction::kHigherIsBetter ? "higher" : "lower";
+}
+
+}  // namespace
+
+double student_t_critical(double confidence, double df) {
+  const double p = 0.5 + confidence / 2.0;
+  if (df < 2.0) {
+    // Exact for one degree of freedom (Cauchy) and conservative in between.
+    return std::tan(std::numbers::pi * (p - 0.5));
+  }
+  // Cornish-Fisher expansion around the normal quantile; within 1% of the
+  // exact value from two degrees of freedom up.
+  const double z = normal_quantile(p);
+  const double z2 = z * z;
+  const double g1 = (z2 + 1.0) * z / 4.0;
+  const double g2 = ((5.0 * z2 + 16.0) * z2 + 3.0) * z / 96.0;
+  const double g3 = (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) * z / 384.0;
+  const double g4 = ((((79.0 * z2 + 776.0) * z2 + 1482.0) * z2 - 1920.0) * z2 - 945.0) * z / 92160.0;
+  return z + g1 / df + g2 / (df * df) + g3 / (df * df * df) + g4 / (df * df * df * df);
+}
+
+SampleStats describe(std::span<const double> values, double confidence) {
+  SampleStats stats;
+  stats.count = values.size();
+  if (values.empty()) {
+    return stats;
+  }
+  double sum = 0.0;
+  for (const auto v : values) {
+    sum += v;
+  }
+  const auto n = static_cast<double>(values.size());
+  stats.mean = sum / n;
+  stats.ci_low = stats.mean;
+  stats.ci_high = stats.mean;
+  if (values.size() < 2) {
+    return stats;
+  }
+  double squares = 0.0;
+  for (const auto v : values) {
+    squares += (v - stats.mean) * (v - stats.mean);
+  }
+  stats.stddev = std::sqrt(squares / (n - 1.0));
+  const double half_width = student_t_critical(confidence, n - 1.0) * stats.stddev / std::sqrt(n);
+  stats.ci_low = stats.mean - half_width;
+  stats.ci_high = stats.mean + half_width;
+  return stats;
+}
+
+const char* verdict_name(Verdict verdict) {
+  switch (verdict) {
+    case Verdict::kUnchanged:
+      return "unchanged";
+    case Verdict::kImproved:
+      return "improved";
+    case Verdict::kRegressed:
+      return "regressed";
+    case Verdict::kNoBaseline:
+      return "no-baseline";
+  }
+  return "unknown";
+}
+
+MetricComparison compare_metric(const MetricSamples& baseline, const MetricSamples& current,
+                                const ComparisonConfig& config) {
+  MetricComparison result;
+  result.name = current.name;
+  result.unit = current.unit;
+  result.direction = current.direction;
+  result.baseline = describe(baseline.values, config.confidence);
+  result.current = describe(current.values, config.confidence);
+  if (baseline.values.empty() || current.values.empty()) {
+    result.verdict = Verdict::kNoBaseline;
+    return result;
+  }
+
+  const double base = result.baseline.mean;
+  const double diff = result.current.mean - base;
+  double diff_low = diff;
+  double diff_high = diff;
+  result.significance_tested = result.baseline.count >= 2 && result.current.count >= 2;
+  if (result.significance_tested) {
+    // Welch's t interval for the difference of means.
+    const double vb = result.baseline.stddev * result.baseline.stddev /
+                      static_cast<double>(result.baseline.count);
+    const double vc = result.current.stddev * result.current.stddev /
+                      static_cast<double>(result.current.count);
+    const double se = std::sqrt(vb + vc);
+    if (se > 0.0) {
+      const double df =
+          (vb + vc) * (vb + vc) /
+          (vb * vb / static_cast<double>(result.baseline.count - 1) +
+           vc * vc / static_cast<double>(result.current.count - 1));
+      const double half_width = student_t_critical(config.confidence, df) * se;
+      diff_low = diff - half_width;
+      diff_high = diff + half_width;
+    }
+  }
+
+  // A zero baseline has no meaningful relative change; treat any difference
+  // as a full-scale one.
+  const double scale = base != 0.0 ? std::abs(base) : 1.0;
+  result.change_percent = diff / scale * 100.0;
+  result.change_ci_low_percent = diff_low / scale * 100.0;
+  result.change_ci_high_percent = diff_high / scale * 100.0;
+
+  const double sign = current.direction == Direction::kHigherIsBetter ? 1.0 : -1.0;
+  // Signed so that positive means better.
+  const double gain = sign * diff / scale;
+  const bool significantly_worse = sign > 0 ? diff_high < 0.0 : diff_low > 0.0;
+  const bool significantly_better = sign > 0 ? diff_low > 0.0 : diff_high < 0.0;
+  if (gain < -config.tolerance && significantly_worse) {
+    result.verdict = Verdict::kRegressed;
+  } else if (gain > config.tolerance && significantly_better) {
+    result.verdict = Verdict::kImproved;
+  }
+  return result;
+}
+
+void PerfBaseline::set(MetricSamples samples) {
+  auto it = std::find_if(metrics_.begin(), metrics_.end(),
+                         [&](const MetricSamples& m) { return m.name == samples.name; });
+  if (it != metrics_.end()) {
+    *it = std::move(samples);
+  } else {
+    metrics_.push_back(std::move(samples));
+  }
+}
+
+const MetricSamples* PerfBaseline::find(const std::string& name) const {
+  auto it = std::find_if(metrics_.begin(), metrics_.end(),
+                         [&](const MetricSamples& m) { return m.name == name; });
+  return it != metrics_.end() ? &*it : nullptr;
+}
+
+std::vector<MetricComparison> PerfBaseline::compare(const PerfBaseline& current,
+                                                    const ComparisonConfig& config) const {
+  std::vector<MetricComparison> comparisons;
+  comparisons.reserve(current.metrics().size());
+  for (const auto& metric : current.metrics()) {
+    const auto* base = find(metric.name);
+    comparisons.push_back(compare_metric(base != nullptr ? *base : MetricSamples{}, metric, config));
+  }
+  return comparisons;
+}
+
+std::string serialize_baseline(const PerfBaseline& baseline) {
+  json metrics = json::object();
+  for (const auto& metric : baseline.metrics()) {
+    const auto stats = describe(metric.values);
+    metrics[metric.name] = json{
+        {"unit", metric.unit},
+        {"direction", direction_name(metric.direction)},
+        {"samples", metric.values},
+        {"mean", stats.mean},
+        {"stddev", stats.stddev},
+    };
+  }
+  return json{{"version", kBaselineVersion}, {"metrics", std::move(metrics)}}.dump(2);
+}
+
+std::optional<PerfBaseline> deserialize_baseline(const std::string& text) {
+  try {
+    const auto j = json::parse(text);
+    if (j.value("version", 0) != kBaselineVersion || !j.contains("metrics") ||
+        !j["metrics"].is_object()) {
+      return std::nullopt;
+    }
+    PerfBaseline baseline;
+    for (const auto& [name, value] : j["metrics"].items()) {
+      MetricSamples samples;
+      samples.name = name;
+      samples.unit = value.value("unit", "");
+      const auto direction = value.value("direction", "higher");
+      if (direction != "higher" && direction != "lower") {
+        return std::nullopt;
+      }
+      samples.direction =
+          direction == "higher" ? Direction::kHigherIsBetter : Direction::kLowerIsBetter;
+      samples.values = value.at("samples").get<std::vector<double>>();
+      baseline.set(std::move(samples));
+    }
+    return baseline;
+  } catch (const json::exception&) {
+    return std::nullopt;
+  }
+}
+
+}  // namespace veil::metrics
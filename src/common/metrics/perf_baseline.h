@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace veil::metrics {
+
+// Whether larger or smaller values of a metric are better.
+enum class Direction : std::uint8_t { kHigherIsBetter, kLowerIsBetter };
+
+// Repeated measurements of one performance metric.
+struct MetricSamples {
+  std::string name;
+  std::string unit;
+  Direction direction{Direction::kHigherIsBetter};
+  std::vector<double> values;
+};
+
+// Mean of a sample with a two-sided confidence interval (Student's t).
+struct SampleStats {
+  std::size_t count{0};
+  double mean{0.0};
+  double stddev{0.0};
+  double ci_low{0.0};
+  double ci_high{0.0};
+};
+
+SampleStats describe(std::span<const double> values, double confidence = 0.95);
+
+// Two-sided Student's t critical value for `confidence` and `df` degrees of
+// freedom (fractional df allowed, as produced by Welch's test).
+double student_t_critical(double confidence, double df);
+
+enum class Verdict : std::uint8_t {
+  kUnchanged,   // Within tolerance or not statistically significant.
+  kImproved,    // Significantly better by more than the tolerance.
+  kRegressed,   // Significantly worse by more than the tolerance.
+  kNoBaseline,  // Metric missing from the baseline.
+};
+
+const char* verdict_name(Verdict verdict);
+
+struct ComparisonConfig {
+  // Confidence level for the difference-of-means interval.
+  double confidence{0.95};
+  // Relative change below which a difference is ignored even when it is
+  // statistically significant.
+  double tolerance{0.05};
+};
+
+struct MetricComparison {
+  std::string name;
+  std::string unit;
+  Direction direction{Direction::kHigherIsBetter};
+  SampleStats baseline;
+  SampleStats current;
+  // (current - baseline) / baseline, in percent.
+  double change_percent{0.0};
+  // Confidence interval of (current - baseline), in percent of the baseline
+  // mean (Welch's unequal-variance t interval).
+  double change_ci_low_percent{0.0};
+  double change_ci_high_percent{0.0};
+  // False when either side has fewer than two samples; the verdict then
+  // rests on the tolerance alone.
+  bool significance_tested{false};
+  Verdict verdict{Verdict::kUnchanged};
+};
+
+// Compare the current samples of a metric against its baseline samples.
+//
+// A metric regresses (or improves) only when the confidence interval of the
+// difference excludes zero *and* the mean moved by more than the tolerance,
+// so run-to-run noise on a busy machine does not fail a review.
+MetricComparison compare_metric(const MetricSamples& baseline, const MetricSamples& current,
+                                const ComparisonConfig& config = {});
+
+// A stored set of metric samples, serialised as JSON:
+//
+//   {"version": 1,
+//    "metrics": {"throughput_mbps": {"unit": "Mbps", "direction": "higher",
+//                                     "samples": [812.4, 798.1, 805.0],
+//                                     "mean": 805.2, "stddev": 7.2}}}
+//
+// "mean" and "stddev" are informational; comparisons use "samples".
+class PerfBaseline {
+ public:
+  // Add or replace a metric.
+  void set(MetricSamples samples);
+
+  const MetricSamples* find(const std::string& name) const;
+
+  const std::vector<MetricSamples>& metrics() const { return metrics_; }
+
+  // Compare every metric of `current` against this baseline, in the order
+  // they appear in `current`.
+  std::vector<MetricComparison> compare(const PerfBaseline& current,
+                                        const ComparisonConfig& config = {}) const;
+
+ private:
+  std::vector<MetricSamples> metrics_;
+};
+
+std::string serialize_baseline(const PerfBaseline& baseline);
+
+// Returns nullopt for malformed JSON or an unsupported version.
+std::optional<PerfBaseline> deserialize_baseline(const std::string& json);
+
+}  // namespace veil::metrics
@@ -0,0 +1,100 @@
+#include "common/obfuscation/cover_traffic.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace veil::obfuscation {
+
+CoverTrafficScheduler::CoverTrafficScheduler(const ObfuscationProfile& profile,
+                                             std::size_t heartbeat_overhead,
+                                             std::function<TimePoint()> now_fn)
+    : profile_(profile),
+      heartbeat_overhead_(heartbeat_overhead),
+      now_fn_(std::move(now_fn)),
+      schedule_(profile_) {
+  const auto now = now_fn_();
+  next_slot_ = now;
+  schedule_heartbeat(now);
+}
+
+std::optional<CoverSlot> CoverTrafficScheduler::poll(std::size_t pending) {
+  const auto now = now_fn_();
+  CoverSlot slot;
+  if (pending > 0) {
+    if (now < next_slot_) {
+      return std::nullopt;
+    }
+    // Jitter shortens the gap, so no packet waits longer than the interval.
+    const auto interval = profile_.cover_slot_interval;
+    const auto jitter = std::min<Clock::duration>(schedule_.at(slot_sequence_).jitter, interval / 2);
+    // Keep the slot phase while data flows; after an idle spell start over.
+    const auto base = now - next_slot_ > interval ? now : next_slot_;
+    next_slot_ = base + interval - jitter;
+
+    slot.kind = CoverSlotKind::kData;
+    slot.size = slot_size(pending);
+    stats_.padding_bytes += slot.size - pending;
+    ++stats_.data_slots;
+    if (now >= next_heartbeat_) {
+      ++stats_.heartbeats_replaced;
+    }
+    // The data shows the connection is alive; no heartbeat needed yet.
+    schedule_heartbeat(now);
+    return slot;
+  }
+
+  if (now < next_heartbeat_) {
+    return std::nullopt;
+  }
+  slot.kind = CoverSlotKind::kHeartbeat;
+  slot.heartbeat_sequence = heartbeat_sequence_;
+  slot.heartbeat = generate_heartbeat_payload(profile_, heartbeat_sequence_);
+  const auto bytes = slot.heartbeat.size() + heartbeat_overhead_;
+  slot.size = slot_size(bytes);
+  stats_.padding_bytes += slot.size - bytes;
+  ++stats_.heartbeat_slots;
+  ++heartbeat_sequence_;
+  schedule_heartbeat(now);
+  return slot;
+}
+
+CoverTrafficScheduler::TimePoint CoverTrafficScheduler::next_wakeup(bool data_pending) const {
+  return data_pending ? next_slot_ : next_heartbeat_;
+}
+
+std::size_t CoverTrafficScheduler::slot_size(std::size_t bytes) {
+  const std::size_t target = schedule_.at(slot_sequence_++).padding_size;
+  if (bytes <= target) {
+    return target;
+  }
+  if (!profile_.enabled || !profile_.use_advanced_padding) {
+    return bytes;
+  }
+  // Too big for the drawn size: the smallest class that holds it.
+  const auto& dist = profile_.padding_distribution;
+  const std::array<std::pair<std::uint8_t, std::size_t>, 3> classes{{
+      {dist.small_weight, dist.small_max},
+      {dist.medium_weight, dist.medium_max},
+      {dist.large_weight, dist.large_max},
+  }};
+  std::size_t size = 0;
+  for (const auto& [weight, max] : classes) {
+    if (weight > 0 && max >= bytes && (size == 0 || max < size)) {
+      size = max;
+    }
+  }
+  return size == 0 ? bytes : size;
+}
+
+void CoverTrafficScheduler::refill_schedule() {
+  if (schedule_.needs_refill()) {
+    schedule_.refill();
+  }
+}
+
+void CoverTrafficScheduler::schedule_heartbeat(TimePoint now) {
+  next_heartbeat_ = now + compute_heartbeat_interval(profile_, heartbeat_sequence_);
+}
+
+}  // namespace veil::obfuscation
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "common/obfuscation/obfuscation_profile.h"
+#include "common/obfuscation/obfuscation_schedule.h"
+
+namespace veil::obfuscation {
+
+// What a cover slot carries.
+enum class CoverSlotKind : std::uint8_t {
+  kData = 0,       // The caller's next queued packet.
+  kHeartbeat = 1,  // `CoverSlot::heartbeat`; nothing was queued.
+};
+
+struct CoverSlot {
+  CoverSlotKind kind{CoverSlotKind::kData};
+  // Plaintext bytes the packet is padded up to. Never less than what it
+  // carries; data larger than every size class is sent unpadded.
+  std::size_t size{0};
+  // Heartbeat payload for kHeartbeat slots.
+  std::vector<std::uint8_t> heartbeat;
+  std::uint64_t heartbeat_sequence{0};
+};
+
+struct CoverTrafficStats {
+  std::uint64_t data_slots{0};
+  std::uint64_t heartbeat_slots{0};
+  // Data slots sent when a heartbeat was due, in its place.
+  std::uint64_t heartbeats_replaced{0};
+  std::uint64_t padding_bytes{0};
+};
+
+/**
+ * Shapes a stream of packets onto a profile's slot schedule and size
+ * classes (ObfuscationProfile::cover_traffic).
+ *
+ * While data is queued, slots come at most cover_slot_interval apart and
+ * each carries the next queued packet, padded to a size drawn from the
+ * padding distribution; a packet larger than the drawn size moves up to
+ * the smallest class that holds it. Data keeps the connection alive, so
+ * heartbeats are sent only on the heartbeat schedule while nothing is
+ * queued, and each data slot pushes the next one back. Padding is thus
+ * only the gap between real data and the shape, not a second stream on
+ * top of it.
+ *
+ * The scheduler holds no packets: the caller keeps its queue and reports
+ * the size of the packet at its head. Sizes are in plaintext bytes of the
+ * carrier's frames, so data and heartbeat slots of one size look alike.
+ *
+ * Thread Safety:
+ *   This class is NOT thread-safe. It is owned by the tunnel and used from
+ *   its event loop thread.
+ */
+class CoverTrafficScheduler {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+
+  // `profile` must outlive the scheduler. `heartbeat_overhead` is what the
+  // carrier adds around a heartbeat payload.
+  explicit CoverTrafficScheduler(const ObfuscationProfile& profile, std::size_t heartbeat_overhead = 0,
+                                 std::function<TimePoint()> now_fn = Clock::now);
+
+  // The slot due now, if any. `pending` is the size of the caller's next
+  // queued packet, 0 when nothing is queued.
+  std::optional<CoverSlot> poll(std::size_t pending);
+
+  // When poll() next returns a slot, given whether data is queued.
+  TimePoint next_wakeup(bool data_pending) const;
+
+  const CoverTrafficStats& stats() const { return stats_; }
+
+  // Precompute upcoming slot sizes and jitter; call off the send path.
+  void refill_schedule();
+
+ private:
+  // Size of the next slot for `bytes` of content.
+  std::size_t slot_size(std::size_t bytes);
+  void schedule_heartbeat(TimePoint now);
+
+  const ObfuscationProfile& profile_;
+  std::size_t heartbeat_overhead_;
+  std::function<TimePoint()> now_fn_;
+  // Sizes and jitter per slot sequence.
+  ObfuscationSchedule schedule_;
+  TimePoint next_slot_;
+  TimePoint next_heartbeat_;
+  std::uint64_t slot_sequence_{0};
+  std::uint64_t heartbeat_sequence_{0};
+  CoverTrafficStats stats_;
+};
+
+}  // namespace veil::obfuscation
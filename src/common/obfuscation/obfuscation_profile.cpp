@@ -968,6 +968,8 @@ ObfuscationProfile create_dpi_mode_profile(DPIBypassMode mode) {
       profile.exponential_max_gap = 60s;
       profile.exponential_long_gap_probability = 0.15f;
       profile.heartbeat_entropy_normalization = true;
+      profile.cover_traffic = true;
+      profile.cover_slot_interval = 20ms;
       return profile;
     }
 
@@ -1085,6 +1087,8 @@ ObfuscationProfile create_dpi_mode_profile(DPIBypassMode mode) {
       profile.exponential_max_gap = 600s;  // Up to 10 minutes
       profile.exponential_long_gap_probability = 0.3f;
       profile.heartbeat_entropy_normalization = false;     // Low entropy for IoT-like traffic
+      profile.cover_traffic = true;
+      profile.cover_slot_interval = 100ms;  // Data rides in slow, small slots
       return profile;
     }
 
@@ -166,6 +166,16 @@ struct ObfuscationProfile {
 
   // Client-to-server direction (for WebSocket masking).
   bool is_client_to_server{true};
+
+  // Cover traffic: packets leave in slots on the profile's schedule and
+  // size classes. A slot carries queued data when there is some, padded up
+  // to its size; a heartbeat goes out only when one is due and nothing is
+  // queued. See CoverTrafficScheduler.
+  bool cover_traffic{false};
+
+  // Longest gap between slots while data is queued, so also the longest a
+  // queued packet waits for one. Timing jitter shortens gaps by up to half.
+  std::chrono::milliseconds cover_slot_interval{20};
 };
 
 // Obfuscation metrics for DPI/ML analysis.
@@ -0,0 +1,53 @@
+#include "common/obfuscation/obfuscation_schedule.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace veil::obfuscation {
+
+ObfuscationSchedule::ObfuscationSchedule(const ObfuscationProfile& profile, std::size_t capacity)
+    : profile_(profile),
+      entries_(std::bit_ceil(std::max<std::size_t>(capacity, 2))),
+      mask_(entries_.size() - 1) {}
+
+ScheduleEntry ObfuscationSchedule::at(std::uint64_t sequence) {
+  cursor_ = std::max(cursor_, sequence + 1);
+  if (sequence >= begin_ && sequence < end_) {
+    ++stats_.hits;
+    return entries_[sequence & mask_];
+  }
+  ++stats_.misses;
+  return compute(profile_, sequence);
+}
+
+void ObfuscationSchedule::refill() {
+  // Lookups ran past the table: start over at the cursor.
+  if (end_ < cursor_) {
+    begin_ = cursor_;
+    end_ = cursor_;
+  }
+  const auto target = cursor_ + entries_.size();
+  while (end_ < target) {
+    entries_[end_ & mask_] = compute(profile_, end_);
+    ++end_;
+    ++stats_.entries_filled;
+  }
+  if (end_ - begin_ > entries_.size()) {
+    begin_ = end_ - entries_.size();
+  }
+}
+
+bool ObfuscationSchedule::needs_refill() const {
+  return end_ < cursor_ + entries_.size() / 2;
+}
+
+ScheduleEntry ObfuscationSchedule::compute(const ObfuscationProfile& profile, std::uint64_t sequence) {
+  ScheduleEntry entry;
+  entry.jitter = compute_timing_jitter_advanced(profile, sequence);
+  entry.padding_size = compute_advanced_padding_size(profile, sequence);
+  entry.padding_class = compute_padding_class(profile, sequence);
+  entry.prefix_size = compute_prefix_size(profile, sequence);
+  return entry;
+}
+
+}  // namespace veil::obfuscation
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "common/obfuscation/obfuscation_profile.h"
+
+namespace veil::obfuscation {
+
+// Per-packet obfuscation values for one sequence number.
+struct ScheduleEntry {
+  // compute_timing_jitter_advanced().
+  std::chrono::microseconds jitter{0};
+  // compute_advanced_padding_size() and compute_padding_class().
+  std::uint16_t padding_size{0};
+  PaddingSizeClass padding_class{PaddingSizeClass::kSmall};
+  // compute_prefix_size().
+  std::uint8_t prefix_size{0};
+};
+
+struct ScheduleStats {
+  // Lookups served from the table, and those computed on the spot.
+  std::uint64_t hits{0};
+  std::uint64_t misses{0};
+  // Entries computed by refill().
+  std::uint64_t entries_filled{0};
+};
+
+/**
+ * Table of upcoming obfuscation values, so the send path does a lookup
+ * instead of several HMACs and floating-point samples per packet.
+ *
+ * Entries are a pure function of the profile seed and the sequence, the
+ * same values the compute_* functions return, so both ends of a session
+ * derive identical tables. refill() computes them in batches ahead of
+ * the last sequence looked up; call it off the send path, e.g. once per
+ * event loop iteration. A lookup the table does not cover yet is computed
+ * directly, with the same result.
+ *
+ * The table is filled lazily: the profile may change until the first
+ * refill() or at(), and not after.
+ *
+ * Thread Safety:
+ *   This class is NOT thread-safe. Each instance belongs to the component
+ *   that owns the sequence it follows.
+ */
+class ObfuscationSchedule {
+ public:
+  static constexpr std::size_t kDefaultCapacity = 256;
+
+  // `profile` must outlive the schedule. Capacity rounds up to a power of two.
+  explicit ObfuscationSchedule(const ObfuscationProfile& profile,
+                               std::size_t capacity = kDefaultCapacity);
+
+  // Values for `sequence`.
+  ScheduleEntry at(std::uint64_t sequence);
+
+  // Compute entries up to `capacity` sequences past the last lookup.
+  void refill();
+
+  // Whether less than half the table lies ahead of the last lookup.
+  bool needs_refill() const;
+
+  const ScheduleStats& stats() const { return stats_; }
+
+  // The entry for `sequence`, computed directly.
+  static ScheduleEntry compute(const ObfuscationProfile& profile, std::uint64_t sequence);
+
+ private:
+  const ObfuscationProfile& profile_;
+  std::vector<ScheduleEntry> entries_;
+  std::uint64_t mask_;
+  // The table holds sequences [begin_, end_).
+  std::uint64_t begin_{0};
+  std::uint64_t end_{0};
+  // One past the highest sequence looked up.
+  std::uint64_t cursor_{0};
+  ScheduleStats stats_;
+};
+
+}  // namespace veil::obfuscation
@@ -86,6 +86,11 @@ void ReplayWindow::set_bit(std::size_t index) {
   bits_[word] |= (std::uint64_t(1) << bit);
 }
 
+utils::MemoryFootprint ReplayWindow::memory_footprint() const {
+  const auto bytes = bits_.capacity() * sizeof(std::uint64_t);
+  return {.reserved = bytes, .in_use = bytes, .limit = bytes};
+}
+
 void ReplayWindow::mask_tail() {
   const auto remainder = window_size_ % kBitsPerWord;
   if (remainder == 0) {
@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <vector>
 
+#include "common/utils/memory_footprint.h"
+
 namespace veil::session {
 
 class ReplayWindow {
@@ -11,6 +13,9 @@ class ReplayWindow {
   explicit ReplayWindow(std::size_t window_size = 1024);
   bool mark_and_check(std::uint64_t sequence);
 
+  // The bitmap is sized once at construction and never grows.
+  utils::MemoryFootprint memory_footprint() const;
+
  private:
   std::size_t window_size_;
   std::uint64_t highest_{0};
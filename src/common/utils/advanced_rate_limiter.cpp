@@ -4,6 +4,20 @@
 
 namespace veil::utils {
 
+namespace {
+
+// libstdc++ deques allocate 512-byte blocks plus a map of at least eight
+// block pointers.
+template <typename T>
+std::size_t deque_heap_bytes(const std::deque<T>& deque) {
+  constexpr std::size_t kBlockBytes = 512;
+  constexpr std::size_t kPerBlock = sizeof(T) < kBlockBytes ? kBlockBytes / sizeof(T) : 1;
+  const std::size_t blocks = deque.size() / kPerBlock + 1;
+  return blocks * kPerBlock * sizeof(T) + std::max<std::size_t>(8, blocks + 2) * sizeof(T*);
+}
+
+}  // namespace
+
 // BurstTokenBucket implementation.
 
 BurstTokenBucket::BurstTokenBucket(std::uint64_t rate_per_sec, double burst_factor,
@@ -205,6 +219,12 @@ std::optional<ClientRateLimitStats> AdvancedRateLimiter::get_client_stats(
   return it->second->stats();
 }
 
+MemoryFootprint ClientRateLimiter::memory_footprint() const {
+  return {.reserved = deque_heap_bytes(reconnect_history_),
+          .in_use = reconnect_history_.size() * sizeof(Clock::time_point),
+          .limit = 0};
+}
+
 AdvancedRateLimiter::GlobalStats AdvancedRateLimiter::get_global_stats() const {
   GlobalStats stats;
   stats.tracked_clients = clients_.size();
@@ -224,6 +244,22 @@ AdvancedRateLimiter::GlobalStats AdvancedRateLimiter::get_global_stats() const {
   return stats;
 }
 
+MemoryFootprint AdvancedRateLimiter::memory_footprint() const {
+  MemoryFootprint footprint;
+  footprint.reserved = (clients_.bucket_count() + client_configs_.bucket_count()) * sizeof(void*);
+  for (const auto& [id, client] : clients_) {
+    const auto client_footprint = client->memory_footprint();
+    footprint.reserved += container_node_bytes<decltype(clients_)>() + string_heap_bytes(id) +
+                          sizeof(ClientRateLimiter) + client_footprint.reserved;
+    footprint.in_use += sizeof(ClientRateLimiter) + client_footprint.in_use;
+  }
+  for (const auto& [id, _] : client_configs_) {
+    footprint.reserved += container_node_bytes<decltype(client_configs_)>() + string_heap_bytes(id);
+    footprint.in_use += sizeof(RateLimiterConfig);
+  }
+  return footprint;
+}
+
 std::size_t AdvancedRateLimiter::cleanup_inactive(std::chrono::seconds max_idle) {
   auto now = now_fn_();
   std::size_t removed = 0;
@@ -9,6 +9,8 @@
 #include <unordered_map>
 #include <memory>
 
+#include "common/utils/memory_footprint.h"
+
 
 namespace veil::utils {
 
@@ -109,6 +111,9 @@ class ClientRateLimiter {
   // Check if client should be blocked due to violations.
   bool is_blocked() const;
 
+  // Heap held by the reconnect history; the buckets are fixed-size.
+  MemoryFootprint memory_footprint() const;
+
   // Get remaining bandwidth budget for current window.
   std::uint64_t remaining_bandwidth() const;
 
@@ -163,6 +168,9 @@ class AdvancedRateLimiter {
   };
   GlobalStats get_global_stats() const;
 
+  // Per-client limiters, their keys and the index overhead.
+  MemoryFootprint memory_footprint() const;
+
   // Clean up inactive clients (call periodically).
   std::size_t cleanup_inactive(std::chrono::seconds max_idle);
 
@@ -0,0 +1,196 @@
+#include "common/utils/allocation_tracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace veil::utils {
+
+namespace {
+
+struct AtomicCounts {
+  std::atomic<std::uint64_t> allocations{0};
+  std::atomic<std::uint64_t> bytes{0};
+};
+
+// constinit: the hook can run before any dynamic initialisation.
+constinit std::array<AtomicCounts, kAllocationSubsystemCount> g_counts{};
+constinit thread_local AllocationSubsystem t_current = AllocationSubsystem::kOther;
+
+}  // namespace
+
+const char* allocation_subsystem_name(AllocationSubsystem subsystem) {
+  switch (subsystem) {
+    case AllocationSubsystem::kOther:
+      return "other";
+    case AllocationSubsystem::kCrypto:
+      return "crypto";
+    case AllocationSubsystem::kHandshake:
+      return "handshake";
+    case AllocationSubsystem::kMux:
+      return "mux";
+    case AllocationSubsystem::kTransport:
+      return "transport";
+    case AllocationSubsystem::kEventLoop:
+      return "event_loop";
+    case AllocationSubsystem::kCount:
+      break;
+  }
+  return "unknown";
+}
+
+void record_allocation(std::size_t bytes) noexcept {
+  auto& counts = g_counts[static_cast<std::size_t>(t_current)];
+  counts.allocations.fetch_add(1, std::memory_order_relaxed);
+  counts.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+AllocationCounts allocation_counts(AllocationSubsystem subsystem) {
+  const auto& counts = g_counts[static_cast<std::size_t>(subsystem)];
+  return {counts.allocations.load(std::memory_order_relaxed),
+          counts.bytes.load(std::memory_order_relaxed)};
+}
+
+AllocationSnapshot allocation_snapshot() {
+  AllocationSnapshot snapshot{};
+  for (std::size_t i = 0; i < kAllocationSubsystemCount; ++i) {
+    snapshot[i] = allocation_counts(static_cast<AllocationSubsystem>(i));
+  }
+  return snapshot;
+}
+
+AllocationCounts total_allocations(const AllocationSnapshot& snapshot) {
+  AllocationCounts total;
+  for (const auto& counts : snapshot) {
+    total.allocations += counts.allocations;
+    total.bytes += counts.bytes;
+  }
+  return total;
+}
+
+void reset_allocation_counts() {
+  for (auto& counts : g_counts) {
+    counts.allocations.store(0, std::memory_order_relaxed);
+    counts.bytes.store(0, std::memory_order_relaxed);
+  }
+}
+
+AllocationSubsystem current_allocation_subsystem() noexcept { return t_current; }
+
+AllocationScope::AllocationScope(AllocationSubsystem subsystem) noexcept : previous_(t_current) {
+  t_current = subsystem;
+}
+
+AllocationScope::~AllocationScope() { t_current = previous_; }
+
+}  // namespace veil::utils
+
+#ifdef VEIL_ALLOCATION_TRACKING
+
+// Replacement global allocation functions. Kept out of line so the compiler
+// cannot pair an inlined malloc with the library's sized delete. The
+// align_val_t overloads serve over-aligned types such as ClientSession and
+// TransportSession (alignas(kCacheLineSize)); both kinds are released with
+// std::free.
+
+namespace {
+
+void* tracked_allocate(std::size_t size) {
+  veil::utils::record_allocation(size);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* tracked_allocate(std::size_t size, std::align_val_t align) {
+  veil::utils::record_allocation(size);
+  const auto alignment = static_cast<std::size_t>(align);
+  // aligned_alloc wants a size that is a multiple of the alignment.
+  const auto rounded = (std::max<std::size_t>(size, 1) + alignment - 1) & ~(alignment - 1);
+  return std::aligned_alloc(alignment, rounded);
+}
+
+}  // namespace
+
+[[gnu::noinline]] void* operator new(std::size_t size) {
+  if (void* ptr = tracked_allocate(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void* operator new[](std::size_t size) {
+  if (void* ptr = tracked_allocate(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void* operator new(std::size_t size, const std::nothrow_t& /*tag*/) noexcept {
+  return tracked_allocate(size);
+}
+
+[[gnu::noinline]] void* operator new[](std::size_t size, const std::nothrow_t& /*tag*/) noexcept {
+  return tracked_allocate(size);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept { std::free(ptr); }
+[[gnu::noinline]] void operator delete[](void* ptr) noexcept { std::free(ptr); }
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t /*size*/) noexcept { std::free(ptr); }
+[[gnu::noinline]] void operator delete[](void* ptr, std::size_t /*size*/) noexcept {
+  std::free(ptr);
+}
+[[gnu::noinline]] void operator delete(void* ptr, const std::nothrow_t& /*tag*/) noexcept {
+  std::free(ptr);
+}
+[[gnu::noinline]] void operator delete[](void* ptr, const std::nothrow_t& /*tag*/) noexcept {
+  std::free(ptr);
+}
+
+[[gnu::noinline]] void* operator new(std::size_t size, std::align_val_t align) {
+  if (void* ptr = tracked_allocate(size, align)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void* operator new[](std::size_t size, std::align_val_t align) {
+  if (void* ptr = tracked_allocate(size, align)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void* operator new(std::size_t size, std::align_val_t align,
+                                     const std::nothrow_t& /*tag*/) noexcept {
+  return tracked_allocate(size, align);
+}
+
+[[gnu::noinline]] void* operator new[](std::size_t size, std::align_val_t align,
+                                       const std::nothrow_t& /*tag*/) noexcept {
+  return tracked_allocate(size, align);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::align_val_t /*align*/) noexcept {
+  std::free(ptr);
+}
+[[gnu::noinline]] void operator delete[](void* ptr, std::align_val_t /*align*/) noexcept {
+  std::free(ptr);
+}
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t /*size*/,
+                                       std::align_val_t /*align*/) noexcept {
+  std::free(ptr);
+}
+[[gnu::noinline]] void operator delete[](void* ptr, std::size_t /*size*/,
+                                         std::align_val_t /*align*/) noexcept {
+  std::free(ptr);
+}
+[[gnu::noinline]] void operator delete(void* ptr, std::align_val_t /*align*/,
+                                       const std::nothrow_t& /*tag*/) noexcept {
+  std::free(ptr);
+}
+[[gnu::noinline]] void operator delete[](void* ptr, std::align_val_t /*align*/,
+                                         const std::nothrow_t& /*tag*/) noexcept {
+  std::free(ptr);
+}
+
+#endif  // VEIL_ALLOCATION_TRACKING
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace veil::utils {
+
+/**
+ * Per-subsystem heap allocation counters for benchmark builds.
+ *
+ * Configuring with -DVEIL_ENABLE_ALLOCATION_TRACKING=ON replaces the global
+ * operator new/delete (see allocation_tracker.cpp) and defines
+ * VEIL_ALLOCATION_TRACKING. Every allocation is then charged to the
+ * subsystem named by the innermost VEIL_ALLOCATION_SCOPE on the calling
+ * thread, or to kOther outside any scope. Benchmarks read the counters to
+ * show which part of the data path still allocates per packet.
+ *
+ * In regular builds the hook is absent and VEIL_ALLOCATION_SCOPE expands to
+ * nothing, so the scopes on the hot path cost nothing.
+ *
+ * Thread Safety:
+ *   Counters are relaxed atomics and the current scope is thread-local, so
+ *   all functions may be called from any thread. Snapshots taken while other
+ *   threads allocate are not atomic across subsystems.
+ *
+ * @see docs/thread_model.md for the VEIL threading model documentation.
+ */
+enum class AllocationSubsystem : std::uint8_t {
+  kOther = 0,
+  kCrypto,
+  kHandshake,
+  kMux,
+  kTransport,
+  kEventLoop,
+  kCount
+};
+
+constexpr std::size_t kAllocationSubsystemCount =
+    static_cast<std::size_t>(AllocationSubsystem::kCount);
+
+const char* allocation_subsystem_name(AllocationSubsystem subsystem);
+
+struct AllocationCounts {
+  std::uint64_t allocations{0};
+  std::uint64_t bytes{0};
+};
+
+using AllocationSnapshot = std::array<AllocationCounts, kAllocationSubsystemCount>;
+
+// True when built with VEIL_ENABLE_ALLOCATION_TRACKING.
+constexpr bool allocation_tracking_enabled() {
+#ifdef VEIL_ALLOCATION_TRACKING
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Charge one allocation of `bytes` to the current thread's subsystem. Called
+// by the operator new hook; must not allocate.
+void record_allocation(std::size_t bytes) noexcept;
+
+AllocationCounts allocation_counts(AllocationSubsystem subsystem);
+AllocationSnapshot allocation_snapshot();
+AllocationCounts total_allocations(const AllocationSnapshot& snapshot);
+void reset_allocation_counts();
+
+AllocationSubsystem current_allocation_subsystem() noexcept;
+
+// Charges allocations on this thread to `subsystem` until destroyed, then
+// restores the enclosing scope. Use through VEIL_ALLOCATION_SCOPE.
+class AllocationScope {
+ public:
+  explicit AllocationScope(AllocationSubsystem subsystem) noexcept;
+  ~AllocationScope();
+
+  AllocationScope(const AllocationScope&) = delete;
+  AllocationScope& operator=(const AllocationScope&) = delete;
+  AllocationScope(AllocationScope&&) = delete;
+  AllocationScope& operator=(AllocationScope&&) = delete;
+
+ private:
+  AllocationSubsystem previous_;
+};
+
+}  // namespace veil::utils
+
+#ifdef VEIL_ALLOCATION_TRACKING
+#define VEIL_ALLOCATION_SCOPE_CONCAT_INNER(a, b) a##b
+#define VEIL_ALLOCATION_SCOPE_CONCAT(a, b) VEIL_ALLOCATION_SCOPE_CONCAT_INNER(a, b)
+#define VEIL_ALLOCATION_SCOPE(subsystem)                                                  \
+  const ::veil::utils::AllocationScope VEIL_ALLOCATION_SCOPE_CONCAT(veil_alloc_scope_, \
+                                                                    __LINE__)(           \
+      ::veil::utils::AllocationSubsystem::subsystem)
+#else
+#define VEIL_ALLOCATION_SCOPE(subsystem) static_cast<void>(0)
+#endif
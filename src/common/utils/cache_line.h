@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+namespace veil::utils {
+
+// Cache line size assumed for layout of per-packet state. 64 bytes on every
+// x86-64 and most ARM64 cores; std::hardware_destructive_interference_size
+// is not used because its value may differ between translation units.
+inline constexpr std::size_t kCacheLineSize = 64;
+
+}  // namespace veil::utils
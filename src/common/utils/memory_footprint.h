@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace veil::utils {
+
+/**
+ * Memory held by a component, as reported by its memory_footprint() method.
+ *
+ * Footprints count heap memory the component owns, not sizeof(*this): the
+ * owner already pays for the object itself, so footprints of members add up
+ * without double counting. Container bookkeeping (tree and hash nodes,
+ * vector slack) is estimated from the standard library's layout, not
+ * measured; see allocation_tracker.h for exact per-subsystem counts in
+ * benchmark builds.
+ */
+struct MemoryFootprint {
+  // Heap bytes allocated, including unused capacity and node overhead.
+  std::size_t reserved{0};
+  // Payload bytes currently held (buffered packets, fragments, ...).
+  std::size_t in_use{0};
+  // Configured cap on in_use; 0 when the component is unbounded.
+  std::size_t limit{0};
+
+  MemoryFootprint& operator+=(const MemoryFootprint& other) {
+    reserved += other.reserved;
+    in_use += other.in_use;
+    limit += other.limit;
+    return *this;
+  }
+};
+
+inline MemoryFootprint operator+(MemoryFootprint lhs, const MemoryFootprint& rhs) {
+  lhs += rhs;
+  return lhs;
+}
+
+// Estimated heap bytes per element of a node-based container: the value plus
+// the links and colour/hash the node carries.
+template <typename Container>
+constexpr std::size_t container_node_bytes() {
+  return sizeof(typename Container::value_type) + 4 * sizeof(void*);
+}
+
+// Heap bytes behind a string; zero while it fits in the small-string buffer.
+inline std::size_t string_heap_bytes(const std::string& s) {
+  const auto* object = static_cast<const void*>(&s);
+  const auto* end = static_cast<const void*>(&s + 1);
+  const auto* data = static_cast<const void*>(s.data());
+  const std::less<const void*> before;
+  const bool inline_buffer = !before(data, object) && before(data, end);
+  return inline_buffer ? 0 : s.capacity() + 1;
+}
+
+}  // namespace veil::utils
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/utils/spsc_ring.h"
+
+namespace veil::utils {
+
+/**
+ * Worker threads that run jobs in parallel and hand them back in the order
+ * they were submitted, so per-session packet order survives parallel
+ * encryption and decryption.
+ *
+ * Job k goes to worker k mod N through that worker's input SpscRing and
+ * comes back through its output ring. Each ring is FIFO, so collect()
+ * restores submission order by visiting the output rings round-robin; no
+ * sequence numbers or reorder buffer are needed. A worker takes jobs in
+ * batches and publishes each batch's results before calling `on_ready`.
+ *
+ * A worker holds at most capacity() jobs, counting those waiting, running
+ * and finished but not collected, so its output ring never overflows;
+ * try_submit() fails instead. Idle workers spin briefly, then sleep until
+ * the next submission.
+ *
+ * Thread Safety:
+ *   try_submit(), ready() and collect() must be called from the one thread
+ *   that owns the pool. `work` and `on_ready` run on the worker threads;
+ *   `on_ready` must be safe to call from several at once. The destructor
+ *   stops and joins the workers, dropping jobs not yet collected.
+ */
+template <typename Job>
+class OrderedWorkerPool {
+ public:
+  using Work = std::function<void(Job&)>;
+  using Notify = std::function<void()>;
+
+  OrderedWorkerPool(std::size_t workers, std::size_t capacity, Work work, Notify on_ready = {})
+      : work_(std::move(work)), on_ready_(std::move(on_ready)) {
+    workers_.reserve(workers == 0 ? 1 : workers);
+    for (std::size_t i = 0; i < workers_.capacity(); ++i) {
+      workers_.push_back(std::make_unique<Worker>(capacity));
+    }
+    for (auto& worker : workers_) {
+      worker->thread = std::thread([this, w = worker.get()] { run(*w); });
+    }
+  }
+
+  ~OrderedWorkerPool() {
+    stopping_.store(true);
+    for (auto& worker : workers_) {
+      worker->wake.fetch_add(1);
+      worker->wake.notify_one();
+    }
+    for (auto& worker : workers_) {
+      worker->thread.join();
+    }
+  }
+
+  OrderedWorkerPool(const OrderedWorkerPool&) = delete;
+  OrderedWorkerPool& operator=(const OrderedWorkerPool&) = delete;
+
+  std::size_t workers() const { return workers_.size(); }
+
+  // Jobs one worker may hold.
+  std::size_t capacity() const { return workers_.front()->input.capacity(); }
+
+  // Submitted and not yet collected.
+  std::size_t in_flight() const { return submitted_ - collected_; }
+
+  // Queue `job` for the next worker in turn; false, leaving it untouched,
+  // if that worker is full. Collect results to make room.
+  bool try_submit(Job&& job) {
+    auto& worker = *workers_[submitted_ % workers_.size()];
+    if (worker.held == capacity() || !worker.input.try_push(std::move(job))) {
+      return false;
+    }
+    ++worker.held;
+    ++submitted_;
+    // Pairs with the fence in park(): either the worker sees the job, or
+    // this sees it parked.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (worker.parked.exchange(false)) {
+      worker.wake.fetch_add(1, std::memory_order_release);
+      worker.wake.notify_one();
+    }
+    return true;
+  }
+
+  // Whether the next job in submission order has finished.
+  bool ready() const {
+    return collected_ < submitted_ && !workers_[collected_ % workers_.size()]->output.empty();
+  }
+
+  // Pass finished jobs to `handler` in submission order, stopping at the
+  // first one still running. Returns the number passed.
+  template <typename Handler>
+  std::size_t collect(Handler&& handler) {
+    std::size_t count = 0;
+    while (collected_ < submitted_) {
+      auto& worker = *workers_[collected_ % workers_.size()];
+      auto job = worker.output.pop();
+      if (!job) {
+        break;
+      }
+      --worker.held;
+      ++collected_;
+      ++count;
+      handler(std::move(*job));
+    }
+    return count;
+  }
+
+ private:
+  // Jobs a worker takes from its input ring at a time.
+  static constexpr std::size_t kBatch = 16;
+  // Empty polls before an idle worker sleeps.
+  static constexpr int kSpins = 64;
+
+  struct Worker {
+    explicit Worker(std::size_t capacity) : input(capacity), output(capacity) {}
+
+    SpscRing<Job> input;
+    SpscRing<Job> output;
+    // Owner thread only: jobs in the input ring, running or in the output
+    // ring.
+    std::size_t held{0};
+    // Sleep word and flag; see park().
+    std::atomic<std::uint32_t> wake{0};
+    std::atomic<bool> parked{false};
+    std::thread thread;
+  };
+
+  void run(Worker& worker) {
+    std::vector<Job> batch;
+    batch.reserve(kBatch);
+    int idle = 0;
+    while (!stopping_.load(std::memory_order_acquire)) {
+      batch.clear();
+      if (worker.input.pop_batch(batch, kBatch) == 0) {
+        if (++idle < kSpins) {
+          std::this_thread::yield();
+        } else {
+          park(worker);
+          idle = 0;
+        }
+        continue;
+      }
+      idle = 0;
+      for (auto& job : batch) {
+        work_(job);
+      }
+      for (auto& job : batch) {
+        // Cannot fail: held counts output slots too.
+        while (!worker.output.try_push(std::move(job))) {
+          std::this_thread::yield();
+        }
+      }
+      if (on_ready_) {
+        on_ready_();
+      }
+    }
+  }
+
+  void park(Worker& worker) {
+    const auto seen = worker.wake.load(std::memory_order_acquire);
+    worker.parked.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (worker.input.empty() && !stopping_.load()) {
+      worker.wake.wait(seen, std::memory_order_acquire);
+    }
+    worker.parked.store(false, std::memory_order_relaxed);
+  }
+
+  Work work_;
+  Notify on_ready_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<bool> stopping_{false};
+  // Owner thread only.
+  std::uint64_t submitted_{0};
+  std::uint64_t collected_{0};
+};
+
+}  // namespace veil::utils
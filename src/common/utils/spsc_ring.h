@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "common/utils/cache_line.h"
+
+namespace veil::utils {
+
+/**
+ * Bounded lock-free queue between one producer thread and one consumer
+ * thread, for handing packets between pipeline stages.
+ *
+ * Capacity is rounded up to a power of two. Each side keeps its own index
+ * and a cached copy of the other's on its own cache line, so it reads the
+ * other side's line only when the cache says the ring looks full (producer)
+ * or empty (consumer): with batches in flight, both sides run mostly on
+ * local lines.
+ *
+ * Thread Safety:
+ *   try_push() may be called from one thread and pop()/pop_batch() from
+ *   one other thread at a time. empty() and size() are safe anywhere but
+ *   only a snapshot.
+ */
+template <typename T>
+class SpscRing {
+ public:
+  explicit SpscRing(std::size_t capacity)
+      : mask_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1),
+        slots_(std::make_unique<T[]>(mask_ + 1)) {}
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  std::size_t capacity() const { return mask_ + 1; }
+
+  // Producer: append `value`; false, leaving it untouched, if the ring is
+  // full.
+  bool try_push(T&& value) {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ > mask_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ > mask_) {
+        return false;
+      }
+    }
+    slots_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer: the oldest element, if any.
+  std::optional<T> pop() {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return std::nullopt;
+      }
+    }
+    std::optional<T> value(std::move(slots_[head & mask_]));
+    head_.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  // Consumer: move up to `max` elements to the end of `out`, freeing their
+  // slots with one release. Returns the number moved.
+  std::size_t pop_batch(std::vector<T>& out, std::size_t max) {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+    }
+    const auto count = std::min<std::size_t>(cached_tail_ - head, max);
+    for (std::size_t i = 0; i < count; ++i) {
+      out.push_back(std::move(slots_[(head + i) & mask_]));
+    }
+    if (count > 0) {
+      head_.store(head + count, std::memory_order_release);
+    }
+    return count;
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+  std::size_t size() const {
+    const auto head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
+  }
+
+ private:
+  const std::size_t mask_;
+  const std::unique_ptr<T[]> slots_;
+
+  // Consumer side.
+  alignas(kCacheLineSize) std::atomic<std::size_t> head_{0};
+  std::size_t cached_tail_{0};
+
+  // Producer side.
+  alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+  std::size_t cached_head_{0};
+};
+
+}  // namespace veil::utils
@@ -0,0 +1,492 @@
+#include "server/data_plane.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "common/logging/logger.h"
+#include "transport/mux/frame.h"
+#include "transport/mux/mux_codec.h"
+#include "tun/ip_packet.h"
+
+namespace veil::server {
+
+namespace {
+
+// Jobs each crypto worker may hold.
+constexpr std::size_t kCryptoRingSize = 256;
+
+// Make each client's datagrams adjacent, keeping their order per client, so
+// the socket can coalesce them into GSO sends. Order across clients does
+// not matter within one sendmmsg call.
+void group_by_destination(std::vector<transport::UdpPacket>& batch) {
+  for (auto first = batch.begin(); first != batch.end();) {
+    const auto remote = first->remote;
+    first = std::stable_partition(
+        first, batch.end(),
+        [&remote](const transport::UdpPacket& packet) { return packet.remote == remote; });
+  }
+}
+
+}  // namespace
+
+ServerDataPlane::ServerDataPlane(tun::TunDevice& tun_device, transport::UdpSocket& udp_socket,
+                                 SessionTable& sessions, handshake::HandshakeResponder& responder,
+                                 transport::TransportSessionConfig transport_config,
+                                 EgressSchedulerConfig egress_config,
+                                 mux::FlowStreamConfig stream_config,
+                                 HairpinConfig hairpin_config, RouteConfig route_config,
+                                 std::size_t crypto_workers)
+    : tun_device_(tun_device),
+      udp_socket_(udp_socket),
+      sessions_(sessions),
+      responder_(responder),
+      transport_config_(transport_config),
+      hairpin_config_(std::move(hairpin_config)),
+      route_config_(std::move(route_config)),
+      egress_(std::move(egress_config)),
+      stream_mapper_(stream_config) {
+  batch_.reserve(egress_.config().batch_size);
+  if (crypto_workers > 0) {
+    start_pipeline(crypto_workers);
+  }
+}
+
+ServerDataPlane::~ServerDataPlane() {
+  // Jobs not yet finished are dropped; the workers stop before the eventfd
+  // they signal is closed.
+  crypto_pool_.reset();
+  if (wake_fd_ >= 0) {
+    ::close(wake_fd_);
+  }
+}
+
+void ServerDataPlane::on_new_session(NewSessionCallback callback) {
+  new_session_callback_ = std::move(callback);
+}
+
+void ServerDataPlane::poll_once(int timeout_ms) {
+  std::error_code ec;
+  // Do not sleep while egress traffic is waiting.
+  if (crypto_pool_) {
+    poll_pipeline(egress_.empty() ? timeout_ms : 0);
+  } else {
+    udp_socket_.poll([this](const transport::UdpPacket& pkt) { handle_udp_packet(pkt); },
+                     egress_.empty() ? timeout_ms : 0, ec);
+  }
+
+  for (std::size_t i = 0; i < egress_.config().batch_size; ++i) {
+    const auto tun_read = tun_device_.read_into(tun_buffer_, ec);
+    if (tun_read <= 0) {
+      break;
+    }
+    handle_tun_packet(
+        std::span<const std::uint8_t>(tun_buffer_.data(), static_cast<std::size_t>(tun_read)));
+  }
+
+  process_retransmits();
+  flush_egress();
+}
+
+void ServerDataPlane::handle_udp_packet(const transport::UdpPacket& packet) {
+  LOG_DEBUG("Received {} bytes from {}:{}", packet.data.size(), packet.remote.host,
+            packet.remote.port);
+  stats_.udp_packets_received++;
+  stats_.udp_bytes_received += packet.data.size();
+
+  auto* session = sessions_.find_by_endpoint(packet.remote);
+  if (session == nullptr) {
+    handle_handshake(packet);
+    return;
+  }
+
+  sessions_.update_activity(session->session_id);
+  session->packets_received++;
+  session->bytes_received += packet.data.size();
+
+  if (!ensure_awake(*session)) {
+    return;
+  }
+
+  if (crypto_pool_) {
+    // Replay-checked here, decrypted by a worker, handled by finish_crypto().
+    auto job = session->transport->prepare_open(packet.data);
+    if (!job) {
+      stats_.decrypt_errors++;
+      return;
+    }
+    submit_crypto(CryptoJob{std::move(*job), session->session_id, packet.ecn});
+    return;
+  }
+
+  auto frames = session->transport->decrypt_packet(packet.data);
+  if (!frames) {
+    stats_.decrypt_errors++;
+    return;
+  }
+
+  session->transport->record_outer_ecn(packet.ecn);
+  const auto outer = static_cast<tun::Ecn>(packet.ecn & 0x03);
+  if (outer == tun::Ecn::kCe) {
+    stats_.ecn_ce_received++;
+  }
+
+  handle_frames(*session, *frames, outer);
+}
+
+void ServerDataPlane::handle_handshake(const transport::UdpPacket& packet) {
+  auto hs_result = responder_.handle_init(packet.data);
+  if (!hs_result) {
+    return;
+  }
+
+  std::error_code ec;
+  if (!udp_socket_.send(hs_result->response, packet.remote, ec)) {
+    LOG_ERROR("Failed to send handshake response: {}", ec.message());
+    stats_.udp_send_errors++;
+    return;
+  }
+
+  auto transport =
+      std::make_unique<transport::TransportSession>(hs_result->session, transport_config_);
+  auto session_id = sessions_.create_session(packet.remote, std::move(transport));
+  if (!session_id) {
+    return;
+  }
+
+  stats_.handshakes_completed++;
+  if (new_session_callback_) {
+    if (const auto* session = sessions_.find_by_id(*session_id)) {
+      new_session_callback_(*session);
+    }
+  }
+}
+
+void ServerDataPlane::handle_frames(ClientSession& session, std::vector<mux::MuxFrame>& frames,
+                                    tun::Ecn outer) {
+  for (auto& frame : frames) {
+    if (frame.kind == mux::FrameKind::kData) {
+      if (!tun::apply_outer_ecn(frame.data.payload, outer)) {
+        stats_.ecn_drops++;
+        continue;
+      }
+      if (hairpin(session, frame.data.payload)) {
+        continue;
+      }
+      std::error_code ec;
+      if (!tun_device_.write(frame.data.payload, ec)) {
+        LOG_ERROR("Failed to write to TUN: {}", ec.message());
+        stats_.tun_write_errors++;
+        session.transport->report_delivery_drop();
+        continue;
+      }
+      stats_.tun_packets_written++;
+    } else if (frame.kind == mux::FrameKind::kAck) {
+      session.transport->process_ack(frame.ack);
+    } else if (frame.kind == mux::FrameKind::kControl &&
+               frame.control.type == static_cast<std::uint8_t>(mux::ControlType::kRoutes)) {
+      if (const auto announced = tun::decode_ip_prefixes(frame.control.payload)) {
+        apply_routes(session, *announced);
+      }
+    }
+  }
+}
+
+void ServerDataPlane::apply_routes(ClientSession& session,
+                                   const std::vector<tun::IpPrefix>& announced) {
+  stats_.route_announcements++;
+  // Clients repeat their announcement; only a change touches the table or
+  // counts rejections. Compared with the last announcement rather than
+  // with what was installed, so prefixes refused below do not make every
+  // repeat look new.
+  if (announced == session.announced_prefixes) {
+    return;
+  }
+  session.announced_prefixes = announced;
+
+  std::vector<tun::IpPrefix> accepted;
+  for (const auto& prefix : announced) {
+    const bool allowed =
+        std::any_of(route_config_.allowed.begin(), route_config_.allowed.end(),
+                    [&prefix](const tun::IpPrefix& range) { return range.covers(prefix); });
+    if (!allowed || accepted.size() >= route_config_.max_per_client) {
+      stats_.routes_rejected++;
+      continue;
+    }
+    accepted.push_back(prefix);
+  }
+  const auto installed = sessions_.set_routes(session.session_id, accepted);
+  stats_.routes_rejected += accepted.size() - installed;
+  LOG_INFO("Session {} routes {} subnet(s)", session.session_id, installed);
+}
+
+void ServerDataPlane::handle_tun_packet(std::span<const std::uint8_t> packet) {
+  stats_.tun_packets_read++;
+  auto* session = sessions_.find_by_destination(tun::destination_address(packet));
+  if (session == nullptr || !ensure_awake(*session)) {
+    stats_.unroutable_packets++;
+    return;
+  }
+  enqueue_for(*session, packet);
+}
+
+bool ServerDataPlane::hairpin(const ClientSession& from, std::span<const std::uint8_t> packet) {
+  if (!hairpin_config_.enabled) {
+    return false;
+  }
+  const auto address = tun::destination_address(packet);
+  auto* to = sessions_.find_by_destination(address);
+  if (to == nullptr || to == &from) {
+    return false;
+  }
+  const auto destination = tun::ipv4_destination(packet);
+  const bool allowed = destination
+                           ? hairpin_allowed(hairpin_config_, from.tunnel_ip_v4, *destination)
+                           : hairpin_config_.default_allow;
+  if (!allowed) {
+    stats_.hairpin_denied++;
+    return true;
+  }
+  if (!ensure_awake(*to)) {
+    stats_.unroutable_packets++;
+    return true;
+  }
+  stats_.hairpin_packets++;
+  enqueue_for(*to, packet);
+  return true;
+}
+
+void ServerDataPlane::enqueue_for(ClientSession& session, std::span<const std::uint8_t> packet) {
+  const bool interactive =
+      mux::priority_for_dscp(tun::dscp(packet)) == mux::StreamPriority::kInteractive;
+  if (!egress_.enqueue(session.session_id,
+                       std::vector<std::uint8_t>(packet.begin(), packet.end()), interactive)) {
+    stats_.egress_drops++;
+  }
+}
+
+void ServerDataPlane::process_retransmits() {
+  for (auto* session : sessions_.get_all_sessions()) {
+    if (!session->transport) {
+      continue;
+    }
+    // Retransmissions and FEC repairs lead the session's own queue, so they
+    // go out before its new data but within its share of the link.
+    for (auto& pkt : session->transport->get_retransmit_packets()) {
+      if (egress_.enqueue_sealed(session->session_id,
+                                 transport::UdpPacket{std::move(pkt), session->endpoint})) {
+        stats_.retransmits_sent++;
+      } else {
+        stats_.egress_drops++;
+      }
+    }
+    for (auto& pkt : session->transport->get_fec_packets()) {
+      if (!egress_.enqueue_sealed(session->session_id,
+                                  transport::UdpPacket{std::move(pkt), session->endpoint})) {
+        stats_.egress_drops++;
+      }
+    }
+    // Window updates and BLOCKED notices are small and time-sensitive.
+    for (auto& pkt : session->transport->get_flow_control_packets()) {
+      if (!egress_.enqueue_priority(transport::UdpPacket{std::move(pkt), session->endpoint})) {
+        stats_.egress_drops++;
+      }
+    }
+    auto released = session->transport->release_stalled_frames();
+    if (!released.empty()) {
+      handle_frames(*session, released, tun::Ecn::kNotEct);
+    }
+  }
+}
+
+void ServerDataPlane::flush_egress() {
+  const auto on_sealed = [this](transport::UdpPacket& packet) {
+    batch_.push_back(std::move(packet));
+  };
+  const auto on_session = [this](std::uint64_t session_id, std::span<const std::uint8_t> packet) {
+    auto* session = sessions_.find_by_id(session_id);
+    if (session == nullptr || !ensure_awake(*session)) {
+      return false;
+    }
+    // The client has no room for this packet; sending it would only have
+    // it dropped there.
+    const auto stream_id = stream_mapper_.stream_for(packet);
+    if (!session->transport->has_send_credit(packet.size(), stream_id)) {
+      stats_.flow_control_drops++;
+      return true;
+    }
+    const std::uint8_t ecn =
+        udp_socket_.ecn_enabled() ? static_cast<std::uint8_t>(tun::ecn_codepoint(packet)) : 0;
+    if (crypto_pool_) {
+      // Sent from a later batch once sealed.
+      for (auto& job : session->transport->prepare_data(packet, stream_id)) {
+        submit_crypto(CryptoJob{std::move(job), session_id, ecn});
+      }
+      return true;
+    }
+    for (auto& pkt : session->transport->encrypt_data(packet, stream_id)) {
+      session->packets_sent++;
+      session->bytes_sent += pkt.size();
+      batch_.push_back(transport::UdpPacket{std::move(pkt), session->endpoint, ecn});
+    }
+    return true;
+  };
+
+  // One batch per poll, matching the TUN read budget: under overload the
+  // per-session queues fill and drop, instead of one session's backlog
+  // being flushed ahead of everyone else's next packet.
+  egress_.drain(egress_.config().batch_size, on_sealed, on_session);
+  if (crypto_pool_) {
+    finish_crypto();
+  }
+  send_batch();
+}
+
+std::size_t ServerDataPlane::prune_egress() {
+  return egress_.prune(
+      [this](std::uint64_t session_id) { return sessions_.find_by_id(session_id) == nullptr; });
+}
+
+void ServerDataPlane::send_batch() {
+  if (batch_.empty()) {
+    return;
+  }
+  if (udp_socket_.gso_enabled()) {
+    group_by_destination(batch_);
+  }
+  std::error_code ec;
+  if (udp_socket_.send_batch(batch_, ec)) {
+    stats_.udp_packets_sent += batch_.size();
+    for (const auto& packet : batch_) {
+      stats_.udp_bytes_sent += packet.data.size();
+    }
+  } else {
+    LOG_ERROR("Failed to send to clients: {}", ec.message());
+    stats_.udp_send_errors++;
+  }
+  stats_.send_batches++;
+  batch_.clear();
+}
+
+bool ServerDataPlane::ensure_awake(ClientSession& session) {
+  if (session.transport) {
+    return true;
+  }
+  if (!sessions_.wake(session, transport_config_)) {
+    return false;
+  }
+  stats_.sessions_woken++;
+  return true;
+}
+
+void ServerDataPlane::start_pipeline(std::size_t workers) {
+  wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wake_fd_ < 0) {
+    LOG_WARN("eventfd failed ({}); running the data plane on one thread", std::strerror(errno));
+    return;
+  }
+  crypto_pool_ = std::make_unique<utils::OrderedWorkerPool<CryptoJob>>(
+      workers, kCryptoRingSize, [](CryptoJob& job) { job.aead.run(); }, [this] { wake_loop(); });
+  finished_.reserve(crypto_pool_->workers() * kCryptoRingSize);
+  LOG_INFO("Pipelined data plane: {} crypto worker threads", crypto_pool_->workers());
+}
+
+void ServerDataPlane::poll_pipeline(int timeout_ms) {
+  // Pairs with the fence in wake_loop(): either the check below sees the
+  // finished jobs, or the worker sees loop_waiting_ and signals the eventfd.
+  loop_waiting_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (crypto_pool_->ready()) {
+    timeout_ms = 0;
+  }
+  std::array<pollfd, 2> fds{{{udp_socket_.fd(), POLLIN, 0}, {wake_fd_, POLLIN, 0}}};
+  ::poll(fds.data(), fds.size(), timeout_ms);
+  loop_waiting_.store(false, std::memory_order_relaxed);
+  if ((fds[1].revents & POLLIN) != 0) {
+    std::uint64_t count = 0;
+    [[maybe_unused]] const auto read = ::read(wake_fd_, &count, sizeof(count));
+  }
+  if ((fds[0].revents & POLLIN) == 0) {
+    return;
+  }
+
+  // A batch per wakeup, so the workers have datagrams to share.
+  for (std::size_t i = 0; i < egress_.config().batch_size; ++i) {
+    bool received = false;
+    std::error_code ec;
+    udp_socket_.poll(
+        [this, &received](const transport::UdpPacket& pkt) {
+          received = true;
+          handle_udp_packet(pkt);
+        },
+        0, ec);
+    if (!received) {
+      break;
+    }
+  }
+}
+
+void ServerDataPlane::wake_loop() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (loop_waiting_.exchange(false)) {
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const auto written = ::write(wake_fd_, &one, sizeof(one));
+  }
+}
+
+void ServerDataPlane::submit_crypto(CryptoJob&& job) {
+  while (!crypto_pool_->try_submit(std::move(job))) {
+    // The workers are full. Finishing jobs here could queue hairpinned
+    // packets mid-drain, so only collect them to make room.
+    const auto collected = crypto_pool_->collect(
+        [this](CryptoJob&& done) { finished_.push_back(std::move(done)); });
+    if (collected == 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void ServerDataPlane::finish_crypto() {
+  crypto_pool_->collect([this](CryptoJob&& done) { finished_.push_back(std::move(done)); });
+  for (auto& job : finished_) {
+    finish_job(job);
+  }
+  finished_.clear();
+}
+
+void ServerDataPlane::finish_job(CryptoJob& job) {
+  auto* session = sessions_.find_by_id(job.session_id);
+  if (session == nullptr || !ensure_awake(*session)) {
+    stats_.crypto_orphans++;
+    return;
+  }
+
+  if (job.aead.kind == transport::AeadJob::Kind::kSeal) {
+    auto packet = session->transport->finish_seal(std::move(job.aead));
+    session->packets_sent++;
+    session->bytes_sent += packet.size();
+    batch_.push_back(transport::UdpPacket{std::move(packet), session->endpoint, job.ecn});
+    return;
+  }
+
+  auto frames = session->transport->finish_open(std::move(job.aead));
+  if (!frames) {
+    stats_.decrypt_errors++;
+    return;
+  }
+  session->transport->record_outer_ecn(job.ecn);
+  const auto outer = static_cast<tun::Ecn>(job.ecn & 0x03);
+  if (outer == tun::Ecn::kCe) {
+    stats_.ecn_ce_received++;
+  }
+  handle_frames(*session, *frames, outer);
+}
+
+}  // namespace veil::server
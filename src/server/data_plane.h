@@ -0,0 +1,230 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "common/handshake/handshake_processor.h"
+#include "common/utils/ordered_worker_pool.h"
+#include "server/egress_scheduler.h"
+#include "server/hairpin.h"
+#include "server/route_table.h"
+#include "server/session_table.h"
+#include "transport/mux/flow_streams.h"
+#include "transport/session/transport_session.h"
+#include "transport/udp_socket/udp_socket.h"
+#include "tun/ip_packet.h"
+#include "tun/tun_device.h"
+
+namespace veil::server {
+
+// Counters for the server packet path.
+struct DataPlaneStats {
+  std::uint64_t udp_packets_received{0};
+  std::uint64_t udp_bytes_received{0};
+  std::uint64_t udp_packets_sent{0};
+  std::uint64_t udp_bytes_sent{0};
+  std::uint64_t udp_send_errors{0};
+  std::uint64_t tun_packets_read{0};
+  std::uint64_t tun_packets_written{0};
+  std::uint64_t tun_write_errors{0};
+  std::uint64_t decrypt_errors{0};
+  std::uint64_t unroutable_packets{0};
+  std::uint64_t handshakes_completed{0};
+  std::uint64_t retransmits_sent{0};
+  std::uint64_t sessions_woken{0};
+  std::uint64_t egress_drops{0};
+  std::uint64_t send_batches{0};
+  // Client-bound packets dropped because the client's receive window was
+  // full.
+  std::uint64_t flow_control_drops{0};
+  // Client packets whose outer header was CE-marked, and inner packets
+  // dropped because they were not ECN-capable.
+  std::uint64_t ecn_ce_received{0};
+  std::uint64_t ecn_drops{0};
+  // Client packets addressed to another client: forwarded to its egress
+  // queue without a TUN round trip, or dropped by the hairpin ACL.
+  std::uint64_t hairpin_packets{0};
+  std::uint64_t hairpin_denied{0};
+  // Routed subnet announcements from clients, and announced subnets not
+  // installed (outside RouteConfig::allowed, over the per-client cap, or
+  // taken).
+  std::uint64_t route_announcements{0};
+  std::uint64_t routes_rejected{0};
+  // Crypto jobs dropped on completion because their session had been
+  // removed meanwhile.
+  std::uint64_t crypto_orphans{0};
+};
+
+// Server packet path between the UDP socket and the TUN device: handshakes
+// for unknown peers, decrypt-to-TUN for known ones, TUN-to-client routing by
+// destination address, and retransmission.
+//
+// Client-bound packets, IPv4 or IPv6, go to the session with the longest
+// matching prefix among tunnel IPs and the subnets clients announce behind
+// themselves (site-to-site), filtered by RouteConfig.
+//
+// Client-bound traffic goes through an EgressScheduler: TUN packets are
+// queued per session and encrypted when their DRR turn comes, retransmits
+// jump the queue, and each poll sends the result in sendmmsg batches.
+// Handshake responses are sent immediately. DRR interleaves clients, so
+// with GSO on the socket a batch is regrouped by client first: a bulk
+// download's equal-sized datagrams then leave as one segmented send each.
+//
+// Client-bound packets are spread over mux streams by flow, so with ordered
+// delivery a loss only holds up packets of the flows sharing its stream.
+// Packets on interactive streams (by DSCP) go ahead of the session's other
+// queued packets.
+//
+// With HairpinConfig::enabled, a client packet addressed to another
+// client's tunnel IP is queued for that client directly ("hairpinned")
+// instead of being written to TUN and read back, subject to the
+// HairpinConfig ACL (IPv4 rules; IPv6 packets get its default). The ACL
+// matches the sending client's assigned address, not the packet's source
+// field, so a client cannot spoof its way past a deny rule. Hairpinned
+// packets are not routed by the kernel, skip the host firewall and keep
+// their TTL.
+//
+// With ECN enabled on the socket, ECN follows RFC 6040 normal mode: outer
+// headers copy the inner packet's ECN field, and CE marks on arriving
+// datagrams are copied onto the inner packets written to TUN.
+//
+// With crypto workers (pipelined mode), the AEAD step of client data
+// packets runs on a utils::OrderedWorkerPool. The loop thread still does
+// everything that touches session state: it assigns sequences, checks
+// replays and queues jobs (TransportSession::prepare_data/prepare_open),
+// then finishes them in submission order, so each session's packets reach
+// TUN and the socket in sequence order however the work was spread.
+// Handshakes, retransmits and control packets stay inline.
+//
+// The data plane owns no I/O resources. The TUN device, socket, session
+// table and handshake responder are supplied by the caller, so veil-server
+// and in-process harnesses run the same code.
+//
+// Thread Safety:
+//   Not thread-safe. All methods must be called from the server loop thread;
+//   crypto workers only run AeadJobs. See docs/thread_model.md.
+class ServerDataPlane {
+ public:
+  using NewSessionCallback = std::function<void(const ClientSession& session)>;
+
+  ServerDataPlane(tun::TunDevice& tun_device, transport::UdpSocket& udp_socket,
+                  SessionTable& sessions, handshake::HandshakeResponder& responder,
+                  transport::TransportSessionConfig transport_config,
+                  EgressSchedulerConfig egress_config = {},
+                  mux::FlowStreamConfig stream_config = {}, HairpinConfig hairpin_config = {},
+                  RouteConfig route_config = {}, std::size_t crypto_workers = 0);
+  ~ServerDataPlane();
+
+  ServerDataPlane(const ServerDataPlane&) = delete;
+  ServerDataPlane& operator=(const ServerDataPlane&) = delete;
+
+  // Called after a handshake completes and the session is registered.
+  void on_new_session(NewSessionCallback callback);
+
+  // One iteration of the server loop: wait up to timeout_ms for a datagram,
+  // read up to a batch of packets from the TUN device, queue due
+  // retransmits and flush the egress scheduler.
+  void poll_once(int timeout_ms);
+
+  // Process a datagram received on the UDP socket.
+  void handle_udp_packet(const transport::UdpPacket& packet);
+
+  // Route a packet read from the TUN device to the owning client's egress
+  // queue.
+  void handle_tun_packet(std::span<const std::uint8_t> packet);
+
+  // Queue due retransmissions for all sessions, and deliver data frames
+  // held too long behind a lost one.
+  void process_retransmits();
+
+  // Encrypt and send one sendmmsg batch of queued egress traffic. In
+  // pipelined mode the batch also carries whatever the workers have
+  // finished since the last flush.
+  void flush_egress();
+
+  // Drop egress state of sessions no longer in the table. Call after
+  // SessionTable cleanup.
+  std::size_t prune_egress();
+
+  const EgressStats& egress_stats() const { return egress_.stats(); }
+
+  const DataPlaneStats& stats() const { return stats_; }
+
+ private:
+  static constexpr std::size_t kMaxPacketSize = 65535;
+
+  void handle_handshake(const transport::UdpPacket& packet);
+
+  // Act on decrypted frames: data to the TUN device, ACKs to the session.
+  void handle_frames(ClientSession& session, std::vector<mux::MuxFrame>& frames, tun::Ecn outer);
+
+  // Queue a decrypted client packet for the client it is addressed to, or
+  // drop it per the hairpin ACL. False if it is not addressed to another
+  // client and should go to TUN.
+  bool hairpin(const ClientSession& from, std::span<const std::uint8_t> packet);
+
+  // Install the allowed part of a client's routed subnet announcement.
+  void apply_routes(ClientSession& session, const std::vector<tun::IpPrefix>& announced);
+
+  // Queue a packet for a client, by DSCP priority.
+  void enqueue_for(ClientSession& session, std::span<const std::uint8_t> packet);
+
+  // Restore a hibernated session's transport; false if it has none.
+  bool ensure_awake(ClientSession& session);
+
+  // Send the accumulated batch with one sendmmsg call, grouped by client
+  // when the socket does GSO.
+  void send_batch();
+
+  // Pipelined mode (crypto_workers > 0).
+  struct CryptoJob {
+    transport::AeadJob aead;
+    std::uint64_t session_id{0};
+    // Outer ECN to send with, or as received.
+    std::uint8_t ecn{0};
+  };
+  void start_pipeline(std::size_t workers);
+  // Wait for a datagram or finished jobs, then receive a batch of
+  // datagrams.
+  void poll_pipeline(int timeout_ms);
+  // Wake the loop thread if it is waiting in poll_pipeline().
+  void wake_loop();
+  // Queue a job. While the workers are full, finished jobs are set aside
+  // for finish_crypto(), so this never re-enters the packet path.
+  void submit_crypto(CryptoJob&& job);
+  // Finish completed jobs in order: queue sealed packets for sending,
+  // handle opened ones.
+  void finish_crypto();
+  void finish_job(CryptoJob& job);
+
+  tun::TunDevice& tun_device_;
+  transport::UdpSocket& udp_socket_;
+  SessionTable& sessions_;
+  handshake::HandshakeResponder& responder_;
+  transport::TransportSessionConfig transport_config_;
+  HairpinConfig hairpin_config_;
+  RouteConfig route_config_;
+
+  EgressScheduler egress_;
+  mux::FlowStreamMapper stream_mapper_;
+  std::vector<transport::UdpPacket> batch_;
+
+  std::unique_ptr<utils::OrderedWorkerPool<CryptoJob>> crypto_pool_;
+  // Finished jobs collected while making room, in order.
+  std::vector<CryptoJob> finished_;
+  // Eventfd the workers signal while the loop thread waits.
+  int wake_fd_{-1};
+  std::atomic<bool> loop_waiting_{false};
+
+  NewSessionCallback new_session_callback_;
+  std::array<std::uint8_t, kMaxPacketSize> tun_buffer_{};
+  DataPlaneStats stats_;
+};
+
+}  // namespace veil::server
@@ -0,0 +1,185 @@
+#include "server/egress_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace veil::server {
+
+EgressScheduler::EgressScheduler(EgressSchedulerConfig config,
+                                 std::function<Clock::time_point()> now_fn)
+    : config_(std::move(config)), now_fn_(std::move(now_fn)) {}
+
+EgressScheduler::Flow& EgressScheduler::flow_for(std::uint64_t session_id) {
+  auto [it, inserted] = flows_.try_emplace(session_id);
+  if (inserted && config_.session_rate_limit) {
+    // No penalty: a shaped session waits for tokens instead of being
+    // locked out after draining its bucket.
+    it->second.quota.emplace(config_.session_rate_limit->bandwidth_bytes_per_sec,
+                             config_.session_rate_limit->burst_allowance_factor,
+                             std::chrono::milliseconds(0), now_fn_);
+  }
+  return it->second;
+}
+
+bool EgressScheduler::admit(std::uint64_t session_id, Flow& flow, std::size_t size) {
+  if (flow.queued_bytes + size > config_.max_queue_bytes) {
+    ++stats_.packets_dropped;
+    if (flow_empty(flow) && !flow.quota) {
+      flows_.erase(session_id);
+    }
+    return false;
+  }
+
+  flow.queued_bytes += size;
+  stats_.queued_bytes += size;
+  ++stats_.packets_enqueued;
+  if (!flow.active) {
+    flow.active = true;
+    active_.push_back(session_id);
+  }
+  return true;
+}
+
+bool EgressScheduler::enqueue(std::uint64_t session_id, std::vector<std::uint8_t> packet,
+                              bool interactive) {
+  auto& flow = flow_for(session_id);
+  if (!admit(session_id, flow, packet.size())) {
+    return false;
+  }
+  (interactive ? flow.interactive : flow.queue).push_back(std::move(packet));
+  return true;
+}
+
+bool EgressScheduler::enqueue_sealed(std::uint64_t session_id, transport::UdpPacket packet) {
+  auto& flow = flow_for(session_id);
+  if (!admit(session_id, flow, packet.data.size())) {
+    return false;
+  }
+  flow.sealed.push_back(std::move(packet));
+  return true;
+}
+
+bool EgressScheduler::enqueue_priority(transport::UdpPacket packet) {
+  if (priority_.size() >= config_.max_priority_packets) {
+    ++stats_.priority_packets_dropped;
+    return false;
+  }
+  priority_.push_back(std::move(packet));
+  return true;
+}
+
+void EgressScheduler::discard_queue(Flow& flow) {
+  stats_.packets_dropped += flow.sealed.size() + flow.interactive.size() + flow.queue.size();
+  stats_.queued_bytes -= flow.queued_bytes;
+  flow.sealed.clear();
+  flow.interactive.clear();
+  flow.queue.clear();
+  flow.queued_bytes = 0;
+}
+
+std::size_t EgressScheduler::drain(std::size_t max_packets, const SealedHandler& on_sealed,
+                                   const SessionHandler& on_session) {
+  std::size_t handed = 0;
+  while (handed < max_packets && !priority_.empty()) {
+    on_sealed(priority_.front());
+    priority_.pop_front();
+    ++handed;
+    ++stats_.priority_packets_sent;
+  }
+
+  // Stop once every backlogged session has been skipped for lack of quota.
+  std::size_t throttled_streak = 0;
+  while (handed < max_packets && !active_.empty() && throttled_streak < active_.size()) {
+    const std::uint64_t session_id = active_.front();
+    auto& flow = flows_.at(session_id);
+    if (!flow.turn_started) {
+      flow.deficit += config_.quantum_bytes;
+      flow.turn_started = true;
+    }
+
+    bool throttled = false;
+    bool gone = false;
+    while (handed < max_packets && !flow_empty(flow)) {
+      const std::size_t size = next_size(flow);
+      if (size > flow.deficit) {
+        break;
+      }
+      if (flow.quota && !flow.quota->try_consume(size)) {
+        throttled = true;
+        break;
+      }
+      if (!flow.sealed.empty()) {
+        on_sealed(flow.sealed.front());
+        flow.sealed.pop_front();
+      } else {
+        auto& queue = next_queue(flow);
+        gone = !on_session(session_id, queue.front());
+        queue.pop_front();
+      }
+      flow.queued_bytes -= size;
+      stats_.queued_bytes -= size;
+      flow.deficit -= size;
+      ++handed;
+      ++stats_.packets_dequeued;
+      if (gone) {
+        discard_queue(flow);
+        break;
+      }
+    }
+
+    if (flow_empty(flow)) {
+      active_.pop_front();
+      if (gone || !flow.quota) {
+        flows_.erase(session_id);
+      } else {
+        flow.active = false;
+        flow.turn_started = false;
+        flow.deficit = 0;
+      }
+      throttled_streak = 0;
+      continue;
+    }
+
+    if (!throttled && next_size(flow) <= flow.deficit) {
+      // Out of packet budget mid-turn; the next drain resumes here.
+      break;
+    }
+
+    if (throttled) {
+      ++stats_.throttled_turns;
+      ++throttled_streak;
+      // A throttled session must not bank credit for a later burst.
+      flow.deficit = std::min(flow.deficit, config_.quantum_bytes);
+    } else {
+      throttled_streak = 0;
+    }
+    flow.turn_started = false;
+    active_.pop_front();
+    active_.push_back(session_id);
+  }
+  return handed;
+}
+
+std::size_t EgressScheduler::prune(const std::function<bool(std::uint64_t session_id)>& is_gone) {
+  std::size_t removed = 0;
+  for (auto it = flows_.begin(); it != flows_.end();) {
+    if (!is_gone(it->first)) {
+      ++it;
+      continue;
+    }
+    discard_queue(it->second);
+    if (it->second.active) {
+      active_.erase(std::find(active_.begin(), active_.end(), it->first));
+    }
+    it = flows_.erase(it);
+    ++removed;
+  }
+  return removed;
+}
+
+std::size_t EgressScheduler::queued_bytes(std::uint64_t session_id) const {
+  const auto it = flows_.find(session_id);
+  return it == flows_.end() ? 0 : it->second.queued_bytes;
+}
+
+}  // namespace veil::server
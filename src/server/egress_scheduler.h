@@ -0,0 +1,144 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "common/utils/advanced_rate_limiter.h"
+#include "transport/udp_socket/udp_socket.h"
+
+namespace veil::server {
+
+struct EgressSchedulerConfig {
+  // Bytes each backlogged session may send per round-robin turn.
+  std::size_t quantum_bytes{1500};
+  // Per-session queue cap; packets beyond it are dropped at enqueue.
+  std::size_t max_queue_bytes{static_cast<std::size_t>(256) * 1024};
+  // Packets handed to one sendmmsg call.
+  std::size_t batch_size{32};
+  // Cap on the priority FIFO, in packets; control packets beyond it are
+  // dropped at enqueue.
+  std::size_t max_priority_packets{256};
+  // Per-session byte quota. Only bandwidth_bytes_per_sec and
+  // burst_allowance_factor apply; empty disables shaping.
+  std::optional<utils::RateLimiterConfig> session_rate_limit;
+};
+
+struct EgressStats {
+  std::uint64_t packets_enqueued{0};
+  std::uint64_t packets_dropped{0};
+  std::uint64_t priority_packets_sent{0};
+  std::uint64_t priority_packets_dropped{0};
+  std::uint64_t packets_dequeued{0};
+  std::uint64_t throttled_turns{0};
+  std::size_t queued_bytes{0};
+};
+
+/**
+ * Server egress scheduler: per-session queues drained by deficit round
+ * robin, ahead of which a small, bounded strict-priority FIFO carries
+ * already-encrypted control traffic (flow-control frames).
+ *
+ * Session queues hold plaintext; the caller encrypts in the drain handler,
+ * so a bulk session gets its fair share of crypto work as well as of the
+ * socket. Packets a session has already sealed (retransmissions, FEC
+ * repairs) go to the head of that session's own queue: they are sent first
+ * within its turns but count against its quantum, queue cap and quota like
+ * any other packet. With session_rate_limit set, each session also has a token bucket
+ * and is skipped for the turn when it is out of tokens. Shaping delays
+ * packets rather than penalising the session.
+ *
+ * Thread Safety:
+ *   This class is NOT thread-safe. It is owned by the ServerDataPlane and
+ *   used from the server loop thread.
+ *
+ * @see docs/thread_model.md for the VEIL threading model documentation.
+ */
+class EgressScheduler {
+ public:
+  using Clock = std::chrono::steady_clock;
+  // Called with each already-encrypted packet, priority or per-session.
+  using SealedHandler = std::function<void(transport::UdpPacket& packet)>;
+  // Called with each dequeued session packet. Return false if the session
+  // is gone; its remaining queue is then discarded.
+  using SessionHandler = std::function<bool(std::uint64_t session_id,
+                                            std::span<const std::uint8_t> packet)>;
+
+  explicit EgressScheduler(EgressSchedulerConfig config = {},
+                           std::function<Clock::time_point()> now_fn = Clock::now);
+
+  // Queue a packet for a session. Interactive packets are sent ahead of the
+  // session's other queued packets, within its own turns, so they cannot
+  // take bandwidth from other sessions. Returns false if the packet was
+  // dropped because the session's queue is full.
+  bool enqueue(std::uint64_t session_id, std::vector<std::uint8_t> packet,
+               bool interactive = false);
+
+  // Queue an already-encrypted packet for a session, ahead of its plaintext
+  // packets. Returns false if the session's queue is full.
+  bool enqueue_sealed(std::uint64_t session_id, transport::UdpPacket packet);
+
+  // Queue a control packet ahead of all session traffic. Returns false if
+  // the priority FIFO is full.
+  bool enqueue_priority(transport::UdpPacket packet);
+
+  // Hand up to max_packets packets to the handlers: all priority packets
+  // first, then session packets in DRR order. Returns the number handed out.
+  std::size_t drain(std::size_t max_packets, const SealedHandler& on_sealed,
+                    const SessionHandler& on_session);
+
+  // Forget sessions for which `is_gone` returns true, with their queues and
+  // quota state. Returns the number removed.
+  std::size_t prune(const std::function<bool(std::uint64_t session_id)>& is_gone);
+
+  bool empty() const { return priority_.empty() && active_.empty(); }
+  std::size_t queued_bytes(std::uint64_t session_id) const;
+  const EgressStats& stats() const { return stats_; }
+  const EgressSchedulerConfig& config() const { return config_; }
+
+ private:
+  struct Flow {
+    std::deque<transport::UdpPacket> sealed;
+    std::deque<std::vector<std::uint8_t>> interactive;
+    std::deque<std::vector<std::uint8_t>> queue;
+    std::size_t queued_bytes{0};
+    std::size_t deficit{0};
+    // Whether the flow is in active_.
+    bool active{false};
+    // Whether the current turn's quantum has been added to deficit.
+    bool turn_started{false};
+    std::optional<utils::BurstTokenBucket> quota;
+  };
+
+  Flow& flow_for(std::uint64_t session_id);
+  static bool flow_empty(const Flow& flow) {
+    return flow.sealed.empty() && flow.interactive.empty() && flow.queue.empty();
+  }
+  // The plaintext sub-queue the flow sends from next.
+  static std::deque<std::vector<std::uint8_t>>& next_queue(Flow& flow) {
+    return flow.interactive.empty() ? flow.queue : flow.interactive;
+  }
+  // Size of the packet the flow sends next; the flow must not be empty.
+  static std::size_t next_size(Flow& flow) {
+    return flow.sealed.empty() ? next_queue(flow).front().size() : flow.sealed.front().data.size();
+  }
+  // Accounts for a packet queued on `flow`; false if it does not fit.
+  bool admit(std::uint64_t session_id, Flow& flow, std::size_t size);
+  void discard_queue(Flow& flow);
+
+  EgressSchedulerConfig config_;
+  std::function<Clock::time_point()> now_fn_;
+  std::unordered_map<std::uint64_t, Flow> flows_;
+  // Sessions with queued packets, in round-robin order.
+  std::deque<std::uint64_t> active_;
+  std::deque<transport::UdpPacket> priority_;
+  EgressStats stats_;
+};
+
+}  // namespace veil::server
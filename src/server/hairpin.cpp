@@ -0,0 +1,45 @@
+#include "server/hairpin.h"
+
+namespace veil::server {
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+  const auto first = text.find_first_not_of(" \t");
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  const auto last = text.find_last_not_of(" \t");
+  return text.substr(first, last - first + 1);
+}
+
+}  // namespace
+
+bool hairpin_allowed(const HairpinConfig& config, std::uint32_t source,
+                     std::uint32_t destination) {
+  for (const auto& rule : config.rules) {
+    if (rule.source.contains(source) && rule.destination.contains(destination)) {
+      return rule.allow;
+    }
+  }
+  return config.default_allow;
+}
+
+std::optional<HairpinRule> parse_hairpin_rule(std::string_view text) {
+  const auto arrow = text.find('>');
+  if (arrow == std::string_view::npos) {
+    return std::nullopt;
+  }
+  auto left = text.substr(0, arrow);
+  if (!left.empty() && left.back() == '-') {
+    left.remove_suffix(1);
+  }
+  const auto source = tun::parse_ipv4_prefix(trim(left));
+  const auto destination = tun::parse_ipv4_prefix(trim(text.substr(arrow + 1)));
+  if (!source || !destination) {
+    return std::nullopt;
+  }
+  return HairpinRule{*source, *destination, true};
+}
+
+}  // namespace veil::server
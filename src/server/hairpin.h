@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "tun/ip_packet.h"
+
+namespace veil::server {
+
+// One hairpin ACL entry: packets from `source` to `destination` are
+// forwarded if `allow`, dropped otherwise.
+struct HairpinRule {
+  tun::Ipv4Prefix source;
+  tun::Ipv4Prefix destination;
+  bool allow{true};
+};
+
+// Client-to-client ("hairpin") forwarding on the server.
+struct HairpinConfig {
+  // Forward packets addressed to another client straight to its egress
+  // queue. When false they go out through the TUN device and come back in
+  // like any other packet, subject to the host's forwarding rules. Off by
+  // default: hairpinned packets bypass the host firewall, so enabling it
+  // drops any client isolation done with iptables on the TUN interface.
+  bool enabled{false};
+  // Checked in order; the first rule matching both addresses decides.
+  std::vector<HairpinRule> rules;
+  // Decision when no rule matches.
+  bool default_allow{true};
+};
+
+// Whether a hairpin packet from `source` to `destination` (host byte order)
+// may be forwarded.
+bool hairpin_allowed(const HairpinConfig& config, std::uint32_t source,
+                     std::uint32_t destination);
+
+// Parse "SRC>DST" or "SRC->DST", each side a prefix as accepted by
+// tun::parse_ipv4_prefix. The rule's action is left to the caller.
+std::optional<HairpinRule> parse_hairpin_rule(std::string_view text);
+
+}  // namespace veil::server
@@ -1,5 +1,3 @@
-#include <arpa/inet.h>
-
 #include <array>
 #include <cstdlib>
 #include <fstream>
@@ -12,11 +10,12 @@
 #include "common/daemon/daemon.h"
 #include "common/handshake/handshake_processor.h"
 #include "common/logging/logger.h"
+#include "common/metrics/metrics.h"
 #include "common/signal/signal_handler.h"
 #include "common/utils/rate_limiter.h"
+#include "server/data_plane.h"
 #include "server/server_config.h"
 #include "server/session_table.h"
-#include "transport/mux/frame.h"
 #include "transport/session/transport_session.h"
 #include "transport/udp_socket/udp_socket.h"
 #include "tun/routing.h"
@@ -25,14 +24,8 @@
 using namespace veil;
 
 namespace {
-constexpr std::size_t kMaxPacketSize = 65535;
-
 // Statistics for display
 struct ServerStats {
-  std::atomic<uint64_t> total_bytes_sent{0};
-  std::atomic<uint64_t> total_bytes_received{0};
-  std::atomic<uint64_t> total_packets_sent{0};
-  std::atomic<uint64_t> total_packets_received{0};
   std::atomic<uint64_t> connections_total{0};
   std::atomic<uint64_t> connections_active{0};
   std::chrono::steady_clock::time_point start_time;
@@ -64,14 +57,6 @@ void log_signal_sigterm() {
   cli::print_warning("Received termination signal, initiating graceful shutdown...");
 }
 
-void log_tun_write_error(const std::error_code& ec) {
-  LOG_ERROR("Failed to write to TUN: {}", ec.message());
-}
-
-void log_handshake_send_error(const std::error_code& ec) {
-  LOG_ERROR("Failed to send handshake response: {}", ec.message());
-}
-
 void log_new_client(const std::string& host, std::uint16_t port, std::uint64_t session_id) {
   LOG_INFO("New client connected from {}:{}, session {}", host, port, session_id);
 
@@ -111,14 +96,6 @@ void log_client_disconnected(const std::string& host, std::uint16_t port,
   }
 }
 
-void log_packet_received([[maybe_unused]] std::size_t size,
-                         [[maybe_unused]] const std::string& host,
-                         [[maybe_unused]] std::uint16_t port) {
-  LOG_DEBUG("Received {} bytes from {}:{}", size, host, port);
-  g_stats.total_packets_received++;
-  g_stats.total_bytes_received += size;
-}
-
 void print_configuration(const server::ServerConfig& config) {
   cli::print_section("Server Configuration");
   cli::print_row("Listen Address", config.listen_address + ":" + std::to_string(config.listen_port));
@@ -136,7 +113,16 @@ void print_configuration(const server::ServerConfig& config) {
   std::cout << '\n';
 }
 
-void print_server_status(std::size_t max_clients) {
+// Publish session memory to the metrics registry.
+void publish_session_memory(const utils::MemoryFootprint& memory) {
+  auto& registry = metrics::get_registry();
+  registry.gauge("server_session_memory_reserved_bytes").set(static_cast<double>(memory.reserved));
+  registry.gauge("server_session_memory_in_use_bytes").set(static_cast<double>(memory.in_use));
+  registry.gauge("server_session_memory_limit_bytes").set(static_cast<double>(memory.limit));
+}
+
+void print_server_status(std::size_t max_clients, const server::DataPlaneStats& traffic,
+                         const utils::MemoryFootprint& memory) {
   auto now = std::chrono::steady_clock::now();
   auto uptime_seconds = std::chrono::duration_cast<std::chrono::seconds>(now - g_stats.start_time).count();
 
@@ -146,10 +132,12 @@ void print_server_status(std::size_t max_clients) {
   cli::print_row("Active Clients", std::to_string(g_stats.connections_active.load()) + "/" +
                                        std::to_string(max_clients));
   cli::print_row("Total Connections", std::to_string(g_stats.connections_total.load()));
-  cli::print_row("Bytes Sent", cli::format_bytes(g_stats.total_bytes_sent.load()));
-  cli::print_row("Bytes Received", cli::format_bytes(g_stats.total_bytes_received.load()));
-  cli::print_row("Packets Sent", std::to_string(g_stats.total_packets_sent.load()));
-  cli::print_row("Packets Received", std::to_string(g_stats.total_packets_received.load()));
+  cli::print_row("Bytes Sent", cli::format_bytes(traffic.udp_bytes_sent));
+  cli::print_row("Bytes Received", cli::format_bytes(traffic.udp_bytes_received));
+  cli::print_row("Packets Sent", std::to_string(traffic.udp_packets_sent));
+  cli::print_row("Packets Received", std::to_string(traffic.udp_packets_received));
+  cli::print_row("Session Memory", cli::format_bytes(memory.reserved) + " reserved, " +
+                                       cli::format_bytes(memory.in_use) + " buffered");
   std::cout << '\n';
 }
 
@@ -283,6 +271,13 @@ int main(int argc, char* argv[]) {
     LOG_ERROR("Failed to open UDP socket: {}", ec.message());
     return EXIT_FAILURE;
   }
+  if (config.tunnel.ecn && !udp_socket.enable_ecn(ec)) {
+    // Without CE reports, outer ECT would hide congestion; send Not-ECT.
+    LOG_WARN("ECN unavailable on UDP socket: {}", ec.message());
+  }
+  if (config.udp_gso && !udp_socket.enable_gso(ec)) {
+    LOG_WARN("UDP GSO unavailable, sending datagrams one by one: {}", ec.message());
+  }
   cli::print_success("Listening on " + config.listen_address + ":" +
                      std::to_string(config.listen_port));
   LOG_INFO("Listening on {}:{}", config.listen_address, config.listen_port);
@@ -334,101 +329,21 @@ int main(int argc, char* argv[]) {
   LOG_INFO("Server running, accepting connections...");
 
   // Main server loop
-  std::array<std::uint8_t, kMaxPacketSize> buffer{};
+  server::ServerDataPlane data_plane(tun_device, udp_socket, session_table, responder,
+                                     config.tunnel.transport, config.egress, config.tunnel.streams,
+                                     config.hairpin, config.routes, config.tunnel.crypto_workers);
+  data_plane.on_new_session([](const server::ClientSession& session) {
+    log_new_client(session.endpoint.host, session.endpoint.port, session.session_id);
+  });
 
   while (running.load() && !sig_handler.should_terminate()) {
-    // Poll UDP socket
-    udp_socket.poll(
-        [&](const transport::UdpPacket& pkt) {
-          log_packet_received(pkt.data.size(), pkt.remote.host, pkt.remote.port);
-
-          // Check if this is from an existing session
-          auto* session = session_table.find_by_endpoint(pkt.remote);
-
-          if (session != nullptr) {
-            // Process data from existing session
-            session_table.update_activity(session->session_id);
-            session->packets_received++;
-            session->bytes_received += pkt.data.size();
-
-            if (session->transport) {
-              auto frames = session->transport->decrypt_packet(pkt.data);
-              if (frames) {
-                for (const auto& frame : *frames) {
-                  if (frame.kind == mux::FrameKind::kData) {
-                    // Write to TUN device
-                    if (!tun_device.write(frame.data.payload, ec)) {
-                      log_tun_write_error(ec);
-                    }
-                  } else if (frame.kind == mux::FrameKind::kAck) {
-                    session->transport->process_ack(frame.ack);
-                  }
-                }
-              }
-            }
-          } else {
-            // New connection - handle handshake
-            auto hs_result = responder.handle_init(pkt.data);
-            if (hs_result) {
-              if (!udp_socket.send(hs_result->response, pkt.remote, ec)) {
-                log_handshake_send_error(ec);
-              } else {
-                // Create transport session
-                auto transport = std::make_unique<transport::TransportSession>(
-                    hs_result->session, config.tunnel.transport);
-
-                // Create client session
-                auto session_id = session_table.create_session(pkt.remote, std::move(transport));
-                if (session_id) {
-                  log_new_client(pkt.remote.host, pkt.remote.port, *session_id);
-                }
-              }
-            }
-          }
-        },
-        10, ec);
-
-    // Read from TUN and route to appropriate client
-    auto tun_read = tun_device.read_into(buffer, ec);
-    if (tun_read > 0) {
-      // Parse IP header to find destination
-      if (tun_read >= 20) {
-        // Extract destination IP from IPv4 header (bytes 16-19)
-        std::uint32_t dst_ip = (static_cast<std::uint32_t>(buffer[16]) << 24) |
-                               (static_cast<std::uint32_t>(buffer[17]) << 16) |
-                               (static_cast<std::uint32_t>(buffer[18]) << 8) |
-                               static_cast<std::uint32_t>(buffer[19]);
-
-        // Convert to string
-        char ip_str[INET_ADDRSTRLEN];
-        struct in_addr addr {};
-        addr.s_addr = htonl(dst_ip);
-        inet_ntop(AF_INET, &addr, ip_str, sizeof(ip_str));
-
-        // Find session by tunnel IP
-        auto* session = session_table.find_by_tunnel_ip(ip_str);
-        if (session != nullptr && session->transport) {
-          // Encrypt and send
-          auto packets = session->transport->encrypt_data(
-              std::span<const std::uint8_t>(buffer.data(), static_cast<std::size_t>(tun_read)));
-          for (const auto& pkt : packets) {
-            if (!udp_socket.send(pkt, session->endpoint, ec)) {
-              LOG_ERROR("Failed to send to client: {}", ec.message());
-            } else {
-              session->packets_sent++;
-              session->bytes_sent += pkt.size();
-              g_stats.total_packets_sent++;
-              g_stats.total_bytes_sent += pkt.size();
-            }
-          }
-        }
-      }
-    }
+    data_plane.poll_once(10);
 
     // Periodic session cleanup
     auto now = std::chrono::steady_clock::now();
     if (now - last_cleanup >= config.cleanup_interval) {
       auto expired = session_table.cleanup_expired();
+      data_plane.prune_egress();
       if (expired > 0) {
         if (g_stats.connections_active >= expired) {
           g_stats.connections_active -= expired;
@@ -438,26 +353,25 @@ int main(int argc, char* argv[]) {
         cli::print_info("Cleaned up " + std::to_string(expired) + " expired session(s)");
         LOG_INFO("Cleaned up {} expired sessions", expired);
       }
+      if (config.hibernate_after.count() > 0) {
+        const auto hibernated = session_table.hibernate_idle(config.hibernate_after);
+        if (hibernated > 0) {
+          LOG_DEBUG("Hibernated {} idle sessions", hibernated);
+        }
+      }
+      session_table.refresh_buffer_limits();
+      const auto memory = session_table.memory_footprint();
+      publish_session_memory(memory);
+      LOG_DEBUG("Session memory: {} bytes reserved, {} in use, {} worst case",
+                memory.reserved, memory.in_use, memory.limit);
       last_cleanup = now;
     }
 
     // Periodic stats display (every 60 seconds in verbose mode)
     if (config.verbose && (now - last_stats >= std::chrono::seconds(60))) {
-      print_server_status(config.max_clients);
+      print_server_status(config.max_clients, data_plane.stats(), session_table.memory_footprint());
       last_stats = now;
     }
-
-    // Process retransmits for all sessions
-    for (auto* session : session_table.get_all_sessions()) {
-      if (session->transport) {
-        auto retransmits = session->transport->get_retransmit_packets();
-        for (const auto& pkt : retransmits) {
-          if (!udp_socket.send(pkt, session->endpoint, ec)) {
-            LOG_WARN("Failed to retransmit to client: {}", ec.message());
-          }
-        }
-      }
-    }
   }
 
   // Cleanup
@@ -469,7 +383,7 @@ int main(int argc, char* argv[]) {
 
   // Print final stats
   if (!config.daemon_mode) {
-    print_server_status(config.max_clients);
+    print_server_status(config.max_clients, data_plane.stats(), session_table.memory_footprint());
   }
 
   cli::print_success("VEIL Server stopped gracefully");
@@ -0,0 +1,264 @@
+#include "server/route_table.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace veil::server {
+
+namespace {
+
+constexpr std::size_t kRootBits = 16;
+constexpr std::size_t kChunkBits = 8;
+
+// First address bit a level indexes: the root takes 16 bits, each chunk
+// level one byte.
+constexpr std::size_t level_start(std::size_t level) {
+  return level == 0 ? 0 : kRootBits + (level - 1) * kChunkBits;
+}
+
+constexpr std::size_t level_end(std::size_t level) {
+  return level == 0 ? kRootBits : level_start(level) + kChunkBits;
+}
+
+std::size_t level_index(const std::array<std::uint8_t, 16>& address, std::size_t level) {
+  if (level == 0) {
+    return (static_cast<std::size_t>(address[0]) << 8) | address[1];
+  }
+  return address[level + 1];
+}
+
+std::array<std::uint8_t, 16> masked(std::array<std::uint8_t, 16> address, std::size_t length) {
+  for (std::size_t bit = length; bit < address.size() * 8; ++bit) {
+    address[bit / 8] &= static_cast<std::uint8_t>(~(0x80U >> (bit % 8)));
+  }
+  return address;
+}
+
+}  // namespace
+
+void RouteTable::insert(const tun::IpPrefix& prefix, std::uint64_t target) {
+  (prefix.version == 6 ? v6_ : v4_).insert(prefix, target);
+}
+
+bool RouteTable::erase(const tun::IpPrefix& prefix) {
+  return (prefix.version == 6 ? v6_ : v4_).erase(prefix);
+}
+
+std::optional<std::uint64_t> RouteTable::find(const tun::IpPrefix& prefix) const {
+  return (prefix.version == 6 ? v6_ : v4_).find(prefix);
+}
+
+std::optional<std::uint64_t> RouteTable::find_overlap(const tun::IpPrefix& prefix,
+                                                      std::uint64_t except) const {
+  return (prefix.version == 6 ? v6_ : v4_).find_overlap(prefix, except);
+}
+
+std::optional<std::uint64_t> RouteTable::lookup(std::span<const std::uint8_t> address) const {
+  if (address.size() == 4) {
+    return v4_.lookup(address);
+  }
+  if (address.size() == 16) {
+    return v6_.lookup(address);
+  }
+  return std::nullopt;
+}
+
+utils::MemoryFootprint RouteTable::memory_footprint() const {
+  return v4_.memory_footprint() + v6_.memory_footprint();
+}
+
+void RouteTable::Trie::insert(const tun::IpPrefix& prefix, std::uint64_t target) {
+  const Key key{masked(prefix.address, prefix.length), prefix.length};
+  auto [it, inserted] = rules_.try_emplace(key, 0);
+  if (!inserted) {
+    // Its slots already refer to the route index.
+    targets_[it->second - 1] = target;
+    return;
+  }
+  if (free_targets_.empty()) {
+    targets_.push_back(target);
+    it->second = static_cast<std::uint32_t>(targets_.size());
+  } else {
+    it->second = free_targets_.back() + 1;
+    free_targets_.pop_back();
+    targets_[it->second - 1] = target;
+  }
+
+  if (root_.empty()) {
+    root_.resize(std::size_t{1} << kRootBits);
+  }
+  assert(it->second <= kMaxSlotValue && "route index overflows a 24-bit slot");
+  const auto leaf = make_slot(it->second, prefix.length);
+  const auto length = prefix.length;
+  paint(0, 0, key, leaf, [length](const Slot& slot) { return slot.depth <= length; });
+}
+
+bool RouteTable::Trie::erase(const tun::IpPrefix& prefix) {
+  const Key key{masked(prefix.address, prefix.length), prefix.length};
+  const auto it = rules_.find(key);
+  if (it == rules_.end()) {
+    return false;
+  }
+  const auto value = it->second;
+  rules_.erase(it);
+
+  if (rules_.empty()) {
+    // Give the first level back too.
+    root_ = std::vector<Slot>();
+    chunks_ = std::vector<Slot>();
+    free_chunks_ = std::vector<std::uint32_t>();
+    targets_ = std::vector<std::uint64_t>();
+    free_targets_ = std::vector<std::uint32_t>();
+    return true;
+  }
+
+  paint(0, 0, key, covering_leaf(key), [value](const Slot& slot) { return slot.value == value; });
+  free_targets_.push_back(value - 1);
+  return true;
+}
+
+std::optional<std::uint64_t> RouteTable::Trie::find(const tun::IpPrefix& prefix) const {
+  const auto it = rules_.find(Key{masked(prefix.address, prefix.length), prefix.length});
+  if (it == rules_.end()) {
+    return std::nullopt;
+  }
+  return targets_[it->second - 1];
+}
+
+std::optional<std::uint64_t> RouteTable::Trie::find_overlap(const tun::IpPrefix& prefix,
+                                                            std::uint64_t except) const {
+  const auto base = masked(prefix.address, prefix.length);
+  // Rules covering the prefix: one candidate per shorter or equal length.
+  for (std::size_t length = 0; length <= prefix.length; ++length) {
+    const auto it =
+        rules_.find(Key{masked(base, length), static_cast<std::uint8_t>(length)});
+    if (it != rules_.end() && targets_[it->second - 1] != except) {
+      return targets_[it->second - 1];
+    }
+  }
+  // Rules within it: keys are ordered by address, so they follow the
+  // prefix itself up to its last address.
+  auto last = base;
+  for (std::size_t bit = prefix.length; bit < address_size_ * 8; ++bit) {
+    last[bit / 8] |= static_cast<std::uint8_t>(0x80U >> (bit % 8));
+  }
+  for (auto it = rules_.upper_bound(Key{base, prefix.length});
+       it != rules_.end() && it->first.first <= last; ++it) {
+    if (targets_[it->second - 1] != except) {
+      return targets_[it->second - 1];
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<std::uint64_t> RouteTable::Trie::lookup(std::span<const std::uint8_t> address) const {
+  if (root_.empty() || address.size() != address_size_) {
+    return std::nullopt;
+  }
+  const Slot* slot = &root_[(static_cast<std::size_t>(address[0]) << 8) | address[1]];
+  // Chunks exist only above routes longer than their level, so the walk
+  // ends within the address.
+  for (std::size_t byte = 2; slot->child(); ++byte) {
+    slot = &chunks_[static_cast<std::size_t>(slot->value) * kChunkSlots + address[byte]];
+  }
+  if (slot->value == 0) {
+    return std::nullopt;
+  }
+  return targets_[slot->value - 1];
+}
+
+utils::MemoryFootprint RouteTable::Trie::memory_footprint() const {
+  utils::MemoryFootprint footprint;
+  footprint.reserved = (root_.capacity() + chunks_.capacity()) * sizeof(Slot) +
+                       rules_.size() * utils::container_node_bytes<decltype(rules_)>() +
+                       targets_.capacity() * sizeof(std::uint64_t) +
+                       (free_chunks_.capacity() + free_targets_.capacity()) * sizeof(std::uint32_t);
+  return footprint;
+}
+
+template <typename Replace>
+void RouteTable::Trie::paint(std::size_t level, std::uint32_t chunk, const Key& prefix,
+                             const Slot& leaf, const Replace& replace) {
+  // Slots move when a chunk is allocated, so they are looked up by index.
+  const auto slot_at = [this, level, chunk](std::size_t index) -> Slot& {
+    return level == 0 ? root_[index]
+                      : chunks_[static_cast<std::size_t>(chunk) * kChunkSlots + index];
+  };
+  const auto& [address, length] = prefix;
+  const std::size_t end = level_end(level);
+  const std::size_t index = level_index(address, level);
+
+  if (length <= end) {
+    // The prefix ends at this level: it covers a run of slots.
+    const std::size_t count = std::size_t{1} << (end - length);
+    const std::size_t first = index & ~(count - 1);
+    for (std::size_t i = first; i < first + count; ++i) {
+      const Slot slot = slot_at(i);
+      if (slot.child()) {
+        paint_all(slot.value, leaf, replace);
+      } else if (replace(slot)) {
+        slot_at(i) = leaf;
+      }
+    }
+    return;
+  }
+
+  if (!slot_at(index).child()) {
+    // The new chunk starts out inheriting the slot it replaces.
+    const auto created = allocate_chunk(slot_at(index));
+    slot_at(index) = make_slot(created, kChild);
+  }
+  const auto child = slot_at(index).value;
+  paint(level + 1, child, prefix, leaf, replace);
+  if (inherited_only(child, end)) {
+    slot_at(index) = chunks_[static_cast<std::size_t>(child) * kChunkSlots];
+    free_chunks_.push_back(child);
+  }
+}
+
+template <typename Replace>
+void RouteTable::Trie::paint_all(std::uint32_t chunk, const Slot& leaf, const Replace& replace) {
+  for (std::size_t i = 0; i < kChunkSlots; ++i) {
+    auto& slot = chunks_[static_cast<std::size_t>(chunk) * kChunkSlots + i];
+    if (slot.child()) {
+      paint_all(slot.value, leaf, replace);
+    } else if (replace(slot)) {
+      slot = leaf;
+    }
+  }
+}
+
+std::uint32_t RouteTable::Trie::allocate_chunk(const Slot& fill) {
+  std::uint32_t chunk = 0;
+  if (free_chunks_.empty()) {
+    chunk = static_cast<std::uint32_t>(chunks_.size() / kChunkSlots);
+    assert(chunk <= kMaxSlotValue && "chunk index overflows a 24-bit slot");
+    chunks_.resize(chunks_.size() + kChunkSlots, fill);
+  } else {
+    chunk = free_chunks_.back();
+    free_chunks_.pop_back();
+    std::fill_n(chunks_.begin() + static_cast<std::ptrdiff_t>(chunk * kChunkSlots), kChunkSlots,
+                fill);
+  }
+  return chunk;
+}
+
+bool RouteTable::Trie::inherited_only(std::uint32_t chunk, std::size_t start_bit) const {
+  const auto first = chunks_.begin() + static_cast<std::ptrdiff_t>(chunk * kChunkSlots);
+  return std::all_of(first, first + kChunkSlots, [start_bit](const Slot& slot) {
+    return !slot.child() && slot.depth <= start_bit;
+  });
+}
+
+RouteTable::Trie::Slot RouteTable::Trie::covering_leaf(const Key& prefix) const {
+  for (std::size_t length = prefix.second; length-- > 0;) {
+    const auto it =
+        rules_.find(Key{masked(prefix.first, length), static_cast<std::uint8_t>(length)});
+    if (it != rules_.end()) {
+      return make_slot(it->second, static_cast<std::uint32_t>(length));
+    }
+  }
+  return Slot{};
+}
+
+}  // namespace veil::server
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "common/utils/memory_footprint.h"
+#include "tun/ip_packet.h"
+
+namespace veil::server {
+
+// Subnets clients may have routed to them.
+struct RouteConfig {
+  // A subnet a client announces is installed only if it lies within one of
+  // these. Empty accepts none.
+  std::vector<tun::IpPrefix> allowed;
+  // Most subnets installed per client; the rest of an announcement is
+  // ignored.
+  std::size_t max_per_client{16};
+};
+
+/**
+ * Longest-prefix-match table from IPv4 and IPv6 prefixes to session IDs.
+ *
+ * Each family is a multibit trie with controlled prefix expansion, laid
+ * out like DIR-24-8 but with smaller strides: a 2^16-slot first level
+ * indexed by the top 16 address bits, then 256-slot chunks per further
+ * address byte. A prefix is copied into every slot it covers that no
+ * longer prefix holds, so a lookup is one load per level and stops at the
+ * first leaf, with no comparisons: one or two loads for tunnel addresses
+ * and subnets up to /24, at most 3 for IPv4 and 15 for IPv6, however many
+ * routes are installed.
+ *
+ * Changes rewrite only the slots a prefix covers. A removed prefix's
+ * slots fall back to the next shorter prefix covering them, and chunks
+ * left with nothing of their own are freed. A family costs 256 KiB for its
+ * first level once it has a route, plus 1 KiB per chunk. Routes of /17 to
+ * /24 need a chunk per distinct /16 they fall in, longer ones one more per
+ * distinct /24: a worst case of 2 KiB for each IPv4 host route in its own
+ * /16, and 1 KiB per level for IPv6.
+ *
+ * Thread Safety:
+ *   This class is NOT thread-safe. SessionTable guards it with its mutex.
+ */
+class RouteTable {
+ public:
+  // Route `prefix` to `target`, replacing any target it had.
+  void insert(const tun::IpPrefix& prefix, std::uint64_t target);
+
+  // Remove `prefix`. Returns false if it was not in the table.
+  bool erase(const tun::IpPrefix& prefix);
+
+  // Target of exactly `prefix`.
+  std::optional<std::uint64_t> find(const tun::IpPrefix& prefix) const;
+
+  // A target other than `except` with a prefix that covers `prefix` or
+  // lies within it, if any.
+  std::optional<std::uint64_t> find_overlap(const tun::IpPrefix& prefix,
+                                            std::uint64_t except) const;
+
+  // Target of the longest prefix containing `address`: 4 bytes for IPv4,
+  // 16 for IPv6, as returned by tun::destination_address().
+  std::optional<std::uint64_t> lookup(std::span<const std::uint8_t> address) const;
+
+  // Number of prefixes.
+  std::size_t size() const { return v4_.size() + v6_.size(); }
+
+  utils::MemoryFootprint memory_footprint() const;
+
+ private:
+  class Trie {
+   public:
+    explicit Trie(std::size_t address_size) : address_size_(address_size) {}
+
+    void insert(const tun::IpPrefix& prefix, std::uint64_t target);
+    bool erase(const tun::IpPrefix& prefix);
+    std::optional<std::uint64_t> find(const tun::IpPrefix& prefix) const;
+    std::optional<std::uint64_t> find_overlap(const tun::IpPrefix& prefix,
+                                              std::uint64_t except) const;
+    std::optional<std::uint64_t> lookup(std::span<const std::uint8_t> address) const;
+    std::size_t size() const { return rules_.size(); }
+    utils::MemoryFootprint memory_footprint() const;
+
+   private:
+    static constexpr std::size_t kChunkSlots = 256;
+
+    // 4 bytes, so a 256-slot chunk is 1 KiB.
+    struct Slot {
+      // Leaf: route index + 1, 0 for no route. Child: chunk index.
+      std::uint32_t value : 24 = 0;
+      // Length of the prefix a leaf was expanded from; kChild for a child.
+      std::uint32_t depth : 8 = 0;
+
+      bool child() const { return depth == kChild; }
+    };
+    static constexpr std::uint32_t kChild = 0xFF;
+    // Largest route index + 1 or chunk index a slot can hold.
+    static constexpr std::uint32_t kMaxSlotValue = (std::uint32_t{1} << 24) - 1;
+
+    // Pack a slot; `value` must not exceed kMaxSlotValue nor `depth` kChild.
+    static Slot make_slot(std::uint32_t value, std::uint32_t depth) {
+      Slot slot;
+      slot.value = value & kMaxSlotValue;
+      slot.depth = depth & kChild;
+      return slot;
+    }
+
+    using Key = std::pair<std::array<std::uint8_t, 16>, std::uint8_t>;
+
+    // Write `leaf` into the slots `prefix` covers at `level` (in `chunk`
+    // below the root) where `replace` holds, creating chunks on the way
+    // down and freeing those left without routes of their own.
+    template <typename Replace>
+    void paint(std::size_t level, std::uint32_t chunk, const Key& prefix, const Slot& leaf,
+               const Replace& replace);
+    // The same for every slot of a chunk and the chunks below it.
+    template <typename Replace>
+    void paint_all(std::uint32_t chunk, const Slot& leaf, const Replace& replace);
+
+    std::uint32_t allocate_chunk(const Slot& fill);
+    // Whether a chunk whose level starts at `start_bit` holds only slots
+    // inherited from above it.
+    bool inherited_only(std::uint32_t chunk, std::size_t start_bit) const;
+
+    // The longest rule strictly shorter than `prefix` that covers it, as a
+    // leaf; an empty slot if there is none.
+    Slot covering_leaf(const Key& prefix) const;
+
+    std::size_t address_size_;
+    std::vector<Slot> root_;
+    std::vector<Slot> chunks_;
+    std::vector<std::uint32_t> free_chunks_;
+    // Installed prefixes (masked address, length) and their route index + 1.
+    std::map<Key, std::uint32_t> rules_;
+    std::vector<std::uint64_t> targets_;
+    std::vector<std::uint32_t> free_targets_;
+  };
+
+  Trie v4_{4};
+  Trie v6_{16};
+};
+
+}  // namespace veil::server
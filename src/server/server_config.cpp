@@ -42,6 +42,22 @@ bool parse_ini_value(const std::string& line, std::string& key, std::string& val
   return !key.empty();
 }
 
+// Append the comma-separated hairpin rules in `value` with action `allow`.
+bool parse_hairpin_rules(const std::string& value, bool allow, HairpinConfig& config) {
+  std::stringstream stream(value);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    auto rule = parse_hairpin_rule(item);
+    if (!rule) {
+      LOG_ERROR("Invalid hairpin rule '{}', expected SRC->DST", item);
+      return false;
+    }
+    rule->allow = allow;
+    config.rules.push_back(*rule);
+  }
+  return true;
+}
+
 std::string get_current_section(const std::string& line) {
   if (line.size() >= 2 && line.front() == '[' && line.back() == ']') {
     return line.substr(1, line.size() - 2);
@@ -166,10 +182,30 @@ bool load_config_file(const std::string& path, ServerConfig& config, std::error_
         config.tunnel.tun.netmask = value;
       } else if (key == "mtu") {
         config.tunnel.tun.mtu = std::stoi(value);
+      } else if (key == "ecn") {
+        config.tunnel.ecn = (value == "true" || value == "1" || value == "yes");
+      } else if (key == "ordered_delivery") {
+        config.tunnel.transport.ordered_delivery =
+            (value == "true" || value == "1" || value == "yes");
+      } else if (key == "reorder_timeout_ms") {
+        config.tunnel.transport.reorder_timeout = std::chrono::milliseconds(std::stoi(value));
+      } else if (key == "streams_per_band") {
+        config.tunnel.streams.streams_per_band = static_cast<std::uint32_t>(std::stoul(value));
+      } else if (key == "flow_control") {
+        config.tunnel.transport.flow_control.enabled =
+            (value == "true" || value == "1" || value == "yes");
+      } else if (key == "fec") {
+        config.tunnel.transport.fec.enabled = (value == "true" || value == "1" || value == "yes");
+      } else if (key == "fec_block_size") {
+        config.tunnel.transport.fec.block_size = std::stoul(value);
+      } else if (key == "fec_block_timeout_ms") {
+        config.tunnel.transport.fec.block_timeout = std::chrono::milliseconds(std::stoi(value));
       }
     } else if (section == "crypto") {
       if (key == "preshared_key_file") {
         config.tunnel.key_file = value;
+      } else if (key == "worker_threads") {
+        config.tunnel.crypto_workers = static_cast<std::size_t>(std::stoul(value));
       }
     } else if (section == "obfuscation") {
       if (key == "profile_seed_file") {
@@ -192,6 +228,65 @@ bool load_config_file(const std::string& path, ServerConfig& config, std::error_
         config.session_timeout = std::chrono::seconds(std::stoi(value));
       } else if (key == "cleanup_interval") {
         config.cleanup_interval = std::chrono::seconds(std::stoi(value));
+      } else if (key == "hibernate_after") {
+        config.hibernate_after = std::chrono::seconds(std::stoi(value));
+      } else if (key == "adaptive_buffers") {
+        config.tunnel.transport.adaptive_buffers =
+            (value == "true" || value == "1" || value == "yes");
+      }
+    } else if (section == "egress") {
+      if (key == "quantum_bytes") {
+        config.egress.quantum_bytes = std::stoul(value);
+      } else if (key == "max_queue_bytes") {
+        config.egress.max_queue_bytes = std::stoul(value);
+      } else if (key == "batch_size") {
+        config.egress.batch_size = std::stoul(value);
+      } else if (key == "gso") {
+        config.udp_gso = (value == "true" || value == "1" || value == "yes");
+      } else if (key == "session_bandwidth_bytes_per_sec") {
+        const auto rate = std::stoull(value);
+        if (rate == 0) {
+          config.egress.session_rate_limit.reset();
+        } else {
+          config.egress.session_rate_limit.emplace().bandwidth_bytes_per_sec = rate;
+        }
+      }
+    } else if (section == "hairpin") {
+      if (key == "enabled") {
+        config.hairpin.enabled = (value == "true" || value == "1" || value == "yes");
+      } else if (key == "default") {
+        if (value != "allow" && value != "deny") {
+          LOG_ERROR("Invalid hairpin default '{}', expected allow or deny", value);
+          ec = std::make_error_code(std::errc::invalid_argument);
+          return false;
+        }
+        config.hairpin.default_allow = value == "allow";
+      } else if (key == "allow" || key == "deny") {
+        if (!parse_hairpin_rules(value, key == "allow", config.hairpin)) {
+          ec = std::make_error_code(std::errc::invalid_argument);
+          return false;
+        }
+      }
+    } else if (section == "routes") {
+      if (key == "allowed") {
+        std::stringstream stream(value);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+          const auto first = item.find_first_not_of(" \t");
+          if (first == std::string::npos) {
+            continue;
+          }
+          item = item.substr(first, item.find_last_not_of(" \t") - first + 1);
+          const auto prefix = tun::parse_ip_prefix(item);
+          if (!prefix) {
+            LOG_ERROR("Invalid routable subnet '{}'", item);
+            ec = std::make_error_code(std::errc::invalid_argument);
+            return false;
+          }
+          config.routes.allowed.push_back(*prefix);
+        }
+      } else if (key == "max_per_client") {
+        config.routes.max_per_client = std::stoul(value);
       }
     } else if (section == "ip_pool") {
       if (key == "start") {
@@ -232,11 +327,39 @@ bool validate_config(const ServerConfig& config, std::string& error) {
     return false;
   }
 
+  if (config.tunnel.streams.streams_per_band == 0 || config.tunnel.streams.streams_per_band > 65536) {
+    error = "streams_per_band must be between 1 and 65536";
+    return false;
+  }
+
+  if (config.tunnel.transport.fec.block_size == 0 ||
+      config.tunnel.transport.fec.block_size > mux::kFecMaxSpan) {
+    error = "fec_block_size must be between 1 and 64";
+    return false;
+  }
+
   if (config.max_clients == 0) {
     error = "Max clients must be greater than 0";
     return false;
   }
 
+  const auto mtu = static_cast<std::size_t>(config.tunnel.tun.mtu);
+  if (config.egress.quantum_bytes == 0 || config.egress.batch_size == 0) {
+    error = "Egress quantum_bytes and batch_size must be greater than 0";
+    return false;
+  }
+
+  if (config.egress.max_queue_bytes < mtu) {
+    error = "Egress max_queue_bytes must hold at least one MTU-sized packet";
+    return false;
+  }
+
+  if (config.egress.session_rate_limit &&
+      config.egress.session_rate_limit->bandwidth_bytes_per_sec < mtu) {
+    error = "Egress session_bandwidth_bytes_per_sec must be at least the MTU";
+    return false;
+  }
+
   return true;
 }
 
@@ -4,6 +4,9 @@
 #include <system_error>
 #include <vector>
 
+#include "server/egress_scheduler.h"
+#include "server/hairpin.h"
+#include "server/route_table.h"
 #include "tunnel/tunnel.h"
 #include "tun/routing.h"
 
@@ -26,10 +29,25 @@ struct ServerConfig {
   std::size_t max_clients{256};
   std::chrono::seconds session_timeout{300};
   std::chrono::seconds cleanup_interval{60};
+  // Idle time after which a session's buffers are released until its next
+  // packet; checked on the cleanup tick. 0 disables hibernation.
+  std::chrono::seconds hibernate_after{60};
+
+  // Client-bound traffic scheduling.
+  EgressSchedulerConfig egress;
+
+  // Client-to-client forwarding.
+  HairpinConfig hairpin;
+
+  // Subnets routed to clients.
+  RouteConfig routes;
 
   // Network.
   std::string listen_address{"0.0.0.0"};
   std::uint16_t listen_port{4433};
+  // Coalesce same-sized datagrams to one client into UDP GSO sends, where
+  // the kernel supports it.
+  bool udp_gso{true};
 
   // IP pool for clients.
   std::string ip_pool_start{"10.8.0.2"};
@@ -8,6 +8,30 @@
 
 namespace veil::server {
 
+namespace {
+
+tun::IpPrefix host_route(std::uint32_t ip) { return tun::to_ip_prefix(tun::Ipv4Prefix{ip, 32}); }
+
+}  // namespace
+
+utils::MemoryFootprint ClientSession::memory_footprint() const {
+  utils::MemoryFootprint footprint{
+      .reserved = utils::string_heap_bytes(endpoint.host) + utils::string_heap_bytes(tunnel_ip) +
+                  (routed_prefixes.capacity() + announced_prefixes.capacity()) *
+                      sizeof(tun::IpPrefix),
+      .in_use = 0,
+      .limit = 0};
+  if (transport) {
+    footprint += transport->memory_footprint();
+    footprint.reserved += sizeof(transport::TransportSession);
+  }
+  if (hibernated) {
+    footprint += hibernated->memory_footprint();
+    footprint.reserved += sizeof(transport::HibernatedSession);
+  }
+  return footprint;
+}
+
 SessionTable::SessionTable(std::size_t max_clients, std::chrono::seconds session_timeout,
                            const std::string& ip_pool_start, const std::string& ip_pool_end,
                            std::function<TimePoint()> now_fn)
@@ -79,14 +103,15 @@ std::optional<std::uint64_t> SessionTable::create_session(
   session->session_id = generate_session_id();
   session->endpoint = endpoint;
   session->tunnel_ip = *ip;
+  session->tunnel_ip_v4 = ip_to_uint(*ip);
   session->transport = std::move(transport);
   session->connected_at = now_fn_();
-  session->last_activity = session->connected_at;
+  sweep_add(*session, session->connected_at);
 
   // Update indices.
   std::string endpoint_key = endpoint.host + ":" + std::to_string(endpoint.port);
   endpoint_index_[endpoint_key] = session->session_id;
-  ip_index_[*ip] = session->session_id;
+  routes_.insert(host_route(session->tunnel_ip_v4), session->session_id);
 
   std::uint64_t id = session->session_id;
   sessions_[id] = std::move(session);
@@ -121,22 +146,79 @@ ClientSession* SessionTable::find_by_endpoint(const transport::UdpEndpoint& endp
 }
 
 ClientSession* SessionTable::find_by_tunnel_ip(const std::string& ip) {
+  return find_by_tunnel_ip(ip_to_uint(ip));
+}
+
+ClientSession* SessionTable::find_by_tunnel_ip(std::uint32_t ip) {
   std::lock_guard<std::mutex> lock(mutex_);
-  auto it = ip_index_.find(ip);
-  if (it != ip_index_.end()) {
-    auto session_it = sessions_.find(it->second);
-    if (session_it != sessions_.end()) {
-      return session_it->second.get();
+  const auto id = routes_.find(host_route(ip));
+  if (!id) {
+    return nullptr;
+  }
+  auto it = sessions_.find(*id);
+  if (it == sessions_.end() || it->second->tunnel_ip_v4 != ip) {
+    return nullptr;
+  }
+  return it->second.get();
+}
+
+ClientSession* SessionTable::find_by_destination(std::span<const std::uint8_t> address) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto id = routes_.lookup(address);
+  if (!id) {
+    return nullptr;
+  }
+  auto it = sessions_.find(*id);
+  return it != sessions_.end() ? it->second.get() : nullptr;
+}
+
+std::size_t SessionTable::set_routes(std::uint64_t session_id,
+                                     std::span<const tun::IpPrefix> prefixes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(session_id);
+  if (it == sessions_.end()) {
+    return 0;
+  }
+  auto& session = *it->second;
+  for (const auto& prefix : session.routed_prefixes) {
+    routes_.erase(prefix);
+  }
+  session.routed_prefixes.clear();
+
+  for (const auto& prefix : prefixes) {
+    if (prefix.version == 4) {
+      // Pool addresses belong to sessions' tunnel IPs, present or future.
+      const auto first = (std::uint32_t{prefix.address[0]} << 24) |
+                         (std::uint32_t{prefix.address[1]} << 16) |
+                         (std::uint32_t{prefix.address[2]} << 8) | prefix.address[3];
+      const tun::Ipv4Prefix v4{first, prefix.length};
+      const auto last = first | ~v4.mask();
+      if (first <= ip_pool_end_ && last >= ip_pool_start_) {
+        LOG_WARN("Session {}: route {} overlaps the IP pool", session_id,
+                 tun::format_ip_prefix(prefix));
+        continue;
+      }
+    }
+    // A slice of another client's subnet, or a subnet around it, would
+    // take part of its traffic by longest-prefix match.
+    if (const auto other = routes_.find_overlap(prefix, session_id)) {
+      LOG_WARN("Session {}: route {} overlaps routes of session {}", session_id,
+               tun::format_ip_prefix(prefix), *other);
+      continue;
+    }
+    if (!routes_.find(prefix)) {
+      routes_.insert(prefix, session_id);
+      session.routed_prefixes.push_back(prefix);
     }
   }
-  return nullptr;
+  return session.routed_prefixes.size();
 }
 
 void SessionTable::update_activity(std::uint64_t session_id) {
   std::lock_guard<std::mutex> lock(mutex_);
   auto it = sessions_.find(session_id);
   if (it != sessions_.end()) {
-    it->second->last_activity = now_fn_();
+    sweep_.last_activity[it->second->sweep_slot] = now_fn_();
   }
 }
 
@@ -147,22 +229,53 @@ bool SessionTable::remove_session(std::uint64_t session_id) {
     return false;
   }
 
+  LOG_INFO("Removed session {} ({}:{}, IP {})", session_id, it->second->endpoint.host,
+           it->second->endpoint.port, it->second->tunnel_ip);
+
+  erase_locked(it);
+  stats_.active_sessions = sessions_.size();
+
+  return true;
+}
+
+void SessionTable::erase_locked(
+    std::unordered_map<std::uint64_t, std::unique_ptr<ClientSession>>::iterator it) {
+  auto& session = *it->second;
+
   // Remove from indices.
-  std::string endpoint_key =
-      it->second->endpoint.host + ":" + std::to_string(it->second->endpoint.port);
+  std::string endpoint_key = session.endpoint.host + ":" + std::to_string(session.endpoint.port);
   endpoint_index_.erase(endpoint_key);
-  ip_index_.erase(it->second->tunnel_ip);
+  routes_.erase(host_route(session.tunnel_ip_v4));
+  for (const auto& prefix : session.routed_prefixes) {
+    routes_.erase(prefix);
+  }
+  sweep_remove(session);
 
   // Release IP.
-  release_ip(it->second->tunnel_ip);
-
-  LOG_INFO("Removed session {} ({}:{}, IP {})", session_id, it->second->endpoint.host,
-           it->second->endpoint.port, it->second->tunnel_ip);
+  release_ip(session.tunnel_ip);
 
+  if (session.hibernated) {
+    --stats_.hibernated_sessions;
+  }
   sessions_.erase(it);
-  stats_.active_sessions = sessions_.size();
+}
 
-  return true;
+void SessionTable::sweep_add(ClientSession& session, TimePoint now) {
+  session.sweep_slot = sweep_.sessions.size();
+  sweep_.sessions.push_back(&session);
+  sweep_.last_activity.push_back(now);
+}
+
+void SessionTable::sweep_remove(const ClientSession& session) {
+  const std::size_t slot = session.sweep_slot;
+  const std::size_t last = sweep_.sessions.size() - 1;
+  if (slot != last) {
+    sweep_.sessions[slot] = sweep_.sessions[last];
+    sweep_.last_activity[slot] = sweep_.last_activity[last];
+    sweep_.sessions[slot]->sweep_slot = slot;
+  }
+  sweep_.sessions.pop_back();
+  sweep_.last_activity.pop_back();
 }
 
 std::size_t SessionTable::cleanup_expired() {
@@ -170,24 +283,18 @@ std::size_t SessionTable::cleanup_expired() {
   auto now = now_fn_();
   std::vector<std::uint64_t> expired;
 
-  for (const auto& [id, session] : sessions_) {
-    auto age = std::chrono::duration_cast<std::chrono::seconds>(now - session->last_activity);
+  for (std::size_t slot = 0; slot < sweep_.last_activity.size(); ++slot) {
+    auto age = std::chrono::duration_cast<std::chrono::seconds>(now - sweep_.last_activity[slot]);
     if (age >= session_timeout_) {
-      expired.push_back(id);
+      expired.push_back(sweep_.sessions[slot]->session_id);
     }
   }
 
   for (std::uint64_t id : expired) {
     auto it = sessions_.find(id);
     if (it != sessions_.end()) {
-      std::string endpoint_key =
-          it->second->endpoint.host + ":" + std::to_string(it->second->endpoint.port);
-      endpoint_index_.erase(endpoint_key);
-      ip_index_.erase(it->second->tunnel_ip);
-      release_ip(it->second->tunnel_ip);
-
       LOG_INFO("Session {} timed out", id);
-      sessions_.erase(it);
+      erase_locked(it);
       stats_.sessions_timed_out++;
     }
   }
@@ -196,14 +303,89 @@ std::size_t SessionTable::cleanup_expired() {
   return expired.size();
 }
 
-std::vector<ClientSession*> SessionTable::get_all_sessions() {
+std::size_t SessionTable::hibernate_idle(std::chrono::seconds idle_after) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto now = now_fn_();
+  std::size_t hibernated = 0;
+
+  for (std::size_t slot = 0; slot < sweep_.last_activity.size(); ++slot) {
+    auto* session = sweep_.sessions[slot];
+    if (!session->transport) {
+      continue;
+    }
+    const auto idle = now - sweep_.last_activity[slot];
+    if (idle < idle_after || !session->transport->can_hibernate()) {
+      continue;
+    }
+    session->hibernated =
+        std::make_unique<transport::HibernatedSession>(session->transport->hibernate());
+    session->transport.reset();
+    ++hibernated;
+    LOG_DEBUG("Session {} hibernated", session->session_id);
+  }
+
+  stats_.sessions_hibernated += hibernated;
+  stats_.hibernated_sessions += hibernated;
+  return hibernated;
+}
+
+void SessionTable::refresh_buffer_limits() {
   std::lock_guard<std::mutex> lock(mutex_);
-  std::vector<ClientSession*> result;
-  result.reserve(sessions_.size());
-  for (auto& [id, session] : sessions_) {
-    result.push_back(session.get());
+  for (auto* session : sweep_.sessions) {
+    if (session->transport) {
+      session->transport->refresh_buffer_limits();
+    }
   }
-  return result;
+}
+
+bool SessionTable::wake(ClientSession& session, const transport::TransportSessionConfig& config) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (session.transport || !session.hibernated) {
+    return false;
+  }
+  session.transport =
+      std::make_unique<transport::TransportSession>(std::move(*session.hibernated), config);
+  session.hibernated.reset();
+  --stats_.hibernated_sessions;
+  LOG_DEBUG("Session {} woken", session.session_id);
+  return true;
+}
+
+utils::MemoryFootprint SessionTable::memory_footprint() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  utils::MemoryFootprint footprint;
+  footprint.reserved = available_ips_.capacity() * sizeof(std::uint32_t) +
+                       (sessions_.bucket_count() + endpoint_index_.bucket_count()) * sizeof(void*) +
+                       sweep_.last_activity.capacity() * sizeof(TimePoint) +
+                       sweep_.sessions.capacity() * sizeof(ClientSession*);
+  for (const auto& [_, session] : sessions_) {
+    footprint += session->memory_footprint();
+    footprint.reserved +=
+        utils::container_node_bytes<decltype(sessions_)>() + sizeof(ClientSession);
+  }
+  for (const auto& [key, _] : endpoint_index_) {
+    footprint.reserved +=
+        utils::container_node_bytes<decltype(endpoint_index_)>() + utils::string_heap_bytes(key);
+  }
+  footprint += routes_.memory_footprint();
+  return footprint;
+}
+
+std::size_t SessionTable::update_memory_usage(session::SessionLifecycleManager& lifecycles) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::size_t updated = 0;
+  for (const auto& [id, session] : sessions_) {
+    if (auto* lifecycle = lifecycles.get_session(id)) {
+      lifecycle->update_memory_usage(sizeof(ClientSession) + session->memory_footprint().reserved);
+      ++updated;
+    }
+  }
+  return updated;
+}
+
+std::vector<ClientSession*> SessionTable::get_all_sessions() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return sweep_.sessions;
 }
 
 }  // namespace veil::server
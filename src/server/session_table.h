@@ -5,39 +5,63 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "common/handshake/handshake_processor.h"
+#include "common/session/session_lifecycle.h"
+#include "common/utils/cache_line.h"
+#include "common/utils/memory_footprint.h"
+#include "server/route_table.h"
 #include "transport/session/transport_session.h"
 #include "transport/udp_socket/udp_socket.h"
 
 namespace veil::server {
 
 // Client session information.
-struct ClientSession {
+//
+// Fields the data plane touches for every packet share the first cache line;
+// addressing and bookkeeping follow. Idle sweeps read SessionTable's index
+// rather than these objects.
+struct alignas(utils::kCacheLineSize) ClientSession {
+  // Transport session. Null while the session is hibernated.
+  std::unique_ptr<transport::TransportSession> transport;
+
+  // Statistics.
+  std::uint64_t bytes_received{0};
+  std::uint64_t bytes_sent{0};
+  std::uint64_t packets_received{0};
+  std::uint64_t packets_sent{0};
+
   // Unique session identifier.
   std::uint64_t session_id{0};
 
+  // Position in SessionTable's sweep index; maintained by the table.
+  std::size_t sweep_slot{0};
+
   // Client endpoint.
   transport::UdpEndpoint endpoint;
 
-  // Assigned tunnel IP.
+  // Assigned tunnel IP, and the same in host byte order for the packet
+  // path.
   std::string tunnel_ip;
+  std::uint32_t tunnel_ip_v4{0};
 
-  // Transport session.
-  std::unique_ptr<transport::TransportSession> transport;
+  // Subnets behind the client that the server routes to it.
+  std::vector<tun::IpPrefix> routed_prefixes;
+  // The client's last routed subnet announcement as received, including
+  // prefixes that were refused; repeats of it leave the table alone.
+  std::vector<tun::IpPrefix> announced_prefixes;
+
+  // Compact state of an idle session; set only while `transport` is null.
+  std::unique_ptr<transport::HibernatedSession> hibernated;
 
-  // Timestamps.
   std::chrono::steady_clock::time_point connected_at;
-  std::chrono::steady_clock::time_point last_activity;
 
-  // Statistics.
-  std::uint64_t bytes_received{0};
-  std::uint64_t bytes_sent{0};
-  std::uint64_t packets_received{0};
-  std::uint64_t packets_sent{0};
+  // Heap held by this session, including its TransportSession.
+  utils::MemoryFootprint memory_footprint() const;
 };
 
 // Session table statistics.
@@ -46,6 +70,8 @@ struct SessionTableStats {
   std::size_t total_sessions_created{0};
   std::size_t sessions_timed_out{0};
   std::size_t sessions_rejected_full{0};
+  std::size_t sessions_hibernated{0};
+  std::size_t hibernated_sessions{0};
 };
 
 // Manages client sessions and IP address allocation.
@@ -72,6 +98,19 @@ class SessionTable {
   // Find session by tunnel IP.
   ClientSession* find_by_tunnel_ip(const std::string& ip);
 
+  // Find session by tunnel IP in host byte order.
+  ClientSession* find_by_tunnel_ip(std::uint32_t ip);
+
+  // Find the session a packet to `address` (tun::destination_address())
+  // goes to: the longest match among tunnel IPs and routed prefixes.
+  ClientSession* find_by_destination(std::span<const std::uint8_t> address);
+
+  // Replace the subnets routed to a session with `prefixes`. Prefixes
+  // overlapping the IP pool, or containing or lying within a route of
+  // another session (its subnets and tunnel IP), are skipped.
+  // Returns the number installed.
+  std::size_t set_routes(std::uint64_t session_id, std::span<const tun::IpPrefix> prefixes);
+
   // Update last activity timestamp.
   void update_activity(std::uint64_t session_id);
 
@@ -82,9 +121,30 @@ class SessionTable {
   // Returns number of sessions removed.
   std::size_t cleanup_expired();
 
+  // Hibernate sessions idle for at least `idle_after` with nothing in flight,
+  // replacing their TransportSession with a HibernatedSession record. The
+  // data plane wakes them on the next packet. Returns the number hibernated.
+  std::size_t hibernate_idle(std::chrono::seconds idle_after);
+
+  // Let awake sessions' adaptive buffer limits decay while they are idle.
+  // Call on every cleanup tick, whether or not hibernation is enabled.
+  void refresh_buffer_limits();
+
+  // Restore a hibernated session's transport. Returns false if it was not
+  // hibernated.
+  bool wake(ClientSession& session, const transport::TransportSessionConfig& config);
+
   // Get all active sessions.
   std::vector<ClientSession*> get_all_sessions();
 
+  // Memory held by all sessions plus the table's own indices and IP pool.
+  utils::MemoryFootprint memory_footprint() const;
+
+  // Report each session's reserved bytes to its lifecycle tracker, if it has
+  // one, so SessionLifecycleConfig::max_memory_per_session is enforced.
+  // Returns the number of sessions updated.
+  std::size_t update_memory_usage(session::SessionLifecycleManager& lifecycles) const;
+
   // Get statistics.
   const SessionTableStats& stats() const { return stats_; }
 
@@ -121,11 +181,26 @@ class SessionTable {
   // Sessions indexed by ID.
   std::unordered_map<std::uint64_t, std::unique_ptr<ClientSession>> sessions_;
 
+  // Struct-of-arrays index over sessions_ for cleanup and hibernation
+  // sweeps, which only need the idle time of every session. Slots are
+  // dense; removal moves the last slot into the hole.
+  struct SweepIndex {
+    std::vector<TimePoint> last_activity;
+    std::vector<ClientSession*> sessions;
+  };
+  SweepIndex sweep_;
+
+  void sweep_add(ClientSession& session, TimePoint now);
+  void sweep_remove(const ClientSession& session);
+
+  // Drop a session from all indices and release its IP.
+  void erase_locked(std::unordered_map<std::uint64_t, std::unique_ptr<ClientSession>>::iterator it);
+
   // Endpoint to session ID mapping.
   std::unordered_map<std::string, std::uint64_t> endpoint_index_;
 
-  // Tunnel IP to session ID mapping.
-  std::unordered_map<std::string, std::uint64_t> ip_index_;
+  // Tunnel IPs (as host routes) and routed prefixes to session IDs.
+  RouteTable routes_;
 
   // Available IPs in the pool.
   std::vector<std::uint32_t> available_ips_;
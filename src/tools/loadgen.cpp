@@ -0,0 +1,875 @@
+// VEIL Load Generator
+//
+// Opens many concurrent client sessions against a running veil-server from
+// one process to find where the server stops keeping up. Each session uses
+// its own UDP socket (the server keys sessions by source endpoint) and the
+// real HandshakeInitiator/TransportSession code. Handshakes are ramped at a
+// fixed rate, then every session offers one of three traffic patterns:
+//
+//   bulk         fixed-size UDP datagrams at a constant rate, plus one
+//                latency probe per --probe-interval-s
+//   interactive  small ICMP echo requests with Poisson arrivals; every
+//                packet is a latency probe
+//   idle         one small ICMP echo per --heartbeat-s, keeping the session
+//                alive without load
+//
+// Usage:
+//   veil-loadgen --host=192.0.2.1 --psk-file=psk.key --sessions=1000 --ramp-rate=200
+//   veil-loadgen --host=192.0.2.1 --psk-file=psk.key --pattern=bulk --rate=200
+//       --server-pid=$(pidof veil-server)
+//   veil-loadgen --host=192.0.2.1 --psk-file=psk.key --sessions=5000 --threads=4
+//       --pattern=idle --duration-s=120 --json
+//
+// Server limits:
+//   veil-server defaults to 256 clients and a 253-address pool. Raise
+//   max_clients and the IP pool for larger runs; otherwise the extra
+//   sessions show up as unresponsive.
+//
+// Data-path latency:
+//   Probes are ICMP echo requests to the server's TUN address. The server
+//   kernel answers and the data plane routes the reply to the session that
+//   owns the destination address. Clients are never told their tunnel
+//   address, so session i uses --pool-end minus i as its source, which is
+//   the server's allocation order on a fresh server. Replies carry the
+//   sending session's index and send time, so a reply that lands on another
+//   load-generator session is still attributed correctly.
+//
+//   Uplink packets are not retransmitted because veil-server does not
+//   acknowledge them. Downlink packets are acknowledged one by one so the
+//   server's retransmit buffers drain as they would for a real client.
+//
+// Output:
+//   A per-second timeline (established sessions, handshakes/s, failures,
+//   packets/s, probe loss, server RSS) followed by a summary. With --json,
+//   both are emitted as one JSON document. The exit status is 0 when every
+//   session established and 2 otherwise.
+//
+
+#include <CLI/CLI.hpp>
+#include <arpa/inet.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/handshake/handshake_processor.h"
+#include "common/logging/logger.h"
+#include "transport/event_loop/event_loop.h"
+#include "transport/session/transport_session.h"
+#include "transport/udp_socket/udp_socket.h"
+
+namespace {
+
+using namespace veil;
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kIpv4HeaderSize = 20;
+constexpr std::size_t kIcmpHeaderSize = 8;
+constexpr std::size_t kUdpHeaderSize = 8;
+constexpr std::uint8_t kProtoIcmp = 1;
+constexpr std::uint8_t kProtoUdp = 17;
+constexpr std::uint8_t kIcmpEchoReply = 0;
+constexpr std::uint8_t kIcmpEchoRequest = 8;
+// Probe payload: magic, sender index, send time in steady-clock nanoseconds.
+constexpr std::array<std::uint8_t, 4> kProbeMagic{'V', 'L', 'G', '1'};
+constexpr std::size_t kProbePayloadSize = 16;
+constexpr std::size_t kMinProbeSize = kIpv4HeaderSize + kIcmpHeaderSize + kProbePayloadSize;
+// Matches TunnelConfig::handshake_skew_tolerance.
+constexpr std::chrono::milliseconds kSkewTolerance{30000};
+// Time after traffic stops for in-flight replies to arrive.
+constexpr std::chrono::seconds kDrainTime{1};
+
+enum class Pattern { kBulk, kInteractive, kIdle };
+
+struct Options {
+  std::string host{"127.0.0.1"};
+  std::uint16_t port{4433};
+  std::string psk_file;
+  std::size_t sessions{100};
+  std::size_t threads{1};
+  double ramp_rate{100.0};
+  double duration_s{30.0};
+  std::string pattern{"interactive"};
+  // Per-session packets per second and inner IP packet size; 0 selects the
+  // pattern default.
+  double rate{0.0};
+  std::size_t size{0};
+  double heartbeat_s{10.0};
+  double probe_interval_s{1.0};
+  double handshake_timeout_s{2.0};
+  int handshake_attempts{3};
+  std::string server_tun_ip{"10.8.0.1"};
+  std::string pool_end{"10.8.0.254"};
+  std::uint16_t sink_port{9};
+  int server_pid{0};
+  double memory_budget_mib{50.0};
+  double loss_threshold{0.05};
+  std::uint64_t seed{1};
+  bool json{false};
+};
+
+// Counters shared by all workers and sampled by the main thread.
+struct Counters {
+  std::atomic<std::uint64_t> sockets_failed{0};
+  std::atomic<std::uint64_t> handshakes_sent{0};
+  std::atomic<std::uint64_t> handshakes_completed{0};
+  std::atomic<std::uint64_t> handshakes_failed{0};
+  std::atomic<std::uint64_t> established{0};
+  std::atomic<std::uint64_t> packets_sent{0};
+  std::atomic<std::uint64_t> bytes_sent{0};
+  std::atomic<std::uint64_t> packets_received{0};
+  std::atomic<std::uint64_t> bytes_received{0};
+  std::atomic<std::uint64_t> send_errors{0};
+  // Downlink packets the transport rejected: duplicates from server
+  // retransmits, replays or decryption failures.
+  std::atomic<std::uint64_t> packets_rejected{0};
+  std::atomic<std::uint64_t> acks_sent{0};
+  std::atomic<std::uint64_t> probes_sent{0};
+  std::atomic<std::uint64_t> probes_answered{0};
+};
+
+// Read-only run parameters plus the shared counters.
+struct Shared {
+  Options options;
+  Pattern pattern{Pattern::kInteractive};
+  double rate{0.0};
+  std::size_t size{0};
+  std::vector<std::uint8_t> psk;
+  transport::UdpEndpoint server;
+  std::uint32_t server_tun_ip{0};
+  std::uint32_t pool_end{0};
+  Clock::time_point start;
+  Clock::time_point traffic_end;
+  Counters counters;
+  // Per-session flag set once any probe from that session is answered.
+  std::vector<std::atomic<bool>> answered;
+};
+
+std::uint64_t count(const std::atomic<std::uint64_t>& counter) {
+  return counter.load(std::memory_order_relaxed);
+}
+
+void bump(std::atomic<std::uint64_t>& counter, std::uint64_t by = 1) {
+  counter.fetch_add(by, std::memory_order_relaxed);
+}
+
+std::uint16_t internet_checksum(std::span<const std::uint8_t> data) {
+  std::uint32_t sum = 0;
+  for (std::size_t i = 0; i + 1 < data.size(); i += 2) {
+    sum += static_cast<std::uint32_t>(data[i] << 8 | data[i + 1]);
+  }
+  if (data.size() % 2 != 0) {
+    sum += static_cast<std::uint32_t>(data.back() << 8);
+  }
+  while ((sum >> 16) != 0U) {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+  }
+  return static_cast<std::uint16_t>(~sum);
+}
+
+void put_u16(std::span<std::uint8_t> out, std::size_t offset, std::uint16_t value) {
+  out[offset] = static_cast<std::uint8_t>(value >> 8);
+  out[offset + 1] = static_cast<std::uint8_t>(value & 0xFF);
+}
+
+void put_u32(std::span<std::uint8_t> out, std::size_t offset, std::uint32_t value) {
+  for (std::size_t i = 0; i < 4; ++i) {
+    out[offset + i] = static_cast<std::uint8_t>(value >> (24 - 8 * i));
+  }
+}
+
+std::uint32_t get_u32(std::span<const std::uint8_t> in, std::size_t offset) {
+  std::uint32_t value = 0;
+  for (std::size_t i = 0; i < 4; ++i) {
+    value = (value << 8) | in[offset + i];
+  }
+  return value;
+}
+
+// Build an IPv4 packet of `total_size` bytes whose first transport-header
+// bytes are filled in by the caller.
+std::vector<std::uint8_t> make_ipv4(std::uint32_t src, std::uint32_t dst, std::uint8_t protocol,
+                                    std::size_t total_size) {
+  std::array<std::uint8_t, kIpv4HeaderSize> header{};
+  header[0] = 0x45;
+  put_u16(header, 2, static_cast<std::uint16_t>(total_size));
+  header[8] = 64;  // TTL
+  header[9] = protocol;
+  put_u32(header, 12, src);
+  put_u32(header, 16, dst);
+  put_u16(header, 10, internet_checksum(header));
+
+  std::vector<std::uint8_t> packet(header.begin(), header.end());
+  packet.resize(total_size, 0);
+  return packet;
+}
+
+std::vector<std::uint8_t> make_probe(std::uint32_t src, std::uint32_t dst, std::size_t size,
+                                     std::uint32_t sender, std::uint16_t sequence) {
+  auto packet = make_ipv4(src, dst, kProtoIcmp, std::max(size, kMinProbeSize));
+  std::span<std::uint8_t> icmp(packet.data() + kIpv4HeaderSize, packet.size() - kIpv4HeaderSize);
+  icmp[0] = kIcmpEchoRequest;
+  put_u16(icmp, 4, static_cast<std::uint16_t>(sender & 0xFFFF));
+  put_u16(icmp, 6, sequence);
+  std::copy(kProbeMagic.begin(), kProbeMagic.end(), icmp.begin() + kIcmpHeaderSize);
+  put_u32(icmp, kIcmpHeaderSize + 4, sender);
+  const auto sent_ns = static_cast<std::uint64_t>(Clock::now().time_since_epoch().count());
+  put_u32(icmp, kIcmpHeaderSize + 8, static_cast<std::uint32_t>(sent_ns >> 32));
+  put_u32(icmp, kIcmpHeaderSize + 12, static_cast<std::uint32_t>(sent_ns & 0xFFFFFFFF));
+  put_u16(icmp, 2, internet_checksum(icmp));
+  return packet;
+}
+
+std::vector<std::uint8_t> make_datagram(std::uint32_t src, std::uint32_t dst,
+                                        std::uint16_t src_port, std::uint16_t dst_port,
+                                        std::size_t size) {
+  auto packet = make_ipv4(src, dst, kProtoUdp,
+                          std::max(size, kIpv4HeaderSize + kUdpHeaderSize));
+  std::span<std::uint8_t> udp(packet.data() + kIpv4HeaderSize, packet.size() - kIpv4HeaderSize);
+  put_u16(udp, 0, src_port);
+  put_u16(udp, 2, dst_port);
+  put_u16(udp, 4, static_cast<std::uint16_t>(udp.size()));
+  // A zero UDP checksum means "not computed" in IPv4.
+  return packet;
+}
+
+struct ProbeReply {
+  std::uint32_t sender{0};
+  Clock::time_point sent;
+};
+
+// Recognise an echo reply to one of our probes.
+std::optional<ProbeReply> parse_probe_reply(std::span<const std::uint8_t> packet) {
+  if (packet.size() < kMinProbeSize || (packet[0] >> 4) != 4 || packet[9] != kProtoIcmp) {
+    return std::nullopt;
+  }
+  const std::size_t ihl = static_cast<std::size_t>(packet[0] & 0x0F) * 4;
+  if (packet.size() < ihl + kIcmpHeaderSize + kProbePayloadSize) {
+    return std::nullopt;
+  }
+  const auto icmp = packet.subspan(ihl);
+  if (icmp[0] != kIcmpEchoReply ||
+      !std::equal(kProbeMagic.begin(), kProbeMagic.end(), icmp.begin() + kIcmpHeaderSize)) {
+    return std::nullopt;
+  }
+  const std::uint64_t sent_ns = (static_cast<std::uint64_t>(get_u32(icmp, kIcmpHeaderSize + 8)) << 32) |
+                                get_u32(icmp, kIcmpHeaderSize + 12);
+  return ProbeReply{get_u32(icmp, kIcmpHeaderSize + 4),
+                    Clock::time_point(Clock::duration(static_cast<Clock::rep>(sent_ns)))};
+}
+
+struct LoadSession {
+  std::uint32_t index{0};
+  std::uint32_t tunnel_ip{0};
+  transport::UdpSocket socket;
+  std::optional<handshake::HandshakeInitiator> initiator;
+  std::unique_ptr<transport::TransportSession> transport;
+  Clock::time_point handshake_sent;
+  int attempts{0};
+  utils::TimerId handshake_timer{utils::kInvalidTimerId};
+  std::uint16_t probe_sequence{0};
+};
+
+// One event loop driving a share of the sessions.
+//
+// Thread Safety:
+//   Everything except stop() runs on the worker thread; results are read
+//   after join(). See docs/thread_model.md.
+class Worker {
+ public:
+  Worker(Shared& shared, std::size_t worker_index)
+      : shared_(shared),
+        worker_index_(worker_index),
+        rng_(shared.options.seed * 0x9E3779B97F4A7C15ULL + worker_index) {}
+
+  void start() { thread_ = std::thread([this] { run(); }); }
+
+  void join() {
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  const std::vector<double>& handshake_ms() const { return handshake_ms_; }
+  const std::vector<double>& rtt_ms() const { return rtt_ms_; }
+
+ private:
+  void run() {
+    loop_ = std::make_unique<transport::EventLoop>();
+
+    const auto& options = shared_.options;
+    for (std::size_t i = worker_index_; i < options.sessions; i += options.threads) {
+      auto session = std::make_unique<LoadSession>();
+      session->index = static_cast<std::uint32_t>(i);
+      session->tunnel_ip = shared_.pool_end - static_cast<std::uint32_t>(i);
+      sessions_.push_back(std::move(session));
+    }
+    for (auto& session : sessions_) {
+      const auto at = shared_.start + std::chrono::duration_cast<Clock::duration>(
+                                          std::chrono::duration<double>(session->index /
+                                                                        options.ramp_rate));
+      auto* s = session.get();
+      loop_->schedule_timer(at - Clock::now(), [this, s](utils::TimerId) { open_session(*s); });
+    }
+    loop_->schedule_timer(shared_.traffic_end + kDrainTime - Clock::now(),
+                          [this](utils::TimerId) { loop_->stop(); });
+    loop_->run();
+  }
+
+  void open_session(LoadSession& session) {
+    std::error_code ec;
+    if (!session.socket.open(0, false, ec)) {
+      LOG_WARN("Session {}: failed to open socket: {}", session.index, ec.message());
+      bump(shared_.counters.sockets_failed);
+      return;
+    }
+    auto* s = &session;
+    loop_->add_socket(&session.socket, session.index, shared_.server,
+                      [this, s](transport::SessionId, std::span<const std::uint8_t> data,
+                                const transport::UdpEndpoint&) { on_packet(*s, data); });
+    send_init(session);
+  }
+
+  void send_init(LoadSession& session) {
+    session.initiator.emplace(shared_.psk, kSkewTolerance);
+    const auto init = session.initiator->create_init();
+    session.handshake_sent = Clock::now();
+    ++session.attempts;
+    bump(shared_.counters.handshakes_sent);
+    send_wire(session, init);
+
+    auto* s = &session;
+    session.handshake_timer = loop_->schedule_timer(
+        std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(shared_.options.handshake_timeout_s)),
+        [this, s](utils::TimerId) { on_handshake_timeout(*s); });
+  }
+
+  void on_handshake_timeout(LoadSession& session) {
+    session.handshake_timer = utils::kInvalidTimerId;
+    if (session.transport) {
+      return;
+    }
+    if (session.attempts < shared_.options.handshake_attempts && Clock::now() < shared_.traffic_end) {
+      send_init(session);
+      return;
+    }
+    LOG_DEBUG("Session {}: handshake failed after {} attempts", session.index, session.attempts);
+    session.initiator.reset();
+    bump(shared_.counters.handshakes_failed);
+  }
+
+  void on_packet(LoadSession& session, std::span<const std::uint8_t> data) {
+    bump(shared_.counters.packets_received);
+    bump(shared_.counters.bytes_received, data.size());
+
+    if (!session.transport) {
+      if (!session.initiator) {
+        return;
+      }
+      auto hs = session.initiator->consume_response(data);
+      if (!hs) {
+        return;
+      }
+      handshake_ms_.push_back(
+          std::chrono::duration<double, std::milli>(Clock::now() - session.handshake_sent).count());
+      session.transport = std::make_unique<transport::TransportSession>(*hs);
+      session.initiator.reset();
+      if (session.handshake_timer != utils::kInvalidTimerId) {
+        loop_->cancel_timer(session.handshake_timer);
+        session.handshake_timer = utils::kInvalidTimerId;
+      }
+      bump(shared_.counters.handshakes_completed);
+      bump(shared_.counters.established);
+      schedule_traffic(session);
+      if (shared_.pattern == Pattern::kBulk) {
+        schedule_probe(session);
+      }
+      return;
+    }
+
+    auto frames = session.transport->decrypt_packet(data);
+    if (!frames) {
+      bump(shared_.counters.packets_rejected);
+      return;
+    }
+    for (const auto& frame : *frames) {
+      if (frame.kind != mux::FrameKind::kData) {
+        continue;
+      }
+      send_wire(session, session.transport->encrypt_ack(frame.data.stream_id));
+      bump(shared_.counters.acks_sent);
+      if (const auto reply = parse_probe_reply(frame.data.payload)) {
+        rtt_ms_.push_back(
+            std::chrono::duration<double, std::milli>(Clock::now() - reply->sent).count());
+        bump(shared_.counters.probes_answered);
+        if (reply->sender < shared_.answered.size()) {
+          shared_.answered[reply->sender].store(true, std::memory_order_relaxed);
+        }
+      }
+    }
+  }
+
+  Clock::duration next_interval(double rate, bool poisson) {
+    const double seconds = poisson ? std::exponential_distribution<double>(rate)(rng_) : 1.0 / rate;
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+  }
+
+  void schedule_traffic(LoadSession& session) {
+    auto* s = &session;
+    const bool poisson = shared_.pattern == Pattern::kInteractive;
+    loop_->schedule_timer(next_interval(shared_.rate, poisson), [this, s](utils::TimerId) {
+      if (Clock::now() >= shared_.traffic_end) {
+        return;
+      }
+      if (shared_.pattern == Pattern::kBulk) {
+        send_inner(*s, make_datagram(s->tunnel_ip, shared_.server_tun_ip,
+                                     static_cast<std::uint16_t>(40000 + (s->index % 20000)),
+                                     shared_.options.sink_port, shared_.size));
+      } else {
+        send_probe(*s, shared_.size);
+      }
+      schedule_traffic(*s);
+    });
+  }
+
+  void schedule_probe(LoadSession& session) {
+    auto* s = &session;
+    loop_->schedule_timer(next_interval(1.0 / shared_.options.probe_interval_s, false),
+                          [this, s](utils::TimerId) {
+                            if (Clock::now() >= shared_.traffic_end) {
+                              return;
+                            }
+                            send_probe(*s, kMinProbeSize);
+                            schedule_probe(*s);
+                          });
+  }
+
+  void send_probe(LoadSession& session, std::size_t size) {
+    bump(shared_.counters.probes_sent);
+    send_inner(session, make_probe(session.tunnel_ip, shared_.server_tun_ip, size, session.index,
+                                   session.probe_sequence++));
+  }
+
+  void send_inner(LoadSession& session, std::span<const std::uint8_t> ip_packet) {
+    for (const auto& pkt : session.transport->encrypt_data(ip_packet)) {
+      send_wire(session, pkt);
+    }
+  }
+
+  void send_wire(LoadSession& session, std::span<const std::uint8_t> packet) {
+    if (!loop_->send_packet(session.socket.fd(), packet, shared_.server)) {
+      bump(shared_.counters.send_errors);
+      return;
+    }
+    bump(shared_.counters.packets_sent);
+    bump(shared_.counters.bytes_sent, packet.size());
+  }
+
+  Shared& shared_;
+  std::size_t worker_index_;
+  std::mt19937_64 rng_;
+  std::unique_ptr<transport::EventLoop> loop_;
+  std::vector<std::unique_ptr<LoadSession>> sessions_;
+  std::vector<double> handshake_ms_;
+  std::vector<double> rtt_ms_;
+  std::thread thread_;
+};
+
+struct Percentiles {
+  std::size_t samples{0};
+  double p50{0.0};
+  double p90{0.0};
+  double p99{0.0};
+  double max{0.0};
+};
+
+Percentiles percentiles(std::vector<double> values) {
+  Percentiles p;
+  p.samples = values.size();
+  if (values.empty()) {
+    return p;
+  }
+  std::sort(values.begin(), values.end());
+  const auto at = [&](double q) {
+    const auto rank = static_cast<std::size_t>(std::ceil(q * static_cast<double>(values.size())));
+    return values[std::clamp<std::size_t>(rank, 1, values.size()) - 1];
+  };
+  p.p50 = at(0.50);
+  p.p90 = at(0.90);
+  p.p99 = at(0.99);
+  p.max = values.back();
+  return p;
+}
+
+nlohmann::json percentiles_json(const Percentiles& p) {
+  return {{"samples", p.samples}, {"p50_ms", p.p50}, {"p90_ms", p.p90}, {"p99_ms", p.p99},
+          {"max_ms", p.max}};
+}
+
+// Resident set size of `pid` in bytes, or nullopt if it cannot be read.
+std::optional<std::uint64_t> read_rss_bytes(int pid) {
+  std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("VmRSS:", 0) == 0) {
+      std::istringstream fields(line.substr(6));
+      std::uint64_t kib = 0;
+      if (fields >> kib) {
+        return kib * 1024;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+double cpu_seconds() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  const auto seconds = [](const timeval& tv) {
+    return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+  };
+  return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+// Raise the open-file soft limit to the hard limit; one socket per session
+// exhausts the usual default of 1024 quickly.
+void raise_fd_limit(std::size_t needed) {
+  rlimit limit{};
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+    return;
+  }
+  limit.rlim_cur = limit.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &limit);
+  getrlimit(RLIMIT_NOFILE, &limit);
+  if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < needed) {
+    std::cerr << "Warning: open file limit " << limit.rlim_cur << " is below the " << needed
+              << " descriptors needed; raise it with ulimit -n\n";
+  }
+}
+
+bool parse_ipv4(const std::string& text, std::uint32_t& out) {
+  in_addr addr{};
+  if (inet_pton(AF_INET, text.c_str(), &addr) != 1) {
+    return false;
+  }
+  out = ntohl(addr.s_addr);
+  return true;
+}
+
+bool load_psk(const std::string& path, std::vector<std::uint8_t>& psk) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  psk.resize(32);
+  file.read(reinterpret_cast<char*>(psk.data()), static_cast<std::streamsize>(psk.size()));
+  return file.gcount() == static_cast<std::streamsize>(psk.size());
+}
+
+// One row of the per-second timeline.
+struct Sample {
+  double t{0.0};
+  std::uint64_t established{0};
+  double handshakes_per_s{0.0};
+  std::uint64_t handshakes_failed{0};
+  double tx_pps{0.0};
+  double rx_pps{0.0};
+  double probe_loss{0.0};
+  std::optional<std::uint64_t> server_rss;
+};
+
+nlohmann::json sample_json(const Sample& s) {
+  nlohmann::json j = {{"t", s.t},
+                      {"established", s.established},
+                      {"handshakes_per_s", s.handshakes_per_s},
+                      {"handshakes_failed", s.handshakes_failed},
+                      {"tx_pps", s.tx_pps},
+                      {"rx_pps", s.rx_pps},
+                      {"probe_loss", s.probe_loss}};
+  if (s.server_rss) {
+    j["server_rss_mib"] = static_cast<double>(*s.server_rss) / (1024.0 * 1024.0);
+  }
+  return j;
+}
+
+void print_sample(const Sample& s) {
+  std::cout << std::fixed << std::setprecision(1) << s.t << ',' << s.established << ','
+            << s.handshakes_per_s << ',' << s.handshakes_failed << ',' << s.tx_pps << ','
+            << s.rx_pps << ',' << std::setprecision(3) << s.probe_loss << ',';
+  if (s.server_rss) {
+    std::cout << std::setprecision(1) << static_cast<double>(*s.server_rss) / (1024.0 * 1024.0);
+  }
+  std::cout << '\n';
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  try {
+    CLI::App app{"VEIL Load Generator"};
+
+    Options options;
+    app.add_option("--host", options.host, "Server address");
+    app.add_option("--port,-p", options.port, "Server UDP port");
+    app.add_option("--psk-file", options.psk_file, "Pre-shared key file (32 bytes)")->required();
+    app.add_option("--sessions,-n", options.sessions, "Concurrent sessions to open");
+    app.add_option("--threads,-t", options.threads, "Worker threads, each with its own event loop");
+    app.add_option("--ramp-rate", options.ramp_rate, "New handshakes per second during ramp-up");
+    app.add_option("--duration-s", options.duration_s, "Seconds of traffic after ramp-up completes");
+    app.add_option("--pattern", options.pattern, "Traffic pattern")
+        ->check(CLI::IsMember({"bulk", "interactive", "idle"}));
+    app.add_option("--rate", options.rate, "Packets per second per session (0 = pattern default)");
+    app.add_option("--size", options.size, "Inner IP packet size in bytes (0 = pattern default)");
+    app.add_option("--heartbeat-s", options.heartbeat_s, "Heartbeat interval for the idle pattern");
+    app.add_option("--probe-interval-s", options.probe_interval_s,
+                   "Latency probe interval for the bulk pattern");
+    app.add_option("--handshake-timeout-s", options.handshake_timeout_s,
+                   "Seconds to wait for a handshake response");
+    app.add_option("--handshake-attempts", options.handshake_attempts,
+                   "Handshake attempts before a session counts as failed");
+    app.add_option("--server-tun-ip", options.server_tun_ip, "Server TUN address (probe target)");
+    app.add_option("--pool-end", options.pool_end, "Last address of the server's client IP pool");
+    app.add_option("--sink-port", options.sink_port, "Destination UDP port for bulk traffic");
+    app.add_option("--server-pid", options.server_pid, "veil-server PID for RSS sampling");
+    app.add_option("--memory-budget-mib", options.memory_budget_mib,
+                   "Server memory budget per 1000 sessions");
+    app.add_option("--loss-threshold", options.loss_threshold,
+                   "Probe loss that marks the server as saturated");
+    app.add_option("--seed", options.seed, "Random seed for traffic timing");
+    app.add_flag("--json,-j", options.json, "JSON output");
+
+    CLI11_PARSE(app, argc, argv);
+
+    logging::configure_logging(logging::LogLevel::warn, true);
+
+    if (options.sessions == 0 || options.threads == 0 || options.ramp_rate <= 0.0 ||
+        options.heartbeat_s <= 0.0 || options.probe_interval_s <= 0.0 || options.rate < 0.0) {
+      std::cerr << "Error: sessions, threads, rates and intervals must be positive\n";
+      return 1;
+    }
+
+    Shared shared;
+    shared.options = options;
+    shared.answered = std::vector<std::atomic<bool>>(options.sessions);
+    if (!load_psk(options.psk_file, shared.psk)) {
+      std::cerr << "Error: cannot read a 32-byte key from " << options.psk_file << '\n';
+      return 1;
+    }
+    if (!parse_ipv4(options.server_tun_ip, shared.server_tun_ip) ||
+        !parse_ipv4(options.pool_end, shared.pool_end)) {
+      std::cerr << "Error: invalid --server-tun-ip or --pool-end\n";
+      return 1;
+    }
+    shared.server = transport::UdpEndpoint{options.host, options.port};
+
+    if (options.pattern == "bulk") {
+      shared.pattern = Pattern::kBulk;
+      shared.rate = options.rate > 0.0 ? options.rate : 100.0;
+      shared.size = options.size > 0 ? options.size : 1200;
+    } else if (options.pattern == "idle") {
+      shared.pattern = Pattern::kIdle;
+      shared.rate = 1.0 / options.heartbeat_s;
+      shared.size = options.size > 0 ? options.size : kMinProbeSize;
+    } else {
+      shared.pattern = Pattern::kInteractive;
+      shared.rate = options.rate > 0.0 ? options.rate : 10.0;
+      shared.size = options.size > 0 ? options.size : 100;
+    }
+
+    raise_fd_limit(options.sessions + 64);
+
+    const auto server_rss_before =
+        options.server_pid > 0 ? read_rss_bytes(options.server_pid) : std::nullopt;
+    const double cpu_before = cpu_seconds();
+    const double ramp_s = static_cast<double>(options.sessions) / options.ramp_rate;
+    shared.start = Clock::now() + std::chrono::milliseconds(100);
+    shared.traffic_end = shared.start + std::chrono::duration_cast<Clock::duration>(
+                                            std::chrono::duration<double>(ramp_s + options.duration_s));
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (std::size_t i = 0; i < options.threads; ++i) {
+      workers.push_back(std::make_unique<Worker>(shared, i));
+      workers.back()->start();
+    }
+
+    // Sample the shared counters once per second until the workers stop.
+    const auto& c = shared.counters;
+    if (!options.json) {
+      std::cout << "t_s,established,handshakes_per_s,handshakes_failed,tx_pps,rx_pps,probe_loss,"
+                   "server_rss_mib\n";
+    }
+    std::vector<Sample> timeline;
+    std::optional<Sample> saturation;
+    std::optional<std::uint64_t> server_rss_peak = server_rss_before;
+    std::uint64_t last_hs = 0;
+    std::uint64_t last_tx = 0;
+    std::uint64_t last_rx = 0;
+    std::uint64_t last_probes = 0;
+    std::uint64_t last_answered = 0;
+    auto last = shared.start;
+    const auto end = shared.traffic_end + kDrainTime;
+    for (auto next = shared.start + std::chrono::seconds(1); last < end;
+         next += std::chrono::seconds(1)) {
+      std::this_thread::sleep_until(std::min(next, end));
+      const auto now = Clock::now();
+      const double dt = std::chrono::duration<double>(now - last).count();
+      last = now;
+
+      Sample s;
+      s.t = std::chrono::duration<double>(now - shared.start).count();
+      s.established = count(c.established);
+      s.handshakes_failed = count(c.handshakes_failed);
+      const auto hs = count(c.handshakes_completed);
+      const auto tx = count(c.packets_sent);
+      const auto rx = count(c.packets_received);
+      const auto probes = count(c.probes_sent);
+      const auto answered = count(c.probes_answered);
+      s.handshakes_per_s = static_cast<double>(hs - last_hs) / dt;
+      s.tx_pps = static_cast<double>(tx - last_tx) / dt;
+      s.rx_pps = static_cast<double>(rx - last_rx) / dt;
+      if (probes > last_probes) {
+        const auto sent = static_cast<double>(probes - last_probes);
+        s.probe_loss = std::max(0.0, 1.0 - static_cast<double>(answered - last_answered) / sent);
+      }
+      last_hs = hs;
+      last_tx = tx;
+      last_rx = rx;
+      last_probes = probes;
+      last_answered = answered;
+
+      if (options.server_pid > 0) {
+        s.server_rss = read_rss_bytes(options.server_pid);
+        if (s.server_rss && (!server_rss_peak || *s.server_rss > *server_rss_peak)) {
+          server_rss_peak = s.server_rss;
+        }
+      }
+      if (!saturation && now < shared.traffic_end &&
+          (s.handshakes_failed > 0 || s.probe_loss > options.loss_threshold)) {
+        saturation = s;
+      }
+      if (!options.json) {
+        print_sample(s);
+      }
+      timeline.push_back(s);
+    }
+
+    std::vector<double> handshake_ms;
+    std::vector<double> rtt_ms;
+    for (auto& worker : workers) {
+      worker->join();
+      handshake_ms.insert(handshake_ms.end(), worker->handshake_ms().begin(),
+                          worker->handshake_ms().end());
+      rtt_ms.insert(rtt_ms.end(), worker->rtt_ms().begin(), worker->rtt_ms().end());
+    }
+    const double wall_s = std::chrono::duration<double>(Clock::now() - shared.start).count();
+    const double cpu_percent = 100.0 * (cpu_seconds() - cpu_before) / wall_s;
+
+    std::size_t unresponsive = 0;
+    for (std::size_t i = 0; i < shared.answered.size(); ++i) {
+      if (!shared.answered[i].load(std::memory_order_relaxed)) {
+        ++unresponsive;
+      }
+    }
+    // Only sessions that sent probes can be judged.
+    unresponsive -= std::min<std::size_t>(unresponsive, options.sessions - count(c.established));
+
+    const auto hs_latency = percentiles(std::move(handshake_ms));
+    const auto rtt = percentiles(std::move(rtt_ms));
+    const double ramp_wall = std::max(ramp_s, 1e-3);
+
+    nlohmann::json summary = {
+        {"sessions", options.sessions},
+        {"threads", options.threads},
+        {"pattern", options.pattern},
+        {"established", count(c.established)},
+        {"unresponsive_sessions", unresponsive},
+        {"socket_failures", count(c.sockets_failed)},
+        {"handshakes_sent", count(c.handshakes_sent)},
+        {"handshakes_completed", count(c.handshakes_completed)},
+        {"handshakes_failed", count(c.handshakes_failed)},
+        {"handshakes_per_s", static_cast<double>(count(c.handshakes_completed)) / ramp_wall},
+        {"handshake_latency", percentiles_json(hs_latency)},
+        {"packets_sent", count(c.packets_sent)},
+        {"bytes_sent", count(c.bytes_sent)},
+        {"packets_received", count(c.packets_received)},
+        {"bytes_received", count(c.bytes_received)},
+        {"acks_sent", count(c.acks_sent)},
+        {"send_errors", count(c.send_errors)},
+        {"packets_rejected", count(c.packets_rejected)},
+        {"probes_sent", count(c.probes_sent)},
+        {"probes_answered", count(c.probes_answered)},
+        {"probe_rtt", percentiles_json(rtt)},
+        {"loadgen_cpu_percent", cpu_percent},
+        {"wall_seconds", wall_s},
+    };
+    if (saturation) {
+      summary["saturation"] = sample_json(*saturation);
+    }
+    std::optional<double> mib_per_1000;
+    if (server_rss_before && server_rss_peak && count(c.established) > 0) {
+      const auto growth = static_cast<double>(*server_rss_peak - *server_rss_before);
+      mib_per_1000 = growth / (1024.0 * 1024.0) * 1000.0 / static_cast<double>(count(c.established));
+      summary["server_rss_before_mib"] = static_cast<double>(*server_rss_before) / (1024.0 * 1024.0);
+      summary["server_rss_peak_mib"] = static_cast<double>(*server_rss_peak) / (1024.0 * 1024.0);
+      summary["server_mib_per_1000_sessions"] = *mib_per_1000;
+      summary["memory_budget_met"] = *mib_per_1000 <= options.memory_budget_mib;
+    }
+
+    if (options.json) {
+      auto samples = nlohmann::json::array();
+      for (const auto& s : timeline) {
+        samples.push_back(sample_json(s));
+      }
+      summary["timeline"] = std::move(samples);
+      std::cout << std::setw(2) << summary << '\n';
+    } else {
+      std::cout << std::fixed << std::setprecision(2) << '\n'
+                << "Established:      " << count(c.established) << " / " << options.sessions
+                << " (" << count(c.handshakes_failed) << " handshake failures, "
+                << count(c.sockets_failed) << " socket failures, " << unresponsive
+                << " unresponsive)\n"
+                << "Handshakes:       " << summary["handshakes_per_s"].get<double>()
+                << "/s, latency p50 " << hs_latency.p50 << " ms, p99 " << hs_latency.p99
+                << " ms, max " << hs_latency.max << " ms\n"
+                << "Probe RTT:        p50 " << rtt.p50 << " ms, p90 " << rtt.p90 << " ms, p99 "
+                << rtt.p99 << " ms (" << count(c.probes_answered) << " / "
+                << count(c.probes_sent) << " answered)\n"
+                << "Packets:          " << count(c.packets_sent) << " sent, "
+                << count(c.packets_received) << " received, " << count(c.send_errors)
+                << " send errors, " << count(c.packets_rejected) << " rejected\n"
+                << "Loadgen CPU:      " << cpu_percent << "%\n";
+      if (saturation) {
+        std::cout << "Saturation:       at t=" << saturation->t << " s with "
+                  << saturation->established << " sessions (probe loss "
+                  << saturation->probe_loss << ", " << saturation->handshakes_failed
+                  << " handshake failures)\n";
+      }
+      if (mib_per_1000) {
+        std::cout << "Server memory:    " << *mib_per_1000 << " MiB per 1000 sessions (budget "
+                  << options.memory_budget_mib << " MiB): "
+                  << (*mib_per_1000 <= options.memory_budget_mib ? "PASS" : "FAIL") << '\n';
+      }
+    }
+    return count(c.established) == options.sessions ? 0 : 2;
+
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << '\n';
+    return 1;
+  }
+}
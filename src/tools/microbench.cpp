@@ -0,0 +1,493 @@
+// VEIL Microbenchmarks
+//
+// Google Benchmark cases for the per-packet hot paths of the transport and
+// crypto layers. Each case isolates one primitive so that a change can be
+// attributed to a single component before it shows up in end-to-end numbers
+// from veil-transport-bench.
+//
+// Usage:
+//   veil-microbench                                   # JSON to stdout
+//   veil-microbench --benchmark_filter=Aead           # subset
+//   veil-microbench --benchmark_out=before.json       # JSON to file
+//   veil-microbench --benchmark_format=console        # human-readable
+//
+// Output is JSON unless a --benchmark_format flag is given explicitly, so
+// results can be diffed with Google Benchmark's tools/compare.py.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/crypto/crypto_engine.h"
+#include "common/obfuscation/obfuscation_profile.h"
+#include "common/obfuscation/obfuscation_schedule.h"
+#include "common/protocol_wrapper/websocket_wrapper.h"
+#include "common/session/replay_window.h"
+#include "common/utils/timer_heap.h"
+#include "server/route_table.h"
+#include "transport/mux/fragment_reassembly.h"
+#include "transport/mux/mux_codec.h"
+#include "transport/mux/retransmit_buffer.h"
+
+namespace {
+
+using namespace veil;
+
+// Payload sizes covering ACK-sized, typical and full-MTU packets.
+constexpr std::int64_t kSizes[] = {64, 256, 512, 1024, 1350, 1500, 9000};
+
+std::vector<std::uint8_t> make_payload(std::size_t size) {
+  std::vector<std::uint8_t> data(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    data[i] = static_cast<std::uint8_t>(i * 31U + 7U);
+  }
+  return data;
+}
+
+std::array<std::uint8_t, crypto::kAeadKeyLen> make_key(std::uint8_t fill) {
+  std::array<std::uint8_t, crypto::kAeadKeyLen> key{};
+  key.fill(fill);
+  return key;
+}
+
+void size_args(benchmark::internal::Benchmark* b) {
+  for (const auto size : kSizes) {
+    b->Arg(size);
+  }
+}
+
+// ============================================================================
+// Crypto
+// ============================================================================
+
+void BM_AeadEncrypt(benchmark::State& state) {
+  const auto key = make_key(0x11);
+  const std::array<std::uint8_t, crypto::kNonceLen> base_nonce{};
+  const auto plaintext = make_payload(static_cast<std::size_t>(state.range(0)));
+  std::uint64_t counter = 0;
+  for (auto _ : state) {
+    const auto nonce = crypto::derive_nonce(base_nonce, counter++);
+    auto ciphertext = crypto::aead_encrypt(key, nonce, {}, plaintext);
+    benchmark::DoNotOptimize(ciphertext.data());
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_AeadEncrypt)->Apply(size_args);
+
+void BM_AeadDecrypt(benchmark::State& state) {
+  const auto key = make_key(0x22);
+  const std::array<std::uint8_t, crypto::kNonceLen> nonce{};
+  const auto plaintext = make_payload(static_cast<std::size_t>(state.range(0)));
+  const auto ciphertext = crypto::aead_encrypt(key, nonce, {}, plaintext);
+  for (auto _ : state) {
+    auto decrypted = crypto::aead_decrypt(key, nonce, {}, ciphertext);
+    benchmark::DoNotOptimize(decrypted);
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_AeadDecrypt)->Apply(size_args);
+
+// Authentication failure path: a tampered packet must be rejected as cheaply
+// as a valid one is accepted, since it is reachable by any off-path sender.
+void BM_AeadDecryptReject(benchmark::State& state) {
+  const auto key = make_key(0x33);
+  const std::array<std::uint8_t, crypto::kNonceLen> nonce{};
+  const auto plaintext = make_payload(static_cast<std::size_t>(state.range(0)));
+  auto ciphertext = crypto::aead_encrypt(key, nonce, {}, plaintext);
+  ciphertext.back() ^= 0x01;
+  for (auto _ : state) {
+    auto decrypted = crypto::aead_decrypt(key, nonce, {}, ciphertext);
+    benchmark::DoNotOptimize(decrypted);
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_AeadDecryptReject)->Arg(64)->Arg(1350);
+
+void BM_ObfuscateSequence(benchmark::State& state) {
+  const auto key = make_key(0x44);
+  std::uint64_t seq = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(crypto::obfuscate_sequence(seq++, key));
+  }
+}
+BENCHMARK(BM_ObfuscateSequence);
+
+void BM_DeobfuscateSequence(benchmark::State& state) {
+  const auto key = make_key(0x55);
+  std::uint64_t seq = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(crypto::deobfuscate_sequence(seq++, key));
+  }
+}
+BENCHMARK(BM_DeobfuscateSequence);
+
+// derive_value() is internal to obfuscation_profile.cpp; compute_prefix_size()
+// is a single derive_value() call plus a modulo, so it measures the same path.
+void BM_DeriveValue(benchmark::State& state) {
+  obfuscation::ObfuscationProfile profile;
+  profile.profile_seed.fill(0x5A);
+  std::uint64_t seq = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(obfuscation::compute_prefix_size(profile, seq++));
+  }
+}
+BENCHMARK(BM_DeriveValue);
+
+void BM_ComputeAdvancedPadding(benchmark::State& state) {
+  obfuscation::ObfuscationProfile profile;
+  profile.profile_seed.fill(0x5A);
+  profile.use_advanced_padding = true;
+  std::uint64_t seq = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(obfuscation::compute_advanced_padding_size(profile, seq++));
+  }
+}
+BENCHMARK(BM_ComputeAdvancedPadding);
+
+// The send path's lookup once ObfuscationSchedule is ahead; the refill
+// runs outside the timed region, as the event loop runs it between sends.
+void BM_ObfuscationScheduleLookup(benchmark::State& state) {
+  obfuscation::ObfuscationProfile profile;
+  profile.profile_seed.fill(0x5A);
+  profile.use_advanced_padding = true;
+  obfuscation::ObfuscationSchedule schedule(profile);
+  std::uint64_t seq = 0;
+  for (auto _ : state) {
+    if (schedule.needs_refill()) {
+      state.PauseTiming();
+      schedule.refill();
+      state.ResumeTiming();
+    }
+    benchmark::DoNotOptimize(schedule.at(seq++));
+  }
+}
+BENCHMARK(BM_ObfuscationScheduleLookup);
+
+// ============================================================================
+// Replay protection
+// ============================================================================
+
+void BM_ReplayWindowInOrder(benchmark::State& state) {
+  session::ReplayWindow window(static_cast<std::size_t>(state.range(0)));
+  std::uint64_t seq = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(window.mark_and_check(seq++));
+  }
+}
+BENCHMARK(BM_ReplayWindowInOrder)->Arg(1024)->Arg(4096);
+
+// Sequences arrive in blocks of 16 with the block reversed, so every packet
+// except the first in a block lands below the current head.
+void BM_ReplayWindowReordered(benchmark::State& state) {
+  session::ReplayWindow window(static_cast<std::size_t>(state.range(0)));
+  std::uint64_t base = 0;
+  std::uint64_t offset = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(window.mark_and_check(base + 15 - offset));
+    if (++offset == 16) {
+      offset = 0;
+      base += 16;
+    }
+  }
+}
+BENCHMARK(BM_ReplayWindowReordered)->Arg(1024)->Arg(4096);
+
+// Sequence jumps larger than the window force a full bitmap reset.
+void BM_ReplayWindowJump(benchmark::State& state) {
+  session::ReplayWindow window(1024);
+  std::uint64_t seq = 0;
+  for (auto _ : state) {
+    seq += 2048;
+    benchmark::DoNotOptimize(window.mark_and_check(seq));
+  }
+}
+BENCHMARK(BM_ReplayWindowJump);
+
+// ============================================================================
+// Mux codec
+// ============================================================================
+
+void BM_MuxEncodeData(benchmark::State& state) {
+  const auto frame =
+      mux::make_data_frame(1, 42, false, make_payload(static_cast<std::size_t>(state.range(0))));
+  for (auto _ : state) {
+    auto encoded = mux::MuxCodec::encode(frame);
+    benchmark::DoNotOptimize(encoded.data());
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_MuxEncodeData)->Arg(64)->Arg(1350);
+
+void BM_MuxDecodeData(benchmark::State& state) {
+  const auto encoded = mux::MuxCodec::encode(
+      mux::make_data_frame(1, 42, false, make_payload(static_cast<std::size_t>(state.range(0)))));
+  for (auto _ : state) {
+    auto decoded = mux::MuxCodec::decode(encoded);
+    benchmark::DoNotOptimize(decoded);
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_MuxDecodeData)->Arg(64)->Arg(1350);
+
+void BM_MuxEncodeAck(benchmark::State& state) {
+  const auto frame = mux::make_ack_frame(1, 1000, 0xFFFF00FFU);
+  for (auto _ : state) {
+    auto encoded = mux::MuxCodec::encode(frame);
+    benchmark::DoNotOptimize(encoded.data());
+  }
+}
+BENCHMARK(BM_MuxEncodeAck);
+
+void BM_MuxDecodeAck(benchmark::State& state) {
+  const auto encoded = mux::MuxCodec::encode(mux::make_ack_frame(1, 1000, 0xFFFF00FFU));
+  for (auto _ : state) {
+    auto decoded = mux::MuxCodec::decode(encoded);
+    benchmark::DoNotOptimize(decoded);
+  }
+}
+BENCHMARK(BM_MuxDecodeAck);
+
+// ============================================================================
+// Retransmit buffer
+// ============================================================================
+
+mux::RetransmitConfig bench_retransmit_config() {
+  mux::RetransmitConfig config;
+  config.max_buffer_bytes = static_cast<std::size_t>(64) * 1024 * 1024;
+  config.high_water_mark = config.max_buffer_bytes;
+  config.low_water_mark = config.max_buffer_bytes;
+  config.enable_burst_protection = false;
+  return config;
+}
+
+// Steady state: insert one packet and ACK the one inserted N packets earlier,
+// keeping N packets in flight.
+void BM_RetransmitInsertAck(benchmark::State& state) {
+  const auto in_flight = static_cast<std::uint64_t>(state.range(0));
+  mux::RetransmitBuffer buffer(bench_retransmit_config());
+  const auto payload = make_payload(1350);
+  std::uint64_t seq = 0;
+  for (; seq < in_flight; ++seq) {
+    buffer.insert(seq, payload);
+  }
+  for (auto _ : state) {
+    buffer.insert(seq, payload);
+    benchmark::DoNotOptimize(buffer.acknowledge(seq - in_flight));
+    ++seq;
+  }
+}
+BENCHMARK(BM_RetransmitInsertAck)->Arg(64)->Arg(1024);
+
+void BM_RetransmitAckCumulative(benchmark::State& state) {
+  const auto batch = static_cast<std::uint64_t>(state.range(0));
+  mux::RetransmitBuffer buffer(bench_retransmit_config());
+  const auto payload = make_payload(1350);
+  std::uint64_t seq = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (std::uint64_t i = 0; i < batch; ++i) {
+      buffer.insert(seq + i, payload);
+    }
+    state.ResumeTiming();
+    buffer.acknowledge_cumulative(seq + batch - 1);
+    seq += batch;
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_RetransmitAckCumulative)->Arg(32)->Arg(256);
+
+// Timer scan with N packets in flight and none of them due yet: this is the
+// cost paid on every event-loop iteration.
+void BM_RetransmitScan(benchmark::State& state) {
+  mux::RetransmitBuffer buffer(bench_retransmit_config());
+  const auto payload = make_payload(1350);
+  for (std::uint64_t seq = 0; seq < static_cast<std::uint64_t>(state.range(0)); ++seq) {
+    buffer.insert(seq, payload);
+  }
+  for (auto _ : state) {
+    auto due = buffer.get_packets_to_retransmit();
+    benchmark::DoNotOptimize(due.data());
+  }
+}
+BENCHMARK(BM_RetransmitScan)->Arg(64)->Arg(1024);
+
+// ============================================================================
+// Fragment reassembly
+// ============================================================================
+
+void BM_FragmentReassembly(benchmark::State& state) {
+  const auto fragments = static_cast<std::size_t>(state.range(0));
+  constexpr std::size_t kChunk = 1024;
+  mux::FragmentReassembly reassembly(static_cast<std::size_t>(16) * 1024 * 1024);
+  const auto chunk = make_payload(kChunk);
+  const auto now = mux::FragmentReassembly::Clock::now();
+  std::uint64_t message_id = 0;
+  for (auto _ : state) {
+    // Deliver in reverse so the reassembler has to order the fragments.
+    for (std::size_t i = fragments; i-- > 0;) {
+      mux::Fragment frag;
+      frag.offset = static_cast<std::uint16_t>(i * kChunk);
+      frag.data = chunk;
+      frag.last = (i + 1 == fragments);
+      reassembly.push(message_id, std::move(frag), now);
+    }
+    auto message = reassembly.try_reassemble(message_id);
+    benchmark::DoNotOptimize(message);
+    ++message_id;
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(fragments * kChunk));
+}
+BENCHMARK(BM_FragmentReassembly)->Arg(2)->Arg(8)->Arg(32);
+
+// ============================================================================
+// Timer heap
+// ============================================================================
+
+void BM_TimerHeapScheduleCancel(benchmark::State& state) {
+  utils::TimerHeap heap;
+  const auto base = utils::TimerHeap::Clock::now() + std::chrono::hours(1);
+  for (std::int64_t i = 0; i < state.range(0); ++i) {
+    heap.schedule_at(base + std::chrono::microseconds(i), [](utils::TimerId) {});
+  }
+  std::int64_t n = 0;
+  for (auto _ : state) {
+    const auto id = heap.schedule_at(base + std::chrono::microseconds(n++), [](utils::TimerId) {});
+    benchmark::DoNotOptimize(heap.cancel(id));
+  }
+}
+BENCHMARK(BM_TimerHeapScheduleCancel)->Arg(16)->Arg(1024);
+
+// Per-packet retransmit timers are pushed forward on every ACK.
+void BM_TimerHeapReschedule(benchmark::State& state) {
+  utils::TimerHeap heap;
+  const auto base = utils::TimerHeap::Clock::now() + std::chrono::hours(1);
+  std::vector<utils::TimerId> ids;
+  for (std::int64_t i = 0; i < state.range(0); ++i) {
+    ids.push_back(heap.schedule_at(base + std::chrono::microseconds(i), [](utils::TimerId) {}));
+  }
+  std::size_t idx = 0;
+  std::int64_t n = 0;
+  for (auto _ : state) {
+    heap.reschedule(ids[idx], base + std::chrono::milliseconds(++n));
+    idx = (idx + 1) % ids.size();
+  }
+}
+BENCHMARK(BM_TimerHeapReschedule)->Arg(16)->Arg(1024);
+
+void BM_TimerHeapProcessExpired(benchmark::State& state) {
+  auto fake_now = utils::TimerHeap::Clock::now();
+  utils::TimerHeap heap([&fake_now] { return fake_now; });
+  std::uint64_t fired = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (std::int64_t i = 0; i < state.range(0); ++i) {
+      heap.schedule_at(fake_now + std::chrono::microseconds(i), [&fired](utils::TimerId) { ++fired; });
+    }
+    fake_now += std::chrono::seconds(1);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(heap.process_expired());
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+  benchmark::DoNotOptimize(fired);
+}
+BENCHMARK(BM_TimerHeapProcessExpired)->Arg(16)->Arg(256);
+
+// ============================================================================
+// Server routing
+// ============================================================================
+
+// TUN-to-client dispatch with N IPv4 prefixes of /16 to /32 installed.
+void BM_RouteTableLookup(benchmark::State& state) {
+  std::mt19937 rng(1);
+  server::RouteTable table;
+  for (std::int64_t i = 0; i < state.range(0); ++i) {
+    const auto length = static_cast<std::uint8_t>(16 + rng() % 17);
+    tun::Ipv4Prefix prefix{static_cast<std::uint32_t>(rng()), length};
+    prefix.address &= prefix.mask();
+    table.insert(tun::to_ip_prefix(prefix), static_cast<std::uint64_t>(i));
+  }
+  std::vector<std::array<std::uint8_t, 4>> addresses(4096);
+  for (auto& address : addresses) {
+    const auto value = static_cast<std::uint32_t>(rng());
+    std::memcpy(address.data(), &value, sizeof(value));
+  }
+  std::size_t next = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(table.lookup(addresses[next++ & 4095]));
+  }
+}
+BENCHMARK(BM_RouteTableLookup)->Arg(1000)->Arg(100000);
+
+// ============================================================================
+// Protocol wrapper
+// ============================================================================
+
+void BM_WebSocketWrap(benchmark::State& state) {
+  const auto payload = make_payload(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    auto frame = protocol_wrapper::WebSocketWrapper::wrap(payload, true);
+    benchmark::DoNotOptimize(frame.data());
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_WebSocketWrap)->Arg(64)->Arg(1350);
+
+void BM_WebSocketUnwrap(benchmark::State& state) {
+  const auto frame = protocol_wrapper::WebSocketWrapper::wrap(
+      make_payload(static_cast<std::size_t>(state.range(0))), true);
+  for (auto _ : state) {
+    auto payload = protocol_wrapper::WebSocketWrapper::unwrap(frame);
+    benchmark::DoNotOptimize(payload);
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_WebSocketUnwrap)->Arg(64)->Arg(1350);
+
+void BM_WebSocketApplyMask(benchmark::State& state) {
+  auto payload = make_payload(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    protocol_wrapper::WebSocketWrapper::apply_mask(payload, 0xA1B2C3D4U);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_WebSocketApplyMask)->Arg(64)->Arg(1350);
+
+bool has_format_flag(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg(argv[i]);
+    if (arg.starts_with("--benchmark_format") || arg.starts_with("--benchmark_list_tests")) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  // Default to JSON so CI and compare.py can consume stdout directly.
+  std::vector<char*> args(argv, argv + argc);
+  std::string json_flag = "--benchmark_format=json";
+  if (!has_format_flag(argc, argv)) {
+    args.push_back(json_flag.data());
+  }
+  int args_count = static_cast<int>(args.size());
+
+  benchmark::Initialize(&args_count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(args_count, args.data())) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
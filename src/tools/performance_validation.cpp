@@ -11,6 +11,27 @@
 //   veil-performance-validation --test=handshake
 //   veil-performance-validation --test=memory
 //   veil-performance-validation --test=all
+//   veil-performance-validation --test=handshake-scaling --threads=8
+//
+// Handshake scaling (not part of --test=all):
+//   Pre-generates INITs with HandshakeInitiator and drives
+//   HandshakeResponder::handle_init from 1, 2, 4, ... --threads threads, one
+//   responder per thread over a shared HandshakeReplayCache, as a server
+//   does after a restart when every client reconnects at once. Each thread
+//   count runs three phases: valid INITs, the same INITs replayed, and
+//   garbage of INIT size. Reports operations/s, per-call latency and
+//   replay-cache lock contention.
+//
+// Regression baselines:
+//   veil-performance-validation --runs=5 --write-baseline=perf-baseline.json
+//   veil-performance-validation --runs=5 --baseline=perf-baseline.json
+//
+//   Each test is repeated --runs times and every metric (throughput, p99
+//   latencies, handshake rate, memory per session) is compared against the
+//   stored samples with Welch's t-test (see common/metrics/perf_baseline.h).
+//   A metric is flagged only when the change is both significant at
+//   --confidence and larger than --tolerance, and any regression makes the
+//   tool exit non-zero.
 //
 
 #include <CLI/CLI.hpp>
@@ -25,14 +46,21 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <latch>
+#include <malloc.h>
+#include <memory>
 #include <numeric>
+#include <sstream>
 #include <thread>
 #include <vector>
 
 #include "common/crypto/crypto_engine.h"
 #include "common/crypto/random.h"
 #include "common/handshake/handshake_processor.h"
+#include "common/handshake/handshake_replay_cache.h"
 #include "common/logging/logger.h"
+#include "common/metrics/perf_baseline.h"
+#include "common/utils/memory_footprint.h"
 #include "common/utils/rate_limiter.h"
 #include "transport/session/transport_session.h"
 
@@ -56,6 +84,15 @@ struct ValidationConfig {
   std::size_t message_size{1400};
   bool verbose{false};
   bool json_output{false};
+  // Repetitions of each test, giving one sample per run for every metric.
+  int runs{1};
+  std::string baseline_path;
+  std::string write_baseline_path;
+  double tolerance_percent{5.0};
+  double confidence{0.95};
+  // Handshake scaling: highest thread count and INITs handled per thread.
+  int scaling_threads{static_cast<int>(std::max(1U, std::thread::hardware_concurrency()))};
+  int handshakes_per_thread{2000};
 };
 
 // Test results
@@ -74,6 +111,8 @@ struct HandshakeResult {
   double p50_latency_ms{0.0};
   double p95_latency_ms{0.0};
   double p99_latency_ms{0.0};
+  // Sequential handshakes completed per second.
+  double rate_per_sec{0.0};
   std::uint64_t successful{0};
   std::uint64_t failed{0};
   bool passed{false};
@@ -83,14 +122,41 @@ struct MemoryResult {
   std::size_t rss_kb{0};
   std::size_t virt_kb{0};
   double mb_per_client{0.0};
+  // From TransportSession::memory_footprint(): bytes held per idle session
+  // and the worst case its buffer caps allow.
+  double accounted_bytes_per_client{0.0};
+  double worst_case_bytes_per_client{0.0};
   std::uint64_t num_clients{0};
   bool passed{false};
 };
 
+// One phase of the handshake scaling test at one thread count.
+struct ScalingPhaseResult {
+  int threads{0};
+  std::string phase;
+  std::uint64_t operations{0};
+  std::uint64_t accepted{0};
+  double ops_per_sec{0.0};
+  double p50_latency_us{0.0};
+  double p99_latency_us{0.0};
+  // Replay-cache lookups that had to wait for the mutex.
+  double contended_percent{0.0};
+  double lock_wait_ms{0.0};
+};
+
+struct HandshakeScalingResult {
+  std::vector<ScalingPhaseResult> phases;
+  // Valid handshakes/s at the highest thread count over the single-thread
+  // rate, divided by the thread count.
+  double scaling_efficiency{0.0};
+  bool passed{false};
+};
+
 struct ValidationResults {
   ThroughputResult throughput;
   HandshakeResult handshake;
   MemoryResult memory;
+  HandshakeScalingResult scaling;
   bool all_passed{false};
 };
 
@@ -123,8 +189,14 @@ std::vector<std::uint8_t> get_test_psk() {
   return std::vector<std::uint8_t>(32, 0xAB);
 }
 
-// Create a mock handshake session for testing
-handshake::HandshakeSession create_test_session() {
+// Both ends of a completed handshake.
+struct TestSessionPair {
+  handshake::HandshakeSession initiator;
+  handshake::HandshakeSession responder;
+};
+
+// Create a mock handshake session pair for testing
+TestSessionPair create_test_sessions() {
   auto now_fn = []() { return std::chrono::system_clock::now(); };
   auto steady_fn = []() { return std::chrono::steady_clock::now(); };
 
@@ -144,9 +216,11 @@ handshake::HandshakeSession create_test_session() {
     throw std::runtime_error("Failed to consume response");
   }
 
-  return *session;
+  return TestSessionPair{*session, result->session};
 }
 
+handshake::HandshakeSession create_test_session() { return create_test_sessions().initiator; }
+
 // Test throughput
 ThroughputResult test_throughput(const ValidationConfig& config) {
   std::cout << "\n=== Throughput Test ===\n";
@@ -156,8 +230,11 @@ ThroughputResult test_throughput(const ValidationConfig& config) {
   ThroughputResult result;
   std::vector<double> latencies;
 
-  auto handshake_session = create_test_session();
-  transport::TransportSession session(handshake_session);
+  // Packets go from the initiator to the responder; decrypting with the
+  // sender's own session would fail on every packet.
+  auto handshake_sessions = create_test_sessions();
+  transport::TransportSession session(handshake_sessions.initiator);
+  transport::TransportSession peer(handshake_sessions.responder);
 
   // Generate test data
   std::vector<std::uint8_t> test_data(config.message_size);
@@ -176,7 +253,7 @@ ThroughputResult test_throughput(const ValidationConfig& config) {
 
     // Decrypt (simulate loopback)
     for (const auto& pkt : encrypted) {
-      auto decrypted = session.decrypt_packet(pkt);
+      auto decrypted = peer.decrypt_packet(pkt);
       if (decrypted) {
         result.total_bytes += config.message_size;
         ++result.total_packets;
@@ -231,6 +308,7 @@ HandshakeResult test_handshake(const ValidationConfig& config) {
 
   // Sequential handshakes
   std::cout << "Running " << kSequentialHandshakes << " sequential handshakes...\n";
+  const auto sequential_start = std::chrono::steady_clock::now();
 
   for (int i = 0; i < kSequentialHandshakes; ++i) {
     auto start = std::chrono::steady_clock::now();
@@ -257,6 +335,12 @@ HandshakeResult test_handshake(const ValidationConfig& config) {
     }
   }
 
+  const double sequential_sec =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - sequential_start).count();
+  if (sequential_sec > 0.0) {
+    result.rate_per_sec = static_cast<double>(result.successful) / sequential_sec;
+  }
+
   // Parallel handshakes
   std::cout << "Running " << kParallelHandshakes << " parallel handshakes...\n";
 
@@ -324,6 +408,7 @@ HandshakeResult test_handshake(const ValidationConfig& config) {
   std::cout << "  P95 latency: " << result.p95_latency_ms << " ms "
             << (result.passed ? "[PASS]" : "[FAIL]") << "\n";
   std::cout << "  P99 latency: " << result.p99_latency_ms << " ms\n";
+  std::cout << "  Sequential rate: " << result.rate_per_sec << " handshakes/s\n";
   std::cout << "  Target: <= " << kTargetHandshakeLatencyMs << " ms\n";
   std::cout << "  Successful: " << result.successful << "\n";
   std::cout << "  Failed: " << result.failed << "\n";
@@ -331,6 +416,165 @@ HandshakeResult test_handshake(const ValidationConfig& config) {
   return result;
 }
 
+// Drive handle_init over `inits` from `threads` threads, thread i taking the
+// i-th contiguous slice with its own responder.
+ScalingPhaseResult run_scaling_phase(
+    const char* phase, const std::vector<std::vector<std::uint8_t>>& inits,
+    std::vector<std::unique_ptr<handshake::HandshakeResponder>>& responders,
+    handshake::HandshakeReplayCache& cache) {
+  const auto threads = responders.size();
+  const auto per_thread = inits.size() / threads;
+  std::vector<std::vector<double>> latencies(threads);
+  std::atomic<std::uint64_t> accepted{0};
+  std::latch ready(static_cast<std::ptrdiff_t>(threads) + 1);
+
+  cache.reset_stats();
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (std::size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      auto& samples = latencies[t];
+      samples.reserve(per_thread);
+      std::uint64_t ok = 0;
+      ready.arrive_and_wait();
+      for (std::size_t i = t * per_thread; i < (t + 1) * per_thread; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto result = responders[t]->handle_init(inits[i]);
+        samples.push_back(std::chrono::duration<double, std::micro>(
+                              std::chrono::steady_clock::now() - start)
+                              .count());
+        if (result) {
+          ++ok;
+        }
+      }
+      accepted += ok;
+    });
+  }
+  ready.arrive_and_wait();
+  const auto start = std::chrono::steady_clock::now();
+  for (auto& w : workers) {
+    w.join();
+  }
+  const double elapsed_sec =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::vector<double> all;
+  all.reserve(per_thread * threads);
+  for (const auto& samples : latencies) {
+    all.insert(all.end(), samples.begin(), samples.end());
+  }
+
+  ScalingPhaseResult result;
+  result.threads = static_cast<int>(threads);
+  result.phase = phase;
+  result.operations = all.size();
+  result.accepted = accepted.load();
+  if (elapsed_sec > 0.0) {
+    result.ops_per_sec = static_cast<double>(result.operations) / elapsed_sec;
+  }
+  if (!all.empty()) {
+    result.p50_latency_us = percentile(all, 0.50);
+    result.p99_latency_us = percentile(all, 0.99);
+  }
+  const auto stats = cache.stats();
+  if (stats.lookups > 0) {
+    result.contended_percent =
+        100.0 * static_cast<double>(stats.contended) / static_cast<double>(stats.lookups);
+  }
+  result.lock_wait_ms = std::chrono::duration<double, std::milli>(stats.wait_time).count();
+  return result;
+}
+
+// Test handshake throughput and its scaling across threads
+HandshakeScalingResult test_handshake_scaling(const ValidationConfig& config) {
+  std::cout << "\n=== Handshake Scaling Test ===\n";
+  std::cout << "Threads: up to " << config.scaling_threads << ", "
+            << config.handshakes_per_thread << " INITs per thread\n";
+
+  HandshakeScalingResult result;
+  const auto per_thread = static_cast<std::size_t>(config.handshakes_per_thread);
+
+  // Pin both sides to one instant so pre-generated INITs stay inside the
+  // skew window however long generation and the run take.
+  const auto fixed_now = std::chrono::system_clock::now();
+  auto now_fn = [fixed_now]() { return fixed_now; };
+  auto steady_fn = []() { return std::chrono::steady_clock::now(); };
+
+  std::vector<int> thread_counts;
+  for (int t = 1; t < config.scaling_threads; t *= 2) {
+    thread_counts.push_back(t);
+  }
+  thread_counts.push_back(config.scaling_threads);
+
+  bool all_as_expected = true;
+  double single_thread_rate = 0.0;
+  double top_rate = 0.0;
+  for (const int threads : thread_counts) {
+    const auto total = per_thread * static_cast<std::size_t>(threads);
+
+    // INIT generation costs an X25519 keypair each; keep it out of the timing.
+    std::vector<std::vector<std::uint8_t>> inits;
+    std::vector<std::vector<std::uint8_t>> garbage;
+    inits.reserve(total);
+    garbage.reserve(total);
+    for (std::size_t i = 0; i < total; ++i) {
+      handshake::HandshakeInitiator initiator(get_test_psk(), 200ms, now_fn);
+      inits.push_back(initiator.create_init());
+      garbage.push_back(crypto::random_bytes(inits.back().size()));
+    }
+
+    // One responder per thread, as a multi-threaded server would run them.
+    auto cache = std::make_shared<handshake::HandshakeReplayCache>(total);
+    std::vector<std::unique_ptr<handshake::HandshakeResponder>> responders;
+    for (int t = 0; t < threads; ++t) {
+      responders.push_back(std::make_unique<handshake::HandshakeResponder>(
+          get_test_psk(), 200ms,
+          utils::TokenBucket(3.0 * static_cast<double>(total), 1ms, steady_fn), cache, now_fn));
+    }
+
+    const auto valid = run_scaling_phase("valid", inits, responders, *cache);
+    const auto replayed = run_scaling_phase("replayed", inits, responders, *cache);
+    const auto junk = run_scaling_phase("garbage", garbage, responders, *cache);
+
+    all_as_expected = all_as_expected && valid.accepted == valid.operations &&
+                      replayed.accepted == 0 && junk.accepted == 0;
+    if (threads == 1) {
+      single_thread_rate = valid.ops_per_sec;
+    }
+    top_rate = valid.ops_per_sec;
+
+    result.phases.push_back(valid);
+    result.phases.push_back(replayed);
+    result.phases.push_back(junk);
+  }
+
+  if (single_thread_rate > 0.0) {
+    result.scaling_efficiency =
+        top_rate / (single_thread_rate * static_cast<double>(thread_counts.back()));
+  }
+  result.passed = all_as_expected;
+
+  std::cout << "\nResults:\n";
+  std::cout << "  Threads  Phase     " << std::setw(12) << "ops/s" << std::setw(10) << "p50 us"
+            << std::setw(10) << "p99 us" << std::setw(10) << "accepted" << std::setw(12)
+            << "contended" << std::setw(12) << "wait ms" << '\n';
+  for (const auto& p : result.phases) {
+    std::cout << "  " << std::setw(7) << p.threads << "  " << std::left << std::setw(8)
+              << p.phase << std::right << std::fixed << std::setprecision(0) << std::setw(12)
+              << p.ops_per_sec << std::setprecision(1) << std::setw(10) << p.p50_latency_us
+              << std::setw(10) << p.p99_latency_us << std::setw(10) << p.accepted
+              << std::setw(11) << p.contended_percent << '%' << std::setprecision(2)
+              << std::setw(12) << p.lock_wait_ms << '\n';
+  }
+  std::cout << "  Scaling efficiency at " << thread_counts.back()
+            << " threads: " << std::setprecision(0) << (result.scaling_efficiency * 100.0)
+            << "%\n";
+  std::cout << "  Valid accepted, replays and garbage rejected: "
+            << (result.passed ? "[PASS]" : "[FAIL]") << '\n';
+
+  return result;
+}
+
 // Test memory footprint
 MemoryResult test_memory(const ValidationConfig& config) {
   std::cout << "\n=== Memory Footprint Test ===\n";
@@ -366,6 +610,16 @@ MemoryResult test_memory(const ValidationConfig& config) {
   result.rss_kb = final_rss;
   result.virt_kb = final_virt;
 
+  utils::MemoryFootprint accounted;
+  for (const auto& session : sessions) {
+    accounted += session->memory_footprint();
+    accounted.reserved += sizeof(transport::TransportSession);
+  }
+  const auto clients = static_cast<double>(config.num_clients);
+  result.accounted_bytes_per_client = static_cast<double>(accounted.reserved) / clients;
+  result.worst_case_bytes_per_client =
+      static_cast<double>(accounted.limit + sizeof(transport::TransportSession)) / clients;
+
   std::size_t delta_kb = final_rss - baseline_rss;
   result.mb_per_client = static_cast<double>(delta_kb) / (static_cast<double>(config.num_clients) * 1024.0);
 
@@ -377,13 +631,18 @@ MemoryResult test_memory(const ValidationConfig& config) {
   std::cout << "  Memory delta: " << (delta_kb / 1024) << " MB\n";
   std::cout << "  Per-client: " << std::fixed << std::setprecision(3)
             << (result.mb_per_client * 1024) << " KB\n";
+  std::cout << "  Accounted per-client: " << (result.accounted_bytes_per_client / 1024.0)
+            << " KB (buffer caps allow " << std::setprecision(0)
+            << (result.worst_case_bytes_per_client / 1024.0) << " KB)\n";
   std::cout << "  Projected @1000 clients: " << std::fixed << std::setprecision(1)
             << (result.mb_per_client * 1000) << " MB "
             << (result.passed ? "[PASS]" : "[FAIL]") << "\n";
   std::cout << "  Target: <= " << kTargetMemoryMb << " MB\n";
 
-  // Clean up
+  // Clean up, returning freed pages so a repeated run starts from a
+  // comparable baseline RSS.
   sessions.clear();
+  malloc_trim(0);
 
   return result;
 }
@@ -410,6 +669,86 @@ void print_json_results(const ValidationResults& results) {
   std::cout << "}\n";
 }
 
+// Append one run's results to the per-metric samples.
+void record_samples(const ValidationConfig& config, const ValidationResults& results,
+                    metrics::PerfBaseline& samples) {
+  using metrics::Direction;
+  const auto add = [&](const char* name, const char* unit, Direction direction, double value) {
+    const auto* existing = samples.find(name);
+    auto metric = existing != nullptr ? *existing : metrics::MetricSamples{name, unit, direction, {}};
+    metric.values.push_back(value);
+    samples.set(std::move(metric));
+  };
+  if (config.test_type == "throughput" || config.test_type == "all") {
+    add("throughput_mbps", "Mbps", Direction::kHigherIsBetter, results.throughput.throughput_mbps);
+    add("throughput_p99_latency_ms", "ms", Direction::kLowerIsBetter,
+        results.throughput.p99_latency_ms);
+  }
+  if (config.test_type == "handshake" || config.test_type == "all") {
+    add("handshake_rate_per_sec", "1/s", Direction::kHigherIsBetter,
+        results.handshake.rate_per_sec);
+    add("handshake_p99_latency_ms", "ms", Direction::kLowerIsBetter,
+        results.handshake.p99_latency_ms);
+  }
+  if (config.test_type == "memory" || config.test_type == "all") {
+    add("memory_kb_per_session", "KB", Direction::kLowerIsBetter,
+        results.memory.mb_per_client * 1024.0);
+    add("memory_accounted_bytes_per_session", "B", Direction::kLowerIsBetter,
+        results.memory.accounted_bytes_per_client);
+  }
+  if (config.test_type == "handshake-scaling" && !results.scaling.phases.empty()) {
+    // Rates at the highest thread count; the last three phases belong to it.
+    const auto top = results.scaling.phases.end() - 3;
+    add("handshake_scaling_valid_per_sec", "1/s", Direction::kHigherIsBetter, top[0].ops_per_sec);
+    add("handshake_scaling_replay_reject_per_sec", "1/s", Direction::kHigherIsBetter,
+        top[1].ops_per_sec);
+    add("handshake_scaling_garbage_reject_per_sec", "1/s", Direction::kHigherIsBetter,
+        top[2].ops_per_sec);
+    add("handshake_scaling_efficiency", "ratio", Direction::kHigherIsBetter,
+        results.scaling.scaling_efficiency);
+  }
+}
+
+// Print the baseline comparison table; returns the number of regressions.
+std::size_t print_comparisons(const std::vector<metrics::MetricComparison>& comparisons,
+                              const ValidationConfig& config) {
+  std::cout << "\n=== Baseline Comparison ===\n";
+  std::cout << "Confidence: " << std::fixed << std::setprecision(0) << (config.confidence * 100.0)
+            << "%, tolerance: " << std::setprecision(1) << config.tolerance_percent << "%\n";
+  std::size_t regressions = 0;
+  for (const auto& c : comparisons) {
+    std::cout << "  " << std::left << std::setw(28) << c.name << std::right << std::setprecision(3)
+              << std::setw(12) << c.baseline.mean << " -> " << std::setw(12) << c.current.mean
+              << ' ' << std::left << std::setw(5) << c.unit << std::right;
+    if (c.verdict == metrics::Verdict::kNoBaseline) {
+      std::cout << "  (not in baseline)\n";
+      continue;
+    }
+    std::cout << std::showpos << std::setprecision(1) << std::setw(8) << c.change_percent << "% ";
+    if (c.significance_tested) {
+      std::cout << '[' << c.change_ci_low_percent << "%, " << c.change_ci_high_percent << "%] ";
+    }
+    std::cout << std::noshowpos;
+    switch (c.verdict) {
+      case metrics::Verdict::kRegressed:
+        ++regressions;
+        std::cout << "[REGRESSED]";
+        break;
+      case metrics::Verdict::kImproved:
+        std::cout << "[IMPROVED]";
+        break;
+      default:
+        std::cout << "[OK]";
+        break;
+    }
+    if (!c.significance_tested) {
+      std::cout << " (single run, tolerance only)";
+    }
+    std::cout << '\n';
+  }
+  return regressions;
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -418,16 +757,50 @@ int main(int argc, char** argv) {
 
     ValidationConfig config;
 
-    app.add_option("--test,-t", config.test_type, "Test type: throughput, handshake, memory, all")
-        ->check(CLI::IsMember({"throughput", "handshake", "memory", "all"}));
+    app.add_option("--test,-t", config.test_type,
+                   "Test type: throughput, handshake, memory, all, handshake-scaling")
+        ->check(CLI::IsMember({"throughput", "handshake", "memory", "all", "handshake-scaling"}));
     app.add_option("--duration,-d", config.duration_sec, "Test duration in seconds");
     app.add_option("--clients,-c", config.num_clients, "Number of clients for memory test");
     app.add_option("--size,-s", config.message_size, "Message size in bytes");
     app.add_flag("--verbose,-v", config.verbose, "Verbose output");
     app.add_flag("--json,-j", config.json_output, "JSON output");
+    app.add_option("--runs,-r", config.runs, "Repetitions of each test");
+    app.add_option("--baseline,-b", config.baseline_path, "Compare against a stored baseline");
+    app.add_option("--write-baseline", config.write_baseline_path,
+                   "Write this run's samples as a new baseline");
+    app.add_option("--tolerance", config.tolerance_percent,
+                   "Relative change in percent below which differences are ignored");
+    app.add_option("--confidence", config.confidence, "Confidence level of the regression test");
+    app.add_option("--threads", config.scaling_threads,
+                   "Highest thread count for the handshake scaling test");
+    app.add_option("--handshakes-per-thread", config.handshakes_per_thread,
+                   "INITs each thread handles per phase in the handshake scaling test");
 
     CLI11_PARSE(app, argc, argv);
 
+    if (config.runs < 1 || config.confidence <= 0.0 || config.confidence >= 1.0) {
+      std::cerr << "Error: --runs must be at least 1 and --confidence in (0, 1)\n";
+      return 1;
+    }
+    if (config.scaling_threads < 1 || config.handshakes_per_thread < 1) {
+      std::cerr << "Error: --threads and --handshakes-per-thread must be at least 1\n";
+      return 1;
+    }
+
+    // Load the baseline before spending minutes on the tests.
+    std::optional<metrics::PerfBaseline> baseline;
+    if (!config.baseline_path.empty()) {
+      std::ifstream in(config.baseline_path);
+      std::stringstream text;
+      text << in.rdbuf();
+      baseline = in ? metrics::deserialize_baseline(text.str()) : std::nullopt;
+      if (!baseline) {
+        std::cerr << "Error: cannot read baseline " << config.baseline_path << '\n';
+        return 1;
+      }
+    }
+
     // Initialize logging
     logging::configure_logging(
         config.verbose ? logging::LogLevel::debug : logging::LogLevel::warn, true);
@@ -439,23 +812,37 @@ int main(int argc, char** argv) {
     std::cout << "  Handshake Latency: <= " << kTargetHandshakeLatencyMs << " ms\n";
     std::cout << "  Memory @1000 clients: <= " << kTargetMemoryMb << " MB\n";
 
-    ValidationResults results;
+    const bool run_throughput = config.test_type == "throughput" || config.test_type == "all";
+    const bool run_handshake = config.test_type == "handshake" || config.test_type == "all";
+    const bool run_memory = config.test_type == "memory" || config.test_type == "all";
+    const bool run_scaling = config.test_type == "handshake-scaling";
 
-    if (config.test_type == "throughput" || config.test_type == "all") {
-      results.throughput = test_throughput(config);
-    }
-
-    if (config.test_type == "handshake" || config.test_type == "all") {
-      results.handshake = test_handshake(config);
-    }
-
-    if (config.test_type == "memory" || config.test_type == "all") {
-      results.memory = test_memory(config);
+    // Targets are judged on the last run; every run contributes samples.
+    ValidationResults results;
+    metrics::PerfBaseline samples;
+    for (int run = 1; run <= config.runs; ++run) {
+      if (config.runs > 1) {
+        std::cout << "\n##### Run " << run << " of " << config.runs << " #####\n";
+      }
+      if (run_throughput) {
+        results.throughput = test_throughput(config);
+      }
+      if (run_handshake) {
+        results.handshake = test_handshake(config);
+      }
+      if (run_memory) {
+        results.memory = test_memory(config);
+      }
+      if (run_scaling) {
+        results.scaling = test_handshake_scaling(config);
+      }
+      record_samples(config, results, samples);
     }
 
-    results.all_passed = results.throughput.passed &&
-                         results.handshake.passed &&
-                         results.memory.passed;
+    results.all_passed = (!run_throughput || results.throughput.passed) &&
+                         (!run_handshake || results.handshake.passed) &&
+                         (!run_memory || results.memory.passed) &&
+                         (!run_scaling || results.scaling.passed);
 
     std::cout << "\n=== Summary ===\n";
     if (config.test_type == "all" || config.test_type == "throughput") {
@@ -467,17 +854,40 @@ int main(int argc, char** argv) {
     if (config.test_type == "all" || config.test_type == "memory") {
       std::cout << "Memory: " << (results.memory.passed ? "PASS" : "FAIL") << "\n";
     }
+    if (run_scaling) {
+      std::cout << "Handshake scaling: " << (results.scaling.passed ? "PASS" : "FAIL") << "\n";
+    }
 
     if (config.test_type == "all") {
       std::cout << "\nOverall: " << (results.all_passed ? "ALL TESTS PASSED" : "SOME TESTS FAILED") << "\n";
     }
 
+    std::size_t regressions = 0;
+    if (baseline) {
+      metrics::ComparisonConfig comparison;
+      comparison.confidence = config.confidence;
+      comparison.tolerance = config.tolerance_percent / 100.0;
+      regressions = print_comparisons(baseline->compare(samples, comparison), config);
+      std::cout << (regressions == 0 ? "No regressions against baseline\n"
+                                     : std::to_string(regressions) + " metric(s) regressed\n");
+    }
+
+    if (!config.write_baseline_path.empty()) {
+      std::ofstream out(config.write_baseline_path);
+      out << metrics::serialize_baseline(samples) << '\n';
+      if (!out) {
+        std::cerr << "Error: cannot write baseline " << config.write_baseline_path << '\n';
+        return 1;
+      }
+      std::cout << "Baseline written to " << config.write_baseline_path << '\n';
+    }
+
     if (config.json_output) {
       std::cout << "\n";
       print_json_results(results);
     }
 
-    return results.all_passed ? 0 : 1;
+    return results.all_passed && regressions == 0 ? 0 : 1;
 
   } catch (const std::exception& e) {
     std::cerr << "Error: " << e.what() << '\n';
@@ -0,0 +1,334 @@
+// VEIL Session Simulator
+//
+// Runs many client/server transport sessions over a modelled network on
+// virtual time (see transport/sim/session_simulator.h) and reports goodput,
+// loss and latency. Sweeping one parameter produces one row per value, so a
+// curve for a retransmit, ACK or sender-window setting takes one command.
+//
+// Usage:
+//   veil-sim --sessions=1000 --loss=0.01 --delay-ms=20
+//   veil-sim --loss=0.02 --sweep=min-rto-ms=20,50,100,200
+//   veil-sim --bottleneck-mbps=100 --sweep=window=4,8,16,32,0 --json
+//
+// Output:
+//   CSV (default) or JSON, one record per simulation run.
+//
+
+#include <CLI/CLI.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/logging/logger.h"
+#include "transport/sim/session_simulator.h"
+
+namespace {
+
+using namespace veil;
+
+// A tunable simulation setting, addressable from the command line and by
+// --sweep.
+struct Param {
+  const char* name;
+  const char* help;
+  std::function<void(sim::SimulationConfig&, double)> apply;
+};
+
+std::chrono::milliseconds ms(double value) {
+  return std::chrono::milliseconds(static_cast<std::int64_t>(value));
+}
+
+std::chrono::microseconds us_from_ms(double value) {
+  return std::chrono::microseconds(static_cast<std::int64_t>(value * 1000.0));
+}
+
+const std::vector<Param>& params() {
+  static const std::vector<Param> kParams = {
+      {"sessions", "Number of client sessions",
+       [](sim::SimulationConfig& c, double v) { c.sessions = static_cast<std::size_t>(v); }},
+      {"duration-s", "Seconds of offered traffic",
+       [](sim::SimulationConfig& c, double v) { c.duration = ms(v * 1000.0); }},
+      {"drain-s", "Seconds to run after traffic stops",
+       [](sim::SimulationConfig& c, double v) { c.drain = ms(v * 1000.0); }},
+      {"size", "Message payload size in bytes",
+       [](sim::SimulationConfig& c, double v) {
+         c.traffic.message_size = static_cast<std::size_t>(v);
+       }},
+      {"up-rate", "Uplink messages per second per session",
+       [](sim::SimulationConfig& c, double v) { c.traffic.uplink_rate = v; }},
+      {"down-rate", "Downlink messages per second per session",
+       [](sim::SimulationConfig& c, double v) { c.traffic.downlink_rate = v; }},
+      {"loss", "Random loss probability on each access link",
+       [](sim::SimulationConfig& c, double v) {
+         c.uplink.loss_rate = v;
+         c.downlink.loss_rate = v;
+       }},
+      {"burst-len", "Mean Gilbert-Elliott loss burst length in packets (0 = off)",
+       [](sim::SimulationConfig& c, double v) {
+         for (auto* link : {&c.uplink, &c.downlink}) {
+           link->burst_loss.enabled = v > 0.0;
+           link->burst_loss.p_bad_to_good = v > 0.0 ? 1.0 / v : 1.0;
+           link->burst_loss.p_good_to_bad = v > 0.0 ? 0.01 / v : 0.0;
+         }
+       }},
+      {"delay-ms", "One-way delay on each access link",
+       [](sim::SimulationConfig& c, double v) {
+         c.uplink.delay = us_from_ms(v);
+         c.downlink.delay = us_from_ms(v);
+       }},
+      {"jitter-ms", "Uniform extra delay on each access link",
+       [](sim::SimulationConfig& c, double v) {
+         c.uplink.jitter = us_from_ms(v);
+         c.downlink.jitter = us_from_ms(v);
+       }},
+      {"reorder", "Reorder probability on each access link",
+       [](sim::SimulationConfig& c, double v) {
+         c.uplink.reorder_rate = v;
+         c.downlink.reorder_rate = v;
+       }},
+      {"duplicate", "Duplication probability on each access link",
+       [](sim::SimulationConfig& c, double v) {
+         c.uplink.duplicate_rate = v;
+         c.downlink.duplicate_rate = v;
+       }},
+      {"bottleneck-mbps", "Shared downlink bottleneck rate (0 = none)",
+       [](sim::SimulationConfig& c, double v) {
+         c.shared_downlink.bandwidth_bps = static_cast<std::uint64_t>(v * 1e6);
+       }},
+      {"queue-kb", "Shared downlink bottleneck queue size",
+       [](sim::SimulationConfig& c, double v) {
+         c.shared_downlink.queue_limit_bytes = static_cast<std::size_t>(v * 1024.0);
+       }},
+      {"initial-rtt-ms", "Retransmit initial RTT estimate",
+       [](sim::SimulationConfig& c, double v) {
+         c.transport.retransmit_config.initial_rtt = ms(v);
+       }},
+      {"min-rto-ms", "Retransmit minimum RTO",
+       [](sim::SimulationConfig& c, double v) { c.transport.retransmit_config.min_rto = ms(v); }},
+      {"max-retries", "Retransmit attempts before giving up",
+       [](sim::SimulationConfig& c, double v) {
+         c.transport.retransmit_config.max_retries = static_cast<std::uint32_t>(v);
+       }},
+      {"backoff", "Retransmit backoff factor",
+       [](sim::SimulationConfig& c, double v) {
+         c.transport.retransmit_config.backoff_factor = v;
+       }},
+      {"ack-every", "ACK after this many data packets",
+       [](sim::SimulationConfig& c, double v) {
+         c.ack.ack_every_n_packets = static_cast<std::uint32_t>(v);
+       }},
+      {"ack-delay-ms", "Maximum delayed-ACK time",
+       [](sim::SimulationConfig& c, double v) { c.ack.max_ack_delay = ms(v); }},
+      {"acks-per-rtt", "Request this many ACKs per RTT from the peer (0 = off)",
+       [](sim::SimulationConfig& c, double v) {
+         c.transport.ack_frequency.enabled = v > 0.0;
+         c.transport.ack_frequency.acks_per_rtt = static_cast<std::uint32_t>(v);
+       }},
+      {"window", "Sender window in packets (0 = unlimited)",
+       [](sim::SimulationConfig& c, double v) {
+         c.sender.max_in_flight = static_cast<std::size_t>(v);
+       }},
+      {"pacing-mbps", "Per-session sender pacing rate (0 = off)",
+       [](sim::SimulationConfig& c, double v) {
+         c.sender.pacing_rate_bps = static_cast<std::uint64_t>(v * 1e6);
+       }},
+      {"tick-ms", "Retransmit timer granularity",
+       [](sim::SimulationConfig& c, double v) { c.timer_granularity = ms(v); }},
+  };
+  return kParams;
+}
+
+const Param* find_param(const std::string& name) {
+  for (const auto& param : params()) {
+    if (name == param.name) {
+      return &param;
+    }
+  }
+  return nullptr;
+}
+
+// Parse "name=v1,v2,...".
+bool parse_sweep(const std::string& spec, const Param*& param, std::vector<double>& values) {
+  const auto eq = spec.find('=');
+  if (eq == std::string::npos) {
+    return false;
+  }
+  param = find_param(spec.substr(0, eq));
+  if (param == nullptr) {
+    return false;
+  }
+  std::stringstream ss(spec.substr(eq + 1));
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    try {
+      values.push_back(std::stod(item));
+    } catch (const std::exception&) {
+      return false;
+    }
+  }
+  return !values.empty();
+}
+
+nlohmann::json direction_json(const sim::DirectionResult& d) {
+  return {
+      {"messages_offered", d.messages_offered},
+      {"messages_delivered", d.messages_delivered},
+      {"messages_dropped_sender", d.messages_dropped_sender},
+      {"delivery_ratio", d.delivery_ratio},
+      {"goodput_mbps", d.goodput_bps / 1e6},
+      {"latency_ms",
+       {{"mean", d.latency.mean_ms},
+        {"p50", d.latency.p50_ms},
+        {"p90", d.latency.p90_ms},
+        {"p99", d.latency.p99_ms},
+        {"max", d.latency.max_ms}}},
+      {"data_packets_sent", d.data_packets_sent},
+      {"retransmits", d.retransmits},
+      {"acks_sent", d.acks_sent},
+      {"wire_bytes_sent", d.wire_bytes_sent},
+      {"wire_packets_lost", d.wire_packets_lost},
+      {"goodput_timeline_mbps", [&d] {
+         std::vector<double> mbps;
+         for (const auto bps : d.goodput_timeline_bps) {
+           mbps.push_back(bps / 1e6);
+         }
+         return mbps;
+       }()},
+  };
+}
+
+nlohmann::json result_json(const sim::SimulationResult& r) {
+  return {
+      {"sessions", r.sessions},
+      {"sessions_established", r.sessions_established},
+      {"handshake_attempts", r.handshake_attempts},
+      {"uplink", direction_json(r.uplink)},
+      {"downlink", direction_json(r.downlink)},
+      {"events_processed", r.events_processed},
+      {"virtual_seconds", std::chrono::duration<double>(r.virtual_time).count()},
+      {"wall_seconds", std::chrono::duration<double>(r.wall_time).count()},
+      {"speedup", r.speedup()},
+  };
+}
+
+void print_csv_header(const std::string& sweep_name) {
+  if (!sweep_name.empty()) {
+    std::cout << sweep_name << ',';
+  }
+  std::cout << "established,handshakes";
+  for (const char* dir : {"up", "down"}) {
+    std::cout << ',' << dir << "_offered," << dir << "_delivered," << dir << "_delivery,"
+              << dir << "_goodput_mbps," << dir << "_p50_ms," << dir << "_p99_ms," << dir
+              << "_retransmits," << dir << "_acks," << dir << "_wire_lost";
+  }
+  std::cout << ",events,virtual_s,wall_s,speedup\n";
+}
+
+void print_csv_row(const sim::SimulationResult& r, const std::string& sweep_value) {
+  if (!sweep_value.empty()) {
+    std::cout << sweep_value << ',';
+  }
+  std::cout << r.sessions_established << ',' << r.handshake_attempts;
+  for (const auto* d : {&r.uplink, &r.downlink}) {
+    std::cout << ',' << d->messages_offered << ',' << d->messages_delivered << ','
+              << d->delivery_ratio << ',' << d->goodput_bps / 1e6 << ',' << d->latency.p50_ms
+              << ',' << d->latency.p99_ms << ',' << d->retransmits << ',' << d->acks_sent << ','
+              << d->wire_packets_lost;
+  }
+  std::cout << ',' << r.events_processed << ','
+            << std::chrono::duration<double>(r.virtual_time).count() << ','
+            << std::chrono::duration<double>(r.wall_time).count() << ',' << r.speedup() << '\n';
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  try {
+    CLI::App app{"VEIL Session Simulator"};
+
+    std::vector<double> values(params().size(), std::numeric_limits<double>::quiet_NaN());
+    for (std::size_t i = 0; i < params().size(); ++i) {
+      app.add_option(std::string("--") + params()[i].name, values[i], params()[i].help);
+    }
+    std::uint64_t seed = 1;
+    std::string sweep;
+    bool constant_rate = false;
+    bool json_output = false;
+    app.add_option("--seed", seed, "Master random seed");
+    app.add_option("--sweep", sweep, "Sweep one parameter: name=v1,v2,...");
+    app.add_flag("--constant", constant_rate, "Constant message spacing instead of Poisson");
+    app.add_flag("--json,-j", json_output, "JSON output");
+
+    CLI11_PARSE(app, argc, argv);
+
+    logging::configure_logging(logging::LogLevel::warn, true);
+
+    sim::SimulationConfig base;
+    base.seed = seed;
+    base.traffic.poisson = !constant_rate;
+    for (std::size_t i = 0; i < params().size(); ++i) {
+      if (!std::isnan(values[i])) {
+        params()[i].apply(base, values[i]);
+      }
+    }
+
+    const Param* sweep_param = nullptr;
+    std::vector<double> sweep_values;
+    if (!sweep.empty() && !parse_sweep(sweep, sweep_param, sweep_values)) {
+      std::cerr << "Error: invalid --sweep '" << sweep << "'. Parameters:";
+      for (const auto& param : params()) {
+        std::cerr << ' ' << param.name;
+      }
+      std::cerr << '\n';
+      return 1;
+    }
+    if (sweep_param == nullptr) {
+      sweep_values.push_back(std::numeric_limits<double>::quiet_NaN());
+    }
+
+    const std::string sweep_name = sweep_param != nullptr ? sweep_param->name : "";
+    auto records = nlohmann::json::array();
+    if (!json_output) {
+      print_csv_header(sweep_name);
+    }
+    for (const auto value : sweep_values) {
+      auto config = base;
+      std::string label;
+      if (sweep_param != nullptr) {
+        sweep_param->apply(config, value);
+        std::ostringstream os;
+        os << value;
+        label = os.str();
+      }
+
+      const auto result = sim::run_simulation(config);
+      if (json_output) {
+        auto record = result_json(result);
+        if (sweep_param != nullptr) {
+          record["sweep"] = {{"param", sweep_name}, {"value", value}};
+        }
+        records.push_back(std::move(record));
+      } else {
+        print_csv_row(result, label);
+      }
+    }
+
+    if (json_output) {
+      std::cout << std::setw(2) << records << '\n';
+    }
+    return 0;
+
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << '\n';
+    return 1;
+  }
+}
@@ -1,36 +1,86 @@
 // VEIL Transport Layer Benchmark Tool
 //
 // This tool provides iperf-like functionality for benchmarking the VEIL
-// transport layer. It measures throughput, RTT, and retransmission rates.
+// transport layer. It measures throughput, RTT, retransmission rates and
+// the CPU cost of moving the data.
+//
+// Each client stream is an independent session with its own socket and
+// sender thread. The server runs one receiver thread per SO_REUSEPORT
+// socket; the kernel spreads client flows across them.
 //
 // Usage:
-//   veil-transport-bench --mode=server --port=12345
+//   veil-transport-bench --mode=server --port=12345 --threads=4
 //   veil-transport-bench --mode=client --host=127.0.0.1 --port=12345 --duration=10
+//   veil-transport-bench --mode=client --streams=4 --sizes=64,512,1200 --rate-mbps=100
 //
 // Output:
-//   Throughput (Mbps), RTT (ms), Retransmit rate (%), Data sent/received (MB)
+//   Throughput (Mbps), RTT (ms), Retransmit rate (%), Data sent/received (MB),
+//   CPU utilisation (process, per core and per thread), CPU time and cycles
+//   per byte, and heap allocations per packet. With several --sizes, a
+//   summary table follows the per-size results.
+//
+// Cycles come from perf_event_open and are reported as n/a where hardware
+// counters are unavailable (most VMs and containers).
 //
 
 #include <CLI/CLI.hpp>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <csignal>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <latch>
+#include <map>
+#include <new>
+#include <optional>
+#include <string>
 #include <thread>
 #include <vector>
 
 #include "common/crypto/random.h"
 #include "common/handshake/handshake_processor.h"
 #include "common/logging/logger.h"
+#include "common/utils/allocation_tracker.h"
 #include "common/utils/rate_limiter.h"
 #include "transport/event_loop/event_loop.h"
 #include "transport/session/transport_session.h"
 #include "transport/udp_socket/udp_socket.h"
 
+// Heap allocation counter for the allocations-per-packet figure. Replacing
+// the global operator new in this executable covers every allocation made
+// by the library code it links. The operators stay out of line so the
+// compiler never pairs an inlined free() with a new-expression. Builds with
+// VEIL_ENABLE_ALLOCATION_TRACKING use the library's hook instead, which also
+// splits the count by subsystem.
+#ifndef VEIL_ALLOCATION_TRACKING
+namespace {
+std::atomic<std::uint64_t> g_allocations{0};
+}  // namespace
+
+[[gnu::noinline]] void* operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+  std::free(ptr);
+}
+#endif  // VEIL_ALLOCATION_TRACKING
+
 namespace {
 
 using namespace veil;
@@ -48,12 +98,89 @@ struct BenchConfig {
   std::uint16_t port{12345};
   int duration_sec{10};
   std::size_t message_size{1000};
+  // Message sizes to sweep; overrides message_size when set.
+  std::vector<std::size_t> sizes;
+  // Client: parallel sessions, each with its own socket and thread.
   int num_streams{1};
+  // Server: receiver threads, each with its own SO_REUSEPORT socket.
+  int server_threads{1};
+  // Aggregate client send rate in Mbps (0 = as fast as possible).
+  double rate_mbps{0.0};
   bool verbose{false};
 };
 
+double seconds(const timeval& tv) {
+  return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+}
+
+// CPU seconds (user + system) used by the process or the calling thread.
+double cpu_seconds(int who) {
+  rusage usage{};
+  getrusage(who, &usage);
+  return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+// Process-wide CPU cycle counter. Threads created after open() are counted
+// too (perf inherit).
+class CycleCounter {
+ public:
+  CycleCounter() {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.inherit = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+  ~CycleCounter() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+  CycleCounter(const CycleCounter&) = delete;
+  CycleCounter& operator=(const CycleCounter&) = delete;
+
+  // Cycles of this process and its inherited threads so far. Counts from
+  // threads that have exited are only folded in once they are joined.
+  std::optional<std::uint64_t> read() const {
+    std::uint64_t value = 0;
+    if (fd_ < 0 || ::read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+ private:
+  int fd_{-1};
+};
+
+// Process resource usage at one point in time.
+struct UsageSample {
+  std::chrono::steady_clock::time_point wall;
+  double cpu_sec{0.0};
+  std::optional<std::uint64_t> cycles;
+  std::uint64_t allocations{0};
+  utils::AllocationSnapshot subsystems{};
+
+  static UsageSample take(const CycleCounter& cycles) {
+    UsageSample s;
+    s.wall = std::chrono::steady_clock::now();
+    s.cpu_sec = cpu_seconds(RUSAGE_SELF);
+    s.cycles = cycles.read();
+#ifdef VEIL_ALLOCATION_TRACKING
+    s.subsystems = utils::allocation_snapshot();
+    s.allocations = utils::total_allocations(s.subsystems).allocations;
+#else
+    s.allocations = g_allocations.load(std::memory_order_relaxed);
+#endif
+    return s;
+  }
+};
+
 // Benchmark results.
 struct BenchResults {
+  std::size_t message_size{0};
   std::uint64_t bytes_sent{0};
   std::uint64_t bytes_received{0};
   std::uint64_t packets_sent{0};
@@ -63,6 +190,15 @@ struct BenchResults {
   double avg_rtt_ms{0.0};
   double p95_rtt_ms{0.0};
 
+  // Resource usage over the measurement window.
+  double cpu_sec{0.0};
+  std::optional<std::uint64_t> cycles;
+  std::uint64_t allocations{0};
+  // Allocation counts per subsystem; all zero unless allocation tracking
+  // is compiled in.
+  utils::AllocationSnapshot subsystem_allocations{};
+  std::vector<double> thread_cpu_sec;
+
   double throughput_mbps() const {
     if (duration_sec == 0.0) return 0.0;
     return (static_cast<double>(bytes_sent + bytes_received) * 8.0) / (duration_sec * 1000000.0);
@@ -73,9 +209,59 @@ struct BenchResults {
     return (static_cast<double>(retransmits) / static_cast<double>(packets_sent)) * 100.0;
   }
 
+  // CPU use as a percentage of one core (may exceed 100 with threads).
+  double cpu_percent() const {
+    if (duration_sec == 0.0) return 0.0;
+    return cpu_sec / duration_sec * 100.0;
+  }
+
+  std::uint64_t total_bytes() const { return bytes_sent + bytes_received; }
+  std::uint64_t total_packets() const { return packets_sent + packets_received; }
+
+  double cpu_ns_per_byte() const {
+    if (total_bytes() == 0) return 0.0;
+    return cpu_sec * 1e9 / static_cast<double>(total_bytes());
+  }
+
+  std::optional<double> cycles_per_byte() const {
+    if (!cycles || total_bytes() == 0) return std::nullopt;
+    return static_cast<double>(*cycles) / static_cast<double>(total_bytes());
+  }
+
+  double allocations_per_packet() const {
+    if (total_packets() == 0) return 0.0;
+    return static_cast<double>(allocations) / static_cast<double>(total_packets());
+  }
+
+  void record_usage(const UsageSample& start, const UsageSample& end) {
+    duration_sec = std::chrono::duration<double>(end.wall - start.wall).count();
+    cpu_sec = end.cpu_sec - start.cpu_sec;
+    if (start.cycles && end.cycles) {
+      cycles = *end.cycles - *start.cycles;
+    }
+    allocations = end.allocations - start.allocations;
+    for (std::size_t i = 0; i < subsystem_allocations.size(); ++i) {
+      subsystem_allocations[i].allocations =
+          end.subsystems[i].allocations - start.subsystems[i].allocations;
+      subsystem_allocations[i].bytes = end.subsystems[i].bytes - start.subsystems[i].bytes;
+    }
+  }
+
+  void add(const BenchResults& other) {
+    bytes_sent += other.bytes_sent;
+    bytes_received += other.bytes_received;
+    packets_sent += other.packets_sent;
+    packets_received += other.packets_received;
+    retransmits += other.retransmits;
+  }
+
   void print() const {
+    const auto cores = std::max(1U, std::thread::hardware_concurrency());
     std::cout << "\n=== VEIL Transport Benchmark Results ===\n";
     std::cout << std::fixed << std::setprecision(2);
+    if (message_size != 0) {
+      std::cout << "Message size:     " << message_size << " bytes\n";
+    }
     std::cout << "Duration:         " << duration_sec << " sec\n";
     std::cout << "Bytes sent:       " << (static_cast<double>(bytes_sent) / 1000000.0) << " MB\n";
     std::cout << "Bytes received:   " << (static_cast<double>(bytes_received) / 1000000.0) << " MB\n";
@@ -86,25 +272,81 @@ struct BenchResults {
     std::cout << "Retransmit rate:  " << retransmit_rate() << " %\n";
     std::cout << "Avg RTT:          " << avg_rtt_ms << " ms\n";
     std::cout << "P95 RTT:          " << p95_rtt_ms << " ms\n";
+    std::cout << "CPU:              " << cpu_percent() << " % of one core, "
+              << cpu_percent() / cores << " % of " << cores << " cores\n";
+    for (std::size_t i = 0; i < thread_cpu_sec.size(); ++i) {
+      const double pct = duration_sec == 0.0 ? 0.0 : thread_cpu_sec[i] / duration_sec * 100.0;
+      std::cout << "  Thread " << i << ":       " << pct << " %\n";
+    }
+    std::cout << "CPU per byte:     " << cpu_ns_per_byte() << " ns\n";
+    std::cout << "Cycles per byte:  ";
+    if (const auto cpb = cycles_per_byte()) {
+      std::cout << *cpb << '\n';
+    } else {
+      std::cout << "n/a\n";
+    }
+    std::cout << "Allocs/packet:    " << allocations_per_packet() << '\n';
+    if (utils::allocation_tracking_enabled() && total_packets() != 0) {
+      const auto packets = static_cast<double>(total_packets());
+      for (std::size_t i = 0; i < subsystem_allocations.size(); ++i) {
+        const auto& counts = subsystem_allocations[i];
+        std::cout << "  " << std::left << std::setw(16)
+                  << utils::allocation_subsystem_name(static_cast<utils::AllocationSubsystem>(i))
+                  << std::right << static_cast<double>(counts.allocations) / packets
+                  << " allocs, " << static_cast<double>(counts.bytes) / packets
+                  << " bytes per packet\n";
+      }
+    }
     std::cout << "========================================\n";
   }
 };
 
+void print_summary(const std::vector<BenchResults>& runs) {
+  std::cout << "\n" << std::left << std::setw(8) << "size" << std::right << std::setw(12) << "Mbps"
+            << std::setw(12) << "pkts/s" << std::setw(10) << "cpu %" << std::setw(12) << "ns/byte"
+            << std::setw(14) << "cycles/byte" << std::setw(14) << "allocs/pkt" << std::setw(10)
+            << "rexmit %" << '\n';
+  std::cout << std::fixed << std::setprecision(2);
+  for (const auto& r : runs) {
+    const double pps =
+        r.duration_sec == 0.0 ? 0.0 : static_cast<double>(r.total_packets()) / r.duration_sec;
+    std::cout << std::left << std::setw(8) << r.message_size << std::right << std::setw(12)
+              << r.throughput_mbps() << std::setw(12) << pps << std::setw(10) << r.cpu_percent()
+              << std::setw(12) << r.cpu_ns_per_byte() << std::setw(14);
+    if (const auto cpb = r.cycles_per_byte()) {
+      std::cout << *cpb;
+    } else {
+      std::cout << "n/a";
+    }
+    std::cout << std::setw(14) << r.allocations_per_packet() << std::setw(10)
+              << r.retransmit_rate() << '\n';
+  }
+}
+
 // Simple PSK for benchmarking.
 std::vector<std::uint8_t> get_bench_psk() {
   return std::vector<std::uint8_t>(32, 0xBE);  // Benchmark PSK
 }
 
-// Run server mode.
-int run_server(const BenchConfig& config) {
-  std::cout << "Starting VEIL transport benchmark server on port " << config.port << '\n';
+std::string endpoint_key(const transport::UdpEndpoint& endpoint) {
+  return endpoint.host + ":" + std::to_string(endpoint.port);
+}
 
-  // Create UDP socket.
+// Per-thread server state and counters.
+struct ServerWorker {
+  BenchResults results;
+  double cpu_sec{0.0};
+  std::optional<std::chrono::steady_clock::time_point> first_packet;
+  std::chrono::steady_clock::time_point last_packet;
+};
+
+void run_server_thread(const BenchConfig& config, ServerWorker& worker) {
+  // Create UDP socket. SO_REUSEPORT lets every receiver thread bind the port.
   transport::UdpSocket socket;
   std::error_code ec;
   if (!socket.open(config.port, true, ec)) {
     std::cerr << "Failed to open socket: " << ec.message() << '\n';
-    return 1;
+    return;
   }
 
   // Setup handshake responder.
@@ -113,143 +355,195 @@ int run_server(const BenchConfig& config) {
   utils::TokenBucket bucket(1000.0, 100ms, steady_fn);
   handshake::HandshakeResponder responder(get_bench_psk(), 200ms, std::move(bucket), now_fn);
 
-  std::optional<transport::TransportSession> session;
-  transport::UdpEndpoint client_endpoint;
-  BenchResults results;
-
-  auto start_time = std::chrono::steady_clock::now();
-
-  std::cout << "Waiting for client connection...\n";
+  struct Peer {
+    transport::UdpEndpoint endpoint;
+    std::unique_ptr<transport::TransportSession> session;
+  };
+  std::map<std::string, Peer> peers;
 
   while (g_running.load()) {
     socket.poll(
         [&](const transport::UdpPacket& pkt) {
-          if (!session) {
+          const auto now = std::chrono::steady_clock::now();
+          if (!worker.first_packet) {
+            worker.first_packet = now;
+          }
+          worker.last_packet = now;
+
+          auto it = peers.find(endpoint_key(pkt.remote));
+          if (it == peers.end()) {
             // Handle handshake.
             auto resp = responder.handle_init(pkt.data);
             if (resp) {
-              std::cout << "Handshake completed with client: " << pkt.remote.host << ":"
-                        << pkt.remote.port << '\n';
+              if (config.verbose) {
+                std::cout << "Handshake completed with client: " << pkt.remote.host << ":"
+                          << pkt.remote.port << '\n';
+              }
               socket.send(resp->response, pkt.remote, ec);
-              session.emplace(resp->session, transport::TransportSessionConfig{}, steady_fn);
-              client_endpoint = pkt.remote;
-              start_time = std::chrono::steady_clock::now();
+              peers.emplace(endpoint_key(pkt.remote),
+                            Peer{pkt.remote, std::make_unique<transport::TransportSession>(
+                                                 resp->session, transport::TransportSessionConfig{},
+                                                 steady_fn)});
             }
-          } else {
-            // Handle data.
-            auto frames = session->decrypt_packet(pkt.data);
-            if (frames) {
-              results.bytes_received += pkt.data.size();
-              ++results.packets_received;
-
-              // Generate ACK periodically.
-              for (const auto& frame : *frames) {
-                if (frame.kind == mux::FrameKind::kData) {
-                  auto ack = session->generate_ack(frame.data.stream_id);
-                  auto ack_frame = mux::make_ack_frame(ack.stream_id, ack.ack, ack.bitmap);
-                  auto ack_packets = session->encrypt_data(
-                      mux::MuxCodec::encode(ack_frame), 0, false);
-                  for (const auto& ack_pkt : ack_packets) {
-                    socket.send(ack_pkt, client_endpoint, ec);
-                  }
-                }
+            return;
+          }
+
+          // Handle data.
+          auto& peer = it->second;
+          auto frames = peer.session->decrypt_packet(pkt.data);
+          if (!frames) {
+            return;
+          }
+          worker.results.bytes_received += pkt.data.size();
+          ++worker.results.packets_received;
+
+          for (const auto& frame : *frames) {
+            if (frame.kind == mux::FrameKind::kData) {
+              const auto ack_pkt = peer.session->encrypt_ack(frame.data.stream_id);
+              if (socket.send(ack_pkt, peer.endpoint, ec)) {
+                worker.results.bytes_sent += ack_pkt.size();
+                ++worker.results.packets_sent;
               }
             }
           }
         },
         100, ec);
-
-    if (session) {
-      // Send retransmits if needed.
-      auto retransmits = session->get_retransmit_packets();
-      for (const auto& pkt : retransmits) {
-        socket.send(pkt, client_endpoint, ec);
-        ++results.retransmits;
-      }
-    }
   }
 
-  auto end_time = std::chrono::steady_clock::now();
-  results.duration_sec =
-      std::chrono::duration<double>(end_time - start_time).count();
+  worker.cpu_sec = cpu_seconds(RUSAGE_THREAD);
+}
 
-  if (session) {
-    const auto& stats = session->stats();
-    results.bytes_sent = stats.bytes_sent;
-    results.packets_sent = stats.packets_sent;
+// Run server mode.
+int run_server(const BenchConfig& config) {
+  std::cout << "Starting VEIL transport benchmark server on port " << config.port << " with "
+            << config.server_threads << " receiver thread(s)\n";
+  std::cout << "Waiting for client connections...\n";
+
+  CycleCounter cycles;
+  const auto start = UsageSample::take(cycles);
+
+  std::vector<ServerWorker> workers(static_cast<std::size_t>(config.server_threads));
+  std::vector<std::thread> threads;
+  for (auto& worker : workers) {
+    threads.emplace_back([&config, &worker] { run_server_thread(config, worker); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // CPU and allocations accrue only while packets flow; report them over
+  // the span between the first and last packet.
+  auto end = UsageSample::take(cycles);
+  BenchResults results;
+  std::optional<std::chrono::steady_clock::time_point> first;
+  std::chrono::steady_clock::time_point last{};
+  for (const auto& worker : workers) {
+    results.add(worker.results);
+    results.thread_cpu_sec.push_back(worker.cpu_sec);
+    if (worker.first_packet) {
+      first = first ? std::min(*first, *worker.first_packet) : *worker.first_packet;
+      last = std::max(last, worker.last_packet);
+    }
   }
+  results.record_usage(start, end);
+  results.duration_sec = first ? std::chrono::duration<double>(last - *first).count() : 0.0;
 
   results.print();
   return 0;
 }
 
-// Run client mode.
-int run_client(const BenchConfig& config) {
-  std::cout << "Starting VEIL transport benchmark client\n";
-  std::cout << "Target: " << config.host << ":" << config.port << '\n';
-  std::cout << "Duration: " << config.duration_sec << " seconds\n";
-  std::cout << "Message size: " << config.message_size << " bytes\n";
+// Result of one client stream.
+struct StreamResult {
+  bool connected{false};
+  BenchResults results;
+  std::vector<double> rtt_samples;
+  double cpu_sec{0.0};
+};
 
+// One client stream: handshake, wait for all streams, then send for the
+// configured duration.
+void run_stream(const BenchConfig& config, std::size_t message_size, double rate_bytes_per_sec,
+                std::latch& ready, std::chrono::steady_clock::time_point& start_time,
+                StreamResult& out) {
   // Create UDP socket.
   transport::UdpSocket socket;
   std::error_code ec;
-  if (!socket.open(0, false, ec)) {
-    std::cerr << "Failed to open socket: " << ec.message() << '\n';
-    return 1;
-  }
-
-  transport::UdpEndpoint server{config.host, config.port};
-
-  // Perform handshake.
+  std::optional<transport::TransportSession> session;
+  const transport::UdpEndpoint server{config.host, config.port};
   auto now_fn = []() { return std::chrono::system_clock::now(); };
   auto steady_fn = []() { return std::chrono::steady_clock::now(); };
-  handshake::HandshakeInitiator initiator(get_bench_psk(), 200ms, now_fn);
 
-  auto init_bytes = initiator.create_init();
-  if (!socket.send(init_bytes, server, ec)) {
-    std::cerr << "Failed to send handshake: " << ec.message() << '\n';
-    return 1;
-  }
-
-  std::cout << "Waiting for handshake response...\n";
-
-  std::optional<transport::TransportSession> session;
-
-  // Wait for handshake response.
-  for (int i = 0; i < 50 && !session; ++i) {
-    socket.poll(
-        [&](const transport::UdpPacket& pkt) {
-          auto sess = initiator.consume_response(pkt.data);
-          if (sess) {
-            session.emplace(*sess, transport::TransportSessionConfig{}, steady_fn);
-            std::cout << "Handshake completed!\n";
-          }
-        },
-        100, ec);
+  if (socket.open(0, false, ec)) {
+    // Perform handshake.
+    handshake::HandshakeInitiator initiator(get_bench_psk(), 200ms, now_fn);
+    auto init_bytes = initiator.create_init();
+    if (socket.send(init_bytes, server, ec)) {
+      // Wait for handshake response.
+      for (int i = 0; i < 50 && !session; ++i) {
+        socket.poll(
+            [&](const transport::UdpPacket& pkt) {
+              auto sess = initiator.consume_response(pkt.data);
+              if (sess) {
+                session.emplace(*sess, transport::TransportSessionConfig{}, steady_fn);
+              }
+            },
+            100, ec);
+      }
+    } else {
+      std::cerr << "Failed to send handshake: " << ec.message() << '\n';
+    }
+  } else {
+    std::cerr << "Failed to open socket: " << ec.message() << '\n';
   }
 
+  // Every stream arrives exactly once, connected or not.
+  ready.arrive_and_wait();
   if (!session) {
-    std::cerr << "Handshake failed\n";
-    return 1;
+    return;
   }
+  out.connected = true;
 
   // Prepare test data.
-  std::vector<std::uint8_t> test_data(config.message_size);
+  std::vector<std::uint8_t> test_data(message_size);
   for (std::size_t i = 0; i < test_data.size(); ++i) {
     test_data[i] = static_cast<std::uint8_t>(i & 0xFF);
   }
 
-  BenchResults results;
-  auto start_time = std::chrono::steady_clock::now();
-  auto end_time = start_time + std::chrono::seconds(config.duration_sec);
-
-  std::cout << "Starting benchmark...\n";
+  auto& results = out.results;
+  const auto end_time = start_time + std::chrono::seconds(config.duration_sec);
+  const double cpu_start = cpu_seconds(RUSAGE_THREAD);
 
   // RTT measurements.
-  std::vector<double> rtt_samples;
   std::chrono::steady_clock::time_point last_send_time;
 
   while (g_running.load() && std::chrono::steady_clock::now() < end_time) {
+    // Pace to the configured rate by waiting until the bytes sent so far are
+    // due.
+    if (rate_bytes_per_sec > 0.0) {
+      const auto due = start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                        std::chrono::duration<double>(
+                                            static_cast<double>(results.bytes_sent) /
+                                            rate_bytes_per_sec));
+      if (due > std::chrono::steady_clock::now()) {
+        socket.poll(
+            [&](const transport::UdpPacket& pkt) {
+              auto frames = session->decrypt_packet(pkt.data);
+              if (frames) {
+                results.bytes_received += pkt.data.size();
+                ++results.packets_received;
+                for (const auto& frame : *frames) {
+                  if (frame.kind == mux::FrameKind::kAck) {
+                    session->process_ack(frame.ack);
+                  }
+                }
+              }
+            },
+            0, ec);
+        std::this_thread::sleep_until(std::min(due, end_time));
+        continue;
+      }
+    }
+
     // Send data.
     last_send_time = std::chrono::steady_clock::now();
     auto packets = session->encrypt_data(test_data, 0, false);
@@ -275,7 +569,7 @@ int run_client(const BenchConfig& config) {
             // Measure RTT.
             auto rtt = std::chrono::steady_clock::now() - last_send_time;
             double rtt_ms = std::chrono::duration<double, std::milli>(rtt).count();
-            rtt_samples.push_back(rtt_ms);
+            out.rtt_samples.push_back(rtt_ms);
 
             // Process ACKs.
             for (const auto& frame : *frames) {
@@ -285,13 +579,12 @@ int run_client(const BenchConfig& config) {
             }
           }
         },
-        1, ec);
+        rate_bytes_per_sec > 0.0 ? 0 : 1, ec);
 
     // Handle retransmits.
     auto retransmits = session->get_retransmit_packets();
     for (const auto& pkt : retransmits) {
       socket.send(pkt, server, ec);
-      ++results.retransmits;
     }
 
     // Rotate session if needed.
@@ -300,13 +593,58 @@ int run_client(const BenchConfig& config) {
     }
   }
 
-  auto actual_end = std::chrono::steady_clock::now();
-  results.duration_sec =
-      std::chrono::duration<double>(actual_end - start_time).count();
-
   // Get session stats.
-  const auto& stats = session->stats();
-  results.retransmits = stats.retransmits;
+  results.retransmits = session->stats().retransmits;
+  out.cpu_sec = cpu_seconds(RUSAGE_THREAD) - cpu_start;
+}
+
+// Run the client for one message size.
+std::optional<BenchResults> run_client_once(const BenchConfig& config, std::size_t message_size,
+                                            const CycleCounter& cycles) {
+  const auto streams = static_cast<std::size_t>(config.num_streams);
+  const double rate_bytes_per_sec = config.rate_mbps * 1e6 / 8.0 / static_cast<double>(streams);
+
+  std::latch ready(static_cast<std::ptrdiff_t>(streams) + 1);
+  std::chrono::steady_clock::time_point start_time;
+  std::vector<StreamResult> outs(streams);
+  std::vector<std::thread> threads;
+  for (auto& out : outs) {
+    threads.emplace_back([&, message_size] {
+      run_stream(config, message_size, rate_bytes_per_sec, ready, start_time, out);
+    });
+  }
+
+  // Handshakes are excluded from the measurement window.
+  const auto start = UsageSample::take(cycles);
+  start_time = start.wall;
+  ready.arrive_and_wait();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto end = UsageSample::take(cycles);
+
+  BenchResults results;
+  results.message_size = message_size;
+  std::vector<double> rtt_samples;
+  std::size_t connected = 0;
+  for (const auto& out : outs) {
+    if (!out.connected) {
+      continue;
+    }
+    ++connected;
+    results.add(out.results);
+    results.thread_cpu_sec.push_back(out.cpu_sec);
+    rtt_samples.insert(rtt_samples.end(), out.rtt_samples.begin(), out.rtt_samples.end());
+  }
+  if (connected == 0) {
+    std::cerr << "Handshake failed\n";
+    return std::nullopt;
+  }
+  if (connected < streams) {
+    std::cerr << "Warning: " << streams - connected << " of " << streams
+              << " streams failed to connect\n";
+  }
+  results.record_usage(start, end);
 
   // Calculate RTT statistics.
   if (!rtt_samples.empty()) {
@@ -322,8 +660,42 @@ int run_client(const BenchConfig& config) {
     if (p95_idx >= rtt_samples.size()) p95_idx = rtt_samples.size() - 1;
     results.p95_rtt_ms = rtt_samples[p95_idx];
   }
+  return results;
+}
 
-  results.print();
+// Run client mode.
+int run_client(const BenchConfig& config) {
+  auto sizes = config.sizes;
+  if (sizes.empty()) {
+    sizes.push_back(config.message_size);
+  }
+
+  std::cout << "Starting VEIL transport benchmark client\n";
+  std::cout << "Target: " << config.host << ":" << config.port << '\n';
+  std::cout << "Duration: " << config.duration_sec << " seconds per size\n";
+  std::cout << "Streams: " << config.num_streams << '\n';
+  if (config.rate_mbps > 0.0) {
+    std::cout << "Rate limit: " << config.rate_mbps << " Mbps\n";
+  }
+
+  CycleCounter cycles;
+  std::vector<BenchResults> runs;
+  for (const auto size : sizes) {
+    if (!g_running.load()) {
+      break;
+    }
+    std::cout << "Starting benchmark with " << size << " byte messages...\n";
+    auto results = run_client_once(config, size, cycles);
+    if (!results) {
+      return 1;
+    }
+    results->print();
+    runs.push_back(std::move(*results));
+  }
+
+  if (runs.size() > 1) {
+    print_summary(runs);
+  }
   return 0;
 }
 
@@ -341,11 +713,22 @@ int main(int argc, char** argv) {
     app.add_option("--port,-p", config.port, "Port number");
     app.add_option("--duration,-d", config.duration_sec, "Test duration in seconds (client mode)");
     app.add_option("--size,-s", config.message_size, "Message size in bytes");
-    app.add_option("--streams,-n", config.num_streams, "Number of streams");
+    app.add_option("--sizes", config.sizes, "Message sizes to sweep, comma separated (client mode)")
+        ->delimiter(',');
+    app.add_option("--streams,-n", config.num_streams,
+                   "Number of parallel streams, one thread each (client mode)");
+    app.add_option("--threads,-t", config.server_threads, "Receiver threads (server mode)");
+    app.add_option("--rate-mbps", config.rate_mbps,
+                   "Aggregate send rate limit in Mbps, 0 = unlimited (client mode)");
     app.add_flag("--verbose,-v", config.verbose, "Verbose output");
 
     CLI11_PARSE(app, argc, argv);
 
+    if (config.num_streams < 1 || config.server_threads < 1) {
+      std::cerr << "Error: --streams and --threads must be at least 1\n";
+      return 1;
+    }
+
     // Setup signal handler.
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "common/logging/logger.h"
+#include "common/utils/allocation_tracker.h"
 
 namespace veil::transport {
 
@@ -108,6 +109,7 @@ bool EventLoop::remove_socket(int fd) {
 
 bool EventLoop::send_packet(int fd, std::span<const std::uint8_t> data, const UdpEndpoint& remote) {
   VEIL_DCHECK_THREAD(thread_checker_);
+  VEIL_ALLOCATION_SCOPE(kEventLoop);
 
   auto it = sockets_.find(fd);
   if (it == sockets_.end()) {
@@ -134,7 +136,11 @@ bool EventLoop::send_packet(int fd, std::span<const std::uint8_t> data, const Ud
     }
   }
 
-  // Queue the packet.
+  // Queue the packet, unless the backlog is already full.
+  if (info.pending_sends.size() >= config_.max_pending_sends) {
+    ++info.pending_drops;
+    return false;
+  }
   info.pending_sends.push_back(
       UdpPacket{std::vector<std::uint8_t>(data.begin(), data.end()), remote});
   return true;
@@ -232,6 +238,7 @@ void EventLoop::run() {
 void EventLoop::stop() { running_.store(false); }
 
 void EventLoop::handle_read(int fd) {
+  VEIL_ALLOCATION_SCOPE(kEventLoop);
   auto it = sockets_.find(fd);
   if (it == sockets_.end()) {
     return;
@@ -285,7 +292,7 @@ void EventLoop::handle_write(int fd) {
       }
       break;
     }
-    info.pending_sends.erase(info.pending_sends.begin());
+    info.pending_sends.pop_front();
   }
 }
 
@@ -2,7 +2,9 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -41,6 +43,9 @@ struct EventLoopConfig {
   std::chrono::seconds idle_timeout{300};
   // Statistics log interval (0 = disabled).
   std::chrono::seconds stats_log_interval{60};
+  // Packets queued per socket while it is not writable; further sends are
+  // dropped so a stalled socket cannot build an unbounded backlog.
+  std::size_t max_pending_sends{256};
 };
 
 // Socket registration info.
@@ -60,7 +65,9 @@ struct SocketInfo {
   // Last activity timestamp.
   std::chrono::steady_clock::time_point last_activity;
   // Pending outgoing packets (for EPOLLOUT handling).
-  std::vector<UdpPacket> pending_sends;
+  std::deque<UdpPacket> pending_sends;
+  // Sends dropped because pending_sends was full.
+  std::uint64_t pending_drops{0};
   bool writable{true};
 };
 
@@ -106,7 +113,8 @@ class EventLoop {
   // Remove a socket from the event loop.
   bool remove_socket(int fd);
 
-  // Queue packet for sending (handles EAGAIN/EWOULDBLOCK).
+  // Queue packet for sending (handles EAGAIN/EWOULDBLOCK). Returns false if
+  // the send failed or the socket's pending queue is full.
   bool send_packet(int fd, std::span<const std::uint8_t> data, const UdpEndpoint& remote);
 
   // Schedule a one-shot timer.
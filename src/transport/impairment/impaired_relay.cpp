@@ -0,0 +1,161 @@
+#include "transport/impairment/impaired_relay.h"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <utility>
+
+#include "common/logging/logger.h"
+
+namespace veil::transport {
+
+namespace {
+std::error_code last_error() { return std::error_code(errno, std::generic_category()); }
+
+// Upper bound on datagrams drained from one socket per pump() call, so that
+// a flooding peer cannot starve the other direction.
+constexpr int kMaxDrainPerPump = 256;
+}  // namespace
+
+ImpairedUdpRelay::ImpairedUdpRelay(ImpairedRelayConfig config, std::function<TimePoint()> now_fn)
+    : config_(std::move(config)),
+      now_fn_(std::move(now_fn)),
+      uplink_(config_.uplink),
+      downlink_(config_.downlink) {}
+
+ImpairedUdpRelay::~ImpairedUdpRelay() { close(); }
+
+bool ImpairedUdpRelay::open(std::error_code& ec) {
+  if (!client_side_.open(config_.listen_port, false, ec)) {
+    LOG_ERROR("Relay: failed to bind client side: {}", ec.message());
+    return false;
+  }
+  if (!server_side_.open(0, false, ec)) {
+    LOG_ERROR("Relay: failed to bind server side: {}", ec.message());
+    close();
+    return false;
+  }
+
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    ec = last_error();
+    close();
+    return false;
+  }
+  for (const int fd : {client_side_.fd(), server_side_.fd()}) {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+      ec = last_error();
+      close();
+      return false;
+    }
+  }
+
+  LOG_DEBUG("Relay listening on {} -> {}:{}", listen_port(), config_.server.host,
+            config_.server.port);
+  return true;
+}
+
+void ImpairedUdpRelay::close() {
+  if (epoll_fd_ >= 0) {
+    ::close(epoll_fd_);
+    epoll_fd_ = -1;
+  }
+  client_side_.close();
+  server_side_.close();
+}
+
+int ImpairedUdpRelay::wait_timeout(int timeout_ms, TimePoint now) const {
+  std::optional<TimePoint> next;
+  for (const auto* link : {&uplink_, &downlink_}) {
+    const auto due = link->next_delivery();
+    if (due && (!next || *due < *next)) {
+      next = due;
+    }
+  }
+  if (!next) {
+    return timeout_ms;
+  }
+  if (*next <= now) {
+    return 0;
+  }
+  // Round up so we never wake before the packet is due.
+  const auto until = std::chrono::ceil<std::chrono::milliseconds>(*next - now).count();
+  return std::min(timeout_ms, static_cast<int>(until));
+}
+
+bool ImpairedUdpRelay::pump(int timeout_ms, std::error_code& ec) {
+  if (epoll_fd_ < 0) {
+    ec = std::make_error_code(std::errc::bad_file_descriptor);
+    return false;
+  }
+
+  std::array<epoll_event, 2> events{};
+  const int n = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()),
+                           wait_timeout(timeout_ms, now_fn_()));
+  if (n < 0) {
+    if (errno == EINTR) {
+      return true;
+    }
+    ec = last_error();
+    return false;
+  }
+
+  const auto now = now_fn_();
+  for (int i = 0; i < n; ++i) {
+    const int fd = events[static_cast<std::size_t>(i)].data.fd;
+    if (fd == client_side_.fd()) {
+      drain(client_side_, uplink_, true, now);
+    } else if (fd == server_side_.fd()) {
+      drain(server_side_, downlink_, false, now);
+    }
+  }
+
+  flush(now_fn_());
+  return true;
+}
+
+void ImpairedUdpRelay::drain(UdpSocket& socket, NetworkImpairment& link, bool from_client,
+                             TimePoint now) {
+  std::error_code ec;
+  for (int i = 0; i < kMaxDrainPerPump; ++i) {
+    bool received = false;
+    socket.poll(
+        [&](const UdpPacket& pkt) {
+          received = true;
+          if (from_client && !client_) {
+            LOG_DEBUG("Relay: client is {}:{}", pkt.remote.host, pkt.remote.port);
+            client_ = pkt.remote;
+          }
+          link.submit(pkt.data, now);
+        },
+        0, ec);
+    if (!received) {
+      break;
+    }
+  }
+}
+
+void ImpairedUdpRelay::flush(TimePoint now) {
+  std::error_code ec;
+  for (auto& packet : uplink_.collect(now)) {
+    if (!server_side_.send(packet, config_.server, ec)) {
+      LOG_DEBUG("Relay: uplink send failed: {}", ec.message());
+    }
+  }
+  for (auto& packet : downlink_.collect(now)) {
+    if (!client_) {
+      continue;
+    }
+    if (!client_side_.send(packet, *client_, ec)) {
+      LOG_DEBUG("Relay: downlink send failed: {}", ec.message());
+    }
+  }
+}
+
+}  // namespace veil::transport
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <system_error>
+
+#include "transport/impairment/network_impairment.h"
+#include "transport/udp_socket/udp_socket.h"
+
+namespace veil::transport {
+
+// Configuration for an impaired UDP relay.
+struct ImpairedRelayConfig {
+  // Port the client sends to (0 = ephemeral, see listen_port()).
+  std::uint16_t listen_port{0};
+
+  // Address packets from the client are forwarded to.
+  UdpEndpoint server;
+
+  // Client -> server impairment.
+  ImpairmentConfig uplink;
+
+  // Server -> client impairment.
+  ImpairmentConfig downlink;
+};
+
+// UDP relay that sits between a client and a server and applies a
+// NetworkImpairment in each direction, as `tc netem` would on a real link.
+//
+// The client is pointed at listen_port(); the relay remembers the first
+// client endpoint it sees and forwards server replies back to it. The relay
+// forwards from a separate socket, so the server sees the relay rather than
+// the client as its peer.
+//
+// Only one client is supported per relay.
+//
+// Thread Safety: not thread-safe; pump() is expected to be called from a
+// single thread. See docs/thread_model.md.
+class ImpairedUdpRelay {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+
+  explicit ImpairedUdpRelay(ImpairedRelayConfig config,
+                            std::function<TimePoint()> now_fn = Clock::now);
+  ~ImpairedUdpRelay();
+
+  ImpairedUdpRelay(const ImpairedUdpRelay&) = delete;
+  ImpairedUdpRelay& operator=(const ImpairedUdpRelay&) = delete;
+  ImpairedUdpRelay(ImpairedUdpRelay&&) = delete;
+  ImpairedUdpRelay& operator=(ImpairedUdpRelay&&) = delete;
+
+  // Bind the client-facing and server-facing sockets.
+  bool open(std::error_code& ec);
+
+  void close();
+
+  // Port the client should send to.
+  std::uint16_t listen_port() const { return client_side_.local_port(); }
+
+  // Wait up to timeout_ms for traffic, forward whatever arrived and release
+  // packets whose impairment delay has elapsed. Returns false on socket error.
+  bool pump(int timeout_ms, std::error_code& ec);
+
+  const ImpairmentStats& uplink_stats() const { return uplink_.stats(); }
+  const ImpairmentStats& downlink_stats() const { return downlink_.stats(); }
+
+ private:
+  // Drain all datagrams currently queued on a socket.
+  void drain(UdpSocket& socket, NetworkImpairment& link, bool from_client, TimePoint now);
+
+  void flush(TimePoint now);
+
+  int wait_timeout(int timeout_ms, TimePoint now) const;
+
+  ImpairedRelayConfig config_;
+  std::function<TimePoint()> now_fn_;
+
+  UdpSocket client_side_;
+  UdpSocket server_side_;
+  int epoll_fd_{-1};
+
+  NetworkImpairment uplink_;
+  NetworkImpairment downlink_;
+
+  std::optional<UdpEndpoint> client_;
+};
+
+}  // namespace veil::transport
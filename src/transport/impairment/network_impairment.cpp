@@ -0,0 +1,137 @@
+#include "transport/impairment/network_impairment.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace veil::transport {
+
+NetworkImpairment::NetworkImpairment(ImpairmentConfig config)
+    : config_(config), rng_(config.seed) {}
+
+bool NetworkImpairment::chance(double probability) {
+  if (probability <= 0.0) {
+    return false;
+  }
+  if (probability >= 1.0) {
+    return true;
+  }
+  return unit_(rng_) < probability;
+}
+
+bool NetworkImpairment::lost() {
+  if (config_.burst_loss.enabled) {
+    const auto& ge = config_.burst_loss;
+    if (burst_bad_state_) {
+      if (chance(ge.p_bad_to_good)) {
+        burst_bad_state_ = false;
+      }
+    } else if (chance(ge.p_good_to_bad)) {
+      burst_bad_state_ = true;
+    }
+    if (chance(burst_bad_state_ ? ge.loss_in_bad : ge.loss_in_good)) {
+      ++stats_.dropped_burst;
+      return true;
+    }
+  }
+
+  if (chance(config_.loss_rate)) {
+    ++stats_.dropped_random;
+    return true;
+  }
+  return false;
+}
+
+std::optional<NetworkImpairment::TimePoint> NetworkImpairment::serialize(std::size_t bytes,
+                                                                         TimePoint now) {
+  if (config_.bandwidth_bps == 0) {
+    return now;
+  }
+
+  const auto start = std::max(now, link_free_at_);
+  if (config_.queue_limit_bytes > 0 && link_free_at_ > now) {
+    // Bytes still waiting in the bottleneck queue.
+    const auto backlog_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(link_free_at_ - now).count();
+    const auto backlog_bytes =
+        static_cast<std::uint64_t>(backlog_us) * config_.bandwidth_bps / 8U / 1000000U;
+    if (backlog_bytes + bytes > config_.queue_limit_bytes) {
+      return std::nullopt;
+    }
+  }
+
+  const auto tx_ns = static_cast<std::int64_t>(static_cast<std::uint64_t>(bytes) * 8U *
+                                               1000000000ULL / config_.bandwidth_bps);
+  link_free_at_ = start + std::chrono::nanoseconds(tx_ns);
+  return link_free_at_;
+}
+
+std::chrono::microseconds NetworkImpairment::propagation_delay() {
+  auto delay = config_.delay;
+  if (config_.jitter.count() > 0) {
+    std::uniform_int_distribution<std::int64_t> dist(0, config_.jitter.count());
+    delay += std::chrono::microseconds(dist(rng_));
+  }
+  return delay;
+}
+
+void NetworkImpairment::schedule(std::vector<std::uint8_t> data, TimePoint deliver_at) {
+  queue_.push_back(Scheduled{deliver_at, next_order_++, std::move(data)});
+  std::push_heap(queue_.begin(), queue_.end(), LaterFirst{});
+}
+
+NetworkImpairment::Admission NetworkImpairment::admit(std::size_t bytes, TimePoint now) {
+  ++stats_.packets_submitted;
+
+  if (lost()) {
+    return {};
+  }
+
+  const auto departed = serialize(bytes, now);
+  if (!departed) {
+    ++stats_.dropped_queue;
+    return {};
+  }
+
+  Admission admission{1, *departed + propagation_delay()};
+  if (chance(config_.reorder_rate)) {
+    ++stats_.reordered;
+    admission.deliver_at += config_.reorder_delay;
+  }
+  if (chance(config_.duplicate_rate)) {
+    ++stats_.duplicated;
+    ++admission.copies;
+  }
+  return admission;
+}
+
+std::size_t NetworkImpairment::submit(std::vector<std::uint8_t> packet, TimePoint now) {
+  const auto admission = admit(packet.size(), now);
+  if (admission.copies > 1) {
+    schedule(packet, admission.deliver_at);
+  }
+  if (admission.copies > 0) {
+    schedule(std::move(packet), admission.deliver_at);
+  }
+  return admission.copies;
+}
+
+std::vector<std::vector<std::uint8_t>> NetworkImpairment::collect(TimePoint now) {
+  std::vector<std::vector<std::uint8_t>> due;
+  while (!queue_.empty() && queue_.front().deliver_at <= now) {
+    std::pop_heap(queue_.begin(), queue_.end(), LaterFirst{});
+    ++stats_.packets_delivered;
+    stats_.bytes_delivered += queue_.back().data.size();
+    due.push_back(std::move(queue_.back().data));
+    queue_.pop_back();
+  }
+  return due;
+}
+
+std::optional<NetworkImpairment::TimePoint> NetworkImpairment::next_delivery() const {
+  if (queue_.empty()) {
+    return std::nullopt;
+  }
+  return queue_.front().deliver_at;
+}
+
+}  // namespace veil::transport
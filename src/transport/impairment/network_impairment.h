@@ -0,0 +1,150 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace veil::transport {
+
+// Two-state Markov (Gilbert-Elliott) burst loss model.
+// The channel alternates between a "good" and a "bad" state; each state has
+// its own loss probability. Transition probabilities are evaluated once per
+// packet, so the mean burst length is 1 / p_bad_to_good packets.
+struct GilbertElliottConfig {
+  bool enabled{false};
+  double p_good_to_bad{0.0};
+  double p_bad_to_good{1.0};
+  double loss_in_good{0.0};
+  double loss_in_bad{1.0};
+};
+
+// Link impairment parameters, modelled after `tc netem`.
+struct ImpairmentConfig {
+  // Independent per-packet loss probability (0.0-1.0).
+  double loss_rate{0.0};
+
+  // Correlated burst loss, applied in addition to loss_rate.
+  GilbertElliottConfig burst_loss;
+
+  // Probability that a delivered packet is delivered twice.
+  double duplicate_rate{0.0};
+
+  // Probability that a packet is held back by reorder_delay, letting
+  // packets sent after it overtake it.
+  double reorder_rate{0.0};
+  std::chrono::microseconds reorder_delay{std::chrono::milliseconds(5)};
+
+  // Fixed one-way propagation delay.
+  std::chrono::microseconds delay{0};
+
+  // Uniformly distributed extra delay in [0, jitter].
+  std::chrono::microseconds jitter{0};
+
+  // Link rate in bits per second (0 = unlimited). Packets are serialized
+  // back-to-back, so a burst queues behind the previous packet.
+  std::uint64_t bandwidth_bps{0};
+
+  // Bottleneck queue size in bytes when bandwidth_bps is set (0 = unlimited).
+  // Packets that would exceed it are tail-dropped.
+  std::size_t queue_limit_bytes{0};
+
+  // Seed for the impairment RNG; equal seeds give identical loss patterns.
+  std::uint64_t seed{1};
+};
+
+// Impairment statistics.
+struct ImpairmentStats {
+  std::uint64_t packets_submitted{0};
+  std::uint64_t packets_delivered{0};
+  std::uint64_t bytes_delivered{0};
+  std::uint64_t dropped_random{0};
+  std::uint64_t dropped_burst{0};
+  std::uint64_t dropped_queue{0};
+  std::uint64_t duplicated{0};
+  std::uint64_t reordered{0};
+};
+
+// Userspace model of an impaired one-way link.
+//
+// Packets are submitted with their send time and collected once their
+// delivery time has passed. The model performs no I/O and takes time from
+// the caller, so it can be driven by real sockets (ImpairedUdpRelay) or by
+// a virtual clock in tests.
+//
+// Thread Safety: not thread-safe; see docs/thread_model.md.
+class NetworkImpairment {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+
+  // Fate of a single packet: how many copies arrive, and when.
+  struct Admission {
+    std::size_t copies{0};  // 0 if dropped, 2 if duplicated.
+    TimePoint deliver_at{};
+  };
+
+  explicit NetworkImpairment(ImpairmentConfig config = {});
+
+  // Decide the fate of a `bytes`-long packet sent at `now` without queueing
+  // it. For callers that hold packets themselves (e.g. a discrete-event
+  // simulator); delivered counters are only updated by collect().
+  Admission admit(std::size_t bytes, TimePoint now);
+
+  // Submit a packet sent at `now`.
+  // Returns the number of copies scheduled for delivery (0 if dropped).
+  std::size_t submit(std::vector<std::uint8_t> packet, TimePoint now);
+
+  // Remove and return all packets due at or before `now`, in delivery order.
+  std::vector<std::vector<std::uint8_t>> collect(TimePoint now);
+
+  // Delivery time of the next queued packet.
+  std::optional<TimePoint> next_delivery() const;
+
+  // Number of packets queued for delivery.
+  std::size_t in_flight() const { return queue_.size(); }
+
+  const ImpairmentConfig& config() const { return config_; }
+  const ImpairmentStats& stats() const { return stats_; }
+
+ private:
+  struct Scheduled {
+    TimePoint deliver_at;
+    std::uint64_t order{0};
+    std::vector<std::uint8_t> data;
+  };
+
+  struct LaterFirst {
+    bool operator()(const Scheduled& a, const Scheduled& b) const {
+      if (a.deliver_at != b.deliver_at) {
+        return a.deliver_at > b.deliver_at;
+      }
+      return a.order > b.order;
+    }
+  };
+
+  bool chance(double probability);
+
+  // Returns true if the packet is lost, updating the burst-loss state.
+  bool lost();
+
+  // Time the packet leaves the bottleneck, or nullopt if the queue is full.
+  std::optional<TimePoint> serialize(std::size_t bytes, TimePoint now);
+
+  std::chrono::microseconds propagation_delay();
+
+  void schedule(std::vector<std::uint8_t> data, TimePoint deliver_at);
+
+  ImpairmentConfig config_;
+  std::mt19937_64 rng_;
+  std::uniform_real_distribution<double> unit_{0.0, 1.0};
+  bool burst_bad_state_{false};
+  TimePoint link_free_at_{};
+  std::uint64_t next_order_{0};
+  std::vector<Scheduled> queue_;  // Min-heap on (deliver_at, order).
+  ImpairmentStats stats_;
+};
+
+}  // namespace veil::transport
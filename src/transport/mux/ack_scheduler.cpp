@@ -5,7 +5,10 @@
 namespace veil::mux {
 
 AckScheduler::AckScheduler(AckSchedulerConfig config, std::function<TimePoint()> now_fn)
-    : config_(config), now_fn_(std::move(now_fn)) {}
+    : config_(config),
+      now_fn_(std::move(now_fn)),
+      packet_threshold_(config_.ack_every_n_packets),
+      max_ack_delay_(config_.max_ack_delay) {}
 
 bool AckScheduler::on_packet_received(std::uint64_t stream_id, std::uint64_t sequence, bool fin) {
   // Find or create stream state.
@@ -62,7 +65,7 @@ std::optional<std::uint64_t> AckScheduler::check_ack_timer() {
     const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
         now - state.first_unacked_time);
 
-    if (elapsed >= config_.max_ack_delay) {
+    if (elapsed >= max_ack_delay_) {
       return stream_id;
     }
   }
@@ -122,7 +125,7 @@ std::optional<std::chrono::milliseconds> AckScheduler::time_until_next_ack() con
 
     const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
         now - state.first_unacked_time);
-    const auto remaining = config_.max_ack_delay - elapsed;
+    const auto remaining = max_ack_delay_ - elapsed;
 
     if (remaining <= std::chrono::milliseconds(0)) {
       return std::chrono::milliseconds(0);
@@ -145,6 +148,18 @@ void AckScheduler::reset_stream(std::uint64_t stream_id) {
   }
 }
 
+bool AckScheduler::on_ack_frequency(const AckFrequency& request) {
+  if (!config_.honor_ack_frequency || (last_request_ && request.sequence <= *last_request_)) {
+    return false;
+  }
+  last_request_ = request.sequence;
+  packet_threshold_ = std::max<std::uint32_t>(request.packet_threshold, 1);
+  max_ack_delay_ = std::clamp(request.max_ack_delay, std::chrono::milliseconds(1),
+                              config_.max_requested_ack_delay);
+  ++stats_.ack_frequency_updates;
+  return true;
+}
+
 void AckScheduler::update_bitmap(StreamAckState& state, std::uint64_t sequence) {
   // Bitmap tracks which packets in the last 32 before highest_received have been received.
   if (state.highest_received == 0) {
@@ -182,16 +197,45 @@ bool AckScheduler::should_send_immediate_ack(const StreamAckState& state, bool f
   }
 
   // Immediate ACK after N packets.
-  if (state.packets_since_ack >= config_.ack_every_n_packets) {
+  if (state.packets_since_ack >= packet_threshold_) {
     return true;
   }
 
-  // Immediate ACK if too many pending.
-  if (config_.enable_coalescing && state.packets_since_ack >= config_.max_pending_acks) {
+  // Immediate ACK if too many pending. A larger requested threshold
+  // raises the cap with it.
+  if (config_.enable_coalescing &&
+      state.packets_since_ack >= std::max(config_.max_pending_acks, packet_threshold_)) {
     return true;
   }
 
   return false;
 }
 
+AckFrequencyPolicy::AckFrequencyPolicy(AckFrequencyConfig config) : config_(config) {}
+
+std::optional<AckFrequency> AckFrequencyPolicy::update(std::size_t packets_in_flight,
+                                                       std::chrono::milliseconds rtt,
+                                                       TimePoint now) {
+  const auto per_rtt = std::max<std::uint32_t>(config_.acks_per_rtt, 1);
+  std::uint32_t threshold = std::max<std::uint32_t>(config_.min_packet_threshold, 1);
+  const auto target = std::min<std::size_t>(packets_in_flight / per_rtt, config_.max_packet_threshold);
+  while (static_cast<std::size_t>(threshold) * 2 <= target) {
+    threshold *= 2;
+  }
+  threshold = std::min(threshold, std::max(config_.max_packet_threshold, config_.min_packet_threshold));
+  const auto delay = std::clamp(rtt / per_rtt, config_.min_ack_delay, config_.max_ack_delay);
+
+  if (last_) {
+    const auto drift = delay > last_->max_ack_delay ? delay - last_->max_ack_delay
+                                                    : last_->max_ack_delay - delay;
+    if (now - last_sent_ < rtt ||
+        (threshold == last_->packet_threshold && drift * 4 < last_->max_ack_delay)) {
+      return std::nullopt;
+    }
+  }
+  last_ = AckFrequency{last_ ? last_->sequence + 1 : 0, threshold, delay};
+  last_sent_ = now;
+  return last_;
+}
+
 }  // namespace veil::mux
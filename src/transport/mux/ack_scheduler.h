@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <optional>
@@ -29,6 +30,26 @@ struct AckSchedulerConfig {
 
   // Enable immediate ACK for FIN packets.
   bool immediate_ack_on_fin{true};
+
+  // Apply the peer's AckFrequency requests in place of ack_every_n_packets
+  // and max_ack_delay. Requested delays are capped at this.
+  bool honor_ack_frequency{true};
+  std::chrono::milliseconds max_requested_ack_delay{200};
+};
+
+// Sender-side ACK frequency: ask the peer for about `acks_per_rtt` ACKs per
+// round trip instead of one per ack_every_n_packets, so ACK traffic stops
+// growing with the packet rate.
+struct AckFrequencyConfig {
+  bool enabled{false};
+  std::uint32_t acks_per_rtt{4};
+  // Bounds for the requested packet threshold; the upper one stays within
+  // the 32-packet ACK bitmap.
+  std::uint32_t min_packet_threshold{2};
+  std::uint32_t max_packet_threshold{32};
+  // Bounds for the requested delay, RTT / acks_per_rtt.
+  std::chrono::milliseconds min_ack_delay{1};
+  std::chrono::milliseconds max_ack_delay{25};
 };
 
 // Statistics for ACK scheduling.
@@ -38,6 +59,7 @@ struct AckSchedulerStats {
   std::uint64_t acks_delayed{0};
   std::uint64_t acks_immediate{0};
   std::uint64_t gaps_detected{0};
+  std::uint64_t ack_frequency_updates{0};
 };
 
 // Manages ACK scheduling with delayed-ACK and coalescing.
@@ -74,6 +96,14 @@ class AckScheduler {
   // Reset state for a stream.
   void reset_stream(std::uint64_t stream_id);
 
+  // Apply the peer's ACK frequency request. Returns false if it is older
+  // than one already applied or requests are not honored.
+  bool on_ack_frequency(const AckFrequency& request);
+
+  // Current packet threshold and delayed-ACK time.
+  std::uint32_t packet_threshold() const { return packet_threshold_; }
+  std::chrono::milliseconds max_ack_delay() const { return max_ack_delay_; }
+
  private:
   struct StreamAckState {
     std::uint64_t highest_received{0};
@@ -91,6 +121,38 @@ class AckScheduler {
   std::function<TimePoint()> now_fn_;
   std::vector<std::pair<std::uint64_t, StreamAckState>> streams_;
   AckSchedulerStats stats_;
+  // From config_ until the peer asks otherwise.
+  std::uint32_t packet_threshold_;
+  std::chrono::milliseconds max_ack_delay_;
+  std::optional<std::uint64_t> last_request_;
+};
+
+/**
+ * Chooses the AckFrequency requests a sender makes: a threshold of
+ * packets_in_flight / acks_per_rtt and a delay of RTT / acks_per_rtt, so a
+ * bulk transfer draws about acks_per_rtt ACKs per round trip whatever its
+ * rate. Thresholds are rounded down to a power of two, and a new request
+ * goes out at most once per RTT, when the threshold changes or the delay
+ * moves by a quarter or more.
+ *
+ * Thread Safety:
+ *   This class is NOT thread-safe. It is owned by a TransportSession.
+ */
+class AckFrequencyPolicy {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+
+  explicit AckFrequencyPolicy(AckFrequencyConfig config);
+
+  // The request to send now, if any.
+  std::optional<AckFrequency> update(std::size_t packets_in_flight, std::chrono::milliseconds rtt,
+                                     TimePoint now);
+
+ private:
+  AckFrequencyConfig config_;
+  std::optional<AckFrequency> last_;
+  TimePoint last_sent_{};
 };
 
 }  // namespace veil::mux
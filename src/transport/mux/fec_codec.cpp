@@ -0,0 +1,323 @@
+#include "transport/mux/fec_codec.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <utility>
+
+#include "transport/mux/gf256.h"
+
+namespace veil::mux {
+
+namespace {
+
+// Packets accounted before the decoder reports loss to the sender.
+constexpr std::uint32_t kLossReportPackets = 64;
+
+// Smoothing for the sender's loss estimate.
+constexpr double kLossAlpha = 0.25;
+
+// Cauchy matrix entry 1 / (x_j + y_i) with x_j = 64 + j and y_i = i. The two
+// sets are disjoint for j, i < 64, so the sum is never zero.
+std::uint8_t coefficient(std::size_t repair, std::size_t source) {
+  return gf256_inv(static_cast<std::uint8_t>((kFecMaxSpan + repair) ^ source));
+}
+
+// Add c x symbol to `acc`, where the symbol is `plaintext` behind its
+// 2-byte length. `acc` must hold at least plaintext.size() + 2 bytes.
+void accumulate(std::vector<std::uint8_t>& acc, std::uint8_t c,
+                std::span<const std::uint8_t> plaintext) {
+  const auto length = static_cast<std::uint16_t>(plaintext.size());
+  acc[0] ^= gf256_mul(c, static_cast<std::uint8_t>(length >> 8));
+  acc[1] ^= gf256_mul(c, static_cast<std::uint8_t>(length & 0xFF));
+  gf256_mul_add(acc.data() + 2, plaintext.data(), c, plaintext.size());
+}
+
+}  // namespace
+
+FecEncoder::FecEncoder(FecConfig config) : config_(config) {
+  config_.block_size = std::clamp<std::size_t>(config_.block_size, 1, kFecMaxSpan);
+  config_.max_repair_ratio = std::clamp(config_.max_repair_ratio, 0.0, 1.0);
+  config_.min_repair_ratio = std::clamp(config_.min_repair_ratio, 0.0, config_.max_repair_ratio);
+}
+
+std::vector<FecRepair> FecEncoder::add(std::uint64_t sequence,
+                                       std::span<const std::uint8_t> plaintext, TimePoint now) {
+  std::vector<FecRepair> out;
+  if (sources_ > 0 && (sequence < base_ || sequence - base_ >= kFecMaxSpan)) {
+    out = close();
+  }
+  if (sources_ == 0) {
+    base_ = sequence;
+    opened_ = now;
+    symbol_size_ = 0;
+    repairs_.resize(repair_count(config_.block_size));
+    for (auto& acc : repairs_) {
+      acc.clear();
+    }
+  }
+
+  const auto symbol_size = plaintext.size() + 2;
+  if (symbol_size > symbol_size_) {
+    symbol_size_ = symbol_size;
+    for (auto& acc : repairs_) {
+      acc.resize(symbol_size_, 0);
+    }
+  }
+  for (std::size_t j = 0; j < repairs_.size(); ++j) {
+    accumulate(repairs_[j], coefficient(j, sources_), plaintext);
+  }
+  mask_ |= std::uint64_t{1} << (sequence - base_);
+  ++sources_;
+
+  if (sources_ >= config_.block_size) {
+    auto repairs = close();
+    out.insert(out.end(), std::make_move_iterator(repairs.begin()),
+               std::make_move_iterator(repairs.end()));
+  }
+  return out;
+}
+
+std::vector<FecRepair> FecEncoder::flush_expired(TimePoint now) {
+  if (sources_ == 0 || now - opened_ < config_.block_timeout) {
+    return {};
+  }
+  return close();
+}
+
+std::vector<FecRepair> FecEncoder::close() {
+  // Rows beyond what a short block needs are dropped; any subset of
+  // Cauchy rows still decodes.
+  const auto count = std::min(repair_count(sources_), repairs_.size());
+  std::vector<FecRepair> out;
+  out.reserve(count);
+  for (std::size_t j = 0; j < count; ++j) {
+    out.push_back(FecRepair{base_, mask_, static_cast<std::uint8_t>(j), std::move(repairs_[j])});
+  }
+  sources_ = 0;
+  mask_ = 0;
+  return out;
+}
+
+void FecEncoder::on_loss_report(const LossReport& report) {
+  const auto total = static_cast<double>(report.received) + report.lost;
+  if (total == 0) {
+    return;
+  }
+  loss_rate_ += kLossAlpha * (report.lost / total - loss_rate_);
+}
+
+std::size_t FecEncoder::repair_count(std::size_t sources) const {
+  const double ratio =
+      std::clamp(config_.loss_gain * loss_rate_, config_.min_repair_ratio, config_.max_repair_ratio);
+  const auto count = static_cast<std::size_t>(std::ceil(static_cast<double>(sources) * ratio));
+  return std::clamp<std::size_t>(count, 1, kFecMaxSpan);
+}
+
+utils::MemoryFootprint FecEncoder::memory_footprint() const {
+  utils::MemoryFootprint footprint;
+  footprint.reserved += repairs_.capacity() * sizeof(std::vector<std::uint8_t>);
+  for (const auto& acc : repairs_) {
+    footprint.reserved += acc.capacity();
+    footprint.in_use += acc.size();
+  }
+  return footprint;
+}
+
+FecDecoder::FecDecoder(std::size_t window) : slots_(std::max(window, 2 * kFecMaxSpan)) {}
+
+const FecDecoder::Slot* FecDecoder::find(std::uint64_t sequence) const {
+  const auto& slot = slots_[sequence % slots_.size()];
+  return slot.valid && slot.sequence == sequence ? &slot : nullptr;
+}
+
+std::vector<FecDecoder::Recovered> FecDecoder::on_source(std::uint64_t sequence,
+                                                        std::span<const std::uint8_t> plaintext) {
+  // Retire blocks before this packet overwrites one of their slots.
+  expire(sequence);
+  auto& slot = slots_[sequence % slots_.size()];
+  slot.sequence = sequence;
+  slot.valid = true;
+  slot.plaintext.assign(plaintext.begin(), plaintext.end());
+  newest_ = std::max(newest_, sequence);
+
+  std::vector<Recovered> out;
+  const auto end = blocks_.upper_bound(sequence);
+  for (auto it = blocks_.begin(); it != end; ++it) {
+    const auto offset = sequence - it->first;
+    if (!it->second.done && offset < kFecMaxSpan && ((it->second.mask >> offset) & 1U) != 0) {
+      try_decode(it->first, it->second, out);
+    }
+  }
+  return out;
+}
+
+std::vector<FecDecoder::Recovered> FecDecoder::on_repair(FecRepair repair) {
+  std::vector<Recovered> out;
+  if (newest_ >= repair.base_sequence + slots_.size()) {
+    return out;  // Its sources have left the ring.
+  }
+  auto it = blocks_.find(repair.base_sequence);
+  if (it == blocks_.end()) {
+    if (blocks_.size() >= slots_.size()) {
+      blocks_.erase(blocks_.begin());
+    }
+    it = blocks_.try_emplace(repair.base_sequence, Block{repair.source_mask, {}, false}).first;
+  }
+  auto& block = it->second;
+  if (block.done || block.mask != repair.source_mask ||
+      block.repairs.size() >= static_cast<std::size_t>(std::popcount(block.mask))) {
+    return out;
+  }
+  block.repairs.push_back(std::move(repair));
+  try_decode(it->first, block, out);
+  return out;
+}
+
+void FecDecoder::try_decode(std::uint64_t base, Block& block, std::vector<Recovered>& out) {
+  struct Source {
+    std::size_t index;
+    std::uint64_t sequence;
+    const Slot* slot;
+  };
+  std::vector<Source> known;
+  std::vector<Source> missing;
+  std::size_t index = 0;
+  for (auto mask = block.mask; mask != 0; mask &= mask - 1, ++index) {
+    const auto sequence = base + static_cast<std::uint64_t>(std::countr_zero(mask));
+    const auto* slot = find(sequence);
+    (slot != nullptr ? known : missing).push_back(Source{index, sequence, slot});
+  }
+  if (missing.empty()) {
+    resolve(block, index, 0);
+    return;
+  }
+
+  // Pick one repair per missing source; all rows of a block share a size.
+  const auto symbol_size = block.repairs.front().symbol.size();
+  std::vector<const FecRepair*> rows;
+  std::uint64_t seen_rows = 0;
+  for (const auto& repair : block.repairs) {
+    const auto row_bit = std::uint64_t{1} << (repair.index % kFecMaxSpan);
+    if (repair.index < kFecMaxSpan && repair.symbol.size() == symbol_size &&
+        (seen_rows & row_bit) == 0 && rows.size() < missing.size()) {
+      seen_rows |= row_bit;
+      rows.push_back(&repair);
+    }
+  }
+  if (rows.size() < missing.size()) {
+    return;
+  }
+
+  // Subtract the known sources, leaving rows over the missing ones only.
+  const auto n = missing.size();
+  std::vector<std::vector<std::uint8_t>> symbols;
+  symbols.reserve(n);
+  for (const auto* row : rows) {
+    symbols.push_back(row->symbol);
+  }
+  for (const auto& source : known) {
+    if (source.slot->plaintext.size() + 2 > symbol_size) {
+      resolve(block, index, n);  // Inconsistent with the repair; give up.
+      return;
+    }
+    for (std::size_t r = 0; r < n; ++r) {
+      accumulate(symbols[r], coefficient(rows[r]->index, source.index), source.slot->plaintext);
+    }
+  }
+
+  // Gauss-Jordan elimination on the n x n Cauchy submatrix.
+  std::vector<std::vector<std::uint8_t>> matrix(n, std::vector<std::uint8_t>(n));
+  for (std::size_t r = 0; r < n; ++r) {
+    for (std::size_t m = 0; m < n; ++m) {
+      matrix[r][m] = coefficient(rows[r]->index, missing[m].index);
+    }
+  }
+  for (std::size_t col = 0; col < n; ++col) {
+    auto pivot = col;
+    while (pivot < n && matrix[pivot][col] == 0) {
+      ++pivot;
+    }
+    if (pivot == n) {
+      return;  // Unreachable for a Cauchy matrix.
+    }
+    std::swap(matrix[pivot], matrix[col]);
+    std::swap(symbols[pivot], symbols[col]);
+    const auto scale = gf256_inv(matrix[col][col]);
+    gf256_mul_region(matrix[col].data(), scale, n);
+    gf256_mul_region(symbols[col].data(), scale, symbol_size);
+    for (std::size_t r = 0; r < n; ++r) {
+      const auto factor = matrix[r][col];
+      if (r != col && factor != 0) {
+        gf256_mul_add(matrix[r].data(), matrix[col].data(), factor, n);
+        gf256_mul_add(symbols[r].data(), symbols[col].data(), factor, symbol_size);
+      }
+    }
+  }
+
+  for (std::size_t m = 0; m < n; ++m) {
+    auto& symbol = symbols[m];
+    const std::size_t length = (static_cast<std::size_t>(symbol[0]) << 8) | symbol[1];
+    if (length + 2 > symbol_size) {
+      continue;
+    }
+    symbol.erase(symbol.begin(), symbol.begin() + 2);
+    symbol.resize(length);
+    out.push_back(Recovered{missing[m].sequence, std::move(symbol)});
+    ++recovered_;
+  }
+  resolve(block, index, n);
+}
+
+void FecDecoder::resolve(Block& block, std::size_t sources, std::size_t lost) {
+  block.done = true;
+  block.repairs = {};
+  report_received_ += static_cast<std::uint32_t>(sources - lost);
+  report_lost_ += static_cast<std::uint32_t>(lost);
+}
+
+void FecDecoder::expire(std::uint64_t newest) {
+  while (!blocks_.empty() && blocks_.begin()->first + slots_.size() <= newest) {
+    auto& [base, block] = *blocks_.begin();
+    if (!block.done) {
+      std::size_t sources = 0;
+      std::size_t lost = 0;
+      for (auto mask = block.mask; mask != 0; mask &= mask - 1, ++sources) {
+        if (find(base + static_cast<std::uint64_t>(std::countr_zero(mask))) == nullptr) {
+          ++lost;
+        }
+      }
+      resolve(block, sources, lost);
+    }
+    blocks_.erase(blocks_.begin());
+  }
+}
+
+std::optional<LossReport> FecDecoder::take_loss_report() {
+  if (report_received_ + report_lost_ < kLossReportPackets) {
+    return std::nullopt;
+  }
+  const LossReport report{report_received_, report_lost_};
+  report_received_ = 0;
+  report_lost_ = 0;
+  return report;
+}
+
+utils::MemoryFootprint FecDecoder::memory_footprint() const {
+  utils::MemoryFootprint footprint;
+  footprint.reserved += slots_.capacity() * sizeof(Slot);
+  for (const auto& slot : slots_) {
+    footprint.reserved += slot.plaintext.capacity();
+    footprint.in_use += slot.plaintext.size();
+  }
+  for (const auto& [_, block] : blocks_) {
+    footprint.reserved += utils::container_node_bytes<decltype(blocks_)>();
+    for (const auto& repair : block.repairs) {
+      footprint.reserved += sizeof(FecRepair) + repair.symbol.capacity();
+      footprint.in_use += repair.symbol.size();
+    }
+  }
+  return footprint;
+}
+
+}  // namespace veil::mux
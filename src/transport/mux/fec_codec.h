@@ -0,0 +1,156 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "common/utils/memory_footprint.h"
+#include "transport/mux/frame.h"
+
+namespace veil::mux {
+
+// Configuration for forward error correction.
+struct FecConfig {
+  // Send repair packets. Receiving needs no configuration: a session
+  // starts decoding when the first repair packet arrives.
+  bool enabled{false};
+  // Data packets per block (1-64).
+  std::size_t block_size{16};
+  // A block still open this long after its first packet is closed early,
+  // so sparse real-time traffic does not wait for a full block.
+  std::chrono::milliseconds block_timeout{20};
+  // Repair packets per block: block sources x clamp(loss_gain x measured
+  // loss rate, min_repair_ratio, max_repair_ratio), rounded up.
+  double min_repair_ratio{0.1};
+  double max_repair_ratio{0.5};
+  double loss_gain{2.0};
+};
+
+// Block sources span at most this many packet sequences.
+inline constexpr std::size_t kFecMaxSpan = 64;
+
+// Bytes a repair packet adds over the largest data packet in its block:
+// control frame header, repair header and the symbol's length prefix.
+inline constexpr std::size_t kFecRepairOverhead = 4 + 17 + 2;
+
+/**
+ * Systematic Reed-Solomon encoder over groups of data packets.
+ *
+ * Data packets go out unchanged; each closed block adds repair packets, any
+ * of which can stand in for any one lost data packet of the block. Repair
+ * row j weights source i by 1 / (x_j + y_i) (a Cauchy matrix), so every
+ * square submatrix is invertible and r repairs recover any r losses.
+ * Repairs are accumulated as packets are added; nothing is copied.
+ *
+ * Thread Safety:
+ *   This class is NOT thread-safe. It is owned by a TransportSession.
+ */
+class FecEncoder {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+
+  explicit FecEncoder(FecConfig config);
+
+  // Add the plaintext of data packet `sequence`. Returns the repairs of any
+  // block this closes: the previous one when `sequence` falls outside its
+  // span, or this one when it is full.
+  std::vector<FecRepair> add(std::uint64_t sequence, std::span<const std::uint8_t> plaintext,
+                             TimePoint now);
+
+  // Close the open block if it has waited block_timeout.
+  std::vector<FecRepair> flush_expired(TimePoint now);
+
+  // Fold in the peer's report of loss before recovery.
+  void on_loss_report(const LossReport& report);
+
+  // Smoothed loss rate from the peer's reports.
+  double loss_rate() const { return loss_rate_; }
+
+  // Repair packets for a block of `sources` packets at the current loss.
+  std::size_t repair_count(std::size_t sources) const;
+
+  utils::MemoryFootprint memory_footprint() const;
+
+ private:
+  std::vector<FecRepair> close();
+
+  FecConfig config_;
+  std::uint64_t base_{0};
+  std::uint64_t mask_{0};
+  std::size_t sources_{0};
+  TimePoint opened_{};
+  // Repair accumulators for the open block, sized for a full block.
+  std::vector<std::vector<std::uint8_t>> repairs_;
+  std::size_t symbol_size_{0};
+  double loss_rate_{0.0};
+};
+
+/**
+ * Receiver side of FecEncoder: remembers recent data packets and rebuilds
+ * missing ones from repair packets, without waiting for a retransmission.
+ *
+ * Received data plaintexts are kept in a ring of `window` slots indexed by
+ * sequence, so a block can be decoded while its packets are among the last
+ * `window` sequences. Blocks short of repairs wait for more; a source that
+ * arrives late also completes them.
+ *
+ * Thread Safety:
+ *   This class is NOT thread-safe. It is owned by a TransportSession.
+ */
+class FecDecoder {
+ public:
+  struct Recovered {
+    std::uint64_t sequence;
+    std::vector<std::uint8_t> plaintext;
+  };
+
+  explicit FecDecoder(std::size_t window = 128);
+
+  // Remember a received data packet. Returns packets this lets a waiting
+  // block recover.
+  std::vector<Recovered> on_source(std::uint64_t sequence, std::span<const std::uint8_t> plaintext);
+
+  // Add a repair packet. Returns the packets it recovers.
+  std::vector<Recovered> on_repair(FecRepair repair);
+
+  // Counts for the sender once enough packets have been accounted.
+  std::optional<LossReport> take_loss_report();
+
+  // Packets recovered so far.
+  std::uint64_t recovered() const { return recovered_; }
+
+  utils::MemoryFootprint memory_footprint() const;
+
+ private:
+  struct Slot {
+    std::uint64_t sequence{0};
+    bool valid{false};
+    std::vector<std::uint8_t> plaintext;
+  };
+  struct Block {
+    std::uint64_t mask{0};
+    std::vector<FecRepair> repairs;
+    bool done{false};
+  };
+
+  const Slot* find(std::uint64_t sequence) const;
+  // Decode `block` if it has enough repairs; appends recovered packets.
+  void try_decode(std::uint64_t base, Block& block, std::vector<Recovered>& out);
+  // Retire blocks whose sources have left the ring.
+  void expire(std::uint64_t newest);
+  void resolve(Block& block, std::size_t sources, std::size_t lost);
+
+  std::vector<Slot> slots_;
+  std::map<std::uint64_t, Block> blocks_;
+  std::uint64_t newest_{0};
+  std::uint32_t report_received_{0};
+  std::uint32_t report_lost_{0};
+  std::uint64_t recovered_{0};
+};
+
+}  // namespace veil::mux
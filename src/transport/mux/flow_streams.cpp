@@ -0,0 +1,62 @@
+#include "transport/mux/flow_streams.h"
+
+#include "common/crypto/random.h"
+#include "tun/ip_packet.h"
+
+namespace veil::mux {
+
+namespace {
+constexpr std::uint8_t kDscpLe = 1;
+constexpr std::uint8_t kDscpCs1 = 8;
+constexpr std::uint8_t kDscpCs3 = 24;
+constexpr std::uint8_t kDscpVoiceAdmit = 44;
+constexpr std::uint8_t kDscpEf = 46;
+}  // namespace
+
+StreamPriority stream_priority(std::uint64_t stream_id) {
+  switch (stream_id >> kStreamBandShift) {
+    case static_cast<std::uint64_t>(StreamPriority::kInteractive):
+      return StreamPriority::kInteractive;
+    case static_cast<std::uint64_t>(StreamPriority::kBulk):
+      return StreamPriority::kBulk;
+    default:
+      return StreamPriority::kNormal;
+  }
+}
+
+StreamPriority priority_for_dscp(std::uint8_t dscp) {
+  if (dscp == kDscpLe || dscp == kDscpCs1) {
+    return StreamPriority::kBulk;
+  }
+  if (dscp == kDscpEf || dscp == kDscpVoiceAdmit) {
+    return StreamPriority::kInteractive;
+  }
+  // Class selectors CS3-CS7 have zero low bits; AF classes 2-4 use drop
+  // precedence 1-3 in bits 1-2.
+  const auto class_bits = static_cast<std::uint8_t>(dscp >> 3);
+  const auto low_bits = static_cast<std::uint8_t>(dscp & 0x07);
+  if (low_bits == 0 && dscp >= kDscpCs3) {
+    return StreamPriority::kInteractive;
+  }
+  const bool assured = (low_bits & 0x01) == 0 && low_bits != 0;
+  if (assured && class_bits >= 2 && class_bits <= 4) {
+    return StreamPriority::kInteractive;
+  }
+  return StreamPriority::kNormal;
+}
+
+FlowStreamMapper::FlowStreamMapper(FlowStreamConfig config)
+    : streams_per_band_(config.streams_per_band == 0 ? 1 : config.streams_per_band),
+      hash_seed_(config.hash_seed != 0 ? config.hash_seed
+                                       : static_cast<std::uint32_t>(crypto::random_uint64())) {}
+
+std::uint64_t FlowStreamMapper::stream_for(std::span<const std::uint8_t> packet) const {
+  const auto key = tun::parse_flow_key(packet);
+  if (!key) {
+    return 0;
+  }
+  const auto priority = priority_for_dscp(tun::dscp(packet));
+  return make_stream_id(priority, tun::flow_hash(*key, hash_seed_) % streams_per_band_);
+}
+
+}  // namespace veil::mux
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace veil::mux {
+
+// Priority band of a mux stream. The band is carried in the stream id (see
+// make_stream_id), so both ends agree on it without negotiation. Stream 0,
+// which senders without a FlowStreamMapper use, is in the normal band.
+enum class StreamPriority : std::uint8_t {
+  kNormal = 0,
+  kInteractive = 1,
+  kBulk = 2,
+};
+
+constexpr unsigned kStreamBandShift = 16;
+
+constexpr std::uint64_t make_stream_id(StreamPriority priority, std::uint32_t index) {
+  return (static_cast<std::uint64_t>(priority) << kStreamBandShift) | (index & 0xFFFFU);
+}
+
+// Band of a stream id; unknown bands count as normal.
+StreamPriority stream_priority(std::uint64_t stream_id);
+
+// Band for a DSCP value, after the RFC 4594 service classes: telephony,
+// signalling, multimedia and low-latency data (EF, VOICE-ADMIT, CS3-CS7,
+// AF2x-AF4x) are interactive; CS1 and LE are bulk; the rest is normal.
+StreamPriority priority_for_dscp(std::uint8_t dscp);
+
+struct FlowStreamConfig {
+  // Streams per priority band. Flows hash onto these; flows sharing a stream
+  // can still hold each other up, so more streams mean less head-of-line
+  // blocking but more ordering state at the receiver.
+  std::uint32_t streams_per_band{8};
+  // Flow hash perturbation; 0 picks a random one.
+  std::uint32_t hash_seed{0};
+};
+
+/**
+ * Assigns inner IP packets to mux streams: the DSCP selects the priority
+ * band and the 5-tuple hash a stream within it. Every packet of a flow
+ * lands on the same stream, and so keeps its order under ordered delivery,
+ * while unrelated flows mostly land on other streams and do not wait for
+ * each other's losses.
+ *
+ * Thread Safety:
+ *   Immutable after construction; safe to share between threads.
+ *
+ * @see docs/thread_model.md for the VEIL threading model documentation.
+ */
+class FlowStreamMapper {
+ public:
+  explicit FlowStreamMapper(FlowStreamConfig config = {});
+
+  // Stream for a packet read from the TUN device. Packets that are not IP
+  // go to stream 0.
+  std::uint64_t stream_for(std::span<const std::uint8_t> packet) const;
+
+ private:
+  std::uint32_t streams_per_band_;
+  std::uint32_t hash_seed_;
+};
+
+}  // namespace veil::mux
@@ -88,4 +88,17 @@ std::size_t FragmentReassembly::memory_usage() const {
   return total;
 }
 
+utils::MemoryFootprint FragmentReassembly::memory_footprint() const {
+  utils::MemoryFootprint footprint{.reserved = 0, .in_use = 0, .limit = max_bytes_};
+  for (const auto& [_, state] : state_) {
+    footprint.in_use += state.total_bytes;
+    footprint.reserved += utils::container_node_bytes<decltype(state_)>() +
+                          state.fragments.capacity() * sizeof(Fragment);
+    for (const auto& fragment : state.fragments) {
+      footprint.reserved += fragment.data.capacity();
+    }
+  }
+  return footprint;
+}
+
 }  // namespace veil::mux
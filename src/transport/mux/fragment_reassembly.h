@@ -6,6 +6,8 @@
 #include <optional>
 #include <vector>
 
+#include "common/utils/memory_footprint.h"
+
 namespace veil::mux {
 
 struct Fragment {
@@ -35,9 +37,15 @@ class FragmentReassembly {
   // Get number of incomplete messages currently buffered.
   [[nodiscard]] std::size_t pending_count() const { return state_.size(); }
 
+  // Change the per-message cap for future fragments; buffered data is kept.
+  void set_max_bytes(std::size_t max_bytes) { max_bytes_ = max_bytes; }
+
   // Get total memory used by incomplete fragments.
   [[nodiscard]] std::size_t memory_usage() const;
 
+  // Heap held by incomplete messages; the limit is the per-message cap.
+  [[nodiscard]] utils::MemoryFootprint memory_footprint() const;
+
  private:
   struct State {
     std::vector<Fragment> fragments;
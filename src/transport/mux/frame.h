@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <cstdint>
+#include <limits>
 #include <vector>
 
 namespace veil::mux {
@@ -11,6 +12,9 @@ struct DataFrame {
   std::uint64_t sequence{0};
   bool fin{false};
   std::vector<std::uint8_t> payload;
+  // Part of a fragmented message: `sequence` is (message id << 32) | index
+  // rather than the stream's message sequence.
+  bool fragment{false};
 };
 
 struct AckFrame {
@@ -24,6 +28,59 @@ struct ControlFrame {
   std::vector<std::uint8_t> payload;
 };
 
+// ControlFrame types.
+enum class ControlType : std::uint8_t {
+  kWindowUpdate = 1,
+  kBlocked = 2,
+  kFecRepair = 3,
+  kLossReport = 4,
+  kAckFrequency = 5,
+  kRoutes = 6,
+};
+
+// Stream id that addresses the connection-wide flow-control window.
+constexpr std::uint64_t kConnectionStream = std::numeric_limits<std::uint64_t>::max();
+
+// Receive credit (QUIC MAX_DATA / MAX_STREAM_DATA). The receiver has seen
+// the peer's data below `sequence` (packet sequences for the connection,
+// message sequences for a stream) and accepts `window` payload bytes sent
+// from there on. Anything older counts as delivered or lost, so credit
+// does not leak when packets are dropped on the path.
+struct WindowUpdate {
+  std::uint64_t stream_id{kConnectionStream};
+  std::uint64_t sequence{0};
+  std::uint64_t window{0};
+};
+
+// FEC repair symbol for one block of data packets. Source i of the block is
+// the packet whose sequence is `base_sequence` plus the position of the
+// i-th set bit of `source_mask`; `symbol` is repair row `index` over the
+// sources' length-prefixed plaintexts.
+struct FecRepair {
+  std::uint64_t base_sequence{0};
+  std::uint64_t source_mask{0};
+  std::uint8_t index{0};
+  std::vector<std::uint8_t> symbol;
+};
+
+// Data packets covered by FEC that the receiver got, and those it found
+// missing before recovery, since the last report. Drives the sender's
+// repair ratio.
+struct LossReport {
+  std::uint32_t received{0};
+  std::uint32_t lost{0};
+};
+
+// Sender's request for how often the peer acknowledges its data (after
+// the QUIC ACK_FREQUENCY frame): an ACK once `packet_threshold` data
+// packets are unacknowledged, or `max_ack_delay` after the first of them.
+// Requests carry increasing `sequence` numbers; older ones are ignored.
+struct AckFrequency {
+  std::uint64_t sequence{0};
+  std::uint32_t packet_threshold{2};
+  std::chrono::milliseconds max_ack_delay{50};
+};
+
 // Heartbeat frame for keep-alive and obfuscation.
 struct HeartbeatFrame {
   std::uint64_t timestamp{0};  // Milliseconds since epoch or relative.
@@ -0,0 +1,199 @@
+#include "transport/mux/gf256.h"
+
+#include <array>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define VEIL_GF256_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define VEIL_GF256_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace veil::mux {
+
+namespace {
+
+struct Tables {
+  std::array<std::uint8_t, 512> exp{};
+  std::array<std::uint8_t, 256> log{};
+  // Per coefficient: c * x for x in 0..15, then c * (x << 4).
+  alignas(32) std::array<std::array<std::uint8_t, 32>, 256> nibble{};
+
+  Tables() {
+    unsigned x = 1;
+    for (unsigned i = 0; i < 255; ++i) {
+      exp[i] = static_cast<std::uint8_t>(x);
+      log[x] = static_cast<std::uint8_t>(i);
+      x <<= 1;
+      if ((x & 0x100U) != 0) {
+        x ^= 0x11dU;
+      }
+    }
+    // Doubled so that exp[log a + log b] needs no reduction.
+    for (unsigned i = 255; i < exp.size(); ++i) {
+      exp[i] = exp[i - 255];
+    }
+    for (unsigned c = 0; c < 256; ++c) {
+      for (unsigned n = 0; n < 16; ++n) {
+        nibble[c][n] = mul(static_cast<std::uint8_t>(c), static_cast<std::uint8_t>(n));
+        nibble[c][16 + n] = mul(static_cast<std::uint8_t>(c), static_cast<std::uint8_t>(n << 4));
+      }
+    }
+  }
+
+  std::uint8_t mul(std::uint8_t a, std::uint8_t b) const {
+    if (a == 0 || b == 0) {
+      return 0;
+    }
+    return exp[static_cast<std::size_t>(log[a]) + log[b]];
+  }
+};
+
+const Tables& tables() {
+  static const Tables instance;
+  return instance;
+}
+
+// A kernel computes dst = c * src, or dst ^= c * src when accumulating,
+// given the coefficient's nibble tables.
+using Kernel = void (*)(std::uint8_t* dst, const std::uint8_t* src, const std::uint8_t* nibble,
+                        std::size_t n, bool accumulate);
+
+void scalar_kernel(std::uint8_t* dst, const std::uint8_t* src, const std::uint8_t* nibble,
+                   std::size_t n, bool accumulate) {
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto product =
+        static_cast<std::uint8_t>(nibble[src[i] & 0x0f] ^ nibble[16 + (src[i] >> 4)]);
+    dst[i] = accumulate ? static_cast<std::uint8_t>(dst[i] ^ product) : product;
+  }
+}
+
+#if defined(VEIL_GF256_X86)
+__attribute__((target("ssse3"))) void ssse3_kernel(std::uint8_t* dst, const std::uint8_t* src,
+                                                   const std::uint8_t* nibble, std::size_t n,
+                                                   bool accumulate) {
+  const __m128i lo_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nibble));
+  const __m128i hi_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nibble + 16));
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i lo = _mm_shuffle_epi8(lo_table, _mm_and_si128(x, mask));
+    const __m128i hi = _mm_shuffle_epi8(hi_table, _mm_and_si128(_mm_srli_epi64(x, 4), mask));
+    __m128i product = _mm_xor_si128(lo, hi);
+    if (accumulate) {
+      product = _mm_xor_si128(product, _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), product);
+  }
+  scalar_kernel(dst + i, src + i, nibble, n - i, accumulate);
+}
+
+__attribute__((target("avx2"))) void avx2_kernel(std::uint8_t* dst, const std::uint8_t* src,
+                                                 const std::uint8_t* nibble, std::size_t n,
+                                                 bool accumulate) {
+  const __m256i lo_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(nibble)));
+  const __m256i hi_table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(nibble + 16)));
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    const __m256i lo = _mm256_shuffle_epi8(lo_table, _mm256_and_si256(x, mask));
+    const __m256i hi =
+        _mm256_shuffle_epi8(hi_table, _mm256_and_si256(_mm256_srli_epi64(x, 4), mask));
+    __m256i product = _mm256_xor_si256(lo, hi);
+    if (accumulate) {
+      product = _mm256_xor_si256(product,
+                                 _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i)));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), product);
+  }
+  ssse3_kernel(dst + i, src + i, nibble, n - i, accumulate);
+}
+#endif
+
+#if defined(VEIL_GF256_NEON)
+void neon_kernel(std::uint8_t* dst, const std::uint8_t* src, const std::uint8_t* nibble,
+                 std::size_t n, bool accumulate) {
+  const uint8x16_t lo_table = vld1q_u8(nibble);
+  const uint8x16_t hi_table = vld1q_u8(nibble + 16);
+  const uint8x16_t mask = vdupq_n_u8(0x0f);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const uint8x16_t x = vld1q_u8(src + i);
+    uint8x16_t product = veorq_u8(vqtbl1q_u8(lo_table, vandq_u8(x, mask)),
+                                  vqtbl1q_u8(hi_table, vshrq_n_u8(x, 4)));
+    if (accumulate) {
+      product = veorq_u8(product, vld1q_u8(dst + i));
+    }
+    vst1q_u8(dst + i, product);
+  }
+  scalar_kernel(dst + i, src + i, nibble, n - i, accumulate);
+}
+#endif
+
+struct Dispatch {
+  Kernel kernel;
+  const char* name;
+};
+
+Dispatch select_kernel() {
+#if defined(VEIL_GF256_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return {avx2_kernel, "avx2"};
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return {ssse3_kernel, "ssse3"};
+  }
+#elif defined(VEIL_GF256_NEON)
+  return {neon_kernel, "neon"};
+#endif
+  return {scalar_kernel, "scalar"};
+}
+
+const Dispatch& dispatch() {
+  static const Dispatch selected = select_kernel();
+  return selected;
+}
+
+}  // namespace
+
+std::uint8_t gf256_mul(std::uint8_t a, std::uint8_t b) { return tables().mul(a, b); }
+
+std::uint8_t gf256_inv(std::uint8_t a) {
+  const auto& t = tables();
+  return t.exp[255 - t.log[a]];
+}
+
+void gf256_mul_add(std::uint8_t* dst, const std::uint8_t* src, std::uint8_t c, std::size_t n) {
+  if (c == 0 || n == 0) {
+    return;
+  }
+  if (c == 1) {
+    for (std::size_t i = 0; i < n; ++i) {
+      dst[i] ^= src[i];
+    }
+    return;
+  }
+  dispatch().kernel(dst, src, tables().nibble[c].data(), n, true);
+}
+
+void gf256_mul_region(std::uint8_t* dst, std::uint8_t c, std::size_t n) {
+  if (c == 1 || n == 0) {
+    return;
+  }
+  if (c == 0) {
+    std::memset(dst, 0, n);
+    return;
+  }
+  dispatch().kernel(dst, dst, tables().nibble[c].data(), n, false);
+}
+
+const char* gf256_kernel_name() { return dispatch().name; }
+
+}  // namespace veil::mux
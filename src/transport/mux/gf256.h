@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace veil::mux {
+
+// Arithmetic in GF(2^8) with the polynomial x^8 + x^4 + x^3 + x^2 + 1
+// (0x11d), as used by the FEC block code.
+//
+// The region functions are the hot loops of FEC encoding and decoding.
+// They use the split-nibble table method: a product c * x is the XOR of two
+// 16-entry lookups on the low and high nibble of x, which maps onto a byte
+// shuffle (PSHUFB on x86, TBL on AArch64). The widest kernel the CPU
+// supports is picked on first use.
+
+std::uint8_t gf256_mul(std::uint8_t a, std::uint8_t b);
+
+// Multiplicative inverse; `a` must be non-zero.
+std::uint8_t gf256_inv(std::uint8_t a);
+
+// dst[i] ^= c * src[i] for i < n.
+void gf256_mul_add(std::uint8_t* dst, const std::uint8_t* src, std::uint8_t c, std::size_t n);
+
+// dst[i] = c * dst[i] for i < n.
+void gf256_mul_region(std::uint8_t* dst, std::uint8_t c, std::size_t n);
+
+// Region kernel in use: "avx2", "ssse3", "neon" or "scalar".
+const char* gf256_kernel_name();
+
+}  // namespace veil::mux
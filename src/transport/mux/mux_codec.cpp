@@ -1,5 +1,7 @@
 #include "transport/mux/mux_codec.h"
 
+#include "common/utils/allocation_tracker.h"
+
 #include <algorithm>
 #include <cstdint>
 #include <optional>
@@ -50,6 +52,7 @@ std::uint64_t read_u64(std::span<const std::uint8_t> data, std::size_t offset) {
 namespace veil::mux {
 
 std::vector<std::uint8_t> MuxCodec::encode(const MuxFrame& frame) {
+  VEIL_ALLOCATION_SCOPE(kMux);
   std::vector<std::uint8_t> out;
   out.reserve(encoded_size(frame));
   out.push_back(static_cast<std::uint8_t>(frame.kind));
@@ -59,6 +62,9 @@ std::vector<std::uint8_t> MuxCodec::encode(const MuxFrame& frame) {
       write_u64(out, frame.data.stream_id);
       write_u64(out, frame.data.sequence);
       std::uint8_t flags = frame.data.fin ? 0x01 : 0x00;
+      if (frame.data.fragment) {
+        flags |= 0x02;
+      }
       out.push_back(flags);
       write_u16(out, static_cast<std::uint16_t>(frame.data.payload.size()));
       out.insert(out.end(), frame.data.payload.begin(), frame.data.payload.end());
@@ -89,6 +95,7 @@ std::vector<std::uint8_t> MuxCodec::encode(const MuxFrame& frame) {
 }
 
 std::optional<MuxFrame> MuxCodec::decode(std::span<const std::uint8_t> data) {
+  VEIL_ALLOCATION_SCOPE(kMux);
   if (data.empty()) {
     return std::nullopt;
   }
@@ -106,6 +113,7 @@ std::optional<MuxFrame> MuxCodec::decode(std::span<const std::uint8_t> data) {
       frame.data.sequence = read_u64(data, 9);
       std::uint8_t flags = data[17];
       frame.data.fin = (flags & 0x01) != 0;
+      frame.data.fragment = (flags & 0x02) != 0;
       std::uint16_t payload_len = read_u16(data, 18);
       if (data.size() != kDataHeaderSize + payload_len) {
         return std::nullopt;
@@ -154,6 +162,32 @@ std::optional<MuxFrame> MuxCodec::decode(std::span<const std::uint8_t> data) {
   return frame;
 }
 
+std::optional<std::size_t> MuxCodec::frame_size(std::span<const std::uint8_t> data) {
+  if (data.empty()) {
+    return std::nullopt;
+  }
+  switch (static_cast<FrameKind>(data[0])) {
+    case FrameKind::kData:
+      if (data.size() < kDataHeaderSize) {
+        return std::nullopt;
+      }
+      return kDataHeaderSize + read_u16(data, 18);
+    case FrameKind::kAck:
+      return kAckSize;
+    case FrameKind::kControl:
+      if (data.size() < kControlHeaderSize) {
+        return std::nullopt;
+      }
+      return kControlHeaderSize + read_u16(data, 2);
+    case FrameKind::kHeartbeat:
+      if (data.size() < kHeartbeatHeaderSize) {
+        return std::nullopt;
+      }
+      return kHeartbeatHeaderSize + read_u16(data, 17);
+  }
+  return std::nullopt;
+}
+
 std::size_t MuxCodec::encoded_size(const MuxFrame& frame) {
   switch (frame.kind) {
     case FrameKind::kData:
@@ -196,6 +230,103 @@ MuxFrame make_control_frame(std::uint8_t type, std::vector<std::uint8_t> payload
   return frame;
 }
 
+MuxFrame make_window_update_frame(const WindowUpdate& update) {
+  std::vector<std::uint8_t> payload;
+  payload.reserve(24);
+  write_u64(payload, update.stream_id);
+  write_u64(payload, update.sequence);
+  write_u64(payload, update.window);
+  return make_control_frame(static_cast<std::uint8_t>(ControlType::kWindowUpdate),
+                            std::move(payload));
+}
+
+MuxFrame make_blocked_frame(std::uint64_t stream_id) {
+  std::vector<std::uint8_t> payload;
+  payload.reserve(8);
+  write_u64(payload, stream_id);
+  return make_control_frame(static_cast<std::uint8_t>(ControlType::kBlocked), std::move(payload));
+}
+
+std::optional<WindowUpdate> parse_window_update(const ControlFrame& control) {
+  if (control.type != static_cast<std::uint8_t>(ControlType::kWindowUpdate) ||
+      control.payload.size() != 24) {
+    return std::nullopt;
+  }
+  return WindowUpdate{read_u64(control.payload, 0), read_u64(control.payload, 8),
+                      read_u64(control.payload, 16)};
+}
+
+std::optional<std::uint64_t> parse_blocked(const ControlFrame& control) {
+  if (control.type != static_cast<std::uint8_t>(ControlType::kBlocked) ||
+      control.payload.size() != 8) {
+    return std::nullopt;
+  }
+  return read_u64(control.payload, 0);
+}
+
+MuxFrame make_fec_repair_frame(const FecRepair& repair) {
+  std::vector<std::uint8_t> payload;
+  payload.reserve(17 + repair.symbol.size());
+  write_u64(payload, repair.base_sequence);
+  write_u64(payload, repair.source_mask);
+  payload.push_back(repair.index);
+  payload.insert(payload.end(), repair.symbol.begin(), repair.symbol.end());
+  return make_control_frame(static_cast<std::uint8_t>(ControlType::kFecRepair), std::move(payload));
+}
+
+MuxFrame make_loss_report_frame(const LossReport& report) {
+  std::vector<std::uint8_t> payload;
+  payload.reserve(8);
+  write_u32(payload, report.received);
+  write_u32(payload, report.lost);
+  return make_control_frame(static_cast<std::uint8_t>(ControlType::kLossReport),
+                            std::move(payload));
+}
+
+std::optional<FecRepair> parse_fec_repair(const ControlFrame& control) {
+  if (control.type != static_cast<std::uint8_t>(ControlType::kFecRepair) ||
+      control.payload.size() <= 17) {
+    return std::nullopt;
+  }
+  FecRepair repair{read_u64(control.payload, 0), read_u64(control.payload, 8), control.payload[16],
+                   std::vector<std::uint8_t>(control.payload.begin() + 17, control.payload.end())};
+  if (repair.source_mask == 0) {
+    return std::nullopt;
+  }
+  return repair;
+}
+
+std::optional<LossReport> parse_loss_report(const ControlFrame& control) {
+  if (control.type != static_cast<std::uint8_t>(ControlType::kLossReport) ||
+      control.payload.size() != 8) {
+    return std::nullopt;
+  }
+  return LossReport{read_u32(control.payload, 0), read_u32(control.payload, 4)};
+}
+
+MuxFrame make_ack_frequency_frame(const AckFrequency& request) {
+  std::vector<std::uint8_t> payload;
+  payload.reserve(16);
+  write_u64(payload, request.sequence);
+  write_u32(payload, request.packet_threshold);
+  write_u32(payload, static_cast<std::uint32_t>(request.max_ack_delay.count()));
+  return make_control_frame(static_cast<std::uint8_t>(ControlType::kAckFrequency),
+                            std::move(payload));
+}
+
+std::optional<AckFrequency> parse_ack_frequency(const ControlFrame& control) {
+  if (control.type != static_cast<std::uint8_t>(ControlType::kAckFrequency) ||
+      control.payload.size() != 16) {
+    return std::nullopt;
+  }
+  AckFrequency request{read_u64(control.payload, 0), read_u32(control.payload, 8),
+                       std::chrono::milliseconds(read_u32(control.payload, 12))};
+  if (request.packet_threshold == 0) {
+    return std::nullopt;
+  }
+  return request;
+}
+
 MuxFrame make_heartbeat_frame(std::uint64_t timestamp, std::uint64_t sequence,
                                std::vector<std::uint8_t> payload) {
   MuxFrame frame{};
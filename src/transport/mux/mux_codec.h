@@ -15,7 +15,7 @@ namespace veil::mux {
 //   For kData:
 //     [stream_id: 8 bytes big-endian]
 //     [sequence: 8 bytes big-endian]
-//     [flags: 1 byte, bit 0 = FIN]
+//     [flags: 1 byte, bit 0 = FIN, bit 1 = fragment]
 //     [payload_len: 2 bytes big-endian]
 //     [payload: payload_len bytes]
 //   For kAck:
@@ -26,6 +26,21 @@ namespace veil::mux {
 //     [type: 1 byte]
 //     [payload_len: 2 bytes big-endian]
 //     [payload: payload_len bytes]
+//     ControlType::kWindowUpdate payload:
+//       [stream_id: 8 bytes] [sequence: 8 bytes] [window: 8 bytes]
+//     ControlType::kBlocked payload:
+//       [stream_id: 8 bytes]
+//     ControlType::kFecRepair payload:
+//       [base_sequence: 8 bytes] [source_mask: 8 bytes] [index: 1 byte]
+//       [symbol: remaining bytes]
+//     ControlType::kLossReport payload:
+//       [received: 4 bytes] [lost: 4 bytes]
+//     ControlType::kAckFrequency payload:
+//       [sequence: 8 bytes] [packet_threshold: 4 bytes]
+//       [max_ack_delay_ms: 4 bytes]
+//     ControlType::kRoutes payload, per prefix (tun::encode_ip_prefixes):
+//       [version: 1 byte, 4 or 6] [length: 1 byte]
+//       [address: 4 or 16 bytes]
 //   For kHeartbeat:
 //     [timestamp: 8 bytes big-endian]
 //     [sequence: 8 bytes big-endian]
@@ -40,6 +55,10 @@ class MuxCodec {
   // Parse bytes into a MuxFrame. Returns nullopt on malformed input.
   static std::optional<MuxFrame> decode(std::span<const std::uint8_t> data);
 
+  // Length of the frame at the start of `data`, read from its header, or
+  // nullopt if the header is incomplete. Bytes past it are padding.
+  static std::optional<std::size_t> frame_size(std::span<const std::uint8_t> data);
+
   // Returns the expected size needed to encode this frame (for pre-allocation).
   static std::size_t encoded_size(const MuxFrame& frame);
 
@@ -59,6 +78,31 @@ MuxFrame make_ack_frame(std::uint64_t stream_id, std::uint64_t ack, std::uint32_
 
 MuxFrame make_control_frame(std::uint8_t type, std::vector<std::uint8_t> payload);
 
+MuxFrame make_window_update_frame(const WindowUpdate& update);
+
+// A sender's notice that it has data but no credit on `stream_id`
+// (kConnectionStream for the connection window).
+MuxFrame make_blocked_frame(std::uint64_t stream_id);
+
+// Parse the payload of a kWindowUpdate or kBlocked control frame. Return
+// nullopt for other types or malformed payloads.
+std::optional<WindowUpdate> parse_window_update(const ControlFrame& control);
+std::optional<std::uint64_t> parse_blocked(const ControlFrame& control);
+
+MuxFrame make_fec_repair_frame(const FecRepair& repair);
+MuxFrame make_loss_report_frame(const LossReport& report);
+
+// Parse the payload of a kFecRepair or kLossReport control frame. Return
+// nullopt for other types or malformed payloads.
+std::optional<FecRepair> parse_fec_repair(const ControlFrame& control);
+std::optional<LossReport> parse_loss_report(const ControlFrame& control);
+
+MuxFrame make_ack_frequency_frame(const AckFrequency& request);
+
+// Parse the payload of a kAckFrequency control frame. Return nullopt for
+// other types, malformed payloads and a zero packet threshold.
+std::optional<AckFrequency> parse_ack_frequency(const ControlFrame& control);
+
 MuxFrame make_heartbeat_frame(std::uint64_t timestamp, std::uint64_t sequence,
                                std::vector<std::uint8_t> payload = {});
 
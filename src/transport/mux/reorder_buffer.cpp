@@ -36,4 +36,31 @@ std::optional<std::vector<std::uint8_t>> ReorderBuffer::pop_next() {
   return payload;
 }
 
+std::optional<std::uint64_t> ReorderBuffer::first_buffered() const {
+  if (buffer_.empty()) {
+    return std::nullopt;
+  }
+  return buffer_.begin()->first;
+}
+
+void ReorderBuffer::skip_to(std::uint64_t seq) {
+  if (seq <= next_) {
+    return;
+  }
+  const auto end = buffer_.lower_bound(seq);
+  for (auto it = buffer_.begin(); it != end; ++it) {
+    buffered_bytes_ -= it->second.size();
+  }
+  buffer_.erase(buffer_.begin(), end);
+  next_ = seq;
+}
+
+utils::MemoryFootprint ReorderBuffer::memory_footprint() const {
+  utils::MemoryFootprint footprint{.reserved = 0, .in_use = buffered_bytes_, .limit = max_bytes_};
+  for (const auto& [_, payload] : buffer_) {
+    footprint.reserved += utils::container_node_bytes<decltype(buffer_)>() + payload.capacity();
+  }
+  return footprint;
+}
+
 }  // namespace veil::mux
@@ -5,6 +5,8 @@
 #include <optional>
 #include <vector>
 
+#include "common/utils/memory_footprint.h"
+
 namespace veil::mux {
 
 class ReorderBuffer {
@@ -14,6 +16,20 @@ class ReorderBuffer {
   bool push(std::uint64_t seq, std::vector<std::uint8_t> payload);
   std::optional<std::vector<std::uint8_t>> pop_next();
   std::uint64_t next_expected() const { return next_; }
+  std::size_t buffered_bytes() const { return buffered_bytes_; }
+  bool empty() const { return buffer_.empty(); }
+
+  // Lowest buffered sequence, if any.
+  std::optional<std::uint64_t> first_buffered() const;
+
+  // Give up on everything before `seq`: next_expected() becomes `seq` and
+  // buffered entries below it are discarded. No-op if `seq` is not ahead.
+  void skip_to(std::uint64_t seq);
+
+  // Change the cap for future pushes; buffered data is kept.
+  void set_max_bytes(std::size_t max_bytes) { max_bytes_ = max_bytes; }
+
+  utils::MemoryFootprint memory_footprint() const;
 
  private:
   std::uint64_t next_;
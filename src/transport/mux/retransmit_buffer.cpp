@@ -333,4 +333,25 @@ std::size_t RetransmitBuffer::force_cleanup(std::size_t target_bytes) {
   return dropped;
 }
 
+void RetransmitBuffer::set_max_buffer_bytes(std::size_t max_buffer_bytes) {
+  if (config_.max_buffer_bytes != 0) {
+    const double scale =
+        static_cast<double>(max_buffer_bytes) / static_cast<double>(config_.max_buffer_bytes);
+    config_.high_water_mark =
+        static_cast<std::size_t>(static_cast<double>(config_.high_water_mark) * scale);
+    config_.low_water_mark =
+        static_cast<std::size_t>(static_cast<double>(config_.low_water_mark) * scale);
+  }
+  config_.max_buffer_bytes = max_buffer_bytes;
+}
+
+utils::MemoryFootprint RetransmitBuffer::memory_footprint() const {
+  utils::MemoryFootprint footprint{
+      .reserved = 0, .in_use = buffered_bytes_, .limit = config_.max_buffer_bytes};
+  for (const auto& [_, packet] : pending_) {
+    footprint.reserved += utils::container_node_bytes<decltype(pending_)>() + packet.data.capacity();
+  }
+  return footprint;
+}
+
 }  // namespace veil::mux
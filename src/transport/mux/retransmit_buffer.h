@@ -7,6 +7,8 @@
 #include <optional>
 #include <vector>
 
+#include "common/utils/memory_footprint.h"
+
 namespace veil::mux {
 
 // Drop policy when buffer is full.
@@ -161,6 +163,14 @@ class RetransmitBuffer {
   // Returns number of packets dropped.
   std::size_t force_cleanup(std::size_t target_bytes);
 
+  // Change the buffer cap, scaling the water marks with it. Packets already
+  // buffered are kept even if they exceed the new cap.
+  void set_max_buffer_bytes(std::size_t max_buffer_bytes);
+  std::size_t max_buffer_bytes() const { return config_.max_buffer_bytes; }
+
+  // Heap held by unacknowledged packets; in_use equals buffered_bytes().
+  utils::MemoryFootprint memory_footprint() const;
+
   // Get buffer utilization ratio [0.0, 1.0].
   double utilization() const {
     if (config_.max_buffer_bytes == 0) return 0.0;
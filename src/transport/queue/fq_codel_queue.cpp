@@ -0,0 +1,219 @@
+#include "transport/queue/fq_codel_queue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "common/crypto/random.h"
+#include "tun/ip_packet.h"
+
+namespace veil::transport {
+
+namespace {
+constexpr std::chrono::microseconds kMinInterval{10000};
+constexpr std::chrono::microseconds kMaxInterval{1000000};
+}  // namespace
+
+FqCodelQueue::FqCodelQueue(FqCodelConfig config, std::function<TimePoint()> now_fn)
+    : config_(config),
+      now_fn_(std::move(now_fn)),
+      target_(config_.target),
+      interval_(config_.interval),
+      hash_seed_(config_.hash_seed != 0 ? config_.hash_seed
+                                        : static_cast<std::uint32_t>(crypto::random_uint64())) {
+  if (config_.flows == 0) {
+    config_.flows = 1;
+  }
+}
+
+std::uint32_t FqCodelQueue::bucket_for(std::span<const std::uint8_t> packet) const {
+  const auto key = tun::parse_flow_key(packet);
+  if (!key) {
+    return 0;
+  }
+  return tun::flow_hash(*key, hash_seed_) % config_.flows;
+}
+
+void FqCodelQueue::enqueue(std::span<const std::uint8_t> packet) {
+  const auto id = bucket_for(packet);
+  auto& flow = flows_[id];
+  flow.queue.push_back(Entry{std::vector<std::uint8_t>(packet.begin(), packet.end()), now_fn_()});
+  flow.bytes += packet.size();
+  backlog_bytes_ += packet.size();
+  ++backlog_packets_;
+  ++stats_.enqueued;
+
+  if (flow.list == List::kNone) {
+    flow.list = List::kNew;
+    flow.deficit = static_cast<std::int64_t>(config_.quantum_bytes);
+    new_flows_.push_back(id);
+  }
+
+  while (backlog_bytes_ > config_.limit_bytes && backlog_packets_ > 1) {
+    drop_from_fattest_flow();
+  }
+}
+
+std::optional<std::vector<std::uint8_t>> FqCodelQueue::dequeue() {
+  const auto now = now_fn_();
+  while (true) {
+    std::deque<std::uint32_t>* list = nullptr;
+    if (!new_flows_.empty()) {
+      list = &new_flows_;
+    } else if (!old_flows_.empty()) {
+      list = &old_flows_;
+    } else {
+      return std::nullopt;
+    }
+
+    const auto id = list->front();
+    auto& flow = flows_.at(id);
+    if (flow.deficit <= 0) {
+      flow.deficit += static_cast<std::int64_t>(config_.quantum_bytes);
+      list->pop_front();
+      old_flows_.push_back(id);
+      flow.list = List::kOld;
+      continue;
+    }
+
+    auto entry = codel_dequeue(flow, now);
+    if (!entry) {
+      list->pop_front();
+      // An emptied new flow gets one more pass through the old list, so
+      // a flow cannot stay "new" by sending one packet at a time.
+      if (list == &new_flows_) {
+        old_flows_.push_back(id);
+        flow.list = List::kOld;
+      } else {
+        flow.list = List::kNone;
+      }
+      continue;
+    }
+
+    flow.deficit -= static_cast<std::int64_t>(entry->data.size());
+    ++stats_.dequeued;
+    return std::move(entry->data);
+  }
+}
+
+void FqCodelQueue::set_rtt(std::chrono::microseconds rtt) {
+  interval_ = std::clamp(rtt, kMinInterval, kMaxInterval);
+  target_ = std::max(config_.target, interval_ / 20);
+}
+
+std::optional<FqCodelQueue::Entry> FqCodelQueue::pop_head(Flow& flow, TimePoint now,
+                                                          bool& ok_to_drop) {
+  ok_to_drop = false;
+  if (flow.queue.empty()) {
+    flow.first_above_time = TimePoint{};
+    return std::nullopt;
+  }
+
+  Entry entry = std::move(flow.queue.front());
+  flow.queue.pop_front();
+  flow.bytes -= entry.data.size();
+  backlog_bytes_ -= entry.data.size();
+  --backlog_packets_;
+
+  // A queue holding at most one packet is never "standing", whatever its
+  // sojourn time.
+  const auto sojourn = now - entry.enqueued;
+  if (sojourn < target_ || flow.bytes <= config_.quantum_bytes) {
+    flow.first_above_time = TimePoint{};
+  } else if (flow.first_above_time == TimePoint{}) {
+    flow.first_above_time = now + interval_;
+  } else if (now >= flow.first_above_time) {
+    ok_to_drop = true;
+  }
+  return entry;
+}
+
+std::optional<FqCodelQueue::Entry> FqCodelQueue::codel_dequeue(Flow& flow, TimePoint now) {
+  bool ok_to_drop = false;
+  auto entry = pop_head(flow, now, ok_to_drop);
+  if (!entry) {
+    flow.dropping = false;
+    return std::nullopt;
+  }
+
+  if (flow.dropping) {
+    if (!ok_to_drop) {
+      flow.dropping = false;
+    }
+    while (flow.dropping && now >= flow.drop_next) {
+      ++flow.count;
+      if (mark(*entry)) {
+        flow.drop_next = control_law(flow.drop_next, flow.count);
+        break;
+      }
+      ++stats_.codel_drops;
+      entry = pop_head(flow, now, ok_to_drop);
+      if (!entry) {
+        flow.dropping = false;
+        return std::nullopt;
+      }
+      if (!ok_to_drop) {
+        flow.dropping = false;
+      } else {
+        flow.drop_next = control_law(flow.drop_next, flow.count);
+      }
+    }
+    return entry;
+  }
+
+  if (ok_to_drop) {
+    if (!mark(*entry)) {
+      ++stats_.codel_drops;
+      entry = pop_head(flow, now, ok_to_drop);
+    }
+    flow.dropping = true;
+    // Resume near the previous drop rate if the last episode was recent.
+    const auto delta = flow.count - flow.last_count;
+    flow.count = (delta > 1 && now - flow.drop_next < 16 * interval_) ? delta : 1;
+    flow.drop_next = control_law(now, flow.count);
+    flow.last_count = flow.count;
+  }
+  return entry;
+}
+
+bool FqCodelQueue::mark(Entry& entry) {
+  if (!config_.ecn) {
+    return false;
+  }
+  const auto ecn = tun::ecn_codepoint(entry.data);
+  if (ecn == tun::Ecn::kNotEct) {
+    return false;
+  }
+  if (ecn != tun::Ecn::kCe) {
+    tun::set_ecn_codepoint(entry.data, tun::Ecn::kCe);
+  }
+  ++stats_.ecn_marks;
+  return true;
+}
+
+FqCodelQueue::TimePoint FqCodelQueue::control_law(TimePoint t, std::uint32_t count) const {
+  const auto step = std::chrono::duration<double, std::micro>(
+      static_cast<double>(interval_.count()) / std::sqrt(static_cast<double>(count)));
+  return t + std::chrono::duration_cast<Clock::duration>(step);
+}
+
+void FqCodelQueue::drop_from_fattest_flow() {
+  auto fattest = flows_.end();
+  for (auto it = flows_.begin(); it != flows_.end(); ++it) {
+    if (fattest == flows_.end() || it->second.bytes > fattest->second.bytes) {
+      fattest = it;
+    }
+  }
+  if (fattest == flows_.end() || fattest->second.queue.empty()) {
+    return;
+  }
+  auto& flow = fattest->second;
+  const auto size = flow.queue.front().data.size();
+  flow.queue.pop_front();
+  flow.bytes -= size;
+  backlog_bytes_ -= size;
+  --backlog_packets_;
+  ++stats_.overflow_drops;
+}
+
+}  // namespace veil::transport
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace veil::transport {
+
+struct FqCodelConfig {
+  // Hash buckets; flows that collide share a queue.
+  std::uint32_t flows{1024};
+  // Bytes a flow may dequeue per round-robin turn.
+  std::size_t quantum_bytes{1514};
+  // Acceptable standing queue delay.
+  std::chrono::microseconds target{5000};
+  // Window over which delay must stay above target before dropping;
+  // on the order of the path RTT.
+  std::chrono::microseconds interval{100000};
+  // Total backlog cap; beyond it the fattest flow loses packets.
+  std::size_t limit_bytes{static_cast<std::size_t>(1) << 20};
+  // Mark ECN-capable packets CE instead of dropping them.
+  bool ecn{true};
+  // Flow hash perturbation; 0 picks a random one.
+  std::uint32_t hash_seed{0};
+};
+
+struct FqCodelStats {
+  std::uint64_t enqueued{0};
+  std::uint64_t dequeued{0};
+  std::uint64_t codel_drops{0};
+  std::uint64_t ecn_marks{0};
+  std::uint64_t overflow_drops{0};
+};
+
+/**
+ * Flow-queuing CoDel (RFC 8290) for IP packets read from the TUN device.
+ *
+ * Packets are hashed by 5-tuple into per-flow queues served by deficit
+ * round robin, with flows that just became active served first, so a
+ * sparse flow (a call, a keystroke) does not wait behind a bulk upload.
+ * Each flow runs CoDel (RFC 8289): once its head packet has waited longer
+ * than `target` for a full `interval`, packets are dropped, or CE-marked if
+ * ECN-capable, at an increasing rate until the delay falls again.
+ *
+ * The queue only holds delay if the consumer dequeues slower than packets
+ * arrive, so it must sit in front of the real bottleneck: a pacer or a
+ * socket that pushes back.
+ *
+ * Thread Safety:
+ *   This class is NOT thread-safe. It is owned by the tunnel and used from
+ *   its event loop thread.
+ *
+ * @see docs/thread_model.md for the VEIL threading model documentation.
+ */
+class FqCodelQueue {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+
+  explicit FqCodelQueue(FqCodelConfig config = {},
+                        std::function<TimePoint()> now_fn = Clock::now);
+
+  // Queue a copy of an IP packet.
+  void enqueue(std::span<const std::uint8_t> packet);
+
+  // Next packet to send, or nullopt when empty. May drop or CE-mark packets
+  // on the way.
+  std::optional<std::vector<std::uint8_t>> dequeue();
+
+  // Retune CoDel from the path RTT: interval = rtt, target = 5% of it, but
+  // never below the configured target.
+  void set_rtt(std::chrono::microseconds rtt);
+
+  void set_limit_bytes(std::size_t limit_bytes) { config_.limit_bytes = limit_bytes; }
+
+  bool empty() const { return backlog_packets_ == 0; }
+  std::size_t backlog_bytes() const { return backlog_bytes_; }
+  std::size_t backlog_packets() const { return backlog_packets_; }
+  std::chrono::microseconds target() const { return target_; }
+  std::chrono::microseconds interval() const { return interval_; }
+  const FqCodelStats& stats() const { return stats_; }
+
+ private:
+  struct Entry {
+    std::vector<std::uint8_t> data;
+    TimePoint enqueued;
+  };
+
+  enum class List : std::uint8_t { kNone, kNew, kOld };
+
+  struct Flow {
+    std::deque<Entry> queue;
+    std::size_t bytes{0};
+    std::int64_t deficit{0};
+    List list{List::kNone};
+    // CoDel state.
+    TimePoint first_above_time{};
+    TimePoint drop_next{};
+    std::uint32_t count{0};
+    std::uint32_t last_count{0};
+    bool dropping{false};
+  };
+
+  std::uint32_t bucket_for(std::span<const std::uint8_t> packet) const;
+
+  // Pop the head packet and report whether CoDel's delay condition holds.
+  std::optional<Entry> pop_head(Flow& flow, TimePoint now, bool& ok_to_drop);
+
+  // CoDel dequeue for one flow: drops or marks as the control law says.
+  std::optional<Entry> codel_dequeue(Flow& flow, TimePoint now);
+
+  // CE-mark the packet if allowed; false means it must be dropped.
+  bool mark(Entry& entry);
+
+  TimePoint control_law(TimePoint t, std::uint32_t count) const;
+
+  void drop_from_fattest_flow();
+
+  FqCodelConfig config_;
+  std::function<TimePoint()> now_fn_;
+  std::chrono::microseconds target_;
+  std::chrono::microseconds interval_;
+  std::uint32_t hash_seed_;
+
+  std::unordered_map<std::uint32_t, Flow> flows_;
+  std::deque<std::uint32_t> new_flows_;
+  std::deque<std::uint32_t> old_flows_;
+  std::size_t backlog_bytes_{0};
+  std::size_t backlog_packets_{0};
+  FqCodelStats stats_;
+};
+
+}  // namespace veil::transport
@@ -0,0 +1,96 @@
+#include "transport/queue/packet_pacer.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace veil::transport {
+
+PacketPacer::PacketPacer(PacerConfig config, const obfuscation::ObfuscationProfile* profile,
+                         std::function<TimePoint()> now_fn)
+    : config_(config), profile_(profile), now_fn_(std::move(now_fn)) {
+  if (profile_ != nullptr) {
+    schedule_.emplace(*profile_);
+  }
+}
+
+bool PacketPacer::can_schedule() const {
+  return config_.rate_bytes_per_sec == 0 || pace_next_ <= now_fn_() + config_.horizon;
+}
+
+PacketPacer::TimePoint PacketPacer::schedule(std::size_t bytes) {
+  // An idle sender earns no credit: the clock restarts from now.
+  pace_next_ = std::max(pace_next_, now_fn_());
+  const auto base = pace_next_;
+  if (config_.rate_bytes_per_sec > 0) {
+    pace_next_ += std::chrono::nanoseconds(
+        static_cast<std::int64_t>(bytes * 1000000000ULL / config_.rate_bytes_per_sec));
+  }
+
+  auto departure = base;
+  if (schedule_) {
+    // calculate_next_send_ts(), from the table.
+    departure += schedule_->at(sequence_).jitter;
+  }
+  ++sequence_;
+  last_departure_ = std::max(departure, last_departure_);
+  return last_departure_;
+}
+
+void PacketPacer::refill_schedule() {
+  if (schedule_ && schedule_->needs_refill()) {
+    schedule_->refill();
+  }
+}
+
+PacketPacer::TimePoint PacketPacer::next_schedule_time() const {
+  const auto now = now_fn_();
+  if (config_.rate_bytes_per_sec == 0) {
+    return now;
+  }
+  return std::max(now, pace_next_ - config_.horizon);
+}
+
+PacingWheel::PacingWheel(std::chrono::microseconds granularity, std::size_t slots)
+    : granularity_(std::max(granularity, std::chrono::microseconds(1))),
+      slots_(std::max<std::size_t>(slots, 1)) {}
+
+std::int64_t PacingWheel::tick_of(TimePoint time) const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()) /
+         granularity_;
+}
+
+void PacingWheel::push(UdpPacket packet, TimePoint departure) {
+  auto tick = tick_of(departure);
+  if (size_ == 0) {
+    current_tick_ = tick;
+  }
+  const auto last = current_tick_ + static_cast<std::int64_t>(slots_.size()) - 1;
+  tick = std::clamp(tick, current_tick_, last);
+  slots_[static_cast<std::size_t>(tick) % slots_.size()].push_back(std::move(packet));
+  ++size_;
+}
+
+void PacingWheel::pop_due(TimePoint now, std::vector<UdpPacket>& out) {
+  const auto now_tick = tick_of(now);
+  while (size_ > 0 && current_tick_ <= now_tick) {
+    auto& slot = slots_[static_cast<std::size_t>(current_tick_) % slots_.size()];
+    size_ -= slot.size();
+    std::move(slot.begin(), slot.end(), std::back_inserter(out));
+    slot.clear();
+    ++current_tick_;
+  }
+}
+
+std::optional<PacingWheel::TimePoint> PacingWheel::next_departure() const {
+  if (size_ == 0) {
+    return std::nullopt;
+  }
+  for (auto tick = current_tick_;; ++tick) {
+    if (!slots_[static_cast<std::size_t>(tick) % slots_.size()].empty()) {
+      return TimePoint(std::chrono::duration_cast<Clock::duration>(granularity_ * tick));
+    }
+  }
+}
+
+}  // namespace veil::transport
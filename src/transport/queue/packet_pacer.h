@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "common/obfuscation/obfuscation_profile.h"
+#include "common/obfuscation/obfuscation_schedule.h"
+#include "transport/udp_socket/udp_socket.h"
+
+namespace veil::transport {
+
+struct PacerConfig {
+  // Pacing rate in bytes per second; 0 paces nothing, and only timing
+  // jitter delays packets.
+  std::uint64_t rate_bytes_per_sec{0};
+  // How far ahead of now packets may be scheduled. Beyond it the caller
+  // stops dequeuing, so the backlog stays in its queue (and under its AQM)
+  // instead of in the kernel or the wheel.
+  std::chrono::microseconds horizon{10000};
+  // PacingWheel slot width; packets leave up to this much early.
+  std::chrono::microseconds granularity{250};
+};
+
+/**
+ * Earliest-departure-time clock for outgoing datagrams.
+ *
+ * Each packet gets a departure time: the pacing clock, which advances by
+ * size / rate per packet, plus the obfuscation profile's timing jitter for
+ * the packet. Jitter shifts packets but does not slow the clock, so the
+ * rate holds; departures never go backwards, so packets keep their order.
+ * The times go to the kernel with SO_TXTIME (UdpPacket::departure), or to a
+ * PacingWheel where the socket cannot take them.
+ *
+ * Thread Safety:
+ *   This class is NOT thread-safe. It is owned by the tunnel and used from
+ *   its event loop thread.
+ */
+class PacketPacer {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+
+  // `profile`, if given, supplies timing jitter and must outlive the pacer.
+  explicit PacketPacer(PacerConfig config, const obfuscation::ObfuscationProfile* profile = nullptr,
+                       std::function<TimePoint()> now_fn = Clock::now);
+
+  // Whether another packet may be scheduled now: the pacing clock is
+  // within `horizon` of now.
+  bool can_schedule() const;
+
+  // Departure time for the next packet of `bytes`.
+  TimePoint schedule(std::size_t bytes);
+
+  // When can_schedule() next turns true; now if it already is.
+  TimePoint next_schedule_time() const;
+
+  // Packets scheduled so far (also the jitter sequence).
+  std::uint64_t scheduled() const { return sequence_; }
+
+  // Precompute upcoming jitter values; call off the send path.
+  void refill_schedule();
+
+ private:
+  PacerConfig config_;
+  const obfuscation::ObfuscationProfile* profile_;
+  // Jitter per sequence; empty without a profile.
+  std::optional<obfuscation::ObfuscationSchedule> schedule_;
+  std::function<TimePoint()> now_fn_;
+  // Unjittered departure of the next packet.
+  TimePoint pace_next_{};
+  TimePoint last_departure_{};
+  std::uint64_t sequence_{0};
+};
+
+/**
+ * Userspace fallback for SO_TXTIME: a timer wheel holding datagrams until
+ * their departure time.
+ *
+ * Slots cover `granularity` each; a packet further out than the wheel's
+ * span waits in the last slot. Departures from a PacketPacer never go
+ * backwards, so packets leave in the order they were pushed.
+ *
+ * Thread Safety:
+ *   This class is NOT thread-safe. It is owned by the tunnel and used from
+ *   its event loop thread.
+ */
+class PacingWheel {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+
+  explicit PacingWheel(std::chrono::microseconds granularity = std::chrono::microseconds(250),
+                       std::size_t slots = 256);
+
+  void push(UdpPacket packet, TimePoint departure);
+
+  // Move packets due at `now` to `out`, oldest first.
+  void pop_due(TimePoint now, std::vector<UdpPacket>& out);
+
+  // Departure slot of the earliest held packet.
+  std::optional<TimePoint> next_departure() const;
+
+  bool empty() const { return size_ == 0; }
+  std::size_t size() const { return size_; }
+
+ private:
+  std::int64_t tick_of(TimePoint time) const;
+
+  std::chrono::microseconds granularity_;
+  std::vector<std::vector<UdpPacket>> slots_;
+  // Tick of the oldest slot not yet drained.
+  std::int64_t current_tick_{0};
+  std::size_t size_{0};
+};
+
+}  // namespace veil::transport
@@ -0,0 +1,35 @@
+#include "transport/session/buffer_sizer.h"
+
+#include <algorithm>
+
+namespace veil::transport {
+
+BufferSizer::BufferSizer(BufferSizerConfig config, TimePoint now)
+    : config_(config),
+      window_start_(now),
+      limit_(std::min(config_.min_bytes, config_.max_bytes)) {}
+
+bool BufferSizer::record(std::size_t bytes, TimePoint now, std::chrono::milliseconds rtt) {
+  window_bytes_ += bytes;
+  const auto elapsed = now - window_start_;
+  // A window spans at least one RTT so a single flight is not mistaken for
+  // the whole rate.
+  if (elapsed < std::max<Clock::duration>(config_.sample_interval, rtt)) {
+    return false;
+  }
+
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+  const double sample = static_cast<double>(window_bytes_) / seconds;
+  bandwidth_ = sample >= bandwidth_ ? sample : (bandwidth_ + sample) / 2.0;
+  window_start_ = now;
+  window_bytes_ = 0;
+
+  const double bdp = config_.gain * bandwidth_ * std::chrono::duration<double>(rtt).count();
+  const double clamped =
+      std::clamp(bdp, static_cast<double>(std::min(config_.min_bytes, config_.max_bytes)),
+                 static_cast<double>(config_.max_bytes));
+  limit_ = static_cast<std::size_t>(clamped);
+  return true;
+}
+
+}  // namespace veil::transport
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace veil::transport {
+
+// Configuration for bandwidth-delay-product buffer sizing.
+struct BufferSizerConfig {
+  // Floor for the buffer limit, so an idle session can still absorb a burst.
+  std::size_t min_bytes{static_cast<std::size_t>(64) * 1024};
+  // Ceiling for the buffer limit.
+  std::size_t max_bytes{1 << 20};
+  // Limit = gain x bandwidth x RTT; 2 leaves room for one RTT of retransmits.
+  double gain{2.0};
+  // Shortest window over which bandwidth is sampled.
+  std::chrono::milliseconds sample_interval{100};
+};
+
+/**
+ * Sizes per-session buffers from the measured bandwidth-delay product.
+ *
+ * Bytes moved by the session are accumulated into sample windows. A faster
+ * sample raises the bandwidth estimate immediately; slower samples pull it
+ * down by half each window, so the limit follows a burst up at once and
+ * shrinks over a few windows when traffic stops.
+ *
+ * Thread Safety:
+ *   This class is NOT thread-safe. It is owned by a TransportSession and
+ *   used from that session's thread.
+ *
+ * @see docs/thread_model.md for the VEIL threading model documentation.
+ */
+class BufferSizer {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+
+  BufferSizer(BufferSizerConfig config, TimePoint now);
+
+  // Account `bytes` moved at `now`. Returns true when a sample window closed
+  // and limit() may have changed. Pass zero bytes to let an idle session's
+  // limit decay.
+  bool record(std::size_t bytes, TimePoint now, std::chrono::milliseconds rtt);
+
+  // Current buffer limit, within [min_bytes, max_bytes].
+  std::size_t limit() const { return limit_; }
+
+  // Current bandwidth estimate in bytes per second.
+  double bandwidth() const { return bandwidth_; }
+
+ private:
+  BufferSizerConfig config_;
+  TimePoint window_start_;
+  std::size_t window_bytes_{0};
+  double bandwidth_{0.0};
+  std::size_t limit_;
+};
+
+}  // namespace veil::transport
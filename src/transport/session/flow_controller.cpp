@@ -0,0 +1,209 @@
+#include "transport/session/flow_controller.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "transport/mux/mux_codec.h"
+
+namespace veil::transport {
+
+FlowController::FlowController(FlowControlConfig config, TimePoint now)
+    : config_(config),
+      sizer_(config_.connection_window, now),
+      window_(sizer_.limit()) {}
+
+std::size_t FlowController::SendWindow::credit() const {
+  if (!window) {
+    return std::numeric_limits<std::size_t>::max();
+  }
+  if (outstanding_bytes >= *window) {
+    return 0;
+  }
+  return static_cast<std::size_t>(
+      std::min<std::uint64_t>(*window - outstanding_bytes, std::numeric_limits<std::size_t>::max()));
+}
+
+void FlowController::SendWindow::record(std::uint64_t sequence, std::size_t bytes) {
+  // Nothing to count against until the peer advertises.
+  if (!window) {
+    return;
+  }
+  outstanding.emplace_back(sequence, bytes);
+  outstanding_bytes += bytes;
+}
+
+void FlowController::SendWindow::update(std::uint64_t sequence, std::uint64_t new_window) {
+  // Updates can arrive out of order; an older one is stale.
+  if (window && sequence < acked_sequence) {
+    return;
+  }
+  acked_sequence = sequence;
+  while (!outstanding.empty() && outstanding.front().first < sequence) {
+    outstanding_bytes -= outstanding.front().second;
+    outstanding.pop_front();
+  }
+  window = new_window;
+  if (credit() > 0) {
+    blocked = false;
+    blocked_notice = TimePoint{};
+  }
+}
+
+void FlowController::RecvWindow::record(std::uint64_t sequence, std::size_t bytes) {
+  next_sequence = std::max(next_sequence, sequence + 1);
+  bytes_since_update += bytes;
+}
+
+std::size_t FlowController::send_credit(std::uint64_t stream_id) const {
+  const auto connection = send_connection_.credit();
+  if (stream_id == mux::kConnectionStream) {
+    return connection;
+  }
+  const auto it = send_streams_.find(stream_id);
+  return it == send_streams_.end() ? connection : std::min(connection, it->second.credit());
+}
+
+void FlowController::on_blocked(std::uint64_t stream_id, std::size_t bytes) {
+  if (send_connection_.credit() < bytes) {
+    send_connection_.blocked = true;
+  }
+  const auto it = send_streams_.find(stream_id);
+  if (it != send_streams_.end() && it->second.credit() < bytes) {
+    it->second.blocked = true;
+  }
+}
+
+void FlowController::on_data_sent(std::uint64_t packet_sequence, std::uint64_t stream_id,
+                                  std::optional<std::uint64_t> stream_sequence, std::size_t bytes) {
+  send_connection_.record(packet_sequence, bytes);
+  if (!stream_sequence) {
+    return;
+  }
+  const auto it = send_streams_.find(stream_id);
+  if (it != send_streams_.end()) {
+    it->second.record(*stream_sequence, bytes);
+  }
+}
+
+void FlowController::on_window_update(const mux::WindowUpdate& update) {
+  if (update.stream_id == mux::kConnectionStream) {
+    send_connection_.update(update.sequence, update.window);
+    return;
+  }
+  auto it = send_streams_.find(update.stream_id);
+  if (it == send_streams_.end()) {
+    if (send_streams_.size() >= config_.max_streams) {
+      return;
+    }
+    it = send_streams_.try_emplace(update.stream_id).first;
+  }
+  it->second.update(update.sequence, update.window);
+}
+
+void FlowController::on_data_received(std::uint64_t packet_sequence, std::uint64_t stream_id,
+                                      std::optional<std::uint64_t> stream_sequence,
+                                      std::size_t bytes, TimePoint now,
+                                      std::chrono::milliseconds rtt) {
+  if (sizer_.record(bytes, now, rtt)) {
+    window_ = std::max(window_, sizer_.limit());
+  }
+  recv_connection_.record(packet_sequence, bytes);
+  if (!stream_sequence) {
+    return;
+  }
+  auto it = recv_streams_.find(stream_id);
+  if (it == recv_streams_.end()) {
+    if (recv_streams_.size() >= config_.max_streams) {
+      return;
+    }
+    it = recv_streams_.try_emplace(stream_id).first;
+  }
+  it->second.record(*stream_sequence, bytes);
+}
+
+void FlowController::on_peer_blocked(std::uint64_t stream_id) {
+  if (stream_id == mux::kConnectionStream) {
+    peer_blocked_ = true;
+    recv_connection_.update_due = true;
+    return;
+  }
+  const auto it = recv_streams_.find(stream_id);
+  if (it != recv_streams_.end()) {
+    it->second.update_due = true;
+  }
+}
+
+void FlowController::on_receive_drop() {
+  window_ = std::max(window_ / 2, std::min(config_.connection_window.min_bytes,
+                                           config_.connection_window.max_bytes));
+}
+
+std::vector<mux::MuxFrame> FlowController::take_control_frames(TimePoint now,
+                                                               std::chrono::milliseconds rtt,
+                                                               const HeldBytesFn& held_bytes) {
+  std::vector<mux::MuxFrame> out;
+
+  const auto connection_held = held_bytes(mux::kConnectionStream);
+  if (peer_blocked_) {
+    // Blocked with little buffered: the window, not the receiver, is the
+    // bottleneck.
+    if (connection_held < window_ / 2) {
+      window_ = std::min(window_ * 2, config_.connection_window.max_bytes);
+    }
+    peer_blocked_ = false;
+  }
+
+  maybe_update(mux::kConnectionStream, recv_connection_,
+               window_ - std::min(connection_held, window_), now, rtt, out);
+  const auto stream_cap = std::min(window_, config_.max_stream_window);
+  for (auto& [stream_id, recv] : recv_streams_) {
+    const auto held = held_bytes(stream_id);
+    maybe_update(stream_id, recv, stream_cap - std::min(held, stream_cap), now, rtt, out);
+  }
+
+  const auto notice_due = [&](const SendWindow& send) {
+    return send.blocked && (send.blocked_notice == TimePoint{} || now - send.blocked_notice >= rtt);
+  };
+  if (notice_due(send_connection_)) {
+    out.push_back(mux::make_blocked_frame(mux::kConnectionStream));
+    send_connection_.blocked_notice = now;
+  }
+  for (auto& [stream_id, send] : send_streams_) {
+    if (notice_due(send)) {
+      out.push_back(mux::make_blocked_frame(stream_id));
+      send.blocked_notice = now;
+    }
+  }
+  return out;
+}
+
+void FlowController::maybe_update(std::uint64_t stream_id, RecvWindow& recv, std::size_t window,
+                                  TimePoint now, std::chrono::milliseconds rtt,
+                                  std::vector<mux::MuxFrame>& out) {
+  const bool used_half = recv.bytes_since_update > 0 && recv.bytes_since_update * 2 >= recv.advertised;
+  // Refreshed once per RTT while data flows, so a lost update is replaced.
+  const bool stale = recv.bytes_since_update > 0 && now - recv.last_update >= rtt;
+  const bool opened = recv.next_sequence > 0 && recv.advertised < window / 2;
+  if (!recv.update_due && !used_half && !stale && !opened) {
+    return;
+  }
+  out.push_back(mux::make_window_update_frame(mux::WindowUpdate{stream_id, recv.next_sequence, window}));
+  recv.advertised = window;
+  recv.bytes_since_update = 0;
+  recv.update_due = false;
+  recv.last_update = now;
+}
+
+utils::MemoryFootprint FlowController::memory_footprint() const {
+  utils::MemoryFootprint footprint;
+  const auto entry_bytes = sizeof(decltype(SendWindow::outstanding)::value_type);
+  footprint.reserved += send_connection_.outstanding.size() * entry_bytes;
+  for (const auto& [_, send] : send_streams_) {
+    footprint.reserved += utils::container_node_bytes<decltype(send_streams_)>() +
+                          send.outstanding.size() * entry_bytes;
+  }
+  footprint.reserved += recv_streams_.size() * utils::container_node_bytes<decltype(recv_streams_)>();
+  return footprint;
+}
+
+}  // namespace veil::transport
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/utils/memory_footprint.h"
+#include "transport/mux/frame.h"
+#include "transport/session/buffer_sizer.h"
+
+namespace veil::transport {
+
+// Configuration for credit-based flow control.
+struct FlowControlConfig {
+  // Advertise receive windows to the peer and honour the peer's. A peer
+  // that never advertises a window does not limit this side. Off by
+  // default: it adds window frames to the wire and lets the sender drop
+  // packets it has no credit for; enable it on both ends, mainly alongside
+  // ordered delivery, whose reorder buffers it keeps from overflowing.
+  bool enabled{false};
+  // Connection receive window: starts at min_bytes and grows to gain x
+  // receive bandwidth x RTT, up to max_bytes.
+  BufferSizerConfig connection_window{static_cast<std::size_t>(256) * 1024, 16 << 20, 2.0,
+                                      std::chrono::milliseconds(100)};
+  // Cap on each stream's receive window.
+  std::size_t max_stream_window{4 << 20};
+  // Streams given their own window, per direction; further streams are
+  // limited by the connection window only.
+  std::size_t max_streams{64};
+};
+
+/**
+ * Credit-based flow control for one session, after QUIC's MAX_DATA and
+ * MAX_STREAM_DATA, in both directions.
+ *
+ * Receiving: the connection and each stream advertise a window of payload
+ * bytes beyond the highest sequence seen. The connection window is sized
+ * from the receive bandwidth-delay product, doubles when the peer reports
+ * being blocked while little is buffered, and halves when received data had
+ * to be dropped. Data held in reorder buffers is subtracted, so a stalled
+ * stream closes its own window before it overflows. Updates are sent when
+ * half the last window has been used, once per RTT while data flows, and in
+ * answer to BLOCKED notices.
+ *
+ * Sending: payload bytes sent since the peer's last update count against
+ * its window. When a send is refused, a BLOCKED notice is sent once per RTT
+ * until credit returns.
+ *
+ * Thread Safety:
+ *   This class is NOT thread-safe. It is owned by a TransportSession and
+ *   used from that session's thread.
+ *
+ * @see docs/thread_model.md for the VEIL threading model documentation.
+ */
+class FlowController {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+  // Bytes held at the receiver for a stream, or for the whole connection
+  // when called with mux::kConnectionStream.
+  using HeldBytesFn = std::function<std::size_t(std::uint64_t stream_id)>;
+
+  FlowController(FlowControlConfig config, TimePoint now);
+
+  // Bytes that may be sent now on `stream_id`: the smaller of the
+  // connection and stream credit. Unlimited until the peer advertises.
+  // Pass mux::kConnectionStream for the connection credit alone.
+  std::size_t send_credit(std::uint64_t stream_id) const;
+
+  // Note that a send of `bytes` on `stream_id` was refused for lack of
+  // credit.
+  void on_blocked(std::uint64_t stream_id, std::size_t bytes);
+
+  // Account a sent data packet. `stream_sequence` is the stream's message
+  // sequence, or nullopt for fragments, which count against the
+  // connection window only.
+  void on_data_sent(std::uint64_t packet_sequence, std::uint64_t stream_id,
+                    std::optional<std::uint64_t> stream_sequence, std::size_t bytes);
+
+  void on_window_update(const mux::WindowUpdate& update);
+
+  // Account a received data packet.
+  void on_data_received(std::uint64_t packet_sequence, std::uint64_t stream_id,
+                        std::optional<std::uint64_t> stream_sequence, std::size_t bytes,
+                        TimePoint now, std::chrono::milliseconds rtt);
+
+  void on_peer_blocked(std::uint64_t stream_id);
+
+  // Received data was dropped before delivery; shrink the window.
+  void on_receive_drop();
+
+  // Window updates and BLOCKED notices due now.
+  std::vector<mux::MuxFrame> take_control_frames(TimePoint now, std::chrono::milliseconds rtt,
+                                                 const HeldBytesFn& held_bytes);
+
+  // Current connection receive window before held bytes are subtracted.
+  std::size_t receive_window() const { return window_; }
+
+  utils::MemoryFootprint memory_footprint() const;
+
+ private:
+  struct SendWindow {
+    // Peer's window; nullopt until it advertises one.
+    std::optional<std::uint64_t> window;
+    // The peer has seen everything below this sequence.
+    std::uint64_t acked_sequence{0};
+    // (sequence, bytes) sent at or after acked_sequence.
+    std::deque<std::pair<std::uint64_t, std::size_t>> outstanding;
+    std::size_t outstanding_bytes{0};
+    bool blocked{false};
+    TimePoint blocked_notice{};
+
+    std::size_t credit() const;
+    void record(std::uint64_t sequence, std::size_t bytes);
+    void update(std::uint64_t sequence, std::uint64_t new_window);
+  };
+
+  struct RecvWindow {
+    // One past the highest sequence seen.
+    std::uint64_t next_sequence{0};
+    std::size_t bytes_since_update{0};
+    // Window in the last update; 0 before the first.
+    std::size_t advertised{0};
+    bool update_due{false};
+    TimePoint last_update{};
+
+    void record(std::uint64_t sequence, std::size_t bytes);
+  };
+
+  // Append an update for `recv` to `out` if one is due.
+  void maybe_update(std::uint64_t stream_id, RecvWindow& recv, std::size_t window, TimePoint now,
+                    std::chrono::milliseconds rtt, std::vector<mux::MuxFrame>& out);
+
+  FlowControlConfig config_;
+  SendWindow send_connection_;
+  std::unordered_map<std::uint64_t, SendWindow> send_streams_;
+  RecvWindow recv_connection_;
+  std::unordered_map<std::uint64_t, RecvWindow> recv_streams_;
+  BufferSizer sizer_;
+  std::size_t window_;
+  bool peer_blocked_{false};
+};
+
+}  // namespace veil::transport
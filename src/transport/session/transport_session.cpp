@@ -7,6 +7,7 @@
 #include <chrono>
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <span>
 #include <utility>
@@ -15,6 +16,7 @@
 #include "common/crypto/crypto_engine.h"
 #include "common/crypto/random.h"
 #include "common/logging/logger.h"
+#include "common/utils/allocation_tracker.h"
 
 // SECURITY: Nonce overflow threshold.
 // With uint64_t, we can send 2^64 packets before overflow. At 10 Gbps with 1KB packets,
@@ -25,22 +27,107 @@ constexpr std::uint64_t kNonceOverflowWarningThreshold = std::numeric_limits<std
 
 namespace veil::transport {
 
+namespace {
+
+std::shared_ptr<const AeadKey> share_key(const std::array<std::uint8_t, crypto::kAeadKeyLen>& key) {
+  auto shared = std::make_shared<AeadKey>();
+  shared->bytes = key;
+  return shared;
+}
+
+}  // namespace
+
 TransportSession::TransportSession(const handshake::HandshakeSession& handshake_session,
                                    TransportSessionConfig config, std::function<TimePoint()> now_fn)
-    : config_(config),
-      now_fn_(std::move(now_fn)),
-      keys_(handshake_session.keys),
+    : keys_(handshake_session.keys),
       current_session_id_(handshake_session.session_id),
       send_seq_obfuscation_key_(crypto::derive_sequence_obfuscation_key(keys_.send_key, keys_.send_nonce)),
       recv_seq_obfuscation_key_(crypto::derive_sequence_obfuscation_key(keys_.recv_key, keys_.recv_nonce)),
-      replay_window_(config_.replay_window_size),
+      replay_window_(config.replay_window_size),
+      config_(config),
+      now_fn_(std::move(now_fn)),
       session_rotator_(config_.session_rotation_interval, config_.session_rotation_packets),
-      reorder_buffer_(0, config_.reorder_buffer_size),
+      reorder_limit_(config_.reorder_buffer_size),
       fragment_reassembly_(config_.fragment_buffer_size),
       retransmit_buffer_(config_.retransmit_config, now_fn_) {
+  if (config_.adaptive_buffers) {
+    buffer_sizer_.emplace(config_.buffer_sizing, now_fn_());
+    apply_buffer_limit(buffer_sizer_->limit());
+  }
+  if (config_.flow_control.enabled) {
+    flow_controller_.emplace(config_.flow_control, now_fn_());
+  }
+  if (config_.fec.enabled) {
+    fec_encoder_.emplace(config_.fec);
+  }
+  if (config_.ack_frequency.enabled) {
+    ack_frequency_policy_.emplace(config_.ack_frequency);
+  }
   LOG_DEBUG("TransportSession created with session_id={}", current_session_id_);
 }
 
+TransportSession::TransportSession(HibernatedSession&& hibernated, TransportSessionConfig config,
+                                   std::function<TimePoint()> now_fn)
+    : keys_(hibernated.keys),
+      current_session_id_(hibernated.session_id),
+      send_seq_obfuscation_key_(crypto::derive_sequence_obfuscation_key(keys_.send_key, keys_.send_nonce)),
+      recv_seq_obfuscation_key_(crypto::derive_sequence_obfuscation_key(keys_.recv_key, keys_.recv_nonce)),
+      send_sequence_(hibernated.send_sequence),
+      recv_sequence_max_(hibernated.recv_sequence_max),
+      packets_since_rotation_(hibernated.packets_since_rotation),
+      message_id_counter_(hibernated.message_id_counter),
+      replay_window_(std::move(hibernated.replay_window)),
+      recv_ack_bitmap_(hibernated.recv_ack_bitmap),
+      config_(config),
+      now_fn_(std::move(now_fn)),
+      session_rotator_(config_.session_rotation_interval, config_.session_rotation_packets),
+      send_stream_sequences_(std::move(hibernated.send_stream_sequences)),
+      reorder_limit_(config_.reorder_buffer_size),
+      fragment_reassembly_(config_.fragment_buffer_size),
+      retransmit_buffer_(config_.retransmit_config, now_fn_) {
+  cold_.stats = hibernated.stats;
+  for (const auto& [stream_id, next] : hibernated.recv_stream_sequences) {
+    recv_streams_.try_emplace(stream_id, next, reorder_limit_);
+  }
+  if (config_.adaptive_buffers) {
+    buffer_sizer_.emplace(config_.buffer_sizing, now_fn_());
+    apply_buffer_limit(buffer_sizer_->limit());
+  }
+  if (config_.flow_control.enabled) {
+    flow_controller_.emplace(config_.flow_control, now_fn_());
+  }
+  if (config_.fec.enabled) {
+    fec_encoder_.emplace(config_.fec);
+  }
+  if (config_.ack_frequency.enabled) {
+    ack_frequency_policy_.emplace(config_.ack_frequency);
+  }
+  LOG_DEBUG("TransportSession woken with session_id={}, send_sequence_={}", current_session_id_,
+            send_sequence_);
+}
+
+AeadKey::~AeadKey() { sodium_memzero(bytes.data(), bytes.size()); }
+
+void AeadJob::run() {
+  // Both directions work in place after the 8-byte sequence.
+  const auto body = std::span(packet).subspan(8);
+  if (kind == Kind::kSeal) {
+    crypto::aead_encrypt_into(key->bytes, nonce, {}, body.first(body.size() - crypto::kAeadTagLen),
+                              body);
+    ok = true;
+    return;
+  }
+  ok = crypto::aead_decrypt_into(key->bytes, nonce, {}, body, body).has_value();
+}
+
+HibernatedSession::~HibernatedSession() {
+  // SECURITY: The record carries the session keys.
+  sodium_memzero(keys.send_key.data(), keys.send_key.size());
+  sodium_memzero(keys.recv_key.data(), keys.recv_key.size());
+  sodium_memzero(keys.send_nonce.data(), keys.send_nonce.size());
+  sodium_memzero(keys.recv_nonce.data(), keys.recv_nonce.size());
+}
+
 TransportSession::~TransportSession() {
   // SECURITY: Clear all session key material on destruction
   sodium_memzero(keys_.send_key.data(), keys_.send_key.size());
@@ -53,51 +140,136 @@ TransportSession::~TransportSession() {
 }
 
 std::vector<std::vector<std::uint8_t>> TransportSession::encrypt_data(
-    std::span<const std::uint8_t> plaintext, std::uint64_t stream_id, bool fin) {
+    std::span<const std::uint8_t> plaintext, std::uint64_t stream_id, bool fin, std::size_t pad_to) {
+  auto jobs = prepare_data(plaintext, stream_id, fin, pad_to);
+  std::vector<std::vector<std::uint8_t>> result;
+  result.reserve(jobs.size());
+  for (auto& job : jobs) {
+    job.run();
+    result.push_back(finish_seal(std::move(job)));
+  }
+  return result;
+}
+
+std::vector<AeadJob> TransportSession::prepare_data(std::span<const std::uint8_t> plaintext,
+                                                    std::uint64_t stream_id, bool fin,
+                                                    std::size_t pad_to) {
   VEIL_DCHECK_THREAD(thread_checker_);
+  VEIL_ALLOCATION_SCOPE(kTransport);
 
-  std::vector<std::vector<std::uint8_t>> result;
+  std::vector<AeadJob> jobs;
 
   // Fragment data if necessary.
   auto frames = fragment_data(plaintext, stream_id, fin);
 
+  std::vector<mux::FecRepair> repairs;
   for (auto& frame : frames) {
-    auto encrypted = build_encrypted_packet(frame);
-
-    // Store in retransmit buffer.
-    if (retransmit_buffer_.has_capacity(encrypted.size())) {
-      retransmit_buffer_.insert(send_sequence_ - 1, encrypted);
+    auto encoded = mux::MuxCodec::encode(frame);
+    if (fec_encoder_ && frame.kind == mux::FrameKind::kData) {
+      auto closed = fec_encoder_->add(send_sequence_, encoded, now_fn_());
+      repairs.insert(repairs.end(), std::make_move_iterator(closed.begin()),
+                     std::make_move_iterator(closed.end()));
+    }
+    // Padding is added after FEC, which the peer feeds the unpadded frame.
+    pad_frame(encoded, pad_to);
+    auto job = make_seal_job(encoded);
+    if (flow_controller_ && frame.kind == mux::FrameKind::kData) {
+      flow_controller_->on_data_sent(
+          job.sequence, frame.data.stream_id,
+          frame.data.fragment ? std::nullopt : std::optional<std::uint64_t>(frame.data.sequence),
+          frame.data.payload.size());
     }
 
-    ++stats_.packets_sent;
-    stats_.bytes_sent += encrypted.size();
+    // Stored in the retransmit buffer by finish_seal().
+    job.retain = true;
+
+    ++cold_.stats.packets_sent;
+    cold_.stats.bytes_sent += job.packet.size();
     if (frame.kind == mux::FrameKind::kData) {
-      ++stats_.fragments_sent;
+      ++cold_.stats.fragments_sent;
     }
 
-    result.push_back(std::move(encrypted));
+    jobs.push_back(std::move(job));
     ++packets_since_rotation_;
   }
+  const auto retained = jobs.size();
+  append_repairs(std::move(repairs), jobs);
+
+  if (ack_frequency_policy_) {
+    if (const auto request =
+            ack_frequency_policy_->update(retransmit_buffer_.pending_count() + retained,
+                                          retransmit_buffer_.estimated_rtt(), now_fn_())) {
+      auto job = make_seal_job(mux::MuxCodec::encode(mux::make_ack_frequency_frame(*request)));
+      ++cold_.stats.packets_sent;
+      ++cold_.stats.ack_frequency_requests;
+      cold_.stats.bytes_sent += job.packet.size();
+      ++packets_since_rotation_;
+      jobs.push_back(std::move(job));
+    }
+  }
 
-  return result;
+  if (buffer_sizer_) {
+    std::size_t bytes = 0;
+    for (const auto& job : jobs) {
+      bytes += job.packet.size();
+    }
+    account_buffer_bytes(bytes);
+  }
+
+  return jobs;
+}
+
+std::vector<std::uint8_t> TransportSession::finish_seal(AeadJob&& job) {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  if (job.retain && retransmit_buffer_.has_capacity(job.packet.size())) {
+    retransmit_buffer_.insert(job.sequence, job.packet);
+  }
+  return std::move(job.packet);
+}
+
+std::vector<std::uint8_t> TransportSession::encrypt_heartbeat(std::span<const std::uint8_t> payload,
+                                                           std::uint64_t sequence, std::size_t pad_to) {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  VEIL_ALLOCATION_SCOPE(kTransport);
+
+  const auto timestamp = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(now_fn_().time_since_epoch()).count());
+  auto encoded = mux::MuxCodec::encode(mux::make_heartbeat_frame(
+      timestamp, sequence, std::vector<std::uint8_t>(payload.begin(), payload.end())));
+  pad_frame(encoded, pad_to);
+  auto packet = seal_packet(encoded);
+  ++cold_.stats.packets_sent;
+  ++cold_.stats.heartbeats_sent;
+  cold_.stats.bytes_sent += packet.size();
+  ++packets_since_rotation_;
+  return packet;
 }
 
 std::optional<std::vector<mux::MuxFrame>> TransportSession::decrypt_packet(
     std::span<const std::uint8_t> ciphertext) {
+  auto job = prepare_open(std::vector<std::uint8_t>(ciphertext.begin(), ciphertext.end()));
+  if (!job) {
+    return std::nullopt;
+  }
+  job->run();
+  return finish_open(std::move(*job));
+}
+
+std::optional<AeadJob> TransportSession::prepare_open(std::vector<std::uint8_t> packet) {
   VEIL_DCHECK_THREAD(thread_checker_);
 
   // Minimum packet size: nonce (8 bytes for sequence) + tag (16 bytes) + header (1 byte minimum)
-  constexpr std::size_t kMinPacketSize = 8 + 16 + 1;
-  if (ciphertext.size() < kMinPacketSize) {
-    LOG_DEBUG("Packet too small: {} bytes", ciphertext.size());
-    ++stats_.packets_dropped_decrypt;
+  constexpr std::size_t kMinPacketSize = 8 + crypto::kAeadTagLen + 1;
+  if (packet.size() < kMinPacketSize) {
+    LOG_DEBUG("Packet too small: {} bytes", packet.size());
+    ++cold_.stats.packets_dropped_decrypt;
     return std::nullopt;
   }
 
   // Extract obfuscated sequence from first 8 bytes.
   std::uint64_t obfuscated_sequence = 0;
-  for (int i = 0; i < 8; ++i) {
-    obfuscated_sequence = (obfuscated_sequence << 8) | ciphertext[static_cast<std::size_t>(i)];
+  for (std::size_t i = 0; i < 8; ++i) {
+    obfuscated_sequence = (obfuscated_sequence << 8) | packet[i];
   }
 
   // DPI RESISTANCE (Issue #21): Deobfuscate sequence number.
@@ -105,49 +277,338 @@ std::optional<std::vector<mux::MuxFrame>> TransportSession::decrypt_packet(
   // obfuscation here to recover the real sequence for nonce derivation and replay checking.
   const std::uint64_t sequence = crypto::deobfuscate_sequence(obfuscated_sequence, recv_seq_obfuscation_key_);
 
-  // Replay check.
+  // Replay check, here on the session's thread even when decryption runs
+  // elsewhere.
   if (!replay_window_.mark_and_check(sequence)) {
     LOG_DEBUG("Packet replay detected: sequence={}", sequence);
-    ++stats_.packets_dropped_replay;
+    ++cold_.stats.packets_dropped_replay;
     return std::nullopt;
   }
 
+  if (!cold_.recv_job_key) {
+    cold_.recv_job_key = share_key(keys_.recv_key);
+  }
+  AeadJob job;
+  job.kind = AeadJob::Kind::kOpen;
+  job.sequence = sequence;
   // Derive nonce from sequence.
-  const auto nonce = crypto::derive_nonce(keys_.recv_nonce, sequence);
-
-  // Decrypt (skip sequence prefix).
-  auto ciphertext_body = ciphertext.subspan(8);
-  auto decrypted = crypto::aead_decrypt(keys_.recv_key, nonce, {}, ciphertext_body);
-  if (!decrypted) {
-    LOG_DEBUG("Decryption failed for sequence={}", sequence);
-    ++stats_.packets_dropped_decrypt;
+  job.nonce = crypto::derive_nonce(keys_.recv_nonce, sequence);
+  job.key = cold_.recv_job_key;
+  job.packet = std::move(packet);
+  return job;
+}
+
+std::optional<std::vector<mux::MuxFrame>> TransportSession::finish_open(AeadJob&& job) {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  VEIL_ALLOCATION_SCOPE(kTransport);
+
+  if (!job.ok) {
+    LOG_DEBUG("Decryption failed for sequence={}", job.sequence);
+    ++cold_.stats.packets_dropped_decrypt;
     return std::nullopt;
   }
 
-  ++stats_.packets_received;
-  stats_.bytes_received += ciphertext.size();
+  ++cold_.stats.packets_received;
+  cold_.stats.bytes_received += job.packet.size();
+  account_buffer_bytes(job.packet.size());
 
-  // Parse mux frames from decrypted data.
+  // Parse mux frames from the plaintext, which run() left after the
+  // sequence prefix.
   std::vector<mux::MuxFrame> frames;
-  auto frame = mux::MuxCodec::decode(*decrypted);
-  if (frame) {
+  process_plaintext(job.sequence,
+                    std::span(job.packet).subspan(8, job.packet.size() - 8 - crypto::kAeadTagLen),
+                    frames);
+
+  if (job.sequence > recv_sequence_max_) {
+    recv_sequence_max_ = job.sequence;
+  }
+
+  return frames;
+}
+
+void TransportSession::process_plaintext(std::uint64_t sequence,
+                                         std::span<const std::uint8_t> plaintext,
+                                         std::vector<mux::MuxFrame>& frames) {
+  // Cover-traffic padding follows the frame.
+  if (const auto size = mux::MuxCodec::frame_size(plaintext); size && *size < plaintext.size()) {
+    plaintext = plaintext.first(*size);
+  }
+  auto frame = mux::MuxCodec::decode(plaintext);
+  if (!frame) {
+    return;
+  }
+  if (frame->kind == mux::FrameKind::kData) {
+    ++cold_.stats.fragments_received;
+    recv_ack_bitmap_.ack(sequence);
+    if (flow_controller_) {
+      flow_controller_->on_data_received(
+          sequence, frame->data.stream_id,
+          frame->data.fragment ? std::nullopt : std::optional<std::uint64_t>(frame->data.sequence),
+          frame->data.payload.size(), now_fn_(), retransmit_buffer_.estimated_rtt());
+    }
+    if (fec_decoder_) {
+      auto recovered = fec_decoder_->on_source(sequence, plaintext);
+      if (!recovered.empty()) {
+        deliver_recovered(std::move(recovered), frames);
+      }
+    }
+  }
+
+  if (frame->kind == mux::FrameKind::kControl &&
+      (handle_flow_control(frame->control) || handle_fec(frame->control, frames))) {
+    // Consumed by the session.
+  } else if (config_.ordered_delivery && frame->kind == mux::FrameKind::kData && !frame->data.fragment) {
+    deliver_in_order(std::move(*frame), frames);
+  } else {
     frames.push_back(std::move(*frame));
+  }
+}
 
-    if (frame->kind == mux::FrameKind::kData) {
-      ++stats_.fragments_received;
-      recv_ack_bitmap_.ack(sequence);
+void TransportSession::deliver_in_order(mux::MuxFrame&& frame, std::vector<mux::MuxFrame>& out) {
+  const auto stream_id = frame.data.stream_id;
+  auto it = recv_streams_.find(stream_id);
+  if (it == recv_streams_.end()) {
+    if (recv_streams_.size() >= config_.max_ordered_streams) {
+      out.push_back(std::move(frame));
+      return;
     }
+    it = recv_streams_.try_emplace(stream_id, 0, reorder_limit_).first;
   }
+  auto& stream = it->second;
+  const auto seq = frame.data.sequence;
 
-  if (sequence > recv_sequence_max_) {
-    recv_sequence_max_ = sequence;
+  if (seq < stream.reorder.next_expected()) {
+    // Its gap was already skipped; order is lost either way, so deliver.
+    out.push_back(std::move(frame));
+    return;
   }
 
-  return frames;
+  // Fast path: the next frame with nothing held.
+  if (seq == stream.reorder.next_expected() && stream.reorder.empty()) {
+    stream.reorder.skip_to(seq + 1);
+    out.push_back(std::move(frame));
+    return;
+  }
+
+  if (reorder_buffered_bytes() + frame.data.payload.size() + 1 > reorder_limit_) {
+    // Out of room: stop waiting for this stream's gaps, and have the peer
+    // send less.
+    if (flow_controller_) {
+      flow_controller_->on_receive_drop();
+    }
+    while (auto first = stream.reorder.first_buffered()) {
+      stream.reorder.skip_to(*first);
+      ++cold_.stats.reorder_gaps_skipped;
+      release_ready(stream_id, stream, out);
+    }
+    stream.reorder.skip_to(seq + 1);
+    out.push_back(std::move(frame));
+    return;
+  }
+
+  // The fin flag rides as a trailing byte while the frame is held.
+  auto payload = std::move(frame.data.payload);
+  payload.push_back(frame.data.fin ? 1 : 0);
+  stream.reorder.push(seq, std::move(payload));
+  release_ready(stream_id, stream, out);
+}
+
+void TransportSession::release_ready(std::uint64_t stream_id, RecvStream& stream,
+                                     std::vector<mux::MuxFrame>& out) {
+  while (true) {
+    const auto seq = stream.reorder.next_expected();
+    auto payload = stream.reorder.pop_next();
+    if (!payload) {
+      break;
+    }
+    const bool fin = payload->back() != 0;
+    payload->pop_back();
+    out.push_back(mux::make_data_frame(stream_id, seq, fin, std::move(*payload)));
+  }
+  if (stream.reorder.empty()) {
+    stream.stalled_since = TimePoint{};
+  } else if (stream.stalled_since == TimePoint{}) {
+    stream.stalled_since = now_fn_();
+  }
+}
+
+std::size_t TransportSession::reorder_buffered_bytes() const {
+  std::size_t bytes = 0;
+  for (const auto& [_, stream] : recv_streams_) {
+    bytes += stream.reorder.buffered_bytes();
+  }
+  return bytes;
+}
+
+std::vector<mux::MuxFrame> TransportSession::release_stalled_frames() {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  std::vector<mux::MuxFrame> out;
+  if (!config_.ordered_delivery) {
+    return out;
+  }
+  const auto now = now_fn_();
+  for (auto& [stream_id, stream] : recv_streams_) {
+    if (stream.reorder.empty() || now - stream.stalled_since < config_.reorder_timeout) {
+      continue;
+    }
+    // Skip one gap; frames behind a later gap get a fresh timeout.
+    stream.reorder.skip_to(*stream.reorder.first_buffered());
+    ++cold_.stats.reorder_gaps_skipped;
+    stream.stalled_since = TimePoint{};
+    release_ready(stream_id, stream, out);
+  }
+  return out;
+}
+
+void TransportSession::record_outer_ecn(std::uint8_t ecn) {
+  switch (ecn & 0x03) {
+    case 0x03:
+      cold_.stats.ecn_ce_received++;
+      break;
+    case 0x01:
+    case 0x02:
+      cold_.stats.ecn_ect_received++;
+      break;
+    default:
+      break;
+  }
+}
+
+bool TransportSession::handle_flow_control(const mux::ControlFrame& control) {
+  if (const auto update = mux::parse_window_update(control)) {
+    ++cold_.stats.window_updates_received;
+    if (flow_controller_) {
+      flow_controller_->on_window_update(*update);
+    }
+    return true;
+  }
+  if (const auto stream_id = mux::parse_blocked(control)) {
+    if (flow_controller_) {
+      flow_controller_->on_peer_blocked(*stream_id);
+    }
+    return true;
+  }
+  return false;
+}
+
+bool TransportSession::handle_fec(const mux::ControlFrame& control,
+                                  std::vector<mux::MuxFrame>& frames) {
+  if (auto repair = mux::parse_fec_repair(control)) {
+    ++cold_.stats.fec_repairs_received;
+    if (!fec_decoder_) {
+      fec_decoder_.emplace();
+    }
+    deliver_recovered(fec_decoder_->on_repair(std::move(*repair)), frames);
+    return true;
+  }
+  if (const auto report = mux::parse_loss_report(control)) {
+    if (fec_encoder_) {
+      fec_encoder_->on_loss_report(*report);
+    }
+    return true;
+  }
+  return false;
+}
+
+void TransportSession::deliver_recovered(std::vector<mux::FecDecoder::Recovered> recovered,
+                                         std::vector<mux::MuxFrame>& frames) {
+  for (auto& packet : recovered) {
+    // The packet may have turned up on its own meanwhile.
+    if (!replay_window_.mark_and_check(packet.sequence)) {
+      continue;
+    }
+    ++cold_.stats.fec_recovered;
+    process_plaintext(packet.sequence, packet.plaintext, frames);
+    recv_sequence_max_ = std::max(recv_sequence_max_, packet.sequence);
+  }
+}
+
+void TransportSession::append_repairs(std::vector<mux::FecRepair> repairs,
+                                      std::vector<AeadJob>& out) {
+  for (const auto& repair : repairs) {
+    auto job = make_seal_job(mux::MuxCodec::encode(mux::make_fec_repair_frame(repair)));
+    ++cold_.stats.packets_sent;
+    ++cold_.stats.fec_repairs_sent;
+    cold_.stats.bytes_sent += job.packet.size();
+    ++packets_since_rotation_;
+    out.push_back(std::move(job));
+  }
+}
+
+bool TransportSession::has_send_credit(std::size_t bytes, std::uint64_t stream_id) {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  if (!flow_controller_ || flow_controller_->send_credit(stream_id) >= bytes) {
+    return true;
+  }
+  flow_controller_->on_blocked(stream_id, bytes);
+  ++cold_.stats.flow_control_blocked;
+  return false;
+}
+
+void TransportSession::report_delivery_drop() {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  if (flow_controller_) {
+    flow_controller_->on_receive_drop();
+  }
+}
+
+std::vector<std::vector<std::uint8_t>> TransportSession::get_flow_control_packets() {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  VEIL_ALLOCATION_SCOPE(kTransport);
+
+  std::vector<std::vector<std::uint8_t>> result;
+  if (!flow_controller_) {
+    return result;
+  }
+  const auto held_bytes = [this](std::uint64_t stream_id) {
+    if (stream_id == mux::kConnectionStream) {
+      return reorder_buffered_bytes();
+    }
+    const auto it = recv_streams_.find(stream_id);
+    return it == recv_streams_.end() ? std::size_t{0} : it->second.reorder.buffered_bytes();
+  };
+  for (const auto& frame : flow_controller_->take_control_frames(
+           now_fn_(), retransmit_buffer_.estimated_rtt(), held_bytes)) {
+    auto packet = build_encrypted_packet(frame);
+    ++cold_.stats.packets_sent;
+    cold_.stats.bytes_sent += packet.size();
+    ++packets_since_rotation_;
+    if (frame.control.type == static_cast<std::uint8_t>(mux::ControlType::kWindowUpdate)) {
+      ++cold_.stats.window_updates_sent;
+    }
+    result.push_back(std::move(packet));
+  }
+  return result;
+}
+
+std::vector<std::vector<std::uint8_t>> TransportSession::get_fec_packets() {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  VEIL_ALLOCATION_SCOPE(kTransport);
+
+  std::vector<std::vector<std::uint8_t>> result;
+  if (fec_encoder_) {
+    std::vector<AeadJob> repairs;
+    append_repairs(fec_encoder_->flush_expired(now_fn_()), repairs);
+    for (auto& job : repairs) {
+      job.run();
+      result.push_back(std::move(job.packet));
+    }
+  }
+  if (fec_decoder_) {
+    if (const auto report = fec_decoder_->take_loss_report()) {
+      auto packet = build_encrypted_packet(mux::make_loss_report_frame(*report));
+      ++cold_.stats.packets_sent;
+      cold_.stats.bytes_sent += packet.size();
+      ++packets_since_rotation_;
+      result.push_back(std::move(packet));
+    }
+  }
+  return result;
 }
 
 std::vector<std::vector<std::uint8_t>> TransportSession::get_retransmit_packets() {
   VEIL_DCHECK_THREAD(thread_checker_);
+  VEIL_ALLOCATION_SCOPE(kTransport);
 
   std::vector<std::vector<std::uint8_t>> result;
   auto to_retransmit = retransmit_buffer_.get_packets_to_retransmit();
@@ -155,7 +616,7 @@ std::vector<std::vector<std::uint8_t>> TransportSession::get_retransmit_packets(
   for (const auto* pkt : to_retransmit) {
     if (retransmit_buffer_.mark_retransmitted(pkt->sequence)) {
       result.push_back(pkt->data);
-      ++stats_.retransmits;
+      ++cold_.stats.retransmits;
     } else {
       // Exceeded max retries, drop packet.
       retransmit_buffer_.drop_packet(pkt->sequence);
@@ -192,6 +653,33 @@ mux::AckFrame TransportSession::generate_ack(std::uint64_t stream_id) {
   };
 }
 
+std::vector<std::uint8_t> TransportSession::encrypt_ack(std::uint64_t stream_id) {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  VEIL_ALLOCATION_SCOPE(kTransport);
+
+  const auto ack = generate_ack(stream_id);
+  auto packet = build_encrypted_packet(mux::make_ack_frame(ack.stream_id, ack.ack, ack.bitmap));
+
+  ++cold_.stats.packets_sent;
+  cold_.stats.bytes_sent += packet.size();
+  ++packets_since_rotation_;
+  return packet;
+}
+
+std::vector<std::uint8_t> TransportSession::encrypt_control(mux::ControlType type,
+                                                            std::vector<std::uint8_t> payload) {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  VEIL_ALLOCATION_SCOPE(kTransport);
+
+  auto packet = build_encrypted_packet(
+      mux::make_control_frame(static_cast<std::uint8_t>(type), std::move(payload)));
+
+  ++cold_.stats.packets_sent;
+  cold_.stats.bytes_sent += packet.size();
+  ++packets_since_rotation_;
+  return packet;
+}
+
 bool TransportSession::should_rotate_session() {
   VEIL_DCHECK_THREAD(thread_checker_);
   return session_rotator_.should_rotate(packets_since_rotation_, now_fn_());
@@ -205,7 +693,7 @@ void TransportSession::rotate_session() {
 
   current_session_id_ = session_rotator_.rotate(now_fn_());
   packets_since_rotation_ = 0;
-  ++stats_.session_rotations;
+  ++cold_.stats.session_rotations;
 
   // ===========================================================================
   // SECURITY-CRITICAL: NONCE COUNTER LIFECYCLE
@@ -227,7 +715,7 @@ void TransportSession::rotate_session() {
   // Nonce uniqueness guarantee:
   // - send_sequence_ is uint64_t, allowing 2^64 unique nonces
   // - At 10 Gbps with 1KB packets, exhaustion would take ~58 million years
-  // - send_sequence_ is incremented after each packet in build_encrypted_packet()
+  // - send_sequence_ is incremented after each packet in begin_seal()
   // - It is NEVER reset or decremented
   //
   // This design was chosen over alternatives like:
@@ -246,7 +734,107 @@ void TransportSession::rotate_session() {
             current_session_id_, send_sequence_);
 }
 
+utils::MemoryFootprint TransportSession::memory_footprint() const {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  utils::MemoryFootprint reorder{.reserved = 0, .in_use = 0, .limit = reorder_limit_};
+  for (const auto& [_, stream] : recv_streams_) {
+    const auto footprint = stream.reorder.memory_footprint();
+    reorder.reserved += footprint.reserved + utils::container_node_bytes<decltype(recv_streams_)>();
+    reorder.in_use += footprint.in_use;
+  }
+  reorder.reserved += send_stream_sequences_.size() *
+                      utils::container_node_bytes<decltype(send_stream_sequences_)>();
+  auto footprint = replay_window_.memory_footprint() + reorder +
+                   fragment_reassembly_.memory_footprint() + retransmit_buffer_.memory_footprint();
+  if (flow_controller_) {
+    footprint += flow_controller_->memory_footprint();
+  }
+  if (fec_encoder_) {
+    footprint += fec_encoder_->memory_footprint();
+  }
+  if (fec_decoder_) {
+    footprint += fec_decoder_->memory_footprint();
+  }
+  return footprint;
+}
+
+void TransportSession::refresh_buffer_limits() {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  account_buffer_bytes(0);
+}
+
+bool TransportSession::can_hibernate() const {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  return retransmit_buffer_.pending_count() == 0 && reorder_buffered_bytes() == 0 &&
+         fragment_reassembly_.pending_count() == 0;
+}
+
+HibernatedSession TransportSession::hibernate() const {
+  VEIL_DCHECK_THREAD(thread_checker_);
+  HibernatedSession hibernated;
+  hibernated.keys = keys_;
+  hibernated.session_id = current_session_id_;
+  hibernated.send_sequence = send_sequence_;
+  hibernated.recv_sequence_max = recv_sequence_max_;
+  hibernated.message_id_counter = message_id_counter_;
+  hibernated.packets_since_rotation = packets_since_rotation_;
+  hibernated.replay_window = replay_window_;
+  hibernated.recv_ack_bitmap = recv_ack_bitmap_;
+  hibernated.stats = cold_.stats;
+  hibernated.send_stream_sequences = send_stream_sequences_;
+  for (const auto& [stream_id, stream] : recv_streams_) {
+    hibernated.recv_stream_sequences.emplace(stream_id, stream.reorder.next_expected());
+  }
+  return hibernated;
+}
+
+void TransportSession::account_buffer_bytes(std::size_t bytes) {
+  if (buffer_sizer_ && buffer_sizer_->record(bytes, now_fn_(), retransmit_buffer_.estimated_rtt())) {
+    apply_buffer_limit(buffer_sizer_->limit());
+  }
+}
+
+void TransportSession::apply_buffer_limit(std::size_t limit) {
+  reorder_limit_ = std::min(limit, config_.reorder_buffer_size);
+  for (auto& [_, stream] : recv_streams_) {
+    stream.reorder.set_max_bytes(reorder_limit_);
+  }
+  fragment_reassembly_.set_max_bytes(std::min(limit, config_.fragment_buffer_size));
+  retransmit_buffer_.set_max_buffer_bytes(
+      std::min(limit, config_.retransmit_config.max_buffer_bytes));
+}
+
 std::vector<std::uint8_t> TransportSession::build_encrypted_packet(const mux::MuxFrame& frame) {
+  return seal_packet(mux::MuxCodec::encode(frame));
+}
+
+void TransportSession::pad_frame(std::vector<std::uint8_t>& encoded, std::size_t pad_to) {
+  if (encoded.size() < pad_to) {
+    cold_.stats.padding_bytes_sent += pad_to - encoded.size();
+    encoded.resize(pad_to, 0);
+  }
+}
+
+std::vector<std::uint8_t> TransportSession::seal_packet(std::span<const std::uint8_t> plaintext) {
+  // Encrypt using ChaCha20-Poly1305 AEAD straight into the packet after
+  // the sequence.
+  auto job = begin_seal(plaintext.size());
+  crypto::aead_encrypt_into(keys_.send_key, job.nonce, {}, plaintext,
+                            std::span(job.packet).subspan(8));
+  return std::move(job.packet);
+}
+
+AeadJob TransportSession::make_seal_job(std::span<const std::uint8_t> plaintext) {
+  if (!cold_.send_job_key) {
+    cold_.send_job_key = share_key(keys_.send_key);
+  }
+  auto job = begin_seal(plaintext.size());
+  job.key = cold_.send_job_key;
+  std::copy(plaintext.begin(), plaintext.end(), job.packet.begin() + 8);
+  return job;
+}
+
+AeadJob TransportSession::begin_seal(std::size_t plaintext_size) {
   // SECURITY: Check for sequence number overflow (extremely unlikely but provides defense in depth)
   // At 10 Gbps with 1KB packets, reaching this threshold would take millions of years,
   // but we check anyway to catch any implementation bugs that might cause unexpected growth.
@@ -258,16 +846,14 @@ std::vector<std::uint8_t> TransportSession::build_encrypted_packet(const mux::Mu
     // A production system might want to force session termination here.
   }
 
-  // Serialize the frame.
-  auto plaintext = mux::MuxCodec::encode(frame);
+  AeadJob job;
+  job.kind = AeadJob::Kind::kSeal;
+  job.sequence = send_sequence_;
 
   // Derive nonce from current send sequence.
   // SECURITY: Each packet gets a unique nonce = base_nonce XOR send_sequence_
   // Since send_sequence_ is never reset and always increments, nonces are guaranteed unique.
-  const auto nonce = crypto::derive_nonce(keys_.send_nonce, send_sequence_);
-
-  // Encrypt using ChaCha20-Poly1305 AEAD.
-  auto ciphertext = crypto::aead_encrypt(keys_.send_key, nonce, {}, plaintext);
+  job.nonce = crypto::derive_nonce(keys_.send_nonce, send_sequence_);
 
   // DPI RESISTANCE (Issue #21): Obfuscate sequence number before transmission.
   // Previously, the sequence was sent in plaintext, creating a DPI signature (monotonically
@@ -275,29 +861,34 @@ std::vector<std::uint8_t> TransportSession::build_encrypted_packet(const mux::Mu
   // The receiver can deobfuscate using the same key to recover the sequence for nonce derivation.
   const std::uint64_t obfuscated_sequence = crypto::obfuscate_sequence(send_sequence_, send_seq_obfuscation_key_);
 
-  // Prepend obfuscated sequence number (8 bytes big-endian).
-  std::vector<std::uint8_t> packet;
-  packet.reserve(8 + ciphertext.size());
-  for (int i = 7; i >= 0; --i) {
-    packet.push_back(static_cast<std::uint8_t>((obfuscated_sequence >> (8 * i)) & 0xFF));
+  // Prepend obfuscated sequence number (8 bytes big-endian), with room
+  // after it for the plaintext and tag.
+  job.packet.resize(8 + plaintext_size + crypto::kAeadTagLen);
+  for (std::size_t i = 0; i < 8; ++i) {
+    job.packet[i] = static_cast<std::uint8_t>((obfuscated_sequence >> (8 * (7 - i))) & 0xFF);
   }
-  packet.insert(packet.end(), ciphertext.begin(), ciphertext.end());
 
   // SECURITY: Increment AFTER using the sequence number.
   // This ensures each packet uses a unique sequence, and the next packet will use the next value.
   ++send_sequence_;
 
-  return packet;
+  return job;
 }
 
 std::vector<mux::MuxFrame> TransportSession::fragment_data(std::span<const std::uint8_t> data,
                                                             std::uint64_t stream_id, bool fin) {
   std::vector<mux::MuxFrame> frames;
 
-  if (data.size() <= config_.max_fragment_size) {
+  // Leave room for the repair header when FEC is on.
+  const std::size_t max_fragment_size =
+      fec_encoder_ && config_.max_fragment_size > mux::kFecRepairOverhead
+          ? config_.max_fragment_size - mux::kFecRepairOverhead
+          : config_.max_fragment_size;
+
+  if (data.size() <= max_fragment_size) {
     // No fragmentation needed.
     frames.push_back(mux::make_data_frame(
-        stream_id, message_id_counter_++, fin,
+        stream_id, send_stream_sequences_[stream_id]++, fin,
         std::vector<std::uint8_t>(data.begin(), data.end())));
     return frames;
   }
@@ -308,7 +899,7 @@ std::vector<mux::MuxFrame> TransportSession::fragment_data(std::span<const std::
   std::uint64_t frag_seq = 0;
 
   while (offset < data.size()) {
-    const std::size_t chunk_size = std::min(config_.max_fragment_size, data.size() - offset);
+    const std::size_t chunk_size = std::min(max_fragment_size, data.size() - offset);
     const bool is_last = (offset + chunk_size >= data.size());
     const bool frag_fin = is_last && fin;
 
@@ -320,6 +911,7 @@ std::vector<mux::MuxFrame> TransportSession::fragment_data(std::span<const std::
     const std::uint64_t encoded_seq = (msg_id << 32) | frag_seq;
 
     frames.push_back(mux::make_data_frame(stream_id, encoded_seq, frag_fin, std::move(chunk)));
+    frames.back().data.fragment = true;
 
     offset += chunk_size;
     ++frag_seq;
@@ -1,23 +1,31 @@
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
 #include <span>
+#include <unordered_map>
 #include <vector>
 
 #include "common/crypto/crypto_engine.h"
 #include "common/handshake/handshake_processor.h"
 #include "common/session/replay_window.h"
 #include "common/session/session_rotator.h"
+#include "common/utils/cache_line.h"
+#include "common/utils/memory_footprint.h"
 #include "common/utils/thread_checker.h"
 #include "transport/mux/ack_bitmap.h"
+#include "transport/mux/ack_scheduler.h"
+#include "transport/mux/fec_codec.h"
 #include "transport/mux/fragment_reassembly.h"
 #include "transport/mux/mux_codec.h"
 #include "transport/mux/reorder_buffer.h"
 #include "transport/mux/retransmit_buffer.h"
+#include "transport/session/buffer_sizer.h"
+#include "transport/session/flow_controller.h"
 
 namespace veil::transport {
 
@@ -33,12 +41,41 @@ struct TransportSessionConfig {
   std::chrono::seconds session_rotation_interval{30};
   // Packets before forced session rotation.
   std::uint64_t session_rotation_packets{1000000};
-  // Reorder buffer max bytes.
+  // Reorder buffer max bytes, across all streams.
   std::size_t reorder_buffer_size{1 << 20};
+  // Deliver data frames in order within each mux stream. A frame behind a
+  // gap is held until the gap fills or reorder_timeout passes (see
+  // release_stalled_frames()). Streams are ordered independently, so a
+  // loss only holds up the flows that share its stream. Fragmented
+  // messages are delivered as they arrive.
+  bool ordered_delivery{false};
+  std::chrono::milliseconds reorder_timeout{100};
+  // Streams ordered per session; frames on further streams are delivered
+  // as they arrive.
+  std::size_t max_ordered_streams{64};
   // Fragment reassembly max bytes per message.
   std::size_t fragment_buffer_size{1 << 20};
   // Retransmit configuration.
   mux::RetransmitConfig retransmit_config{};
+  // Size the reorder, fragment and retransmit caps from measured
+  // bandwidth x RTT instead of the fixed sizes above, which then act as
+  // ceilings. Mostly idle sessions then hold small limits.
+  bool adaptive_buffers{false};
+  // Floor, gain and sampling for adaptive sizing (max_bytes is ignored;
+  // each buffer's own size above is its ceiling).
+  BufferSizerConfig buffer_sizing{};
+  // Receive-window advertisement and send credit.
+  FlowControlConfig flow_control{};
+  // Forward error correction: repair packets sent with data so the peer
+  // can rebuild lost packets without a retransmission. While enabled, data
+  // fragments shrink by mux::kFecRepairOverhead so repairs fit the MTU.
+  mux::FecConfig fec{};
+  // Ask the peer to acknowledge about acks_per_rtt times per round trip,
+  // scaled to the packets in flight, rather than every few packets. Only
+  // peers that schedule ACKs with a mux::AckScheduler act on the requests;
+  // today that is the session simulator alone, and veil-client and
+  // veil-server leave this disabled.
+  mux::AckFrequencyConfig ack_frequency{};
 };
 
 // Statistics for observability.
@@ -55,6 +92,102 @@ struct TransportStats {
   std::uint64_t messages_reassembled{0};
   std::uint64_t retransmits{0};
   std::uint64_t session_rotations{0};
+  // Authenticated packets that arrived with ECT or CE in the outer header.
+  std::uint64_t ecn_ect_received{0};
+  std::uint64_t ecn_ce_received{0};
+  // Stream gaps given up on after reorder_timeout.
+  std::uint64_t reorder_gaps_skipped{0};
+  // Sends refused for lack of peer credit, and window updates exchanged.
+  std::uint64_t flow_control_blocked{0};
+  std::uint64_t window_updates_sent{0};
+  std::uint64_t window_updates_received{0};
+  // FEC repair packets exchanged, and data packets rebuilt from them.
+  std::uint64_t fec_repairs_sent{0};
+  std::uint64_t fec_repairs_received{0};
+  std::uint64_t fec_recovered{0};
+  // AckFrequency requests sent to the peer.
+  std::uint64_t ack_frequency_requests{0};
+  // Cover-traffic heartbeats sent, and padding added to reach slot sizes.
+  std::uint64_t heartbeats_sent{0};
+  std::uint64_t padding_bytes_sent{0};
+};
+
+/**
+ * Compact state of an idle session: keys, sequence counters and replay
+ * state, without buffers or configuration. Produced by
+ * TransportSession::hibernate() and turned back into a session by the
+ * TransportSession constructor that takes it.
+ *
+ * Move-only; the destructor clears the key material.
+ */
+struct HibernatedSession {
+  crypto::SessionKeys keys;
+  std::uint64_t session_id{0};
+  std::uint64_t send_sequence{0};
+  std::uint64_t recv_sequence_max{0};
+  std::uint64_t message_id_counter{0};
+  std::uint64_t packets_since_rotation{0};
+  session::ReplayWindow replay_window;
+  mux::AckBitmap recv_ack_bitmap;
+  TransportStats stats;
+  // Next message sequence per stream, sending and (with ordered delivery)
+  // receiving.
+  std::unordered_map<std::uint64_t, std::uint64_t> send_stream_sequences;
+  std::unordered_map<std::uint64_t, std::uint64_t> recv_stream_sequences;
+
+  HibernatedSession() = default;
+  ~HibernatedSession();
+  HibernatedSession(const HibernatedSession&) = delete;
+  HibernatedSession& operator=(const HibernatedSession&) = delete;
+  HibernatedSession(HibernatedSession&&) = default;
+  HibernatedSession& operator=(HibernatedSession&&) = default;
+
+  // Heap held by the replay window and stream sequence maps.
+  utils::MemoryFootprint memory_footprint() const {
+    auto footprint = replay_window.memory_footprint();
+    footprint.reserved += (send_stream_sequences.size() + recv_stream_sequences.size()) *
+                          utils::container_node_bytes<decltype(send_stream_sequences)>();
+    return footprint;
+  }
+};
+
+// One direction's AEAD key, shared between a session and the AeadJobs it
+// prepares so a job can finish after the session is gone. Zeroed on
+// destruction.
+struct AeadKey {
+  std::array<std::uint8_t, crypto::kAeadKeyLen> bytes{};
+
+  AeadKey() = default;
+  ~AeadKey();
+  AeadKey(const AeadKey&) = delete;
+  AeadKey& operator=(const AeadKey&) = delete;
+};
+
+/**
+ * The ChaCha20-Poly1305 step of one packet, split out of the session so it
+ * can run on another thread. The session prepares the job (sequence,
+ * nonce, framing, replay check) and finishes it (retransmit buffer, frame
+ * processing); run() touches nothing but the job, so jobs of one session
+ * may run concurrently as long as they are finished in the order they were
+ * prepared.
+ */
+struct AeadJob {
+  enum class Kind : std::uint8_t { kSeal, kOpen };
+
+  Kind kind{Kind::kSeal};
+  std::uint64_t sequence{0};
+  std::array<std::uint8_t, crypto::kNonceLen> nonce{};
+  std::shared_ptr<const AeadKey> key;
+  // The obfuscated sequence (8 bytes), then for kSeal the plaintext and
+  // room for the tag, and for kOpen the ciphertext and tag. run() works in
+  // place.
+  std::vector<std::uint8_t> packet;
+  // kSeal: keep the sealed packet for retransmission.
+  bool retain{false};
+  // Set by run(): sealed, or opened and authenticated.
+  bool ok{false};
+
+  void run();
 };
 
 /**
@@ -83,6 +216,12 @@ class TransportSession {
                    TransportSessionConfig config = {},
                    std::function<TimePoint()> now_fn = Clock::now);
 
+  // Wake a hibernated session. Sequences and replay state continue where
+  // they stopped; RTT estimates, buffer limits and flow-control windows
+  // start over, and the rotation interval restarts from now.
+  TransportSession(HibernatedSession&& hibernated, TransportSessionConfig config = {},
+                   std::function<TimePoint()> now_fn = Clock::now);
+
   /// SECURITY: Destructor clears all session key material
   ~TransportSession();
 
@@ -97,14 +236,73 @@ class TransportSession {
   // Encrypt and serialize data for transmission.
   // Returns encrypted packet bytes ready to send.
   // If data exceeds MTU, it will be fragmented into multiple packets.
+  // With FEC, repair packets for a block this fills follow the data, and
+  // with ack_frequency, a new AckFrequency request when one is due.
+  // Data packets are padded inside the encryption to at least `pad_to`
+  // plaintext bytes (a cover-traffic slot size); the peer drops the padding.
   std::vector<std::vector<std::uint8_t>> encrypt_data(std::span<const std::uint8_t> plaintext,
-                                                       std::uint64_t stream_id = 0, bool fin = false);
+                                                       std::uint64_t stream_id = 0, bool fin = false,
+                                                       std::size_t pad_to = 0);
+
+  // encrypt_data() in two halves around the AEAD step, for callers that
+  // run it on worker threads: prepare_data() assigns sequences and frames
+  // the packets; run each job, then pass it to finish_seal() in the order
+  // prepared to get the packet to send.
+  std::vector<AeadJob> prepare_data(std::span<const std::uint8_t> plaintext,
+                                    std::uint64_t stream_id = 0, bool fin = false,
+                                    std::size_t pad_to = 0);
+  std::vector<std::uint8_t> finish_seal(AeadJob&& job);
+
+  // decrypt_packet() split the same way. prepare_open() checks the size
+  // and the replay window, so it returns nothing for packets dropped
+  // before decryption; finish_open() returns what decrypt_packet() would.
+  std::optional<AeadJob> prepare_open(std::vector<std::uint8_t> packet);
+  std::optional<std::vector<mux::MuxFrame>> finish_open(AeadJob&& job);
+
+  // Encrypt a heartbeat carrying `payload`, padded like encrypt_data().
+  // Heartbeats are not retransmitted; decrypt_packet() returns them.
+  std::vector<std::uint8_t> encrypt_heartbeat(std::span<const std::uint8_t> payload,
+                                              std::uint64_t sequence, std::size_t pad_to = 0);
 
   // Decrypt and process a received packet.
   // Returns decrypted mux frames if successful.
-  // Performs replay check and decryption.
+  // Performs replay check and decryption. Window updates, BLOCKED notices
+  // and FEC frames are handled here and not returned; data packets that
+  // FEC rebuilds are returned with the packet that completed them.
+  // AckFrequency requests are returned as control frames; only a caller
+  // that runs an AckScheduler (the session simulator) applies them, and
+  // Tunnel and ServerDataPlane ignore them.
   std::optional<std::vector<mux::MuxFrame>> decrypt_packet(std::span<const std::uint8_t> ciphertext);
 
+  // Record the outer ECN codepoint (RFC 3168 bits) of a packet that
+  // decrypt_packet() accepted. CE counts are the path's congestion signal.
+  void record_outer_ecn(std::uint8_t ecn);
+
+  // With ordered delivery, data frames held longer than reorder_timeout
+  // behind a gap: the gap is skipped and the frames after it released.
+  // Call periodically; returns nothing when ordered delivery is off.
+  std::vector<mux::MuxFrame> release_stalled_frames();
+
+  // Whether the peer's advertised windows allow sending `bytes` on
+  // `stream_id` now (pass mux::kConnectionStream to check the connection
+  // window alone). On false, a BLOCKED notice is queued for the peer.
+  // Always true while flow control is off or the peer has not advertised.
+  bool has_send_credit(std::size_t bytes, std::uint64_t stream_id = mux::kConnectionStream);
+
+  // Received data was dropped after decrypt_packet() returned it, e.g. the
+  // TUN write failed. The receive window shrinks, so the peer slows down.
+  void report_delivery_drop();
+
+  // Encrypted window updates and BLOCKED notices due now. Call
+  // periodically, like get_retransmit_packets(); the packets are not
+  // retransmitted, as newer ones supersede them.
+  std::vector<std::vector<std::uint8_t>> get_flow_control_packets();
+
+  // Encrypted FEC repairs for blocks held open past block_timeout, and
+  // loss reports for the peer's encoder. Call periodically, like
+  // get_retransmit_packets().
+  std::vector<std::vector<std::uint8_t>> get_fec_packets();
+
   // Get packets that need retransmission.
   std::vector<std::vector<std::uint8_t>> get_retransmit_packets();
 
@@ -114,6 +312,17 @@ class TransportSession {
   // Generate an ACK frame for received packets on a stream.
   mux::AckFrame generate_ack(std::uint64_t stream_id);
 
+  // Encrypt an ACK frame for received packets on a stream.
+  // ACK packets are not buffered for retransmission; a lost ACK is
+  // superseded by the next one.
+  std::vector<std::uint8_t> encrypt_ack(std::uint64_t stream_id);
+
+  // Encrypt a control frame that is not retransmitted, such as the route
+  // announcement a client repeats periodically. decrypt_packet() returns it
+  // to the peer.
+  std::vector<std::uint8_t> encrypt_control(mux::ControlType type,
+                                            std::vector<std::uint8_t> payload);
+
   // Check if session should rotate (time or packet count threshold).
   bool should_rotate_session();
 
@@ -131,24 +340,90 @@ class TransportSession {
   std::uint64_t send_sequence() const { return send_sequence_; }
 
   // Get statistics.
-  const TransportStats& stats() const { return stats_; }
+  const TransportStats& stats() const { return cold_.stats; }
+
+  // Number of sent packets not yet acknowledged or given up on.
+  std::size_t packets_in_flight() const { return retransmit_buffer_.pending_count(); }
+
+  // Smoothed round-trip time from acknowledged packets.
+  std::chrono::milliseconds estimated_rtt() const { return retransmit_buffer_.estimated_rtt(); }
 
   // Get retransmit buffer statistics.
   const mux::RetransmitStats& retransmit_stats() const { return retransmit_buffer_.stats(); }
 
+  // Heap held by the replay window and the reorder, fragment and retransmit
+  // buffers. `limit` sums their configured caps, the worst case per session.
+  utils::MemoryFootprint memory_footprint() const;
+
+  // Current per-buffer cap: the adaptive limit, or the fixed retransmit
+  // buffer size when adaptive sizing is off.
+  std::size_t buffer_limit() const { return retransmit_buffer_.max_buffer_bytes(); }
+
+  // Let adaptive limits decay while no traffic flows. Call periodically;
+  // a no-op when adaptive sizing is off.
+  void refresh_buffer_limits();
+
+  // True when nothing is in flight or buffered, so hibernate() loses no data.
+  bool can_hibernate() const;
+
+  // Capture the state needed to resume this session. Check can_hibernate()
+  // first; unacknowledged packets are not carried over. The session should
+  // be destroyed afterwards, as both copies hold the keys.
+  HibernatedSession hibernate() const;
+
  private:
   // Build an encrypted packet from mux frame.
   std::vector<std::uint8_t> build_encrypted_packet(const mux::MuxFrame& frame);
+  // Encrypt an encoded mux frame under the next send sequence.
+  std::vector<std::uint8_t> seal_packet(std::span<const std::uint8_t> plaintext);
+  // Claim the next send sequence for a packet of `plaintext_size` bytes: a
+  // seal job with its nonce and obfuscated sequence, but no key or
+  // plaintext yet.
+  AeadJob begin_seal(std::size_t plaintext_size);
+  // A complete seal job for an encoded mux frame.
+  AeadJob make_seal_job(std::span<const std::uint8_t> plaintext);
+  // Zero-pad an encoded frame to `pad_to` bytes.
+  void pad_frame(std::vector<std::uint8_t>& encoded, std::size_t pad_to);
+
+  // Handle the decrypted plaintext of packet `sequence`, appending frames
+  // for the caller to `frames`.
+  void process_plaintext(std::uint64_t sequence, std::span<const std::uint8_t> plaintext,
+                         std::vector<mux::MuxFrame>& frames);
+
+  // Apply a received FEC frame; false if it is not one.
+  bool handle_fec(const mux::ControlFrame& control, std::vector<mux::MuxFrame>& frames);
+  // Process packets rebuilt by the FEC decoder as if they had arrived.
+  void deliver_recovered(std::vector<mux::FecDecoder::Recovered> recovered,
+                         std::vector<mux::MuxFrame>& frames);
+  // Seal jobs for repair frames, appended to `out`.
+  void append_repairs(std::vector<mux::FecRepair> repairs, std::vector<AeadJob>& out);
+
+  // Feed the buffer sizer and apply a changed limit.
+  void account_buffer_bytes(std::size_t bytes);
+  void apply_buffer_limit(std::size_t limit);
+
+  // Ordered delivery: hand `frame` and any frames it unblocks to `out`.
+  void deliver_in_order(mux::MuxFrame&& frame, std::vector<mux::MuxFrame>& out);
+
+  struct RecvStream;
+  // Move a stream's in-order frames to `out` and update its stall time.
+  void release_ready(std::uint64_t stream_id, RecvStream& stream, std::vector<mux::MuxFrame>& out);
+  std::size_t reorder_buffered_bytes() const;
+
+  // Apply a received flow-control frame; false if it is not one.
+  bool handle_flow_control(const mux::ControlFrame& control);
 
   // Fragment large data into multiple frames.
   std::vector<mux::MuxFrame> fragment_data(std::span<const std::uint8_t> data, std::uint64_t stream_id,
                                             bool fin);
 
-  TransportSessionConfig config_;
-  std::function<TimePoint()> now_fn_;
+  // Layout: the keys, sequence counters and replay state read for every
+  // packet come first, starting on a cache line, so encrypt and decrypt
+  // touch the same four adjacent lines. Statistics and job keys follow on
+  // lines of their own; configuration, rotation and buffers after that.
 
   // Crypto keys from handshake.
-  crypto::SessionKeys keys_;
+  alignas(utils::kCacheLineSize) crypto::SessionKeys keys_;
   std::uint64_t current_session_id_;
 
   // DPI resistance: Keys for obfuscating sequence numbers (Issue #21).
@@ -163,25 +438,58 @@ class TransportSession {
   // Resetting would cause nonce reuse, completely breaking ChaCha20-Poly1305 security.
   std::uint64_t send_sequence_{0};
   std::uint64_t recv_sequence_max_{0};
+  std::uint64_t packets_since_rotation_{0};
+
+  // Message ID counter for fragmentation.
+  std::uint64_t message_id_counter_{0};
 
   // Replay protection.
   session::ReplayWindow replay_window_;
+  mux::AckBitmap recv_ack_bitmap_;
+
+  // Kept off the lines above: statistics are only written per packet, and
+  // the job keys are used only by the pipelined crypto path.
+  struct ColdState {
+    // Copies of keys_.send_key and recv_key for AeadJobs, made on first use.
+    std::shared_ptr<const AeadKey> send_job_key;
+    std::shared_ptr<const AeadKey> recv_job_key;
+    TransportStats stats;
+  };
+  alignas(utils::kCacheLineSize) ColdState cold_;
+
+  // Cold: not touched on the per-packet fast path.
+  TransportSessionConfig config_;
+  std::function<TimePoint()> now_fn_;
 
   // Session rotation.
   session::SessionRotator session_rotator_;
-  std::uint64_t packets_since_rotation_{0};
 
   // Multiplexing state.
-  mux::AckBitmap recv_ack_bitmap_;
-  mux::ReorderBuffer reorder_buffer_;
+  struct RecvStream {
+    RecvStream(std::uint64_t next, std::size_t max_bytes) : reorder(next, max_bytes) {}
+    mux::ReorderBuffer reorder;
+    // When the head-of-line gap opened; unset while nothing is held.
+    TimePoint stalled_since{};
+  };
+  std::unordered_map<std::uint64_t, std::uint64_t> send_stream_sequences_;
+  std::unordered_map<std::uint64_t, RecvStream> recv_streams_;
+  std::size_t reorder_limit_;
   mux::FragmentReassembly fragment_reassembly_;
   mux::RetransmitBuffer retransmit_buffer_;
 
-  // Message ID counter for fragmentation.
-  std::uint64_t message_id_counter_{0};
+  // Adaptive buffer sizing; empty when disabled.
+  std::optional<BufferSizer> buffer_sizer_;
+
+  // Credit-based flow control; empty when disabled.
+  std::optional<FlowController> flow_controller_;
+
+  // FEC: the encoder exists when enabled, the decoder once the peer has
+  // sent a repair packet.
+  std::optional<mux::FecEncoder> fec_encoder_;
+  std::optional<mux::FecDecoder> fec_decoder_;
 
-  // Statistics.
-  TransportStats stats_;
+  // Sender-side ACK frequency; empty when disabled.
+  std::optional<mux::AckFrequencyPolicy> ack_frequency_policy_;
 
   // Thread safety: verifies single-threaded access in debug builds.
   VEIL_THREAD_CHECKER(thread_checker_);
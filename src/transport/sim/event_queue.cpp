@@ -0,0 +1,77 @@
+#include "transport/sim/event_queue.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace veil::sim {
+
+namespace {
+// Fixed origins keep handshake timestamps and timer arithmetic identical
+// between runs. The steady origin is offset from the epoch so nothing
+// mistakes it for a default-constructed time point.
+constexpr auto kSteadyOrigin = std::chrono::hours(1);
+constexpr auto kSystemOrigin = std::chrono::seconds(1704067200);  // 2024-01-01T00:00:00Z
+}  // namespace
+
+VirtualClock::VirtualClock()
+    : start_(TimePoint(kSteadyOrigin)),
+      now_(start_),
+      system_start_(SystemClock::time_point(kSystemOrigin)) {}
+
+VirtualClock::SystemClock::time_point VirtualClock::system_now() const {
+  return system_start_ + std::chrono::duration_cast<SystemClock::duration>(elapsed());
+}
+
+void VirtualClock::advance_to(TimePoint t) { now_ = std::max(now_, t); }
+
+std::function<VirtualClock::TimePoint()> VirtualClock::steady_fn() const {
+  return [this] { return now_; };
+}
+
+std::function<VirtualClock::SystemClock::time_point()> VirtualClock::system_fn() const {
+  return [this] { return system_now(); };
+}
+
+EventQueue::EventQueue(VirtualClock& clock) : clock_(clock) {}
+
+void EventQueue::schedule_at(TimePoint at, Callback callback) {
+  queue_.push_back(Event{std::max(at, clock_.now()), next_order_++, std::move(callback)});
+  std::push_heap(queue_.begin(), queue_.end(), LaterFirst{});
+}
+
+void EventQueue::schedule_after(VirtualClock::Clock::duration delay, Callback callback) {
+  schedule_at(clock_.now() + delay, std::move(callback));
+}
+
+bool EventQueue::run_next() {
+  if (queue_.empty()) {
+    return false;
+  }
+  std::pop_heap(queue_.begin(), queue_.end(), LaterFirst{});
+  auto event = std::move(queue_.back());
+  queue_.pop_back();
+
+  clock_.advance_to(event.at);
+  ++events_processed_;
+  event.callback();
+  return true;
+}
+
+std::uint64_t EventQueue::run_until(TimePoint deadline) {
+  std::uint64_t ran = 0;
+  while (!queue_.empty() && queue_.front().at <= deadline) {
+    run_next();
+    ++ran;
+  }
+  clock_.advance_to(deadline);
+  return ran;
+}
+
+std::optional<EventQueue::TimePoint> EventQueue::next_event_time() const {
+  if (queue_.empty()) {
+    return std::nullopt;
+  }
+  return queue_.front().at;
+}
+
+}  // namespace veil::sim
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace veil::sim {
+
+// Simulated time source.
+//
+// Provides both a steady clock (transport, retransmit, ACK timers) and a
+// system clock (handshake timestamps) that advance together, so components
+// taking a `now_fn` can run unmodified on virtual time. Both start at fixed
+// instants so runs are reproducible.
+//
+// Thread Safety: not thread-safe; see docs/thread_model.md.
+class VirtualClock {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = Clock::time_point;
+  using SystemClock = std::chrono::system_clock;
+
+  VirtualClock();
+
+  TimePoint now() const { return now_; }
+  SystemClock::time_point system_now() const;
+
+  // Time elapsed since the clock was created.
+  Clock::duration elapsed() const { return now_ - start_; }
+
+  // Move the clock forward to `t`. Time never moves backwards.
+  void advance_to(TimePoint t);
+
+  // Adapters for components that take a `now_fn`. The clock must outlive
+  // any component holding one of these.
+  std::function<TimePoint()> steady_fn() const;
+  std::function<SystemClock::time_point()> system_fn() const;
+
+ private:
+  TimePoint start_;
+  TimePoint now_;
+  SystemClock::time_point system_start_;
+};
+
+// Discrete-event scheduler driving a VirtualClock.
+//
+// Events run in time order; events scheduled for the same instant run in
+// the order they were scheduled, so a run is fully determined by its inputs.
+// Running an event advances the clock to the event's time first.
+//
+// Thread Safety: not thread-safe; see docs/thread_model.md.
+class EventQueue {
+ public:
+  using TimePoint = VirtualClock::TimePoint;
+  using Callback = std::function<void()>;
+
+  explicit EventQueue(VirtualClock& clock);
+
+  // Schedule `callback` at `at`. Times in the past run at the current time.
+  void schedule_at(TimePoint at, Callback callback);
+  void schedule_after(VirtualClock::Clock::duration delay, Callback callback);
+
+  // Run the earliest event. Returns false if the queue is empty.
+  bool run_next();
+
+  // Run all events due at or before `deadline`, then advance the clock to
+  // `deadline`. Returns the number of events run.
+  std::uint64_t run_until(TimePoint deadline);
+
+  bool empty() const { return queue_.empty(); }
+  std::size_t size() const { return queue_.size(); }
+  std::optional<TimePoint> next_event_time() const;
+  std::uint64_t events_processed() const { return events_processed_; }
+
+ private:
+  struct Event {
+    TimePoint at;
+    std::uint64_t order{0};
+    Callback callback;
+  };
+
+  struct LaterFirst {
+    bool operator()(const Event& a, const Event& b) const {
+      if (a.at != b.at) {
+        return a.at > b.at;
+      }
+      return a.order > b.order;
+    }
+  };
+
+  VirtualClock& clock_;
+  std::vector<Event> queue_;  // Min-heap on (at, order).
+  std::uint64_t next_order_{0};
+  std::uint64_t events_processed_{0};
+};
+
+}  // namespace veil::sim
@@ -0,0 +1,585 @@
+#include "transport/sim/session_simulator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <random>
+#include <utility>
+
+#include "common/handshake/handshake_processor.h"
+#include "common/utils/rate_limiter.h"
+#include "transport/sim/event_queue.h"
+
+namespace veil::sim {
+
+namespace {
+
+using TimePoint = VirtualClock::TimePoint;
+
+// Handshake packets carry random DPI padding. They are charged to the links
+// at a fixed nominal size so padding does not perturb seeded runs.
+constexpr std::size_t kHandshakeWireBytes = 256;
+constexpr std::chrono::milliseconds kHandshakeSkewTolerance{30000};
+constexpr std::uint64_t kStreamId = 0;
+
+enum Direction : std::size_t { kUplink = 0, kDownlink = 1 };
+
+enum class PacketKind : std::uint8_t { kHandshake, kTransport };
+
+Direction opposite(Direction dir) { return dir == kUplink ? kDownlink : kUplink; }
+
+// SplitMix64 finalizer: derives independent seeds from the master seed.
+std::uint64_t mix_seed(std::uint64_t seed, std::uint64_t stream) {
+  std::uint64_t z = seed + (stream + 1) * 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+transport::ImpairmentConfig with_seed(transport::ImpairmentConfig config, std::uint64_t seed) {
+  config.seed = seed;
+  return config;
+}
+
+bool is_passthrough(const transport::ImpairmentConfig& config) {
+  return config.loss_rate <= 0.0 && !config.burst_loss.enabled && config.duplicate_rate <= 0.0 &&
+         config.reorder_rate <= 0.0 && config.delay.count() == 0 && config.jitter.count() == 0 &&
+         config.bandwidth_bps == 0;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  const auto rank = static_cast<std::size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+  return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+struct PendingMessage {
+  std::uint64_t id{0};
+  TimePoint created;
+};
+
+// One end of a session. Each endpoint sends data in one direction and
+// receives (and ACKs) data in the other.
+struct Endpoint {
+  std::unique_ptr<transport::TransportSession> transport;
+  std::unique_ptr<mux::AckScheduler> acks;
+  std::deque<PendingMessage> queue;
+  TimePoint pace_next{};
+  std::uint64_t next_message_id{0};
+  bool send_armed{false};
+  bool retransmit_armed{false};
+  bool ack_armed{false};
+  bool traffic_started{false};
+};
+
+struct Session {
+  Session(const SimulationConfig& config, std::size_t index)
+      : uplink(with_seed(config.uplink, mix_seed(config.seed, 3 * index))),
+        downlink(with_seed(config.downlink, mix_seed(config.seed, 3 * index + 1))),
+        rng(mix_seed(config.seed, 3 * index + 2)) {}
+
+  std::unique_ptr<handshake::HandshakeInitiator> initiator;
+  std::uint32_t handshake_attempt{0};
+  bool established{false};
+  Endpoint client;
+  Endpoint server;
+  transport::NetworkImpairment uplink;
+  transport::NetworkImpairment downlink;
+  std::mt19937_64 rng;
+};
+
+struct DirectionState {
+  DirectionResult result;
+  std::vector<double> latencies_ms;
+  std::vector<std::uint64_t> timeline_bytes;
+  std::uint64_t bytes_in_duration{0};
+  std::optional<transport::NetworkImpairment> shared;
+  double rate{0.0};
+};
+
+class Simulator {
+ public:
+  explicit Simulator(const SimulationConfig& config);
+
+  SimulationResult run();
+
+ private:
+  Endpoint& sender(Session& session, Direction dir) {
+    return dir == kUplink ? session.client : session.server;
+  }
+  Endpoint& receiver(Session& session, Direction dir) {
+    return dir == kUplink ? session.server : session.client;
+  }
+
+  void start_handshake(std::size_t index);
+  void on_handshake_init(std::size_t index, const std::vector<std::uint8_t>& packet);
+  void on_handshake_response(std::size_t index, const std::vector<std::uint8_t>& packet);
+
+  void transmit(std::size_t index, Direction dir, std::vector<std::uint8_t> packet,
+                PacketKind kind);
+  void forward(transport::NetworkImpairment& link, std::size_t index, Direction dir,
+               std::vector<std::uint8_t> packet, PacketKind kind, bool last_hop);
+  void arrive(std::size_t index, Direction dir, const std::vector<std::uint8_t>& packet,
+              PacketKind kind);
+
+  void start_traffic(std::size_t index, Direction dir);
+  void generate(std::size_t index, Direction dir);
+  void try_send(std::size_t index, Direction dir);
+  void poll_retransmits(std::size_t index, Direction dir);
+  void arm_send(std::size_t index, Direction dir, TimePoint at);
+  void arm_retransmit(std::size_t index, Direction dir);
+
+  // ACK handling for data flowing in `data_dir`.
+  void send_ack(std::size_t index, Direction data_dir);
+  void arm_ack_timer(std::size_t index, Direction data_dir);
+  void on_ack_timer(std::size_t index, Direction data_dir);
+
+  void deliver(Direction dir, const std::vector<std::uint8_t>& payload);
+  std::vector<std::uint8_t> make_payload(const PendingMessage& message) const;
+  std::chrono::nanoseconds next_interval(Session& session, double rate);
+  DirectionResult finish(DirectionState& state);
+
+  SimulationConfig config_;
+  std::size_t message_size_;
+  VirtualClock clock_;
+  EventQueue events_;
+  TimePoint origin_;
+  TimePoint traffic_end_;
+  std::vector<std::uint8_t> psk_;
+  std::unique_ptr<handshake::HandshakeResponder> responder_;
+  std::vector<Session> sessions_;
+  std::array<DirectionState, 2> directions_;
+  std::size_t established_{0};
+  std::uint64_t handshake_attempts_{0};
+};
+
+Simulator::Simulator(const SimulationConfig& config)
+    : config_(config),
+      message_size_(std::max(kMinMessageSize,
+                             std::min(config.traffic.message_size,
+                                      config.transport.max_fragment_size))),
+      events_(clock_),
+      origin_(clock_.now()),
+      traffic_end_(origin_ + config.duration),
+      psk_(32, 0x5C) {
+  responder_ = std::make_unique<handshake::HandshakeResponder>(
+      psk_, kHandshakeSkewTolerance,
+      utils::TokenBucket(1e9, std::chrono::milliseconds(1), clock_.steady_fn()),
+      clock_.system_fn());
+
+  sessions_.reserve(config_.sessions);
+  for (std::size_t i = 0; i < config_.sessions; ++i) {
+    sessions_.emplace_back(config_, i);
+  }
+
+  config_.sample_interval = std::max(config_.sample_interval, std::chrono::milliseconds(1));
+  const auto total = config_.duration + config_.drain;
+  const auto buckets = static_cast<std::size_t>(
+      (total + config_.sample_interval - std::chrono::milliseconds(1)) / config_.sample_interval);
+  const std::array<const transport::ImpairmentConfig*, 2> shared{&config_.shared_uplink,
+                                                                 &config_.shared_downlink};
+  for (std::size_t dir = 0; dir < directions_.size(); ++dir) {
+    auto& state = directions_[dir];
+    state.timeline_bytes.assign(std::max<std::size_t>(buckets, 1), 0);
+    if (!is_passthrough(*shared[dir])) {
+      state.shared.emplace(with_seed(*shared[dir], mix_seed(config_.seed, ~dir)));
+    }
+  }
+  directions_[kUplink].rate = config_.traffic.uplink_rate;
+  directions_[kDownlink].rate = config_.traffic.downlink_rate;
+}
+
+SimulationResult Simulator::run() {
+  const auto wall_start = std::chrono::steady_clock::now();
+
+  const auto ramp = std::chrono::duration_cast<std::chrono::nanoseconds>(config_.session_ramp);
+  const auto count = static_cast<std::int64_t>(std::max<std::size_t>(sessions_.size(), 1));
+  for (std::size_t i = 0; i < sessions_.size(); ++i) {
+    events_.schedule_at(origin_ + ramp * static_cast<std::int64_t>(i) / count,
+                        [this, i] { start_handshake(i); });
+  }
+  events_.run_until(traffic_end_ + config_.drain);
+
+  SimulationResult result;
+  result.sessions = sessions_.size();
+  result.sessions_established = established_;
+  result.handshake_attempts = handshake_attempts_;
+  result.uplink = finish(directions_[kUplink]);
+  result.downlink = finish(directions_[kDownlink]);
+  result.events_processed = events_.events_processed();
+  result.virtual_time = clock_.now() - origin_;
+  result.wall_time = std::chrono::steady_clock::now() - wall_start;
+  return result;
+}
+
+void Simulator::start_handshake(std::size_t index) {
+  auto& session = sessions_[index];
+  if (session.established || clock_.now() >= traffic_end_) {
+    return;
+  }
+
+  session.initiator = std::make_unique<handshake::HandshakeInitiator>(
+      psk_, kHandshakeSkewTolerance, clock_.system_fn());
+  const auto attempt = ++session.handshake_attempt;
+  ++handshake_attempts_;
+  transmit(index, kUplink, session.initiator->create_init(), PacketKind::kHandshake);
+
+  events_.schedule_after(config_.handshake_timeout, [this, index, attempt] {
+    if (sessions_[index].handshake_attempt == attempt) {
+      start_handshake(index);
+    }
+  });
+}
+
+void Simulator::on_handshake_init(std::size_t index, const std::vector<std::uint8_t>& packet) {
+  auto result = responder_->handle_init(packet);
+  if (!result) {
+    return;
+  }
+
+  // A repeated init (the response was lost) replaces the server's session,
+  // as a reconnecting client would.
+  auto& server = sessions_[index].server;
+  server.transport = std::make_unique<transport::TransportSession>(
+      result->session, config_.transport, clock_.steady_fn());
+  server.acks = std::make_unique<mux::AckScheduler>(config_.ack, clock_.steady_fn());
+  transmit(index, kDownlink, std::move(result->response), PacketKind::kHandshake);
+  start_traffic(index, kDownlink);
+}
+
+void Simulator::on_handshake_response(std::size_t index,
+                                      const std::vector<std::uint8_t>& packet) {
+  auto& session = sessions_[index];
+  if (session.established || !session.initiator) {
+    return;
+  }
+  auto handshake_session = session.initiator->consume_response(packet);
+  if (!handshake_session) {
+    return;
+  }
+
+  session.client.transport = std::make_unique<transport::TransportSession>(
+      *handshake_session, config_.transport, clock_.steady_fn());
+  session.client.acks = std::make_unique<mux::AckScheduler>(config_.ack, clock_.steady_fn());
+  session.initiator.reset();
+  session.established = true;
+  ++established_;
+  start_traffic(index, kUplink);
+}
+
+void Simulator::transmit(std::size_t index, Direction dir, std::vector<std::uint8_t> packet,
+                         PacketKind kind) {
+  auto& session = sessions_[index];
+  auto& link = dir == kUplink ? session.uplink : session.downlink;
+  forward(link, index, dir, std::move(packet), kind, !directions_[dir].shared.has_value());
+}
+
+void Simulator::forward(transport::NetworkImpairment& link, std::size_t index, Direction dir,
+                        std::vector<std::uint8_t> packet, PacketKind kind, bool last_hop) {
+  const auto bytes = kind == PacketKind::kHandshake ? kHandshakeWireBytes : packet.size();
+  const auto admission = link.admit(bytes, clock_.now());
+  if (admission.copies == 0) {
+    ++directions_[dir].result.wire_packets_lost;
+    return;
+  }
+
+  for (std::size_t copy = 0; copy < admission.copies; ++copy) {
+    auto data = copy + 1 == admission.copies ? std::move(packet) : packet;
+    events_.schedule_at(admission.deliver_at,
+                        [this, index, dir, kind, last_hop, data = std::move(data)]() mutable {
+                          if (last_hop) {
+                            arrive(index, dir, data, kind);
+                          } else {
+                            forward(*directions_[dir].shared, index, dir, std::move(data), kind,
+                                    true);
+                          }
+                        });
+  }
+}
+
+void Simulator::arrive(std::size_t index, Direction dir, const std::vector<std::uint8_t>& packet,
+                       PacketKind kind) {
+  if (kind == PacketKind::kHandshake) {
+    if (dir == kUplink) {
+      on_handshake_init(index, packet);
+    } else {
+      on_handshake_response(index, packet);
+    }
+    return;
+  }
+
+  auto& endpoint = receiver(sessions_[index], dir);
+  if (!endpoint.transport) {
+    // Data that overtook the handshake response.
+    return;
+  }
+  auto frames = endpoint.transport->decrypt_packet(packet);
+  if (!frames) {
+    return;
+  }
+
+  for (const auto& frame : *frames) {
+    if (frame.kind == mux::FrameKind::kData) {
+      deliver(dir, frame.data.payload);
+      if (endpoint.acks->on_packet_received(frame.data.stream_id, frame.data.sequence,
+                                            frame.data.fin)) {
+        send_ack(index, dir);
+      } else {
+        arm_ack_timer(index, dir);
+      }
+    } else if (frame.kind == mux::FrameKind::kAck) {
+      // ACKs travelling in `dir` acknowledge data sent the other way.
+      endpoint.transport->process_ack(frame.ack);
+      try_send(index, opposite(dir));
+    } else if (frame.kind == mux::FrameKind::kControl) {
+      if (const auto request = mux::parse_ack_frequency(frame.control)) {
+        endpoint.acks->on_ack_frequency(*request);
+      }
+    }
+  }
+}
+
+void Simulator::start_traffic(std::size_t index, Direction dir) {
+  auto& endpoint = sender(sessions_[index], dir);
+  const auto rate = directions_[dir].rate;
+  if (endpoint.traffic_started || rate <= 0.0) {
+    return;
+  }
+  endpoint.traffic_started = true;
+  events_.schedule_after(next_interval(sessions_[index], rate),
+                         [this, index, dir] { generate(index, dir); });
+}
+
+void Simulator::generate(std::size_t index, Direction dir) {
+  const auto now = clock_.now();
+  if (now >= traffic_end_) {
+    return;
+  }
+
+  auto& endpoint = sender(sessions_[index], dir);
+  auto& result = directions_[dir].result;
+  ++result.messages_offered;
+  if (endpoint.queue.size() >= config_.sender.max_queued_messages) {
+    ++result.messages_dropped_sender;
+  } else {
+    endpoint.queue.push_back(PendingMessage{endpoint.next_message_id++, now});
+    try_send(index, dir);
+  }
+
+  events_.schedule_after(next_interval(sessions_[index], directions_[dir].rate),
+                         [this, index, dir] { generate(index, dir); });
+}
+
+void Simulator::try_send(std::size_t index, Direction dir) {
+  auto& endpoint = sender(sessions_[index], dir);
+  if (!endpoint.transport) {
+    return;
+  }
+
+  auto& result = directions_[dir].result;
+  const auto& sender_config = config_.sender;
+  const auto now = clock_.now();
+  while (!endpoint.queue.empty()) {
+    if (sender_config.max_in_flight > 0 &&
+        endpoint.transport->packets_in_flight() >= sender_config.max_in_flight) {
+      break;
+    }
+    if (sender_config.pacing_rate_bps > 0 && endpoint.pace_next > now) {
+      arm_send(index, dir, endpoint.pace_next);
+      break;
+    }
+
+    const auto payload = make_payload(endpoint.queue.front());
+    endpoint.queue.pop_front();
+    ++result.messages_sent;
+    for (auto& packet : endpoint.transport->encrypt_data(payload, kStreamId, false)) {
+      ++result.data_packets_sent;
+      result.wire_bytes_sent += packet.size();
+      if (sender_config.pacing_rate_bps > 0) {
+        const auto tx_ns = static_cast<std::int64_t>(packet.size() * 8U * 1000000000ULL /
+                                                     sender_config.pacing_rate_bps);
+        endpoint.pace_next = std::max(endpoint.pace_next, now) + std::chrono::nanoseconds(tx_ns);
+      }
+      transmit(index, dir, std::move(packet), PacketKind::kTransport);
+    }
+  }
+
+  if (endpoint.transport->packets_in_flight() > 0) {
+    arm_retransmit(index, dir);
+  }
+}
+
+void Simulator::poll_retransmits(std::size_t index, Direction dir) {
+  auto& endpoint = sender(sessions_[index], dir);
+  endpoint.retransmit_armed = false;
+  if (!endpoint.transport) {
+    return;
+  }
+
+  auto& result = directions_[dir].result;
+  for (auto& packet : endpoint.transport->get_retransmit_packets()) {
+    ++result.retransmits;
+    result.wire_bytes_sent += packet.size();
+    transmit(index, dir, std::move(packet), PacketKind::kTransport);
+  }
+  // FEC repairs for a block that timed out.
+  for (auto& packet : endpoint.transport->get_fec_packets()) {
+    result.wire_bytes_sent += packet.size();
+    transmit(index, dir, std::move(packet), PacketKind::kTransport);
+  }
+  // Packets given up on free window space.
+  try_send(index, dir);
+}
+
+void Simulator::arm_send(std::size_t index, Direction dir, TimePoint at) {
+  auto& endpoint = sender(sessions_[index], dir);
+  if (endpoint.send_armed) {
+    return;
+  }
+  endpoint.send_armed = true;
+  events_.schedule_at(at, [this, index, dir] {
+    sender(sessions_[index], dir).send_armed = false;
+    try_send(index, dir);
+  });
+}
+
+void Simulator::arm_retransmit(std::size_t index, Direction dir) {
+  auto& endpoint = sender(sessions_[index], dir);
+  if (endpoint.retransmit_armed) {
+    return;
+  }
+  endpoint.retransmit_armed = true;
+  events_.schedule_after(config_.timer_granularity,
+                         [this, index, dir] { poll_retransmits(index, dir); });
+}
+
+void Simulator::send_ack(std::size_t index, Direction data_dir) {
+  auto& endpoint = receiver(sessions_[index], data_dir);
+  auto packet = endpoint.transport->encrypt_ack(kStreamId);
+  endpoint.acks->ack_sent(kStreamId);
+
+  auto& result = directions_[data_dir].result;
+  ++result.acks_sent;
+  result.wire_bytes_sent += packet.size();
+  transmit(index, opposite(data_dir), std::move(packet), PacketKind::kTransport);
+  // Loss reports for the sender's FEC ride along with ACKs.
+  for (auto& report : endpoint.transport->get_fec_packets()) {
+    result.wire_bytes_sent += report.size();
+    transmit(index, opposite(data_dir), std::move(report), PacketKind::kTransport);
+  }
+}
+
+void Simulator::arm_ack_timer(std::size_t index, Direction data_dir) {
+  auto& endpoint = receiver(sessions_[index], data_dir);
+  if (endpoint.ack_armed || !endpoint.acks) {
+    return;
+  }
+  const auto wait = endpoint.acks->time_until_next_ack();
+  if (!wait) {
+    return;
+  }
+  endpoint.ack_armed = true;
+  events_.schedule_after(*wait, [this, index, data_dir] { on_ack_timer(index, data_dir); });
+}
+
+void Simulator::on_ack_timer(std::size_t index, Direction data_dir) {
+  auto& endpoint = receiver(sessions_[index], data_dir);
+  endpoint.ack_armed = false;
+  if (!endpoint.acks) {
+    return;
+  }
+  if (endpoint.acks->check_ack_timer()) {
+    send_ack(index, data_dir);
+  }
+  arm_ack_timer(index, data_dir);
+}
+
+void Simulator::deliver(Direction dir, const std::vector<std::uint8_t>& payload) {
+  if (payload.size() < kMinMessageSize) {
+    return;
+  }
+  std::int64_t created_ns = 0;
+  std::memcpy(&created_ns, payload.data() + sizeof(std::uint64_t), sizeof(created_ns));
+
+  const auto now = clock_.now();
+  const auto latency = now - (origin_ + std::chrono::nanoseconds(created_ns));
+  auto& state = directions_[dir];
+  ++state.result.messages_delivered;
+  state.result.bytes_delivered += payload.size();
+  state.latencies_ms.push_back(std::chrono::duration<double, std::milli>(latency).count());
+
+  if (now < traffic_end_) {
+    state.bytes_in_duration += payload.size();
+  }
+  const auto bucket = static_cast<std::size_t>((now - origin_) / config_.sample_interval);
+  state.timeline_bytes[std::min(bucket, state.timeline_bytes.size() - 1)] += payload.size();
+}
+
+std::vector<std::uint8_t> Simulator::make_payload(const PendingMessage& message) const {
+  const auto created_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(message.created - origin_).count();
+  std::array<std::uint8_t, kMinMessageSize> header{};
+  std::memcpy(header.data(), &message.id, sizeof(message.id));
+  std::memcpy(header.data() + sizeof(message.id), &created_ns, sizeof(created_ns));
+
+  std::vector<std::uint8_t> payload(header.begin(), header.end());
+  payload.resize(message_size_, 0x5A);
+  return payload;
+}
+
+std::chrono::nanoseconds Simulator::next_interval(Session& session, double rate) {
+  double seconds = 1.0 / rate;
+  if (config_.traffic.poisson) {
+    std::exponential_distribution<double> dist(rate);
+    seconds = dist(session.rng);
+  }
+  return std::max(std::chrono::nanoseconds(1),
+                  std::chrono::nanoseconds(static_cast<std::int64_t>(seconds * 1e9)));
+}
+
+DirectionResult Simulator::finish(DirectionState& state) {
+  auto result = state.result;
+  const auto seconds = std::chrono::duration<double>(config_.duration).count();
+  if (seconds > 0.0) {
+    result.goodput_bps = static_cast<double>(state.bytes_in_duration) * 8.0 / seconds;
+  }
+  if (result.messages_offered > 0) {
+    result.delivery_ratio = static_cast<double>(result.messages_delivered) /
+                            static_cast<double>(result.messages_offered);
+  }
+
+  auto& latencies = state.latencies_ms;
+  std::sort(latencies.begin(), latencies.end());
+  if (!latencies.empty()) {
+    double sum = 0.0;
+    for (const auto value : latencies) {
+      sum += value;
+    }
+    result.latency.mean_ms = sum / static_cast<double>(latencies.size());
+    result.latency.p50_ms = percentile(latencies, 0.50);
+    result.latency.p90_ms = percentile(latencies, 0.90);
+    result.latency.p99_ms = percentile(latencies, 0.99);
+    result.latency.max_ms = latencies.back();
+  }
+
+  const auto bucket_seconds = std::chrono::duration<double>(config_.sample_interval).count();
+  for (const auto bytes : state.timeline_bytes) {
+    result.goodput_timeline_bps.push_back(static_cast<double>(bytes) * 8.0 / bucket_seconds);
+  }
+  return result;
+}
+
+}  // namespace
+
+SimulationResult run_simulation(const SimulationConfig& config) {
+  Simulator simulator(config);
+  return simulator.run();
+}
+
+}  // namespace veil::sim
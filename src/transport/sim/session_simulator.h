@@ -0,0 +1,142 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "transport/impairment/network_impairment.h"
+#include "transport/mux/ack_scheduler.h"
+#include "transport/session/transport_session.h"
+
+namespace veil::sim {
+
+// Application traffic offered by every session.
+struct TrafficConfig {
+  // Payload bytes per message. Clamped to [kMinMessageSize,
+  // max_fragment_size] so every message travels as one datagram.
+  std::size_t message_size{1000};
+  // Mean messages per second per session in each direction (0 = idle).
+  double uplink_rate{20.0};
+  double downlink_rate{100.0};
+  // Exponential inter-arrival times instead of constant spacing.
+  bool poisson{true};
+};
+
+// Sender-side rate control.
+//
+// The transport has no congestion controller, so the simulator stands one
+// in with a fixed window and an optional pacer to explore those settings.
+struct SenderConfig {
+  // Maximum unacknowledged packets per session and direction (0 = unlimited).
+  std::size_t max_in_flight{0};
+  // Pacing rate per session and direction in bits per second (0 = off).
+  std::uint64_t pacing_rate_bps{0};
+  // Messages queued behind the window or pacer before new ones are dropped.
+  std::size_t max_queued_messages{1024};
+};
+
+struct SimulationConfig {
+  std::size_t sessions{100};
+  // Time during which applications offer traffic.
+  std::chrono::milliseconds duration{10000};
+  // Extra time after `duration` for in-flight data and retransmits to land.
+  std::chrono::milliseconds drain{2000};
+  // Session start times are spread evenly over this interval.
+  std::chrono::milliseconds session_ramp{1000};
+  // Client re-sends its handshake if no response arrives within this time.
+  std::chrono::milliseconds handshake_timeout{1000};
+  // How often an endpoint with unacknowledged data polls for retransmits,
+  // mirroring the client/server event loop tick.
+  std::chrono::milliseconds timer_granularity{10};
+  // Width of the goodput timeline buckets.
+  std::chrono::milliseconds sample_interval{1000};
+  // Master seed. Link, traffic and arrival randomness is derived from it;
+  // the `seed` fields of the link configs below are ignored.
+  std::uint64_t seed{1};
+
+  // Per-session access links.
+  transport::ImpairmentConfig uplink;
+  transport::ImpairmentConfig downlink;
+  // Links shared by all sessions, traversed after the access link. A
+  // default-constructed config means no shared bottleneck.
+  transport::ImpairmentConfig shared_uplink;
+  transport::ImpairmentConfig shared_downlink;
+
+  transport::TransportSessionConfig transport;
+  mux::AckSchedulerConfig ack;
+  SenderConfig sender;
+  TrafficConfig traffic;
+};
+
+struct LatencySummary {
+  double mean_ms{0.0};
+  double p50_ms{0.0};
+  double p90_ms{0.0};
+  double p99_ms{0.0};
+  double max_ms{0.0};
+};
+
+// Results for one direction of traffic, summed over all sessions.
+struct DirectionResult {
+  // Messages generated by the application.
+  std::uint64_t messages_offered{0};
+  // Messages dropped because the sender queue was full.
+  std::uint64_t messages_dropped_sender{0};
+  // Messages handed to the transport.
+  std::uint64_t messages_sent{0};
+  // Messages that reached the receiving application.
+  std::uint64_t messages_delivered{0};
+  // Application payload bytes delivered.
+  std::uint64_t bytes_delivered{0};
+
+  // Wire activity: data packets (first transmissions), retransmissions and
+  // ACK packets sent in the reverse direction for this traffic.
+  std::uint64_t data_packets_sent{0};
+  std::uint64_t retransmits{0};
+  std::uint64_t acks_sent{0};
+  std::uint64_t wire_bytes_sent{0};
+  // Packets of any kind dropped by the link models in this direction.
+  std::uint64_t wire_packets_lost{0};
+
+  // Payload bits per second delivered while traffic was offered, i.e.
+  // excluding the drain period.
+  double goodput_bps{0.0};
+  // messages_delivered / messages_offered.
+  double delivery_ratio{0.0};
+  // Application-to-application latency, including time queued at the sender.
+  LatencySummary latency;
+  // Delivered payload bits per second for each sample_interval bucket.
+  std::vector<double> goodput_timeline_bps;
+};
+
+struct SimulationResult {
+  std::size_t sessions{0};
+  std::size_t sessions_established{0};
+  std::uint64_t handshake_attempts{0};
+  DirectionResult uplink;
+  DirectionResult downlink;
+
+  std::uint64_t events_processed{0};
+  std::chrono::nanoseconds virtual_time{0};
+  std::chrono::nanoseconds wall_time{0};
+
+  // Virtual seconds simulated per wall-clock second.
+  double speedup() const {
+    if (wall_time.count() == 0) return 0.0;
+    return static_cast<double>(virtual_time.count()) / static_cast<double>(wall_time.count());
+  }
+};
+
+// Smallest message that fits the simulator's latency-tracking header.
+constexpr std::size_t kMinMessageSize = 16;
+
+// Run client and server TransportSessions for `config.sessions` clients over
+// modelled links on virtual time.
+//
+// Every session performs a real handshake and exchanges real encrypted
+// packets; only the network and the clock are simulated. Apart from
+// wall_time, the result is a pure function of `config`.
+SimulationResult run_simulation(const SimulationConfig& config);
+
+}  // namespace veil::sim
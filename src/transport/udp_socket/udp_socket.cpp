@@ -2,8 +2,11 @@
 
 #include <arpa/inet.h>
 #include <cerrno>
+#include <ctime>
+#include <linux/net_tstamp.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -38,6 +41,110 @@ bool resolve(const veil::transport::UdpEndpoint& endpoint, sockaddr_in& addr) {
   return true;
 }
 
+// Kernel limits on one GSO send: UDP_MAX_SEGMENTS on older kernels, and
+// the largest UDP payload over IPv4.
+constexpr std::size_t kMaxGsoSegments = 64;
+constexpr std::size_t kMaxGsoBytes = 65507;
+
+// Ancillary data for an outgoing datagram: IP_TOS, SCM_TXTIME and
+// UDP_SEGMENT.
+union SendControl {
+  cmsghdr header;
+  std::array<std::uint8_t, CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(std::uint64_t)) +
+                               CMSG_SPACE(sizeof(std::uint16_t))>
+      buffer;
+};
+
+// Attach an ECN codepoint, a departure time in CLOCK_MONOTONIC
+// nanoseconds and a GSO segment size to `msg`, each only if non-zero.
+void set_send_control(msghdr& msg, SendControl& control, std::uint8_t ecn, std::uint64_t txtime_ns,
+                      std::uint16_t gso_size = 0) {
+  msg.msg_control = nullptr;
+  msg.msg_controllen = 0;
+  if (ecn == 0 && txtime_ns == 0 && gso_size == 0) {
+    return;
+  }
+  std::memset(&control, 0, sizeof(control));
+  msg.msg_control = control.buffer.data();
+  msg.msg_controllen = sizeof(control.buffer);
+  std::size_t used = 0;
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (ecn != 0) {
+    cmsg->cmsg_level = IPPROTO_IP;
+    cmsg->cmsg_type = IP_TOS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    const int tos = ecn & 0x03;
+    std::memcpy(CMSG_DATA(cmsg), &tos, sizeof(tos));
+    used += CMSG_SPACE(sizeof(int));
+    cmsg = CMSG_NXTHDR(&msg, cmsg);
+  }
+#ifdef SCM_TXTIME
+  if (txtime_ns != 0) {
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_TXTIME;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(txtime_ns));
+    std::memcpy(CMSG_DATA(cmsg), &txtime_ns, sizeof(txtime_ns));
+    used += CMSG_SPACE(sizeof(txtime_ns));
+    cmsg = CMSG_NXTHDR(&msg, cmsg);
+  }
+#endif
+#ifdef UDP_SEGMENT
+  if (gso_size != 0) {
+    cmsg->cmsg_level = IPPROTO_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(gso_size));
+    std::memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+    used += CMSG_SPACE(sizeof(gso_size));
+  }
+#endif
+  msg.msg_controllen = used;
+  if (used == 0) {
+    msg.msg_control = nullptr;
+  }
+}
+
+std::uint64_t txtime_of(const veil::transport::UdpPacket& packet) {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(packet.departure.time_since_epoch())
+          .count());
+}
+
+// Number of packets from `first` that can go out as one GSO send: same
+// peer, ECN and departure time, and the size of the first except for a
+// shorter last one.
+std::size_t gso_run_length(std::span<const veil::transport::UdpPacket> packets,
+                           std::size_t first) {
+  const auto& head = packets[first];
+  const std::size_t segment = head.data.size();
+  std::size_t total = segment;
+  std::size_t count = 1;
+  while (segment != 0 && first + count < packets.size() && count < kMaxGsoSegments) {
+    const auto& next = packets[first + count];
+    if (next.remote != head.remote || next.ecn != head.ecn || next.departure != head.departure ||
+        next.data.empty() || next.data.size() > segment ||
+        total + next.data.size() > kMaxGsoBytes) {
+      break;
+    }
+    total += next.data.size();
+    ++count;
+    if (next.data.size() < segment) {
+      break;
+    }
+  }
+  return count;
+}
+
+// ECN bits of a received IP_TOS control message, or 0 if absent.
+std::uint8_t read_tos_ecn(msghdr& msg) {
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_TOS &&
+        cmsg->cmsg_len >= CMSG_LEN(1)) {
+      return static_cast<std::uint8_t>(*CMSG_DATA(cmsg) & 0x03);
+    }
+  }
+  return 0;
+}
+
 void fill_endpoint(const sockaddr_in& addr, veil::transport::UdpEndpoint& endpoint) {
   std::array<char, INET_ADDRSTRLEN> buffer{};
   const char* res = inet_ntop(AF_INET, &addr.sin_addr, buffer.data(), buffer.size());
@@ -120,54 +227,125 @@ bool UdpSocket::send(std::span<const std::uint8_t> data, const UdpEndpoint& remo
   return true;
 }
 
+bool UdpSocket::send(std::span<const std::uint8_t> data, const UdpEndpoint& remote,
+                     std::uint8_t ecn, std::error_code& ec) {
+  if (ecn == 0) {
+    return send(data, remote, ec);
+  }
+  return send_message(data, remote, ecn, 0, ec);
+}
+
+bool UdpSocket::send(const UdpPacket& packet, std::error_code& ec) {
+  const auto txtime_ns = txtime_enabled_ ? txtime_of(packet) : 0;
+  if (packet.ecn == 0 && txtime_ns == 0) {
+    return send(packet.data, packet.remote, ec);
+  }
+  return send_message(packet.data, packet.remote, packet.ecn, txtime_ns, ec);
+}
+
+bool UdpSocket::send_message(std::span<const std::uint8_t> data, const UdpEndpoint& remote,
+                             std::uint8_t ecn, std::uint64_t txtime_ns, std::error_code& ec) {
+  sockaddr_in addr{};
+  if (!resolve(remote, addr)) {
+    ec = std::make_error_code(std::errc::invalid_argument);
+    return false;
+  }
+  iovec iov{const_cast<std::uint8_t*>(data.data()), data.size()};
+  msghdr msg{};
+  msg.msg_name = &addr;
+  msg.msg_namelen = sizeof(addr);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  SendControl control{};
+  set_send_control(msg, control, ecn, txtime_ns);
+  const auto sent = ::sendmsg(fd_, &msg, 0);
+  if (sent < 0 || static_cast<std::size_t>(sent) != data.size()) {
+    ec = last_error();
+    return false;
+  }
+  return true;
+}
+
 bool UdpSocket::send_batch(std::span<const UdpPacket> packets, std::error_code& ec) {
   if (packets.empty()) {
     return true;
   }
+  // Packets not yet sent when sendmmsg is unavailable.
+  std::size_t fallback_from = 0;
 
 #if VEIL_HAS_SENDMMSG
   // Use sendmmsg for better performance when available.
-  std::vector<mmsghdr> messages(packets.size());
+  std::vector<mmsghdr> messages;
+  messages.reserve(packets.size());
+  // Index of each message's first packet.
+  std::vector<std::size_t> firsts;
+  firsts.reserve(packets.size());
   std::vector<sockaddr_in> addrs(packets.size());
   std::vector<iovec> iovecs(packets.size());
-  for (std::size_t i = 0; i < packets.size(); ++i) {
-    if (!resolve(packets[i].remote, addrs[i])) {
+  std::vector<SendControl> controls(packets.size());
+  for (std::size_t i = 0; i < packets.size();) {
+    const std::size_t count = gso_enabled_ ? gso_run_length(packets, i) : 1;
+    auto& addr = addrs[messages.size()];
+    if (!resolve(packets[i].remote, addr)) {
       ec = std::make_error_code(std::errc::invalid_argument);
       return false;
     }
-    iovecs[i].iov_base = const_cast<std::uint8_t*>(packets[i].data.data());
-    iovecs[i].iov_len = packets[i].data.size();
-    messages[i].msg_hdr.msg_name = &addrs[i];
-    messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
-    messages[i].msg_hdr.msg_iov = &iovecs[i];
-    messages[i].msg_hdr.msg_iovlen = 1;
-    messages[i].msg_hdr.msg_control = nullptr;
-    messages[i].msg_hdr.msg_controllen = 0;
-    messages[i].msg_hdr.msg_flags = 0;
-    messages[i].msg_len = 0;
+    for (std::size_t k = i; k < i + count; ++k) {
+      iovecs[k].iov_base = const_cast<std::uint8_t*>(packets[k].data.data());
+      iovecs[k].iov_len = packets[k].data.size();
+    }
+    mmsghdr message{};
+    message.msg_hdr.msg_name = &addr;
+    message.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    message.msg_hdr.msg_iov = &iovecs[i];
+    message.msg_hdr.msg_iovlen = count;
+    set_send_control(message.msg_hdr, controls[messages.size()], packets[i].ecn,
+                     txtime_enabled_ ? txtime_of(packets[i]) : 0,
+                     count > 1 ? static_cast<std::uint16_t>(packets[i].data.size()) : 0);
+    messages.push_back(message);
+    firsts.push_back(i);
+    i += count;
   }
-  const auto sent =
-      ::sendmmsg(fd_, messages.data(), static_cast<unsigned int>(messages.size()), 0);
-  if (sent < 0) {
+
+  // sendmmsg stops at the first message that fails and reports how many
+  // went out; only a call starting with the failing message returns its
+  // errno. So resend from the first unsent message until all are sent or
+  // one fails on its own.
+  std::size_t done = 0;
+  while (done < messages.size()) {
+    const auto sent = ::sendmmsg(fd_, messages.data() + done,
+                                 static_cast<unsigned int>(messages.size() - done), 0);
+    if (sent > 0) {
+      done += static_cast<std::size_t>(sent);
+      continue;
+    }
+    if (sent == 0) {
+      ec = std::make_error_code(std::errc::io_error);
+      return false;
+    }
+    // The egress device cannot checksum GSO sends; segment the rest in
+    // userspace.
+    if (errno == EIO && messages[done].msg_hdr.msg_iovlen > 1) {
+      LOG_WARN("UDP GSO send failed, disabling GSO");
+      gso_enabled_ = false;
+      return send_batch(packets.subspan(firsts[done]), ec);
+    }
     // If sendmmsg fails with EPERM (sandbox/container), fall back to sendto.
     if (errno == EPERM || errno == ENOSYS) {
       LOG_DEBUG("sendmmsg failed with {}, falling back to sendto", errno);
-      goto fallback;
+      fallback_from = firsts[done];
+      break;
     }
     ec = last_error();
     return false;
   }
-  if (static_cast<std::size_t>(sent) != packets.size()) {
-    ec = last_error();
-    return false;
+  if (done == messages.size()) {
+    return true;
   }
-  return true;
-
-fallback:
 #endif
   // Fallback: send each packet individually with sendto.
-  for (const auto& pkt : packets) {
-    if (!send(pkt.data, pkt.remote, ec)) {
+  for (const auto& pkt : packets.subspan(fallback_from)) {
+    if (!send(pkt, ec)) {
       return false;
     }
   }
@@ -208,26 +386,96 @@ bool UdpSocket::poll(const ReceiveHandler& handler, int timeout_ms, std::error_c
       continue;
     }
     sockaddr_in src{};
-    socklen_t src_len = sizeof(src);
-    const auto read =
-        ::recvfrom(fd_, buffer.data(), buffer.size(), 0, reinterpret_cast<sockaddr*>(&src), &src_len);
+    iovec iov{buffer.data(), buffer.size()};
+    std::array<std::uint8_t, CMSG_SPACE(sizeof(int))> control{};
+    msghdr msg{};
+    msg.msg_name = &src;
+    msg.msg_namelen = sizeof(src);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (ecn_enabled_) {
+      msg.msg_control = control.data();
+      msg.msg_controllen = control.size();
+    }
+    const auto read = ::recvmsg(fd_, &msg, 0);
     if (read <= 0) {
       continue;
     }
     UdpEndpoint remote{};
     fill_endpoint(src, remote);
-    handler(UdpPacket{std::vector<std::uint8_t>(buffer.begin(), buffer.begin() + read), remote});
+    const std::uint8_t ecn = ecn_enabled_ ? read_tos_ecn(msg) : 0;
+    handler(
+        UdpPacket{std::vector<std::uint8_t>(buffer.begin(), buffer.begin() + read), remote, ecn});
   }
 
   ::close(ep);
   return true;
 }
 
+bool UdpSocket::enable_ecn(std::error_code& ec) {
+  const int enable = 1;
+  if (setsockopt(fd_, IPPROTO_IP, IP_RECVTOS, &enable, sizeof(enable)) != 0) {
+    ec = last_error();
+    return false;
+  }
+  ecn_enabled_ = true;
+  return true;
+}
+
+bool UdpSocket::enable_txtime(std::error_code& ec) {
+#ifdef SO_TXTIME
+  sock_txtime config{};
+  config.clockid = CLOCK_MONOTONIC;
+  config.flags = 0;
+  if (setsockopt(fd_, SOL_SOCKET, SO_TXTIME, &config, sizeof(config)) != 0) {
+    ec = last_error();
+    return false;
+  }
+  txtime_enabled_ = true;
+  return true;
+#else
+  ec = std::make_error_code(std::errc::operation_not_supported);
+  return false;
+#endif
+}
+
+bool UdpSocket::enable_gso(std::error_code& ec) {
+#ifdef UDP_SEGMENT
+  // Also the probe for kernel support: a zero default segment size leaves
+  // sends without a UDP_SEGMENT control message unsegmented.
+  const int segment_size = 0;
+  if (setsockopt(fd_, IPPROTO_UDP, UDP_SEGMENT, &segment_size, sizeof(segment_size)) != 0) {
+    ec = last_error();
+    return false;
+  }
+  gso_enabled_ = true;
+  return true;
+#else
+  ec = std::make_error_code(std::errc::operation_not_supported);
+  return false;
+#endif
+}
+
+std::uint16_t UdpSocket::local_port() const {
+  if (fd_ < 0) {
+    return 0;
+  }
+  sockaddr_in addr{};
+  socklen_t len = sizeof(addr);
+  if (::getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+    return 0;
+  }
+  return ntohs(addr.sin_port);
+}
+
 void UdpSocket::close() {
   if (fd_ >= 0) {
     ::close(fd_);
     fd_ = -1;
   }
+  ecn_enabled_ = false;
+  txtime_enabled_ = false;
+  gso_enabled_ = false;
 }
 
 }  // namespace veil::transport
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -14,11 +15,20 @@ namespace veil::transport {
 struct UdpEndpoint {
   std::string host;
   std::uint16_t port{0};
+
+  friend bool operator==(const UdpEndpoint&, const UdpEndpoint&) = default;
 };
 
 struct UdpPacket {
   std::vector<std::uint8_t> data;
   UdpEndpoint remote;
+  // ECN codepoint of the outer IP header (RFC 3168, 0 = Not-ECT). Filled
+  // in on receive when ECN is enabled; applied on send when non-zero.
+  std::uint8_t ecn{0};
+  // Earliest departure time on a socket with SO_TXTIME enabled; the
+  // kernel's fq qdisc holds the datagram until then. The default (clock
+  // epoch) sends at once. Ignored on receive and without SO_TXTIME.
+  std::chrono::steady_clock::time_point departure{};
 };
 
 class UdpSocket {
@@ -31,17 +41,55 @@ class UdpSocket {
   bool open(std::uint16_t bind_port, bool reuse_port, std::error_code& ec);
   bool connect(const UdpEndpoint& remote, std::error_code& ec);
   bool send(std::span<const std::uint8_t> data, const UdpEndpoint& remote, std::error_code& ec);
+  // Send with the given ECN codepoint in the outer IP header.
+  bool send(std::span<const std::uint8_t> data, const UdpEndpoint& remote, std::uint8_t ecn,
+            std::error_code& ec);
+  // Send with the packet's ECN codepoint and, if SO_TXTIME is enabled,
+  // departure time.
+  bool send(const UdpPacket& packet, std::error_code& ec);
+  // Send with one sendmmsg call. With GSO enabled, each run of adjacent
+  // packets to the same peer with equal size, ECN and departure time (the
+  // last may be shorter) goes out as one message the kernel segments.
   bool send_batch(std::span<const UdpPacket> packets, std::error_code& ec);
   bool poll(const ReceiveHandler& handler, int timeout_ms, std::error_code& ec);
   void close();
 
+  // Report the ECN codepoint of received datagrams in UdpPacket::ecn
+  // (IP_RECVTOS). Callers that set ECT on outgoing datagrams must enable
+  // this, or the CE marks the path applies in place of drops are lost.
+  bool enable_ecn(std::error_code& ec);
+  bool ecn_enabled() const { return ecn_enabled_; }
+
+  // Accept departure times on outgoing datagrams (SO_TXTIME on
+  // CLOCK_MONOTONIC, the clock behind std::chrono::steady_clock on Linux).
+  // Times only take effect under the fq qdisc; elsewhere datagrams leave
+  // at once. Fails where the kernel lacks SO_TXTIME.
+  bool enable_txtime(std::error_code& ec);
+  bool txtime_enabled() const { return txtime_enabled_; }
+
+  // Coalesce runs in send_batch() into UDP GSO sends (UDP_SEGMENT, Linux
+  // 4.18+). Fails where the kernel lacks it. If a send later fails because
+  // the route cannot segment, GSO is turned off and the batch resent.
+  bool enable_gso(std::error_code& ec);
+  bool gso_enabled() const { return gso_enabled_; }
+
   int fd() const { return fd_; }
 
+  // Port the socket is bound to (useful after binding to port 0).
+  // Returns 0 if the socket is not open.
+  std::uint16_t local_port() const;
+
  private:
   int fd_{-1};
   UdpEndpoint connected_;
+  bool ecn_enabled_{false};
+  bool txtime_enabled_{false};
+  bool gso_enabled_{false};
 
   bool configure_socket(bool reuse_port, std::error_code& ec);
+  // sendmsg() with an ECN codepoint and departure time (0 = none).
+  bool send_message(std::span<const std::uint8_t> data, const UdpEndpoint& remote, std::uint8_t ecn,
+                    std::uint64_t txtime_ns, std::error_code& ec);
 };
 
 }  // namespace veil::transport
@@ -0,0 +1,354 @@
+#include "tun/ip_packet.h"
+
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <charconv>
+
+namespace veil::tun {
+
+namespace {
+
+constexpr std::size_t kIpv4MinHeader = 20;
+constexpr std::size_t kIpv6Header = 40;
+constexpr std::uint8_t kProtoTcp = 6;
+constexpr std::uint8_t kProtoUdp = 17;
+constexpr std::uint8_t kProtoSctp = 132;
+
+bool has_ports(std::uint8_t protocol) {
+  return protocol == kProtoTcp || protocol == kProtoUdp || protocol == kProtoSctp;
+}
+
+std::uint16_t read_u16(std::span<const std::uint8_t> bytes, std::size_t offset) {
+  return static_cast<std::uint16_t>((bytes[offset] << 8) | bytes[offset + 1]);
+}
+
+void read_ports(std::span<const std::uint8_t> packet, std::size_t offset, FlowKey& key) {
+  if (has_ports(key.protocol) && packet.size() >= offset + 4) {
+    key.src_port = read_u16(packet, offset);
+    key.dst_port = read_u16(packet, offset + 2);
+  }
+}
+
+std::uint32_t read_u32(std::span<const std::uint8_t> bytes, std::size_t offset) {
+  return (static_cast<std::uint32_t>(read_u16(bytes, offset)) << 16) | read_u16(bytes, offset + 2);
+}
+
+std::size_t ipv4_header_length(std::span<const std::uint8_t> packet) {
+  if (packet.size() < kIpv4MinHeader || (packet[0] >> 4) != 4) {
+    return 0;
+  }
+  const std::size_t ihl = static_cast<std::size_t>(packet[0] & 0x0F) * 4;
+  return ihl >= kIpv4MinHeader && ihl <= packet.size() ? ihl : 0;
+}
+
+// FNV-1a over a byte range.
+std::uint32_t fnv1a(std::uint32_t hash, std::span<const std::uint8_t> bytes) {
+  for (const auto byte : bytes) {
+    hash ^= byte;
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+}  // namespace
+
+std::optional<FlowKey> parse_flow_key(std::span<const std::uint8_t> packet) {
+  if (packet.empty()) {
+    return std::nullopt;
+  }
+  FlowKey key;
+  key.ip_version = static_cast<std::uint8_t>(packet[0] >> 4);
+
+  if (key.ip_version == 4) {
+    const std::size_t ihl = ipv4_header_length(packet);
+    if (ihl == 0) {
+      return std::nullopt;
+    }
+    key.protocol = packet[9];
+    std::copy_n(packet.begin() + 12, 4, key.src.begin());
+    std::copy_n(packet.begin() + 16, 4, key.dst.begin());
+    // Only the first fragment carries the transport header.
+    const bool later_fragment = (read_u16(packet, 6) & 0x1FFF) != 0;
+    if (!later_fragment) {
+      read_ports(packet, ihl, key);
+    }
+    return key;
+  }
+
+  if (key.ip_version == 6) {
+    if (packet.size() < kIpv6Header) {
+      return std::nullopt;
+    }
+    key.protocol = packet[6];
+    std::copy_n(packet.begin() + 8, 16, key.src.begin());
+    std::copy_n(packet.begin() + 24, 16, key.dst.begin());
+    read_ports(packet, kIpv6Header, key);
+    return key;
+  }
+
+  return std::nullopt;
+}
+
+std::uint32_t flow_hash(const FlowKey& key, std::uint32_t seed) {
+  std::uint32_t hash = 2166136261U ^ seed;
+  hash = fnv1a(hash, key.src);
+  hash = fnv1a(hash, key.dst);
+  const std::array<std::uint8_t, 6> rest{
+      static_cast<std::uint8_t>(key.src_port >> 8), static_cast<std::uint8_t>(key.src_port),
+      static_cast<std::uint8_t>(key.dst_port >> 8), static_cast<std::uint8_t>(key.dst_port),
+      key.protocol, key.ip_version};
+  return fnv1a(hash, rest);
+}
+
+std::uint8_t dscp(std::span<const std::uint8_t> packet) {
+  if (ipv4_header_length(packet) != 0) {
+    return static_cast<std::uint8_t>(packet[1] >> 2);
+  }
+  if (packet.size() >= kIpv6Header && (packet[0] >> 4) == 6) {
+    return static_cast<std::uint8_t>(((packet[0] & 0x0F) << 2) | (packet[1] >> 6));
+  }
+  return 0;
+}
+
+Ecn ecn_codepoint(std::span<const std::uint8_t> packet) {
+  if (ipv4_header_length(packet) != 0) {
+    return static_cast<Ecn>(packet[1] & 0x03);
+  }
+  if (packet.size() >= kIpv6Header && (packet[0] >> 4) == 6) {
+    return static_cast<Ecn>((packet[1] >> 4) & 0x03);
+  }
+  return Ecn::kNotEct;
+}
+
+bool set_ecn_codepoint(std::span<std::uint8_t> packet, Ecn ecn) {
+  const auto bits = static_cast<std::uint8_t>(ecn);
+  const std::size_t ihl = ipv4_header_length(packet);
+  if (ihl != 0) {
+    packet[1] = static_cast<std::uint8_t>((packet[1] & 0xFC) | bits);
+    packet[10] = 0;
+    packet[11] = 0;
+    std::uint32_t sum = 0;
+    for (std::size_t i = 0; i < ihl; i += 2) {
+      sum += read_u16(packet, i);
+    }
+    while ((sum >> 16) != 0) {
+      sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    const auto checksum = static_cast<std::uint16_t>(~sum);
+    packet[10] = static_cast<std::uint8_t>(checksum >> 8);
+    packet[11] = static_cast<std::uint8_t>(checksum);
+    return true;
+  }
+  if (packet.size() >= kIpv6Header && (packet[0] >> 4) == 6) {
+    packet[1] = static_cast<std::uint8_t>((packet[1] & 0xCF) | (bits << 4));
+    return true;
+  }
+  return false;
+}
+
+std::optional<Ecn> decapsulated_ecn(Ecn inner, Ecn outer) {
+  if (outer == Ecn::kCe) {
+    if (inner == Ecn::kNotEct) {
+      return std::nullopt;
+    }
+    return Ecn::kCe;
+  }
+  // ECT(1) on the outside (an L4S marking) overrides ECT(0) inside.
+  if (outer == Ecn::kEct1 && inner == Ecn::kEct0) {
+    return Ecn::kEct1;
+  }
+  return inner;
+}
+
+bool apply_outer_ecn(std::span<std::uint8_t> packet, Ecn outer) {
+  if (outer == Ecn::kNotEct || outer == Ecn::kEct0) {
+    return true;
+  }
+  const auto inner = ecn_codepoint(packet);
+  const auto result = decapsulated_ecn(inner, outer);
+  if (!result) {
+    return false;
+  }
+  if (*result != inner) {
+    set_ecn_codepoint(packet, *result);
+  }
+  return true;
+}
+
+std::optional<std::uint32_t> ipv4_source(std::span<const std::uint8_t> packet) {
+  if (ipv4_header_length(packet) == 0) {
+    return std::nullopt;
+  }
+  return read_u32(packet, 12);
+}
+
+std::optional<std::uint32_t> ipv4_destination(std::span<const std::uint8_t> packet) {
+  if (ipv4_header_length(packet) == 0) {
+    return std::nullopt;
+  }
+  return read_u32(packet, 16);
+}
+
+std::optional<Ipv4Prefix> parse_ipv4_prefix(std::string_view text) {
+  if (text == "any") {
+    return Ipv4Prefix{};
+  }
+  Ipv4Prefix prefix;
+  prefix.length = 32;
+  const auto slash = text.find('/');
+  if (slash != std::string_view::npos) {
+    const auto len = text.substr(slash + 1);
+    unsigned value = 0;
+    const auto [end, ec] = std::from_chars(len.data(), len.data() + len.size(), value);
+    if (ec != std::errc{} || end != len.data() + len.size() || len.empty() || value > 32) {
+      return std::nullopt;
+    }
+    prefix.length = static_cast<std::uint8_t>(value);
+    text = text.substr(0, slash);
+  }
+
+  std::uint32_t address = 0;
+  const char* cursor = text.data();
+  const char* const last = text.data() + text.size();
+  for (int octet = 0; octet < 4; ++octet) {
+    if (octet > 0) {
+      if (cursor == last || *cursor != '.') {
+        return std::nullopt;
+      }
+      ++cursor;
+    }
+    unsigned value = 0;
+    const auto [end, ec] = std::from_chars(cursor, last, value);
+    if (ec != std::errc{} || end == cursor || end - cursor > 3 || value > 255) {
+      return std::nullopt;
+    }
+    address = (address << 8) | value;
+    cursor = end;
+  }
+  if (cursor != last) {
+    return std::nullopt;
+  }
+  prefix.address = address & prefix.mask();
+  return prefix;
+}
+
+std::span<const std::uint8_t> destination_address(std::span<const std::uint8_t> packet) {
+  if (ipv4_header_length(packet) != 0) {
+    return packet.subspan(16, 4);
+  }
+  if (packet.size() >= kIpv6Header && (packet[0] >> 4) == 6) {
+    return packet.subspan(24, 16);
+  }
+  return {};
+}
+
+bool IpPrefix::covers(const IpPrefix& other) const {
+  if (other.version != version || other.length < length) {
+    return false;
+  }
+  const std::size_t full = length / 8;
+  if (!std::equal(address.begin(), address.begin() + static_cast<std::ptrdiff_t>(full),
+                  other.address.begin())) {
+    return false;
+  }
+  const unsigned rest = length % 8;
+  if (rest == 0) {
+    return true;
+  }
+  const auto mask = static_cast<std::uint8_t>(0xFF << (8 - rest));
+  return ((address[full] ^ other.address[full]) & mask) == 0;
+}
+
+void IpPrefix::clear_host_bits() {
+  for (std::size_t bit = length; bit < address.size() * 8; ++bit) {
+    address[bit / 8] &= static_cast<std::uint8_t>(~(0x80U >> (bit % 8)));
+  }
+}
+
+IpPrefix to_ip_prefix(const Ipv4Prefix& prefix) {
+  IpPrefix out;
+  out.version = 4;
+  out.length = prefix.length;
+  for (std::size_t i = 0; i < 4; ++i) {
+    out.address[i] = static_cast<std::uint8_t>(prefix.address >> (24 - 8 * i));
+  }
+  return out;
+}
+
+std::optional<IpPrefix> parse_ip_prefix(std::string_view text) {
+  if (text.find(':') == std::string_view::npos) {
+    const auto v4 = parse_ipv4_prefix(text);
+    if (!v4 || text == "any") {
+      return std::nullopt;
+    }
+    return to_ip_prefix(*v4);
+  }
+
+  IpPrefix prefix;
+  prefix.version = 6;
+  prefix.length = 128;
+  const auto slash = text.find('/');
+  if (slash != std::string_view::npos) {
+    const auto len = text.substr(slash + 1);
+    unsigned value = 0;
+    const auto [end, ec] = std::from_chars(len.data(), len.data() + len.size(), value);
+    if (ec != std::errc{} || end != len.data() + len.size() || len.empty() || value > 128) {
+      return std::nullopt;
+    }
+    prefix.length = static_cast<std::uint8_t>(value);
+    text = text.substr(0, slash);
+  }
+  const std::string address(text);
+  if (inet_pton(AF_INET6, address.c_str(), prefix.address.data()) != 1) {
+    return std::nullopt;
+  }
+  prefix.clear_host_bits();
+  return prefix;
+}
+
+std::string format_ip_prefix(const IpPrefix& prefix) {
+  std::array<char, INET6_ADDRSTRLEN> buffer{};
+  const int family = prefix.version == 6 ? AF_INET6 : AF_INET;
+  if (inet_ntop(family, prefix.address.data(), buffer.data(), buffer.size()) == nullptr) {
+    return "?";
+  }
+  return std::string(buffer.data()) + "/" + std::to_string(prefix.length);
+}
+
+std::vector<std::uint8_t> encode_ip_prefixes(std::span<const IpPrefix> prefixes) {
+  std::vector<std::uint8_t> payload;
+  for (const auto& prefix : prefixes) {
+    payload.push_back(prefix.version);
+    payload.push_back(prefix.length);
+    payload.insert(payload.end(), prefix.address.begin(),
+                   prefix.address.begin() + static_cast<std::ptrdiff_t>(prefix.address_size()));
+  }
+  return payload;
+}
+
+std::optional<std::vector<IpPrefix>> decode_ip_prefixes(std::span<const std::uint8_t> payload) {
+  std::vector<IpPrefix> prefixes;
+  std::size_t offset = 0;
+  while (offset < payload.size()) {
+    if (payload.size() - offset < 2) {
+      return std::nullopt;
+    }
+    IpPrefix prefix;
+    prefix.version = payload[offset];
+    prefix.length = payload[offset + 1];
+    offset += 2;
+    if ((prefix.version != 4 && prefix.version != 6) || prefix.length > prefix.max_length() ||
+        payload.size() - offset < prefix.address_size()) {
+      return std::nullopt;
+    }
+    std::copy_n(payload.begin() + static_cast<std::ptrdiff_t>(offset), prefix.address_size(),
+                prefix.address.begin());
+    offset += prefix.address_size();
+    prefix.clear_host_bits();
+    prefixes.push_back(prefix);
+  }
+  return prefixes;
+}
+
+}  // namespace veil::tun
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace veil::tun {
+
+// ECN codepoints (RFC 3168), the low two bits of the IPv4 TOS / IPv6
+// traffic class byte.
+enum class Ecn : std::uint8_t {
+  kNotEct = 0b00,
+  kEct1 = 0b01,
+  kEct0 = 0b10,
+  kCe = 0b11,
+};
+
+// Transport 5-tuple of an IP packet. Addresses are stored as 16 bytes; IPv4
+// addresses occupy the first four. Ports are zero for protocols without them
+// and for non-first fragments.
+struct FlowKey {
+  std::array<std::uint8_t, 16> src{};
+  std::array<std::uint8_t, 16> dst{};
+  std::uint16_t src_port{0};
+  std::uint16_t dst_port{0};
+  std::uint8_t protocol{0};
+  std::uint8_t ip_version{0};
+
+  friend bool operator==(const FlowKey&, const FlowKey&) = default;
+};
+
+// Parse the 5-tuple of an IPv4 or IPv6 packet as read from the TUN device.
+// IPv6 extension headers are not walked; the next-header value is used as
+// the protocol. Returns nullopt for truncated or non-IP packets.
+std::optional<FlowKey> parse_flow_key(std::span<const std::uint8_t> packet);
+
+// Hash of a flow key, perturbed by `seed` so flow-to-bucket mapping is not
+// predictable from outside.
+std::uint32_t flow_hash(const FlowKey& key, std::uint32_t seed);
+
+// DSCP (the upper six bits of the IPv4 TOS / IPv6 traffic class byte) of
+// an IPv4 or IPv6 packet; 0 for anything else.
+std::uint8_t dscp(std::span<const std::uint8_t> packet);
+
+// ECN field of an IPv4 or IPv6 packet; kNotEct for anything else.
+Ecn ecn_codepoint(std::span<const std::uint8_t> packet);
+
+// Set the ECN field to `ecn`, updating the IPv4 header checksum. Returns
+// false if the packet is not a well-formed IPv4 or IPv6 header.
+bool set_ecn_codepoint(std::span<std::uint8_t> packet, Ecn ecn);
+
+// ECN of a packet leaving the tunnel (RFC 6040 section 4.2): the inner
+// codepoint combined with the outer one it arrived under. nullopt means the
+// packet must be dropped, because the path marked CE on a packet whose
+// sender cannot understand it.
+std::optional<Ecn> decapsulated_ecn(Ecn inner, Ecn outer);
+
+// Apply decapsulated_ecn() to an inner IP packet in place. Returns false if
+// the packet must be dropped.
+bool apply_outer_ecn(std::span<std::uint8_t> packet, Ecn outer);
+
+// Source and destination of an IPv4 packet in host byte order; nullopt for
+// anything else.
+std::optional<std::uint32_t> ipv4_source(std::span<const std::uint8_t> packet);
+std::optional<std::uint32_t> ipv4_destination(std::span<const std::uint8_t> packet);
+
+// An IPv4 prefix, address in host byte order.
+struct Ipv4Prefix {
+  std::uint32_t address{0};
+  std::uint8_t length{0};
+
+  std::uint32_t mask() const { return length == 0 ? 0 : ~std::uint32_t{0} << (32 - length); }
+  bool contains(std::uint32_t ip) const { return ((ip ^ address) & mask()) == 0; }
+
+  friend bool operator==(const Ipv4Prefix&, const Ipv4Prefix&) = default;
+};
+
+// Parse "a.b.c.d/len", a bare address (a /32) or "any" (0.0.0.0/0). Host
+// bits past the prefix length are cleared.
+std::optional<Ipv4Prefix> parse_ipv4_prefix(std::string_view text);
+
+// Destination address bytes of an IPv4 (4 bytes) or IPv6 (16 bytes)
+// packet, pointing into `packet`; empty for anything else.
+std::span<const std::uint8_t> destination_address(std::span<const std::uint8_t> packet);
+
+// An IPv4 or IPv6 prefix. Address bytes are in network order; bytes past
+// address_size() are zero.
+struct IpPrefix {
+  std::uint8_t version{4};
+  std::array<std::uint8_t, 16> address{};
+  std::uint8_t length{0};
+
+  std::size_t address_size() const { return version == 6 ? 16 : 4; }
+  std::uint8_t max_length() const { return static_cast<std::uint8_t>(address_size() * 8); }
+
+  // Whether `other` lies entirely within this prefix.
+  bool covers(const IpPrefix& other) const;
+
+  // Zero the address bits past `length`.
+  void clear_host_bits();
+
+  friend bool operator==(const IpPrefix&, const IpPrefix&) = default;
+};
+
+// IPv4 prefix as an IpPrefix.
+IpPrefix to_ip_prefix(const Ipv4Prefix& prefix);
+
+// Parse an IPv4 or IPv6 prefix ("192.168.10.0/24", "fd00:1::/64") or bare
+// address. Host bits past the prefix length are cleared.
+std::optional<IpPrefix> parse_ip_prefix(std::string_view text);
+
+// "address/length".
+std::string format_ip_prefix(const IpPrefix& prefix);
+
+// Wire form of a prefix list, as carried in route announcements: per
+// prefix, [version: 1 byte, 4 or 6] [length: 1 byte] [address: 4 or 16
+// bytes].
+std::vector<std::uint8_t> encode_ip_prefixes(std::span<const IpPrefix> prefixes);
+
+// Parse encode_ip_prefixes() output, clearing host bits. Return nullopt for
+// a malformed payload.
+std::optional<std::vector<IpPrefix>> decode_ip_prefixes(std::span<const std::uint8_t> payload);
+
+}  // namespace veil::tun
@@ -34,25 +34,33 @@ TunDevice::~TunDevice() { close(); }
 
 TunDevice::TunDevice(TunDevice&& other) noexcept
     : fd_(other.fd_),
+      peer_fd_(other.peer_fd_),
       device_name_(std::move(other.device_name_)),
       stats_(other.stats_),
       packet_info_(other.packet_info_) {
   other.fd_ = -1;
+  other.peer_fd_ = -1;
 }
 
 TunDevice& TunDevice::operator=(TunDevice&& other) noexcept {
   if (this != &other) {
     close();
     fd_ = other.fd_;
+    peer_fd_ = other.peer_fd_;
     device_name_ = std::move(other.device_name_);
     stats_ = other.stats_;
     packet_info_ = other.packet_info_;
     other.fd_ = -1;
+    other.peer_fd_ = -1;
   }
   return *this;
 }
 
 bool TunDevice::open(const TunConfig& config, std::error_code& ec) {
+  if (config.virtual_device) {
+    return open_virtual(config, ec);
+  }
+
   // Open the TUN clone device.
   fd_ = ::open("/dev/net/tun", O_RDWR | O_NONBLOCK);
   if (fd_ < 0) {
@@ -114,7 +122,28 @@ bool TunDevice::open(const TunConfig& config, std::error_code& ec) {
   return true;
 }
 
+bool TunDevice::open_virtual(const TunConfig& config, std::error_code& ec) {
+  // SOCK_SEQPACKET preserves packet boundaries like a TUN fd does.
+  std::array<int, 2> fds{-1, -1};
+  if (::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds.data()) != 0) {
+    ec = last_error();
+    LOG_ERROR("Failed to create virtual TUN socketpair: {}", ec.message());
+    return false;
+  }
+
+  fd_ = fds[0];
+  peer_fd_ = fds[1];
+  packet_info_ = false;
+  device_name_ = config.device_name.empty() ? "vtun" : config.device_name;
+  LOG_INFO("Created virtual TUN device: {}", device_name_);
+  return true;
+}
+
 void TunDevice::close() {
+  if (peer_fd_ >= 0) {
+    ::close(peer_fd_);
+    peer_fd_ = -1;
+  }
   if (fd_ >= 0) {
     ::close(fd_);
     fd_ = -1;
@@ -235,9 +264,18 @@ bool TunDevice::bring_interface_up(std::error_code& ec) {
   return true;
 }
 
-bool TunDevice::set_mtu(int mtu, std::error_code& ec) { return configure_mtu(mtu, ec); }
+bool TunDevice::set_mtu(int mtu, std::error_code& ec) {
+  if (is_virtual()) {
+    return true;
+  }
+  return configure_mtu(mtu, ec);
+}
 
 bool TunDevice::set_up(bool up, std::error_code& ec) {
+  if (is_virtual()) {
+    return true;
+  }
+
   const int sock = socket(AF_INET, SOCK_DGRAM, 0);
   if (sock < 0) {
     ec = last_error();
@@ -25,6 +25,10 @@ struct TunConfig {
   bool packet_info{false};
   // Bring interface up automatically.
   bool bring_up{true};
+  // Back the device with an in-process socketpair instead of /dev/net/tun.
+  // Needs no privileges; the other end is available via peer_fd(). Address,
+  // MTU and link-state settings are accepted but have no effect.
+  bool virtual_device{false};
 };
 
 // Statistics for TUN device operations.
@@ -65,6 +69,14 @@ class TunDevice {
   // Get file descriptor for event loop integration.
   int fd() const { return fd_; }
 
+  // Check if the device is an in-process virtual device.
+  bool is_virtual() const { return peer_fd_ >= 0; }
+
+  // Get the peer end of a virtual device (-1 for a real TUN device).
+  // Each read/write on the peer carries exactly one IP packet, mirroring
+  // what the kernel side of a TUN device sees.
+  int peer_fd() const { return peer_fd_; }
+
   // Get the actual device name (may differ from requested if empty).
   const std::string& device_name() const { return device_name_; }
 
@@ -102,7 +114,11 @@ class TunDevice {
   // Bring interface up.
   bool bring_interface_up(std::error_code& ec);
 
+  // Create a socketpair-backed virtual device.
+  bool open_virtual(const TunConfig& config, std::error_code& ec);
+
   int fd_{-1};
+  int peer_fd_{-1};
   std::string device_name_;
   TunStats stats_;
   bool packet_info_{false};
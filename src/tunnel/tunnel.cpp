@@ -1,17 +1,35 @@
 #include "tunnel/tunnel.h"
 
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <array>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
+#include <iterator>
 
 #include "common/handshake/handshake_processor.h"
 #include "common/logging/logger.h"
 #include "common/signal/signal_handler.h"
 #include "common/utils/rate_limiter.h"
+#include "transport/mux/mux_codec.h"
+#include "tun/ip_packet.h"
 
 namespace veil::tunnel {
 
 namespace {
 constexpr std::size_t kMaxPacketSize = 65535;
+// TUN packets read, and uplink packets sent, per loop iteration.
+constexpr std::size_t kUplinkBatch = 32;
+// Pacer horizon: about 10 ms of data, but never less than two full packets.
+constexpr double kPacerHorizonSeconds = 0.01;
+// Longest wait for datagrams when no uplink packet is due sooner.
+constexpr int kMaxPollTimeoutMs = 10;
+// Pipelined mode: packets the TUN ring, and each crypto worker, hold.
+constexpr std::size_t kPipelineRingSize = 256;
 
 bool load_key_from_file(const std::string& path, std::vector<std::uint8_t>& key,
                         std::error_code& ec) {
@@ -33,7 +51,34 @@ bool load_key_from_file(const std::string& path, std::vector<std::uint8_t>& key,
 }  // namespace
 
 Tunnel::Tunnel(TunnelConfig config, std::function<TimePoint()> now_fn)
-    : config_(std::move(config)), now_fn_(std::move(now_fn)), pmtu_discovery_(config_.pmtu, now_fn_) {}
+    : config_(std::move(config)),
+      now_fn_(std::move(now_fn)),
+      pmtu_discovery_(config_.pmtu, now_fn_),
+      uplink_queue_(config_.uplink_queue, now_fn_),
+      stream_mapper_(config_.streams) {
+  if (config_.dpi_mode) {
+    obfuscation_profile_ = obfuscation::create_dpi_mode_profile(*config_.dpi_mode);
+    if (obfuscation_profile_.cover_traffic) {
+      cover_scheduler_.emplace(obfuscation_profile_, mux::MuxCodec::kHeartbeatHeaderSize, now_fn_);
+    }
+  }
+  if (!cover_scheduler_ &&
+      (config_.uplink_rate_bytes_per_sec > 0 || config_.timing_jitter.count() > 0)) {
+    transport::PacerConfig pacer{.rate_bytes_per_sec = config_.uplink_rate_bytes_per_sec};
+    if (config_.uplink_rate_bytes_per_sec > 0) {
+      const auto rate = static_cast<double>(config_.uplink_rate_bytes_per_sec);
+      const double horizon =
+          std::max(kPacerHorizonSeconds, 2.0 * static_cast<double>(config_.tun.mtu) / rate);
+      pacer.horizon = std::chrono::microseconds(static_cast<std::int64_t>(horizon * 1e6));
+    }
+    obfuscation_profile_.timing_jitter_enabled = config_.timing_jitter.count() > 0;
+    obfuscation_profile_.max_timing_jitter_ms =
+        static_cast<std::uint16_t>(std::min<std::int64_t>(config_.timing_jitter.count(), 0xFFFF));
+    uplink_pacer_.emplace(pacer,
+                          obfuscation_profile_.timing_jitter_enabled ? &obfuscation_profile_ : nullptr,
+                          now_fn_);
+  }
+}
 
 Tunnel::~Tunnel() { stop(); }
 
@@ -80,6 +125,8 @@ bool Tunnel::initialize(std::error_code& ec) {
     return false;
   }
   LOG_INFO("UDP socket opened on port {}", config_.local_port);
+  configure_ecn();
+  configure_txtime();
 
   // Create event loop.
   event_loop_ = std::make_unique<transport::EventLoop>(config_.event_loop, now_fn_);
@@ -137,27 +184,58 @@ void Tunnel::run() {
     }
   }
 
+  if (config_.crypto_workers > 0) {
+    start_pipeline();
+  }
+
   // Main event loop.
   std::array<std::uint8_t, kMaxPacketSize> tun_buffer{};
 
   while (running_.load() && !sig_handler.should_terminate()) {
     std::error_code ec;
 
-    // Check TUN device for incoming packets.
-    auto tun_read = tun_device_.read_into(tun_buffer, ec);
-    if (tun_read > 0) {
-      on_tun_packet(std::span<const std::uint8_t>(tun_buffer.data(), static_cast<std::size_t>(tun_read)));
-    } else if (tun_read < 0) {
-      LOG_ERROR("TUN read error: {}", ec.message());
-      stats_.tun_read_errors++;
+    // Move a batch of packets from the TUN device into the uplink queue.
+    if (crypto_pool_) {
+      drain_tun_ring();
+    } else {
+      for (std::size_t i = 0; i < kUplinkBatch; ++i) {
+        auto tun_read = tun_device_.read_into(tun_buffer, ec);
+        if (tun_read > 0) {
+          on_tun_packet(
+              std::span<const std::uint8_t>(tun_buffer.data(), static_cast<std::size_t>(tun_read)));
+          continue;
+        }
+        if (tun_read < 0) {
+          LOG_ERROR("TUN read error: {}", ec.message());
+          stats_.tun_read_errors++;
+        }
+        break;
+      }
     }
 
-    // Poll UDP socket for incoming packets.
-    udp_socket_.poll(
-        [this](const transport::UdpPacket& pkt) {
-          on_udp_packet(pkt.data, pkt.remote);
-        },
-        10, ec);
+    drain_uplink_queue();
+
+    // Obfuscation values for the next packets, computed while none is due.
+    if (uplink_pacer_) {
+      uplink_pacer_->refill_schedule();
+    }
+    if (cover_scheduler_) {
+      cover_scheduler_->refill_schedule();
+    }
+
+    // Poll UDP socket for incoming packets, waking when uplink packets are
+    // due. A window update arrives as a datagram and ends the poll, so
+    // there is no need to spin while the server's window is closed.
+    const int poll_timeout_ms = uplink_poll_timeout_ms();
+    if (crypto_pool_) {
+      poll_pipeline(poll_timeout_ms);
+    } else {
+      udp_socket_.poll(
+          [this](const transport::UdpPacket& pkt) {
+            on_udp_packet(pkt.data, pkt.remote, pkt.ecn);
+          },
+          poll_timeout_ms, ec);
+    }
 
     // Process session timers if we have an active session.
     if (session_) {
@@ -171,6 +249,32 @@ void Tunnel::run() {
         }
       }
 
+      // Window updates for the server, and notices that we are blocked.
+      for (const auto& pkt : session_->get_flow_control_packets()) {
+        std::error_code send_ec;
+        transport::UdpEndpoint remote{config_.server_address, config_.server_port};
+        if (!udp_socket_.send(pkt, remote, send_ec)) {
+          LOG_WARN("Failed to send window update: {}", send_ec.message());
+        }
+      }
+
+      // FEC repairs for a block that timed out, and loss reports.
+      for (const auto& pkt : session_->get_fec_packets()) {
+        std::error_code send_ec;
+        transport::UdpEndpoint remote{config_.server_address, config_.server_port};
+        if (!udp_socket_.send(pkt, remote, send_ec)) {
+          LOG_WARN("Failed to send FEC packet: {}", send_ec.message());
+        }
+      }
+
+      announce_routes();
+
+      // Give up on frames held too long behind a lost one.
+      auto released = session_->release_stalled_frames();
+      if (!released.empty()) {
+        handle_frames(released, tun::Ecn::kNotEct);
+      }
+
       // Check for session rotation.
       if (session_->should_rotate_session()) {
         session_->rotate_session();
@@ -187,6 +291,7 @@ void Tunnel::run() {
   }
 
   LOG_INFO("Tunnel stopping...");
+  stop_pipeline();
   set_state(ConnectionState::kDisconnected);
   running_.store(false);
 }
@@ -207,23 +312,197 @@ void Tunnel::on_tun_packet(std::span<const std::uint8_t> packet) {
     return;
   }
 
-  // Encrypt and send through UDP.
-  auto encrypted_packets = session_->encrypt_data(packet);
-  for (const auto& enc_pkt : encrypted_packets) {
-    std::error_code ec;
-    transport::UdpEndpoint remote{config_.server_address, config_.server_port};
-    if (!udp_socket_.send(enc_pkt, remote, ec)) {
-      LOG_WARN("Failed to send encrypted packet: {}", ec.message());
-      stats_.encrypt_errors++;
+  // Queue for encryption; drain_uplink_queue() sends it.
+  uplink_queue_.enqueue(packet);
+}
+
+void Tunnel::drain_uplink_queue() {
+  if (!session_) {
+    return;
+  }
+
+  // Track the path: CoDel's interval follows the RTT, and the backlog cap
+  // shrinks with the session's bandwidth-delay sized buffer limit.
+  uplink_queue_.set_rtt(session_->estimated_rtt());
+  uplink_queue_.set_limit_bytes(std::min(config_.uplink_queue.limit_bytes, session_->buffer_limit()));
+
+  // Paced packets now due go out first, behind any the socket refused.
+  if (!pacing_wheel_.empty()) {
+    std::vector<transport::UdpPacket> due;
+    pacing_wheel_.pop_due(now_fn_(), due);
+    std::move(due.begin(), due.end(), std::back_inserter(blocked_sends_));
+  }
+  while (!blocked_sends_.empty()) {
+    if (!send_encrypted(blocked_sends_.front())) {
+      return;
+    }
+    blocked_sends_.pop_front();
+  }
+
+  if (cover_scheduler_) {
+    send_cover_slots();
+  } else {
+    send_paced();
+  }
+
+  const auto& queue_stats = uplink_queue_.stats();
+  stats_.uplink_queue_drops = queue_stats.codel_drops + queue_stats.overflow_drops;
+  stats_.uplink_ecn_marks = queue_stats.ecn_marks;
+}
+
+void Tunnel::send_paced() {
+  const transport::UdpEndpoint remote{config_.server_address, config_.server_port};
+  uplink_flow_blocked_ = false;
+  for (std::size_t sent = 0; sent < kUplinkBatch; ++sent) {
+    if (uplink_pacer_ && !uplink_pacer_->can_schedule()) {
+      break;
+    }
+    // Out of connection credit: leave packets in the uplink queue, where
+    // CoDel turns the wait into drops or marks for the inner flows.
+    if (!uplink_queue_.empty() &&
+        !session_->has_send_credit(static_cast<std::size_t>(config_.tun.mtu))) {
+      uplink_flow_blocked_ = true;
+      break;
+    }
+    auto packet = uplink_queue_.dequeue();
+    if (!packet) {
+      break;
+    }
+    // A stream without credit would hold up every other flow if its
+    // packet waited at the head, so the packet is dropped instead.
+    const auto stream_id = stream_mapper_.stream_for(*packet);
+    if (!session_->has_send_credit(packet->size(), stream_id)) {
+      stats_.flow_control_drops++;
       continue;
     }
-    stats_.udp_packets_sent++;
-    stats_.udp_bytes_sent += enc_pkt.size();
+
+    // RFC 6040 normal mode: the outer header carries the inner ECN field,
+    // but only if CE marks on the way back can be read.
+    const std::uint8_t ecn =
+        udp_socket_.ecn_enabled() ? static_cast<std::uint8_t>(tun::ecn_codepoint(*packet)) : 0;
+    if (crypto_pool_) {
+      // Sent from finish_crypto() once sealed.
+      for (auto& job : session_->prepare_data(*packet, stream_id)) {
+        submit_crypto(CryptoJob{std::move(job), remote, ecn});
+      }
+    } else {
+      for (auto& enc_pkt : session_->encrypt_data(*packet, stream_id)) {
+        send_uplink(transport::UdpPacket{std::move(enc_pkt), remote, ecn});
+      }
+    }
+    if (!blocked_sends_.empty()) {
+      break;
+    }
+  }
+  if (!pacing_wheel_.empty()) {
+    // Packets scheduled for now need not wait for the next loop.
+    std::vector<transport::UdpPacket> due;
+    pacing_wheel_.pop_due(now_fn_(), due);
+    for (auto& out : due) {
+      if (!blocked_sends_.empty() || !send_encrypted(out)) {
+        blocked_sends_.push_back(std::move(out));
+      }
+    }
+  }
+}
+
+void Tunnel::send_cover_slots() {
+  const transport::UdpEndpoint remote{config_.server_address, config_.server_port};
+  uplink_flow_blocked_ = false;
+  while (blocked_sends_.empty()) {
+    if (!cover_held_) {
+      if (!uplink_queue_.empty() &&
+          !session_->has_send_credit(static_cast<std::size_t>(config_.tun.mtu))) {
+        uplink_flow_blocked_ = true;
+      } else {
+        cover_held_ = uplink_queue_.dequeue();
+      }
+    }
+    const std::size_t pending = cover_held_ ? mux::MuxCodec::kDataHeaderSize + cover_held_->size() : 0;
+    auto slot = cover_scheduler_->poll(pending);
+    if (!slot) {
+      return;
+    }
+
+    std::vector<std::vector<std::uint8_t>> encrypted_packets;
+    std::uint8_t ecn = 0;
+    if (slot->kind == obfuscation::CoverSlotKind::kData) {
+      auto packet = std::move(*cover_held_);
+      cover_held_.reset();
+      const auto stream_id = stream_mapper_.stream_for(packet);
+      if (!session_->has_send_credit(packet.size(), stream_id)) {
+        stats_.flow_control_drops++;
+        continue;
+      }
+      ecn = udp_socket_.ecn_enabled() ? static_cast<std::uint8_t>(tun::ecn_codepoint(packet)) : 0;
+      encrypted_packets = session_->encrypt_data(packet, stream_id, false, slot->size);
+    } else {
+      encrypted_packets.push_back(
+          session_->encrypt_heartbeat(slot->heartbeat, slot->heartbeat_sequence, slot->size));
+    }
+    for (auto& enc_pkt : encrypted_packets) {
+      transport::UdpPacket out{std::move(enc_pkt), remote, ecn};
+      if (!blocked_sends_.empty() || !send_encrypted(out)) {
+        blocked_sends_.push_back(std::move(out));
+      }
+    }
+  }
+}
+
+void Tunnel::send_uplink(transport::UdpPacket packet) {
+  if (uplink_pacer_) {
+    const auto departure = uplink_pacer_->schedule(packet.data.size());
+    packet.departure = departure;
+    if (!udp_socket_.txtime_enabled()) {
+      pacing_wheel_.push(std::move(packet), departure);
+      return;
+    }
+  }
+  if (!blocked_sends_.empty() || !send_encrypted(packet)) {
+    blocked_sends_.push_back(std::move(packet));
+  }
+}
+
+bool Tunnel::send_encrypted(const transport::UdpPacket& packet) {
+  std::error_code ec;
+  if (!udp_socket_.send(packet, ec)) {
+    if (ec.value() == EAGAIN || ec.value() == EWOULDBLOCK) {
+      return false;
+    }
+    LOG_WARN("Failed to send encrypted packet: {}", ec.message());
+    stats_.encrypt_errors++;
+    return true;
+  }
+  stats_.udp_packets_sent++;
+  stats_.udp_bytes_sent += packet.data.size();
+  return true;
+}
+
+int Tunnel::uplink_poll_timeout_ms() const {
+  if (!blocked_sends_.empty()) {
+    return 1;
+  }
+  const auto now = now_fn_();
+  std::optional<TimePoint> wake;
+  if (cover_scheduler_) {
+    if (session_) {
+      wake = cover_scheduler_->next_wakeup(cover_held_.has_value());
+    }
+  } else if (!uplink_queue_.empty() && !uplink_flow_blocked_) {
+    wake = uplink_pacer_ ? uplink_pacer_->next_schedule_time() : now;
+  }
+  if (const auto departure = pacing_wheel_.next_departure()) {
+    wake = wake ? std::min(*wake, *departure) : *departure;
+  }
+  if (!wake) {
+    return kMaxPollTimeoutMs;
   }
+  const auto wait = std::chrono::ceil<std::chrono::milliseconds>(*wake - now).count();
+  return static_cast<int>(std::clamp<std::int64_t>(wait, 0, kMaxPollTimeoutMs));
 }
 
 void Tunnel::on_udp_packet(std::span<const std::uint8_t> packet,
-                            const transport::UdpEndpoint& remote) {
+                            const transport::UdpEndpoint& remote, std::uint8_t outer_ecn) {
   stats_.udp_packets_received++;
   stats_.udp_bytes_received += packet.size();
 
@@ -231,6 +510,17 @@ void Tunnel::on_udp_packet(std::span<const std::uint8_t> packet,
     return;
   }
 
+  if (crypto_pool_) {
+    // Replay-checked here, decrypted by a worker, handled by finish_crypto().
+    auto job = session_->prepare_open(std::vector<std::uint8_t>(packet.begin(), packet.end()));
+    if (!job) {
+      stats_.decrypt_errors++;
+      return;
+    }
+    submit_crypto(CryptoJob{std::move(*job), remote, outer_ecn});
+    return;
+  }
+
   // Decrypt the packet.
   auto frames = session_->decrypt_packet(packet);
   if (!frames) {
@@ -238,15 +528,192 @@ void Tunnel::on_udp_packet(std::span<const std::uint8_t> packet,
     stats_.decrypt_errors++;
     return;
   }
+  on_decrypted(*frames, packet.size(), remote, outer_ecn);
+}
+
+void Tunnel::on_decrypted(std::vector<mux::MuxFrame>& frames, std::size_t size,
+                          const transport::UdpEndpoint& remote, std::uint8_t outer_ecn) {
+  session_->record_outer_ecn(outer_ecn);
+  const auto outer = static_cast<tun::Ecn>(outer_ecn & 0x03);
+  if (outer == tun::Ecn::kCe) {
+    stats_.ecn_ce_received++;
+  }
+
+  handle_frames(frames, outer);
+
+  // Update PMTU discovery.
+  pmtu_discovery_.handle_probe_success(remote.host, static_cast<int>(size));
+}
+
+void Tunnel::start_pipeline() {
+  wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wake_fd_ < 0) {
+    LOG_WARN("eventfd failed ({}); running the data plane on one thread", std::strerror(errno));
+    return;
+  }
+  tun_ring_ = std::make_unique<utils::SpscRing<std::vector<std::uint8_t>>>(kPipelineRingSize);
+  crypto_pool_ = std::make_unique<utils::OrderedWorkerPool<CryptoJob>>(
+      config_.crypto_workers, kPipelineRingSize, [](CryptoJob& job) { job.aead.run(); },
+      [this] { wake_loop(); });
+  pipeline_running_.store(true);
+  tun_reader_ = std::thread([this] { read_tun(); });
+  LOG_INFO("Pipelined data plane: TUN reader and {} crypto worker threads",
+           config_.crypto_workers);
+}
+
+void Tunnel::stop_pipeline() {
+  if (!crypto_pool_) {
+    return;
+  }
+  pipeline_running_.store(false);
+  if (tun_reader_.joinable()) {
+    tun_reader_.join();
+  }
+  // Unsent uplink packets are dropped, as on any stop.
+  crypto_pool_.reset();
+  tun_ring_.reset();
+  ::close(wake_fd_);
+  wake_fd_ = -1;
+}
+
+void Tunnel::read_tun() {
+  std::array<std::uint8_t, kMaxPacketSize> buffer{};
+  pollfd pfd{tun_device_.fd(), POLLIN, 0};
+  while (pipeline_running_.load(std::memory_order_relaxed)) {
+    if (::poll(&pfd, 1, kMaxPollTimeoutMs) <= 0) {
+      continue;
+    }
+    bool pushed = false;
+    for (std::size_t i = 0; i < kUplinkBatch; ++i) {
+      std::error_code ec;
+      const auto n = tun_device_.read_into(buffer, ec);
+      if (n < 0) {
+        LOG_ERROR("TUN read error: {}", ec.message());
+        tun_read_errors_.fetch_add(1, std::memory_order_relaxed);
+        // Do not spin on a device that keeps failing.
+        ::poll(nullptr, 0, kMaxPollTimeoutMs);
+      }
+      if (n <= 0) {
+        break;
+      }
+      std::vector<std::uint8_t> packet(buffer.begin(), buffer.begin() + n);
+      if (tun_ring_->try_push(std::move(packet))) {
+        pushed = true;
+      } else {
+        tun_ring_drops_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    // One wakeup per batch.
+    if (pushed) {
+      wake_loop();
+    }
+  }
+}
+
+void Tunnel::drain_tun_ring() {
+  std::vector<std::vector<std::uint8_t>> packets;
+  tun_ring_->pop_batch(packets, tun_ring_->capacity());
+  for (const auto& packet : packets) {
+    on_tun_packet(packet);
+  }
+  stats_.tun_read_errors += tun_read_errors_.exchange(0, std::memory_order_relaxed);
+  stats_.tun_ring_drops += tun_ring_drops_.exchange(0, std::memory_order_relaxed);
+}
+
+void Tunnel::poll_pipeline(int timeout_ms) {
+  // Pairs with the fence in wake_loop(): either the check below sees the
+  // new work, or the producer sees loop_waiting_ and signals the eventfd.
+  loop_waiting_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!tun_ring_->empty() || crypto_pool_->ready()) {
+    timeout_ms = 0;
+  }
+  std::array<pollfd, 2> fds{{{udp_socket_.fd(), POLLIN, 0}, {wake_fd_, POLLIN, 0}}};
+  ::poll(fds.data(), fds.size(), timeout_ms);
+  loop_waiting_.store(false, std::memory_order_relaxed);
+  if ((fds[1].revents & POLLIN) != 0) {
+    std::uint64_t count = 0;
+    [[maybe_unused]] const auto read = ::read(wake_fd_, &count, sizeof(count));
+  }
+
+  if ((fds[0].revents & POLLIN) != 0) {
+    for (std::size_t i = 0; i < kUplinkBatch; ++i) {
+      bool received = false;
+      std::error_code ec;
+      udp_socket_.poll(
+          [this, &received](const transport::UdpPacket& pkt) {
+            received = true;
+            on_udp_packet(pkt.data, pkt.remote, pkt.ecn);
+          },
+          0, ec);
+      if (!received) {
+        break;
+      }
+    }
+  }
+  finish_crypto();
+}
+
+void Tunnel::wake_loop() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (loop_waiting_.exchange(false)) {
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const auto written = ::write(wake_fd_, &one, sizeof(one));
+  }
+}
+
+void Tunnel::submit_crypto(CryptoJob&& job) {
+  while (!crypto_pool_->try_submit(std::move(job))) {
+    // The workers are full: finish what they have done to make room.
+    if (finish_crypto() == 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+std::size_t Tunnel::finish_crypto() {
+  return crypto_pool_->collect([this](CryptoJob&& job) {
+    if (job.aead.kind == transport::AeadJob::Kind::kSeal) {
+      send_uplink(transport::UdpPacket{session_->finish_seal(std::move(job.aead)), job.remote,
+                                       job.ecn});
+      return;
+    }
+    const auto size = job.aead.packet.size();
+    auto frames = session_->finish_open(std::move(job.aead));
+    if (!frames) {
+      LOG_DEBUG("Failed to decrypt packet from {}:{}", job.remote.host, job.remote.port);
+      stats_.decrypt_errors++;
+      return;
+    }
+    on_decrypted(*frames, size, job.remote, job.ecn);
+  });
+}
+
+void Tunnel::discard_crypto() {
+  if (!crypto_pool_) {
+    return;
+  }
+  while (crypto_pool_->in_flight() > 0) {
+    if (crypto_pool_->collect([](CryptoJob&&) {}) == 0) {
+      std::this_thread::yield();
+    }
+  }
+}
 
-  // Process each frame.
-  for (const auto& frame : *frames) {
+void Tunnel::handle_frames(std::vector<mux::MuxFrame>& frames, tun::Ecn outer) {
+  for (auto& frame : frames) {
     if (frame.kind == mux::FrameKind::kData) {
+      // Carry the path's congestion marks to the inner flow.
+      if (!tun::apply_outer_ecn(frame.data.payload, outer)) {
+        stats_.ecn_drops++;
+        continue;
+      }
       // Write decrypted data to TUN device.
       std::error_code ec;
       if (!tun_device_.write(frame.data.payload, ec)) {
         LOG_ERROR("Failed to write to TUN: {}", ec.message());
         stats_.tun_write_errors++;
+        session_->report_delivery_drop();
         continue;
       }
       stats_.tun_packets_sent++;
@@ -255,9 +722,6 @@ void Tunnel::on_udp_packet(std::span<const std::uint8_t> packet,
       session_->process_ack(frame.ack);
     }
   }
-
-  // Update PMTU discovery.
-  pmtu_discovery_.handle_probe_success(remote.host, static_cast<int>(packet.size()));
 }
 
 bool Tunnel::perform_handshake(std::error_code& ec) {
@@ -307,13 +771,36 @@ bool Tunnel::perform_handshake(std::error_code& ec) {
     return false;
   }
 
-  // Create transport session from handshake result.
+  // Create transport session from handshake result. Packets encrypted
+  // under the previous session are useless to the server.
+  discard_crypto();
+  blocked_sends_.clear();
+  pacing_wheel_ = transport::PacingWheel();
+  cover_held_.reset();
   session_ = std::make_unique<transport::TransportSession>(*hs_session, config_.transport, now_fn_);
+  // The server knows nothing of a new session's routes.
+  next_route_announce_ = TimePoint{};
 
   LOG_INFO("Handshake completed successfully, session ID: {}", session_->session_id());
   return true;
 }
 
+void Tunnel::announce_routes() {
+  if (config_.routed_subnets.empty() || now_fn_() < next_route_announce_) {
+    return;
+  }
+  // Announcements are not acknowledged; repeating them covers a lost one
+  // and a server that restarted its session table.
+  next_route_announce_ = now_fn_() + config_.route_announce_interval;
+  std::error_code ec;
+  transport::UdpEndpoint remote{config_.server_address, config_.server_port};
+  const auto packet = session_->encrypt_control(mux::ControlType::kRoutes,
+                                                tun::encode_ip_prefixes(config_.routed_subnets));
+  if (!udp_socket_.send(packet, remote, ec)) {
+    LOG_WARN("Failed to send routed subnets: {}", ec.message());
+  }
+}
+
 void Tunnel::set_state(ConnectionState new_state) {
   ConnectionState old_state = state_.exchange(new_state);
   if (old_state != new_state) {
@@ -379,6 +866,8 @@ void Tunnel::handle_reconnect() {
     set_state(ConnectionState::kReconnecting);
     return;
   }
+  configure_ecn();
+  configure_txtime();
 
   // Reconnect.
   transport::UdpEndpoint remote{config_.server_address, config_.server_port};
@@ -404,6 +893,27 @@ void Tunnel::handle_reconnect() {
   LOG_INFO("Reconnected successfully");
 }
 
+void Tunnel::configure_ecn() {
+  if (!config_.ecn) {
+    return;
+  }
+  std::error_code ec;
+  if (!udp_socket_.enable_ecn(ec)) {
+    // Without CE reports, outer ECT would hide congestion; send Not-ECT.
+    LOG_WARN("ECN unavailable on UDP socket: {}", ec.message());
+  }
+}
+
+void Tunnel::configure_txtime() {
+  if (!uplink_pacer_ || !config_.uplink_txtime) {
+    return;
+  }
+  std::error_code ec;
+  if (!udp_socket_.enable_txtime(ec)) {
+    LOG_WARN("SO_TXTIME unavailable ({}); pacing uplink in userspace", ec.message());
+  }
+}
+
 void Tunnel::on_state_change(StateChangeCallback callback) {
   state_change_callback_ = std::move(callback);
 }
@@ -3,19 +3,29 @@
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <span>
 #include <string>
 #include <system_error>
+#include <thread>
 #include <vector>
 
 #include "common/crypto/crypto_engine.h"
+#include "common/obfuscation/cover_traffic.h"
 #include "common/obfuscation/obfuscation_profile.h"
+#include "common/utils/ordered_worker_pool.h"
+#include "common/utils/spsc_ring.h"
 #include "transport/event_loop/event_loop.h"
+#include "transport/mux/flow_streams.h"
 #include "transport/mux/frame.h"
+#include "transport/queue/packet_pacer.h"
+#include "transport/queue/fq_codel_queue.h"
 #include "transport/session/transport_session.h"
 #include "transport/udp_socket/udp_socket.h"
+#include "tun/ip_packet.h"
 #include "tun/mtu_discovery.h"
 #include "tun/routing.h"
 #include "tun/tun_device.h"
@@ -51,6 +61,23 @@ struct TunnelStats {
   std::uint64_t tun_read_errors{0};
   std::uint64_t tun_write_errors{0};
 
+  // Uplink queue: packets dropped by CoDel or queue overflow, and packets
+  // CE-marked instead of dropped.
+  std::uint64_t uplink_queue_drops{0};
+  std::uint64_t uplink_ecn_marks{0};
+
+  // Uplink packets dropped because their stream had no flow-control credit.
+  std::uint64_t flow_control_drops{0};
+
+  // Received packets whose outer header was CE-marked, and those dropped
+  // because their inner packet was not ECN-capable.
+  std::uint64_t ecn_ce_received{0};
+  std::uint64_t ecn_drops{0};
+
+  // Pipelined mode: TUN packets dropped because the loop thread fell
+  // behind and the reader thread's ring was full.
+  std::uint64_t tun_ring_drops{0};
+
   // Connection.
   std::uint64_t reconnect_count{0};
   std::chrono::steady_clock::time_point connected_since;
@@ -84,6 +111,48 @@ struct TunnelConfig {
   // PMTU discovery configuration.
   tun::PmtuConfig pmtu;
 
+  // Fair queue between TUN reads and encryption.
+  transport::FqCodelConfig uplink_queue;
+
+  // Mapping of inner flows onto mux streams.
+  mux::FlowStreamConfig streams;
+
+  // Propagate ECN between tunneled packets and the outer UDP header
+  // (RFC 6040): outer ECT is copied from the inner packet, and CE marks
+  // the path applies are copied onto inner packets before the TUN write.
+  bool ecn{true};
+
+  // Uplink pacing rate in bytes per second (0 = send as fast as the socket
+  // accepts). Set just below the real uplink rate so the backlog forms in
+  // the uplink queue rather than in the modem.
+  std::uint64_t uplink_rate_bytes_per_sec{0};
+
+  // Hand paced departure times to the kernel with SO_TXTIME instead of
+  // holding packets in a userspace timer wheel. Needs the fq qdisc on the
+  // egress interface, which otherwise sends them unpaced.
+  bool uplink_txtime{false};
+
+  // Maximum obfuscation timing jitter added to each uplink packet's
+  // departure (0 = none). It delays packets without lowering the rate.
+  std::chrono::milliseconds timing_jitter{0};
+
+  // DPI bypass preset for the obfuscation profile. In modes with cover
+  // traffic (kIoTMimic, kTrickle) uplink packets leave in the profile's
+  // slots, padded to its size classes, with heartbeats only while idle.
+  std::optional<obfuscation::DPIBypassMode> dpi_mode;
+
+  // Subnets behind this client for the server to route to it (site-to-site).
+  // Announced after each handshake and then every route_announce_interval;
+  // the server installs those its [routes] allowed list covers.
+  std::vector<tun::IpPrefix> routed_subnets;
+  std::chrono::seconds route_announce_interval{30};
+
+  // Pipelined data plane: a TUN reader thread and this many crypto worker
+  // threads beside the loop thread, which keeps sequencing, replay checks
+  // and socket I/O, so one connection can use more than one core for
+  // encryption. 0 runs the whole data plane on the loop thread.
+  std::size_t crypto_workers{0};
+
   // Reconnection settings.
   bool auto_reconnect{true};
   std::chrono::milliseconds reconnect_delay{5000};
@@ -104,6 +173,13 @@ using StateChangeCallback = std::function<void(ConnectionState old_state, Connec
 using ErrorCallback = std::function<void(const std::string& error)>;
 
 // Main tunnel class that bridges TUN device with encrypted UDP transport.
+//
+// By default run() does all packet work on its own thread. With
+// crypto_workers > 0 it runs a pipeline instead: a reader thread moves TUN
+// packets to the loop thread through an SpscRing, and the loop thread hands
+// data packet encryption and decryption to an OrderedWorkerPool, finishing
+// the results in order. Cover-traffic slots and control packets are still
+// sealed on the loop thread. See docs/thread_model.md.
 class Tunnel {
  public:
   using Clock = std::chrono::steady_clock;
@@ -154,7 +230,9 @@ class Tunnel {
   virtual void on_tun_packet(std::span<const std::uint8_t> packet);
 
   // Called when a packet is received from the UDP socket.
-  virtual void on_udp_packet(std::span<const std::uint8_t> packet, const transport::UdpEndpoint& remote);
+  // `outer_ecn` is the ECN codepoint of the outer IP header.
+  virtual void on_udp_packet(std::span<const std::uint8_t> packet, const transport::UdpEndpoint& remote,
+                             std::uint8_t outer_ecn);
 
   // Called to perform handshake (client initiates, server responds).
   virtual bool perform_handshake(std::error_code& ec);
@@ -165,6 +243,74 @@ class Tunnel {
   // Send packet through the tunnel.
   bool send_packet(std::span<const std::uint8_t> data);
 
+  // Encrypt and send queued uplink packets while the pacer and the socket
+  // allow.
+  void drain_uplink_queue();
+
+  // Dequeue, encrypt and send or pace packets while the pacer and the
+  // socket allow.
+  void send_paced();
+
+  // Cover traffic: fill the slots that are due with queued packets, or
+  // with heartbeats while nothing is queued.
+  void send_cover_slots();
+
+  // Act on decrypted frames: data to the TUN device, ACKs to the session.
+  void handle_frames(std::vector<mux::MuxFrame>& frames, tun::Ecn outer);
+
+  // Send an encrypted packet; false if the socket would block.
+  bool send_encrypted(const transport::UdpPacket& packet);
+
+  // Pace, send or hold an encrypted uplink packet, behind any already
+  // blocked.
+  void send_uplink(transport::UdpPacket packet);
+
+  // Act on a packet the session accepted: ECN accounting, frames and PMTU.
+  void on_decrypted(std::vector<mux::MuxFrame>& frames, std::size_t size,
+                    const transport::UdpEndpoint& remote, std::uint8_t outer_ecn);
+
+  // Pipelined mode (crypto_workers > 0). The loop thread hands AEAD jobs to
+  // the workers and finishes them in submission order, so packets keep
+  // their sequence order in both directions.
+  struct CryptoJob {
+    transport::AeadJob aead;
+    transport::UdpEndpoint remote;
+    // Outer ECN to send with, or as received.
+    std::uint8_t ecn{0};
+  };
+  void start_pipeline();
+  void stop_pipeline();
+  // The TUN reader thread: moves packets into tun_ring_.
+  void read_tun();
+  // Pass packets from tun_ring_ to on_tun_packet().
+  void drain_tun_ring();
+  // Wait up to timeout_ms for a datagram, TUN packets from the reader or
+  // finished crypto jobs, then receive a batch of datagrams.
+  void poll_pipeline(int timeout_ms);
+  // Wake the loop thread if it is waiting in poll_pipeline().
+  void wake_loop();
+  // Queue a job, finishing earlier ones while the workers are full.
+  void submit_crypto(CryptoJob&& job);
+  // Finish completed jobs in order: send sealed packets, handle opened
+  // ones. Returns the number finished.
+  std::size_t finish_crypto();
+  // Wait out the jobs in flight and drop them, before the session changes.
+  void discard_crypto();
+
+  // How long the event loop may wait for datagrams before uplink packets
+  // are due.
+  int uplink_poll_timeout_ms() const;
+
+  // Send the routed subnet announcement when it is due.
+  void announce_routes();
+
+  // Enable outer ECN reporting on the UDP socket if configured.
+  void configure_ecn();
+
+  // Hand uplink pacing to the kernel (SO_TXTIME) if configured. Like
+  // configure_ecn(), needed again whenever the socket is reopened.
+  void configure_txtime();
+
   // Handle reconnection logic.
   void handle_reconnect();
 
@@ -178,6 +324,17 @@ class Tunnel {
   tun::TunDevice tun_device_;
   tun::RouteManager route_manager_;
   tun::PmtuDiscovery pmtu_discovery_;
+  transport::FqCodelQueue uplink_queue_;
+  mux::FlowStreamMapper stream_mapper_;
+  // Departure times for uplink packets while pacing or jitter is on; they
+  // wait in the wheel unless the socket takes them with SO_TXTIME.
+  std::optional<transport::PacketPacer> uplink_pacer_;
+  transport::PacingWheel pacing_wheel_;
+  // Encrypted packets the socket refused with EAGAIN, and paced packets
+  // that are due, sent before anything else is dequeued.
+  std::deque<transport::UdpPacket> blocked_sends_;
+  // Set while the server's connection window stops the uplink queue.
+  bool uplink_flow_blocked_{false};
   transport::UdpSocket udp_socket_;
   std::unique_ptr<transport::TransportSession> session_;
   std::unique_ptr<transport::EventLoop> event_loop_;
@@ -185,6 +342,22 @@ class Tunnel {
   // Crypto.
   crypto::KeyPair key_pair_;
   obfuscation::ObfuscationProfile obfuscation_profile_;
+  // Slot schedule while the profile has cover traffic; it replaces pacing.
+  std::optional<obfuscation::CoverTrafficScheduler> cover_scheduler_;
+  // Uplink packet dequeued for the next cover slot.
+  std::optional<std::vector<std::uint8_t>> cover_held_;
+
+  // Pipelined mode; empty while the loop thread does all the work.
+  std::unique_ptr<utils::OrderedWorkerPool<CryptoJob>> crypto_pool_;
+  std::unique_ptr<utils::SpscRing<std::vector<std::uint8_t>>> tun_ring_;
+  std::thread tun_reader_;
+  std::atomic<bool> pipeline_running_{false};
+  // Eventfd the reader and workers signal while the loop thread waits.
+  int wake_fd_{-1};
+  std::atomic<bool> loop_waiting_{false};
+  // Counted by the reader thread, folded into stats_ by the loop thread.
+  std::atomic<std::uint64_t> tun_ring_drops_{0};
+  std::atomic<std::uint64_t> tun_read_errors_{0};
 
   // State.
   std::atomic<bool> running_{false};
@@ -197,6 +370,9 @@ class Tunnel {
   StateChangeCallback state_change_callback_;
   ErrorCallback error_callback_;
 
+  // When routed_subnets are next announced; reset by each handshake.
+  TimePoint next_route_announce_{};
+
   // Reconnection.
   int reconnect_attempts_{0};
   TimePoint last_reconnect_attempt_;
@@ -0,0 +1,340 @@
+#pragma once
+
+// In-process client <-> server loopback harness.
+//
+// Runs a full tunnel::Tunnel (client) and server::ServerDataPlane (server) in
+// one process, each on its own thread, with virtual TUN devices and an
+// ImpairedUdpRelay between their UDP sockets:
+//
+//   client TUN peer <-> Tunnel <-> relay (uplink/downlink impairment)
+//                                      <-> ServerDataPlane <-> server TUN peer
+//
+// No root privileges, real TUN devices or `tc netem` are needed, so the
+// tests run unprivileged and reproducibly (impairments are seeded).
+//
+// A second client can be added for client-to-client tests; it talks to the
+// server socket directly, without impairment.
+
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "common/handshake/handshake_processor.h"
+#include "common/utils/rate_limiter.h"
+#include "server/data_plane.h"
+#include "server/session_table.h"
+#include "transport/impairment/impaired_relay.h"
+#include "transport/udp_socket/udp_socket.h"
+#include "tun/tun_device.h"
+#include "tunnel/tunnel.h"
+
+namespace veil::integration {
+
+struct LoopbackConfig {
+  // Client -> server link.
+  transport::ImpairmentConfig uplink;
+  // Server -> client link.
+  transport::ImpairmentConfig downlink;
+  // Transport settings used on both ends.
+  transport::TransportSessionConfig transport;
+  // How long start() waits for the handshake.
+  std::chrono::milliseconds connect_timeout{5000};
+  // Subnets the client announces, and those the server accepts.
+  std::vector<tun::IpPrefix> client_subnets;
+  std::chrono::seconds route_announce_interval{30};
+  server::RouteConfig routes;
+  // Server client-to-client forwarding, and whether to start a second
+  // client to exercise it.
+  server::HairpinConfig hairpin;
+  bool second_client{false};
+  // Crypto worker threads on each end; 0 runs it single-threaded.
+  std::size_t client_crypto_workers{0};
+  std::size_t server_crypto_workers{0};
+};
+
+// Process CPU time (user + system) consumed so far.
+inline std::chrono::microseconds process_cpu_time() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  const auto to_us = [](const timeval& tv) {
+    return std::chrono::seconds(tv.tv_sec) + std::chrono::microseconds(tv.tv_usec);
+  };
+  return std::chrono::duration_cast<std::chrono::microseconds>(to_us(usage.ru_utime) +
+                                                               to_us(usage.ru_stime));
+}
+
+// Build a minimal IPv4/UDP packet. Only the fields the data plane looks at
+// (version, length and addresses) need to be meaningful.
+inline std::vector<std::uint8_t> make_ipv4_packet(const std::array<std::uint8_t, 4>& src,
+                                                  const std::array<std::uint8_t, 4>& dst,
+                                                  std::span<const std::uint8_t> payload) {
+  std::array<std::uint8_t, 20> header{};
+  const auto total = static_cast<std::uint16_t>(header.size() + payload.size());
+  header[0] = 0x45;
+  header[2] = static_cast<std::uint8_t>(total >> 8);
+  header[3] = static_cast<std::uint8_t>(total & 0xFF);
+  header[8] = 64;  // TTL
+  header[9] = 17;  // UDP
+  std::copy(src.begin(), src.end(), header.begin() + 12);
+  std::copy(dst.begin(), dst.end(), header.begin() + 16);
+  std::uint32_t sum = 0;
+  for (std::size_t i = 0; i < header.size(); i += 2) {
+    sum += static_cast<std::uint32_t>(header[i] << 8 | header[i + 1]);
+  }
+  while ((sum >> 16) != 0U) {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+  }
+  const auto checksum = static_cast<std::uint16_t>(~sum);
+  header[10] = static_cast<std::uint8_t>(checksum >> 8);
+  header[11] = static_cast<std::uint8_t>(checksum & 0xFF);
+
+  std::vector<std::uint8_t> packet(header.begin(), header.end());
+  packet.insert(packet.end(), payload.begin(), payload.end());
+  return packet;
+}
+
+class LoopbackHarness {
+ public:
+  explicit LoopbackHarness(LoopbackConfig config = {}) : config_(std::move(config)) {}
+
+  ~LoopbackHarness() { stop(); }
+
+  LoopbackHarness(const LoopbackHarness&) = delete;
+  LoopbackHarness& operator=(const LoopbackHarness&) = delete;
+
+  // Bring up server, relay and client, and wait for the handshake.
+  bool start(std::error_code& ec) {
+    psk_.assign(32, 0x5C);
+
+    // Server side.
+    tun::TunConfig server_tun;
+    server_tun.virtual_device = true;
+    server_tun.device_name = "vserver";
+    if (!server_tun_.open(server_tun, ec) || !server_udp_.open(0, false, ec)) {
+      return false;
+    }
+    // Best effort, as in veil-server.
+    std::error_code gso_ec;
+    server_udp_.enable_gso(gso_ec);
+    sessions_ = std::make_unique<server::SessionTable>(16, std::chrono::seconds(300), "10.8.0.2",
+                                                       "10.8.0.17");
+    responder_ = std::make_unique<handshake::HandshakeResponder>(
+        psk_, std::chrono::milliseconds(30000),
+        utils::TokenBucket(100.0, std::chrono::milliseconds(10)));
+    data_plane_ = std::make_unique<server::ServerDataPlane>(
+        server_tun_, server_udp_, *sessions_, *responder_, config_.transport,
+        server::EgressSchedulerConfig{}, mux::FlowStreamConfig{}, config_.hairpin, config_.routes,
+        config_.server_crypto_workers);
+    data_plane_->on_new_session([this](const server::ClientSession& session) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      client_tunnel_ips_.push_back(session.tunnel_ip);
+    });
+
+    // Impaired link.
+    transport::ImpairedRelayConfig relay_config;
+    relay_config.server = transport::UdpEndpoint{"127.0.0.1", server_udp_.local_port()};
+    relay_config.uplink = config_.uplink;
+    relay_config.downlink = config_.downlink;
+    relay_ = std::make_unique<transport::ImpairedUdpRelay>(relay_config);
+    if (!relay_->open(ec)) {
+      return false;
+    }
+
+    // Client side.
+    auto client_config = make_client_config("vclient", relay_->listen_port());
+    client_config.routed_subnets = config_.client_subnets;
+    client_config.route_announce_interval = config_.route_announce_interval;
+    client_config.crypto_workers = config_.client_crypto_workers;
+    tunnel_ = std::make_unique<tunnel::Tunnel>(client_config);
+    if (!tunnel_->initialize(ec)) {
+      return false;
+    }
+
+    running_.store(true);
+    server_thread_ = std::thread([this] {
+      while (running_.load()) {
+        data_plane_->poll_once(1);
+      }
+    });
+    relay_thread_ = std::thread([this] {
+      std::error_code relay_ec;
+      while (running_.load()) {
+        relay_->pump(1, relay_ec);
+      }
+    });
+    client_thread_ = std::thread([this] { tunnel_->run(); });
+    if (!wait_connected(*tunnel_, 1, ec)) {
+      return false;
+    }
+
+    // Started once the first client has its address, so the two are
+    // assigned in a known order.
+    if (config_.second_client) {
+      second_tunnel_ = std::make_unique<tunnel::Tunnel>(
+          make_client_config("vclient2", server_udp_.local_port()));
+      if (!second_tunnel_->initialize(ec)) {
+        return false;
+      }
+      second_client_thread_ = std::thread([this] { second_tunnel_->run(); });
+      if (!wait_connected(*second_tunnel_, 2, ec)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Stop all threads. Statistics are stable once this returns.
+  void stop() {
+    for (auto* tunnel : {tunnel_.get(), second_tunnel_.get()}) {
+      if (tunnel != nullptr) {
+        tunnel->stop();
+      }
+    }
+    running_.store(false);
+    for (auto* t : {&client_thread_, &second_client_thread_, &server_thread_, &relay_thread_}) {
+      if (t->joinable()) {
+        t->join();
+      }
+    }
+  }
+
+  std::string client_tunnel_ip() { return tunnel_ip(0); }
+  std::string second_client_tunnel_ip() { return tunnel_ip(1); }
+
+  // Write a packet into the client TUN, as the client OS would.
+  bool client_send(std::span<const std::uint8_t> packet) {
+    return inject(tunnel_->tun_device()->peer_fd(), packet);
+  }
+
+  // Write a packet into the server TUN, as the server OS would.
+  bool server_send(std::span<const std::uint8_t> packet) {
+    return inject(server_tun_.peer_fd(), packet);
+  }
+
+  // Read a packet the client wrote to its TUN device.
+  std::optional<std::vector<std::uint8_t>> client_receive(std::chrono::milliseconds timeout) {
+    return receive(tunnel_->tun_device()->peer_fd(), timeout);
+  }
+
+  // The same for the second client.
+  bool second_client_send(std::span<const std::uint8_t> packet) {
+    return inject(second_tunnel_->tun_device()->peer_fd(), packet);
+  }
+  std::optional<std::vector<std::uint8_t>> second_client_receive(
+      std::chrono::milliseconds timeout) {
+    return receive(second_tunnel_->tun_device()->peer_fd(), timeout);
+  }
+
+  // Read a packet the server wrote to its TUN device.
+  std::optional<std::vector<std::uint8_t>> server_receive(std::chrono::milliseconds timeout) {
+    return receive(server_tun_.peer_fd(), timeout);
+  }
+
+  const transport::ImpairmentStats& uplink_stats() const { return relay_->uplink_stats(); }
+  const transport::ImpairmentStats& downlink_stats() const { return relay_->downlink_stats(); }
+  const server::DataPlaneStats& server_stats() const { return data_plane_->stats(); }
+  const tunnel::TunnelStats& client_stats() const { return tunnel_->stats(); }
+
+ private:
+  tunnel::TunnelConfig make_client_config(const std::string& device_name, std::uint16_t port) {
+    tunnel::TunnelConfig client_config;
+    client_config.tun.virtual_device = true;
+    client_config.tun.device_name = device_name;
+    client_config.server_address = "127.0.0.1";
+    client_config.server_port = port;
+    client_config.psk = psk_;
+    client_config.transport = config_.transport;
+    client_config.auto_reconnect = false;
+    client_config.handshake_skew_tolerance = config_.connect_timeout;
+    return client_config;
+  }
+
+  // Wait until `tunnel` is connected and the server has assigned
+  // `sessions` addresses in total.
+  bool wait_connected(tunnel::Tunnel& tunnel, std::size_t sessions, std::error_code& ec) {
+    const auto deadline = std::chrono::steady_clock::now() + config_.connect_timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+      if (tunnel.state() == tunnel::ConnectionState::kConnected &&
+          !tunnel_ip(sessions - 1).empty()) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ec = std::make_error_code(std::errc::timed_out);
+    return false;
+  }
+
+  std::string tunnel_ip(std::size_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index < client_tunnel_ips_.size() ? client_tunnel_ips_[index] : std::string();
+  }
+
+  static bool inject(int fd, std::span<const std::uint8_t> packet) {
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+      const auto n = ::send(fd, packet.data(), packet.size(), MSG_DONTWAIT);
+      if (n == static_cast<ssize_t>(packet.size())) {
+        return true;
+      }
+      if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+  }
+
+  static std::optional<std::vector<std::uint8_t>> receive(int fd,
+                                                          std::chrono::milliseconds timeout) {
+    pollfd pfd{fd, POLLIN, 0};
+    if (::poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0) {
+      return std::nullopt;
+    }
+    std::vector<std::uint8_t> buffer(65535);
+    const auto n = ::recv(fd, buffer.data(), buffer.size(), MSG_DONTWAIT);
+    if (n <= 0) {
+      return std::nullopt;
+    }
+    buffer.resize(static_cast<std::size_t>(n));
+    return buffer;
+  }
+
+  LoopbackConfig config_;
+  std::vector<std::uint8_t> psk_;
+
+  tun::TunDevice server_tun_;
+  transport::UdpSocket server_udp_;
+  std::unique_ptr<server::SessionTable> sessions_;
+  std::unique_ptr<handshake::HandshakeResponder> responder_;
+  std::unique_ptr<server::ServerDataPlane> data_plane_;
+  std::unique_ptr<transport::ImpairedUdpRelay> relay_;
+  std::unique_ptr<tunnel::Tunnel> tunnel_;
+  std::unique_ptr<tunnel::Tunnel> second_tunnel_;
+
+  std::atomic<bool> running_{false};
+  std::thread server_thread_;
+  std::thread relay_thread_;
+  std::thread client_thread_;
+  std::thread second_client_thread_;
+
+  std::mutex mutex_;
+  // Assigned tunnel IPs, in handshake order.
+  std::vector<std::string> client_tunnel_ips_;
+};
+
+}  // namespace veil::integration
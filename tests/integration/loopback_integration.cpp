@@ -0,0 +1,418 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include "loopback_harness.h"
+#include "server/hairpin.h"
+
+namespace veil::integration {
+
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr std::array<std::uint8_t, 4> kServerSideHost{10, 8, 0, 1};
+constexpr std::array<std::uint8_t, 4> kRemoteHost{192, 0, 2, 10};
+constexpr std::array<std::uint8_t, 4> kSiteHost{192, 168, 50, 7};
+
+std::array<std::uint8_t, 4> parse_ipv4(const std::string& ip) {
+  std::array<std::uint8_t, 4> out{};
+  unsigned a = 0;
+  unsigned b = 0;
+  unsigned c = 0;
+  unsigned d = 0;
+  if (std::sscanf(ip.c_str(), "%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
+    out = {static_cast<std::uint8_t>(a), static_cast<std::uint8_t>(b),
+           static_cast<std::uint8_t>(c), static_cast<std::uint8_t>(d)};
+  }
+  return out;
+}
+
+// Payload carries a sequence number and the send time so the receiver can
+// check ordering/duplication and compute one-way latency.
+std::vector<std::uint8_t> make_probe(std::uint32_t seq, std::size_t size) {
+  std::vector<std::uint8_t> payload(std::max<std::size_t>(size, 12), 0xA5);
+  const auto sent_ns = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+  std::memcpy(payload.data(), &seq, sizeof(seq));
+  std::memcpy(payload.data() + 4, &sent_ns, sizeof(sent_ns));
+  return payload;
+}
+
+struct Probe {
+  std::uint32_t seq{0};
+  std::chrono::nanoseconds latency{0};
+};
+
+Probe read_probe(const std::vector<std::uint8_t>& ip_packet) {
+  Probe probe;
+  std::uint64_t sent_ns = 0;
+  std::memcpy(&probe.seq, ip_packet.data() + 20, sizeof(probe.seq));
+  std::memcpy(&sent_ns, ip_packet.data() + 24, sizeof(sent_ns));
+  const auto now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+  probe.latency = std::chrono::nanoseconds(now_ns - static_cast<std::int64_t>(sent_ns));
+  return probe;
+}
+
+struct TransferReport {
+  std::set<std::uint32_t> delivered;
+  std::size_t duplicates{0};
+  // Probes that arrived after a later one.
+  std::size_t reordered{0};
+  std::uint64_t bytes{0};
+  std::chrono::nanoseconds max_latency{0};
+  std::chrono::nanoseconds total_latency{0};
+  std::chrono::microseconds cpu{0};
+  std::chrono::microseconds wall{0};
+
+  double goodput_mbps() const {
+    if (wall.count() == 0) return 0.0;
+    return static_cast<double>(bytes) * 8.0 / static_cast<double>(wall.count());
+  }
+
+  double mean_latency_ms() const {
+    if (delivered.empty()) return 0.0;
+    return static_cast<double>(total_latency.count()) / 1e6 /
+           static_cast<double>(delivered.size());
+  }
+
+  double cpu_ns_per_byte() const {
+    if (bytes == 0) return 0.0;
+    return static_cast<double>(cpu.count()) * 1000.0 / static_cast<double>(bytes);
+  }
+
+  void print(const char* label) const {
+    std::cout << "[loopback] " << label << ": delivered=" << delivered.size()
+              << " dup=" << duplicates << " goodput=" << goodput_mbps()
+              << " Mbps mean_latency=" << mean_latency_ms() << " ms cpu=" << cpu_ns_per_byte()
+              << " ns/B\n";
+  }
+};
+
+enum class Direction { kUplink, kDownlink };
+
+// Send `count` probes in one direction, pacing them by `gap`, and collect
+// what arrives until `count` unique probes are seen or `drain` elapses with
+// nothing new.
+TransferReport transfer(LoopbackHarness& harness, Direction dir, std::uint32_t count,
+                        std::size_t size, std::chrono::microseconds gap,
+                        std::chrono::milliseconds drain = 2000ms) {
+  const auto client_ip = parse_ipv4(harness.client_tunnel_ip());
+  TransferReport report;
+  const auto cpu_start = process_cpu_time();
+  const auto wall_start = std::chrono::steady_clock::now();
+
+  auto collect = [&](std::chrono::milliseconds timeout) {
+    auto pkt = dir == Direction::kUplink ? harness.server_receive(timeout)
+                                         : harness.client_receive(timeout);
+    if (!pkt || pkt->size() < 32) {
+      return false;
+    }
+    const auto probe = read_probe(*pkt);
+    if (!report.delivered.empty() && probe.seq < *report.delivered.rbegin()) {
+      ++report.reordered;
+    }
+    if (!report.delivered.insert(probe.seq).second) {
+      ++report.duplicates;
+      return true;
+    }
+    report.bytes += pkt->size();
+    report.total_latency += probe.latency;
+    report.max_latency = std::max(report.max_latency, probe.latency);
+    return true;
+  };
+
+  for (std::uint32_t seq = 0; seq < count; ++seq) {
+    const auto payload = make_probe(seq, size);
+    const auto packet = dir == Direction::kUplink
+                            ? make_ipv4_packet(client_ip, kRemoteHost, payload)
+                            : make_ipv4_packet(kRemoteHost, client_ip, payload);
+    const bool sent = dir == Direction::kUplink ? harness.client_send(packet)
+                                                : harness.server_send(packet);
+    EXPECT_TRUE(sent);
+    const auto next = std::chrono::steady_clock::now() + gap;
+    while (std::chrono::steady_clock::now() < next) {
+      collect(0ms);
+    }
+  }
+
+  while (report.delivered.size() < count && collect(drain)) {
+  }
+
+  report.wall = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - wall_start);
+  report.cpu = process_cpu_time() - cpu_start;
+  return report;
+}
+
+}  // namespace
+
+TEST(LoopbackIntegration, CleanLinkBothDirections) {
+  LoopbackHarness harness;
+  std::error_code ec;
+  ASSERT_TRUE(harness.start(ec)) << ec.message();
+  EXPECT_EQ(harness.client_tunnel_ip(), "10.8.0.17");
+
+  const auto up = transfer(harness, Direction::kUplink, 50, 512, 2ms);
+  const auto down = transfer(harness, Direction::kDownlink, 50, 512, 2ms);
+  harness.stop();
+  up.print("clean uplink");
+  down.print("clean downlink");
+
+  EXPECT_EQ(up.delivered.size(), 50u);
+  EXPECT_EQ(down.delivered.size(), 50u);
+  EXPECT_EQ(up.duplicates, 0u);
+  EXPECT_EQ(down.duplicates, 0u);
+  EXPECT_EQ(harness.server_stats().handshakes_completed, 1u);
+  EXPECT_EQ(harness.uplink_stats().dropped_random, 0u);
+}
+
+TEST(LoopbackIntegration, PipelinedClientDeliversEachPacketOnce) {
+  LoopbackConfig config;
+  config.client_crypto_workers = 3;
+  LoopbackHarness harness(config);
+  std::error_code ec;
+  ASSERT_TRUE(harness.start(ec)) << ec.message();
+
+  const auto up = transfer(harness, Direction::kUplink, 200, 512, 200us);
+  const auto down = transfer(harness, Direction::kDownlink, 200, 512, 200us);
+  harness.stop();
+  up.print("pipelined uplink");
+  down.print("pipelined downlink");
+
+  EXPECT_EQ(up.delivered.size(), 200u);
+  EXPECT_EQ(down.delivered.size(), 200u);
+  EXPECT_EQ(up.duplicates, 0u);
+  EXPECT_EQ(down.duplicates, 0u);
+  EXPECT_EQ(up.reordered, 0u);
+  EXPECT_EQ(down.reordered, 0u);
+  EXPECT_EQ(harness.server_stats().handshakes_completed, 1u);
+}
+
+TEST(LoopbackIntegration, PipelinedServerKeepsOrder) {
+  LoopbackConfig config;
+  config.server_crypto_workers = 3;
+  LoopbackHarness harness(config);
+  std::error_code ec;
+  ASSERT_TRUE(harness.start(ec)) << ec.message();
+
+  const auto up = transfer(harness, Direction::kUplink, 200, 512, 200us);
+  const auto down = transfer(harness, Direction::kDownlink, 200, 512, 200us);
+  harness.stop();
+  up.print("pipelined server uplink");
+  down.print("pipelined server downlink");
+
+  EXPECT_EQ(up.delivered.size(), 200u);
+  EXPECT_EQ(down.delivered.size(), 200u);
+  EXPECT_EQ(up.duplicates, 0u);
+  EXPECT_EQ(down.duplicates, 0u);
+  EXPECT_EQ(up.reordered, 0u);
+  EXPECT_EQ(down.reordered, 0u);
+  EXPECT_EQ(harness.server_stats().crypto_orphans, 0u);
+}
+
+TEST(LoopbackIntegration, DelayIsApplied) {
+  LoopbackConfig config;
+  config.uplink.delay = 20ms;
+  LoopbackHarness harness(config);
+  std::error_code ec;
+  ASSERT_TRUE(harness.start(ec)) << ec.message();
+
+  const auto up = transfer(harness, Direction::kUplink, 20, 256, 2ms);
+  harness.stop();
+  up.print("delay 20ms uplink");
+
+  ASSERT_EQ(up.delivered.size(), 20u);
+  EXPECT_GE(up.mean_latency_ms(), 20.0);
+}
+
+// Loss, duplication and reordering on the wire must not surface as loss or
+// duplicates on the far TUN: retransmission recovers drops and the replay
+// window discards wire duplicates.
+TEST(LoopbackIntegration, ImpairedLinkDeliversEachPacketOnce) {
+  LoopbackConfig config;
+  config.uplink.loss_rate = 0.05;
+  config.uplink.duplicate_rate = 0.05;
+  config.uplink.reorder_rate = 0.1;
+  config.uplink.reorder_delay = 3ms;
+  config.uplink.delay = 2ms;
+  config.uplink.jitter = 1ms;
+  config.uplink.seed = 42;
+  LoopbackHarness harness(config);
+  std::error_code ec;
+  ASSERT_TRUE(harness.start(ec)) << ec.message();
+
+  const auto up = transfer(harness, Direction::kUplink, 100, 512, 2ms, 3000ms);
+  harness.stop();
+  up.print("lossy uplink");
+
+  EXPECT_EQ(up.duplicates, 0u);
+  EXPECT_EQ(up.delivered.size(), 100u);
+  const auto& link = harness.uplink_stats();
+  EXPECT_GT(link.dropped_random, 0u);
+  EXPECT_GT(link.duplicated, 0u);
+  EXPECT_GT(link.reordered, 0u);
+}
+
+TEST(LoopbackIntegration, BurstLossIsRecovered) {
+  LoopbackConfig config;
+  config.downlink.burst_loss.enabled = true;
+  config.downlink.burst_loss.p_good_to_bad = 0.05;
+  config.downlink.burst_loss.p_bad_to_good = 0.5;
+  config.downlink.seed = 7;
+  LoopbackHarness harness(config);
+  std::error_code ec;
+  ASSERT_TRUE(harness.start(ec)) << ec.message();
+
+  const auto down = transfer(harness, Direction::kDownlink, 100, 512, 2ms, 3000ms);
+  harness.stop();
+  down.print("burst-loss downlink");
+
+  EXPECT_GT(harness.downlink_stats().dropped_burst, 0u);
+  EXPECT_EQ(down.duplicates, 0u);
+  EXPECT_EQ(down.delivered.size(), 100u);
+}
+
+TEST(LoopbackIntegration, BandwidthCapLimitsGoodput) {
+  LoopbackConfig config;
+  config.downlink.bandwidth_bps = 2'000'000;
+  LoopbackHarness harness(config);
+  std::error_code ec;
+  ASSERT_TRUE(harness.start(ec)) << ec.message();
+
+  const auto down = transfer(harness, Direction::kDownlink, 100, 1000, 0us);
+  harness.stop();
+  down.print("2 Mbps downlink");
+
+  ASSERT_EQ(down.delivered.size(), 100u);
+  // 100 x ~1.1 KB on the wire at 2 Mbps takes at least ~400 ms.
+  EXPECT_LT(down.goodput_mbps(), 2.0);
+  EXPECT_GE(down.wall, 400ms);
+}
+
+// A subnet the client announces is routed to it once the server accepts
+// the announcement; one outside the server's allowed list is not.
+TEST(LoopbackIntegration, RoutesAnnouncedSubnetsToClient) {
+  LoopbackConfig config;
+  config.client_subnets = {*tun::parse_ip_prefix("192.168.50.0/24"),
+                           *tun::parse_ip_prefix("172.16.0.0/24")};
+  config.routes.allowed = {*tun::parse_ip_prefix("192.168.0.0/16")};
+  LoopbackHarness harness(config);
+  std::error_code ec;
+  ASSERT_TRUE(harness.start(ec)) << ec.message();
+
+  // The announcement races the first packets; resend until it lands.
+  const std::vector<std::uint8_t> payload(64, 0x5A);
+  const auto packet = make_ipv4_packet(kRemoteHost, kSiteHost, payload);
+  std::optional<std::vector<std::uint8_t>> received;
+  for (int attempt = 0; attempt < 100 && !received; ++attempt) {
+    ASSERT_TRUE(harness.server_send(packet));
+    received = harness.client_receive(20ms);
+  }
+  ASSERT_TRUE(received.has_value());
+  EXPECT_EQ(*received, packet);
+
+  ASSERT_TRUE(harness.server_send(make_ipv4_packet(kRemoteHost, {172, 16, 0, 9}, payload)));
+  EXPECT_FALSE(harness.client_receive(100ms).has_value());
+  harness.stop();
+
+  EXPECT_GE(harness.server_stats().route_announcements, 1u);
+  EXPECT_GE(harness.server_stats().routes_rejected, 1u);
+}
+
+TEST(LoopbackIntegration, RepeatedAnnouncementLeavesRoutesAlone) {
+  LoopbackConfig config;
+  // One subnet outside `allowed`, one overlapping the IP pool: both are
+  // refused, but only the first time the client announces them.
+  config.client_subnets = {*tun::parse_ip_prefix("192.168.50.0/24"),
+                           *tun::parse_ip_prefix("172.16.0.0/24"),
+                           *tun::parse_ip_prefix("10.8.0.0/28")};
+  config.route_announce_interval = std::chrono::seconds(1);
+  config.routes.allowed = {*tun::parse_ip_prefix("192.168.0.0/16"),
+                           *tun::parse_ip_prefix("10.0.0.0/8")};
+  LoopbackHarness harness(config);
+  std::error_code ec;
+  ASSERT_TRUE(harness.start(ec)) << ec.message();
+
+  // Keep the client's loop busy past a few announcement intervals.
+  const auto up = transfer(harness, Direction::kUplink, 25, 256, 100ms);
+  harness.stop();
+
+  EXPECT_EQ(up.delivered.size(), 25u);
+  EXPECT_GE(harness.server_stats().route_announcements, 2u);
+  EXPECT_EQ(harness.server_stats().routes_rejected, 2u);
+}
+
+// A packet from one client to another's tunnel IP is forwarded by the
+// server without going through its TUN device.
+TEST(LoopbackIntegration, HairpinForwardsBetweenClients) {
+  LoopbackConfig config;
+  config.hairpin.enabled = true;
+  config.second_client = true;
+  LoopbackHarness harness(config);
+  std::error_code ec;
+  ASSERT_TRUE(harness.start(ec)) << ec.message();
+
+  const std::vector<std::uint8_t> payload(64, 0x3C);
+  const auto packet = make_ipv4_packet(parse_ipv4(harness.client_tunnel_ip()),
+                                       parse_ipv4(harness.second_client_tunnel_ip()), payload);
+  ASSERT_TRUE(harness.client_send(packet));
+  const auto received = harness.second_client_receive(1000ms);
+  ASSERT_TRUE(received.has_value());
+  EXPECT_EQ(*received, packet);
+  EXPECT_FALSE(harness.server_receive(100ms).has_value());
+  harness.stop();
+
+  EXPECT_EQ(harness.server_stats().hairpin_packets, 1u);
+  EXPECT_EQ(harness.server_stats().tun_packets_written, 0u);
+}
+
+// The ACL matches the sender's assigned address, so a forged source
+// address does not get a packet past a rule that denies the sender.
+TEST(LoopbackIntegration, HairpinAclDeniesBySessionAddress) {
+  LoopbackConfig config;
+  config.hairpin.enabled = true;
+  auto deny = server::parse_hairpin_rule("10.8.0.17->any");
+  ASSERT_TRUE(deny.has_value());
+  deny->allow = false;
+  config.hairpin.rules.push_back(*deny);
+  config.second_client = true;
+  LoopbackHarness harness(config);
+  std::error_code ec;
+  ASSERT_TRUE(harness.start(ec)) << ec.message();
+  ASSERT_EQ(harness.client_tunnel_ip(), "10.8.0.17");
+
+  const auto first = parse_ipv4(harness.client_tunnel_ip());
+  const auto second = parse_ipv4(harness.second_client_tunnel_ip());
+  const std::vector<std::uint8_t> payload(64, 0x3C);
+  ASSERT_TRUE(harness.client_send(make_ipv4_packet(first, second, payload)));
+  // No rule matches 10.8.0.5, so the default would allow it if the header
+  // were trusted.
+  ASSERT_TRUE(harness.client_send(make_ipv4_packet({10, 8, 0, 5}, second, payload)));
+  EXPECT_FALSE(harness.second_client_receive(200ms).has_value());
+
+  // The rule is one-way.
+  const auto reply = make_ipv4_packet(second, first, payload);
+  ASSERT_TRUE(harness.second_client_send(reply));
+  const auto received = harness.client_receive(1000ms);
+  ASSERT_TRUE(received.has_value());
+  EXPECT_EQ(*received, reply);
+  harness.stop();
+
+  EXPECT_EQ(harness.server_stats().hairpin_denied, 2u);
+  EXPECT_EQ(harness.server_stats().hairpin_packets, 1u);
+  EXPECT_EQ(harness.server_stats().tun_packets_written, 0u);
+}
+
+}  // namespace veil::integration
@@ -179,4 +179,69 @@ TEST_F(AckSchedulerTest, DelayedAckStats) {
   EXPECT_EQ(scheduler.stats().acks_immediate, 1U);
 }
 
+TEST_F(AckSchedulerTest, AckFrequencyRequestRaisesThreshold) {
+  AckScheduler scheduler(config_, [this]() { return now_; });
+  ASSERT_TRUE(scheduler.on_ack_frequency(AckFrequency{1, 16, 10ms}));
+  EXPECT_EQ(scheduler.packet_threshold(), 16U);
+  EXPECT_EQ(scheduler.max_ack_delay(), 10ms);
+
+  // Past both ack_every_n_packets and max_pending_acks.
+  for (std::uint64_t seq = 1; seq < 16; ++seq) {
+    EXPECT_FALSE(scheduler.on_packet_received(0, seq, false));
+  }
+  EXPECT_TRUE(scheduler.on_packet_received(0, 16, false));
+  scheduler.ack_sent(0);
+
+  // The delay timer follows the request too.
+  scheduler.on_packet_received(0, 17, false);
+  now_ += 10ms;
+  EXPECT_EQ(scheduler.check_ack_timer(), 0U);
+
+  // A gap still gets an immediate ACK.
+  EXPECT_TRUE(scheduler.on_packet_received(0, 20, false));
+}
+
+TEST_F(AckSchedulerTest, StaleOrUnhonoredAckFrequencyIgnored) {
+  AckScheduler scheduler(config_, [this]() { return now_; });
+  ASSERT_TRUE(scheduler.on_ack_frequency(AckFrequency{5, 8, 1000ms}));
+  // Delay capped at max_requested_ack_delay.
+  EXPECT_EQ(scheduler.max_ack_delay(), config_.max_requested_ack_delay);
+  EXPECT_FALSE(scheduler.on_ack_frequency(AckFrequency{4, 32, 5ms}));
+  EXPECT_EQ(scheduler.packet_threshold(), 8U);
+  EXPECT_EQ(scheduler.stats().ack_frequency_updates, 1U);
+
+  config_.honor_ack_frequency = false;
+  AckScheduler fixed(config_, [this]() { return now_; });
+  EXPECT_FALSE(fixed.on_ack_frequency(AckFrequency{1, 8, 5ms}));
+  EXPECT_EQ(fixed.packet_threshold(), config_.ack_every_n_packets);
+}
+
+TEST(AckFrequencyPolicyTest, ScalesWithWindowAndRtt) {
+  AckFrequencyPolicy policy(AckFrequencyConfig{.enabled = true});
+  auto now = std::chrono::steady_clock::now();
+
+  // Small window: the minimum threshold, RTT / 4 delay.
+  auto request = policy.update(3, 40ms, now);
+  ASSERT_TRUE(request.has_value());
+  EXPECT_EQ(request->sequence, 0U);
+  EXPECT_EQ(request->packet_threshold, 2U);
+  EXPECT_EQ(request->max_ack_delay, 10ms);
+
+  // Nothing new: no request. A larger window within the same RTT waits.
+  EXPECT_FALSE(policy.update(3, 40ms, now + 10ms).has_value());
+  EXPECT_FALSE(policy.update(100, 40ms, now + 20ms).has_value());
+
+  // 100 in flight / 4 = 25, rounded down to 16.
+  request = policy.update(100, 40ms, now + 50ms);
+  ASSERT_TRUE(request.has_value());
+  EXPECT_EQ(request->sequence, 1U);
+  EXPECT_EQ(request->packet_threshold, 16U);
+
+  // Capped at max_packet_threshold and max_ack_delay.
+  request = policy.update(1000, 400ms, now + 500ms);
+  ASSERT_TRUE(request.has_value());
+  EXPECT_EQ(request->packet_threshold, 32U);
+  EXPECT_EQ(request->max_ack_delay, 25ms);
+}
+
 }  // namespace veil::mux::tests
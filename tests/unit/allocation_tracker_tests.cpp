@@ -0,0 +1,90 @@
+#include "common/utils/allocation_tracker.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "common/utils/cache_line.h"
+
+namespace veil::utils::test {
+
+class AllocationTrackerTest : public ::testing::Test {
+ protected:
+  void SetUp() override { reset_allocation_counts(); }
+};
+
+TEST_F(AllocationTrackerTest, ScopesNestAndRestore) {
+  EXPECT_EQ(current_allocation_subsystem(), AllocationSubsystem::kOther);
+  {
+    const AllocationScope transport(AllocationSubsystem::kTransport);
+    EXPECT_EQ(current_allocation_subsystem(), AllocationSubsystem::kTransport);
+    {
+      const AllocationScope crypto(AllocationSubsystem::kCrypto);
+      EXPECT_EQ(current_allocation_subsystem(), AllocationSubsystem::kCrypto);
+    }
+    EXPECT_EQ(current_allocation_subsystem(), AllocationSubsystem::kTransport);
+  }
+  EXPECT_EQ(current_allocation_subsystem(), AllocationSubsystem::kOther);
+}
+
+TEST_F(AllocationTrackerTest, RecordChargesCurrentSubsystem) {
+  {
+    const AllocationScope mux(AllocationSubsystem::kMux);
+    record_allocation(100);
+    record_allocation(28);
+  }
+  const auto mux = allocation_counts(AllocationSubsystem::kMux);
+  EXPECT_GE(mux.allocations, 2U);
+  EXPECT_GE(mux.bytes, 128U);
+
+  const auto snapshot = allocation_snapshot();
+  const auto total = total_allocations(snapshot);
+  EXPECT_GE(total.allocations, mux.allocations);
+
+  reset_allocation_counts();
+  EXPECT_EQ(allocation_counts(AllocationSubsystem::kMux).allocations, 0U);
+}
+
+TEST_F(AllocationTrackerTest, HookCountsOnlyWhenEnabled) {
+  {
+    const AllocationScope handshake(AllocationSubsystem::kHandshake);
+    std::string heap(256, 'x');
+    ASSERT_EQ(heap.size(), 256U);
+  }
+  const auto counts = allocation_counts(AllocationSubsystem::kHandshake);
+  if (allocation_tracking_enabled()) {
+    EXPECT_GE(counts.allocations, 1U);
+    EXPECT_GE(counts.bytes, 257U);
+  } else {
+    EXPECT_EQ(counts.allocations, 0U);
+  }
+}
+
+TEST_F(AllocationTrackerTest, HookCountsOverAlignedAllocations) {
+  struct alignas(kCacheLineSize) Aligned {
+    char bytes[3 * kCacheLineSize];
+  };
+  {
+    const AllocationScope transport(AllocationSubsystem::kTransport);
+    const auto single = std::make_unique<Aligned>();
+    const auto array = std::make_unique<Aligned[]>(2);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(single.get()) % kCacheLineSize, 0U);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(array.get()) % kCacheLineSize, 0U);
+  }
+  const auto counts = allocation_counts(AllocationSubsystem::kTransport);
+  if (allocation_tracking_enabled()) {
+    EXPECT_GE(counts.allocations, 2U);
+    EXPECT_GE(counts.bytes, 3 * sizeof(Aligned));
+  } else {
+    EXPECT_EQ(counts.allocations, 0U);
+  }
+}
+
+TEST_F(AllocationTrackerTest, SubsystemNames) {
+  EXPECT_STREQ(allocation_subsystem_name(AllocationSubsystem::kOther), "other");
+  EXPECT_STREQ(allocation_subsystem_name(AllocationSubsystem::kEventLoop), "event_loop");
+}
+
+}  // namespace veil::utils::test
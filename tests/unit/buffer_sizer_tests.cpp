@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "transport/session/buffer_sizer.h"
+
+namespace veil::tests {
+
+using namespace std::chrono_literals;
+
+class BufferSizerTest : public ::testing::Test {
+ protected:
+  transport::BufferSizer::TimePoint now_{std::chrono::steady_clock::now()};
+  transport::BufferSizerConfig config_;
+};
+
+TEST_F(BufferSizerTest, StartsAtFloor) {
+  transport::BufferSizer sizer(config_, now_);
+  EXPECT_EQ(sizer.limit(), config_.min_bytes);
+  EXPECT_EQ(sizer.bandwidth(), 0.0);
+}
+
+TEST_F(BufferSizerTest, WindowClosesAfterSampleIntervalOrRtt) {
+  transport::BufferSizer sizer(config_, now_);
+  EXPECT_FALSE(sizer.record(1000, now_ + 50ms, 10ms));
+  EXPECT_TRUE(sizer.record(1000, now_ + 100ms, 10ms));
+
+  // A longer RTT stretches the window.
+  EXPECT_FALSE(sizer.record(1000, now_ + 250ms, 200ms));
+  EXPECT_TRUE(sizer.record(1000, now_ + 300ms, 200ms));
+}
+
+TEST_F(BufferSizerTest, LimitTracksBandwidthDelayProduct) {
+  transport::BufferSizer sizer(config_, now_);
+  // 100 KB over a 200 ms window = 500 KB/s; at 200 ms RTT, 2 x BDP = 200 KB.
+  ASSERT_TRUE(sizer.record(100'000, now_ + 200ms, 200ms));
+  EXPECT_DOUBLE_EQ(sizer.bandwidth(), 500'000.0);
+  EXPECT_EQ(sizer.limit(), 200'000U);
+}
+
+TEST_F(BufferSizerTest, LimitClampedToConfiguredRange) {
+  config_.min_bytes = 10'000;
+  config_.max_bytes = 50'000;
+  transport::BufferSizer sizer(config_, now_);
+
+  ASSERT_TRUE(sizer.record(10'000'000, now_ + 100ms, 100ms));
+  EXPECT_EQ(sizer.limit(), config_.max_bytes);
+
+  transport::BufferSizer idle(config_, now_);
+  ASSERT_TRUE(idle.record(0, now_ + 100ms, 100ms));
+  EXPECT_EQ(idle.limit(), config_.min_bytes);
+}
+
+TEST_F(BufferSizerTest, DecaysGraduallyWhenIdle) {
+  transport::BufferSizer sizer(config_, now_);
+  ASSERT_TRUE(sizer.record(1'000'000, now_ + 100ms, 100ms));
+  const double peak = sizer.bandwidth();
+
+  ASSERT_TRUE(sizer.record(0, now_ + 200ms, 100ms));
+  EXPECT_DOUBLE_EQ(sizer.bandwidth(), peak / 2);
+
+  auto t = now_ + 200ms;
+  for (int i = 0; i < 20; ++i) {
+    t += 100ms;
+    sizer.record(0, t, 100ms);
+  }
+  EXPECT_EQ(sizer.limit(), config_.min_bytes);
+}
+
+}  // namespace veil::tests
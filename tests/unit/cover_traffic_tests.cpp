@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "common/obfuscation/cover_traffic.h"
+#include "common/obfuscation/obfuscation_profile.h"
+
+namespace veil::tests {
+
+using namespace std::chrono_literals;
+
+class CoverTrafficTest : public ::testing::Test {
+ protected:
+  void use_mode(obfuscation::DPIBypassMode mode) {
+    profile_ = obfuscation::create_dpi_mode_profile(mode);
+    profile_.profile_seed.fill(0x17);
+  }
+
+  obfuscation::CoverTrafficScheduler make_scheduler() {
+    return obfuscation::CoverTrafficScheduler(profile_, kHeartbeatOverhead, [this] { return now_; });
+  }
+
+  static constexpr std::size_t kHeartbeatOverhead = 19;
+  obfuscation::ObfuscationProfile profile_;
+  obfuscation::CoverTrafficScheduler::TimePoint now_{std::chrono::steady_clock::now()};
+};
+
+TEST_F(CoverTrafficTest, DataWaitsAtMostOneSlotInterval) {
+  use_mode(obfuscation::DPIBypassMode::kIoTMimic);
+  ASSERT_TRUE(profile_.cover_traffic);
+  auto scheduler = make_scheduler();
+
+  auto slot = scheduler.poll(100);
+  ASSERT_TRUE(slot.has_value());
+  EXPECT_EQ(slot->kind, obfuscation::CoverSlotKind::kData);
+  EXPECT_FALSE(scheduler.poll(100).has_value());
+
+  for (int i = 0; i < 200; ++i) {
+    const auto wait = scheduler.next_wakeup(true) - now_;
+    EXPECT_GE(wait, profile_.cover_slot_interval / 2);
+    EXPECT_LE(wait, profile_.cover_slot_interval);
+    now_ = scheduler.next_wakeup(true);
+    ASSERT_TRUE(scheduler.poll(100).has_value());
+  }
+  EXPECT_EQ(scheduler.stats().data_slots, 201U);
+
+  // After an idle spell the next packet goes at once, without a burst.
+  now_ += 5s;
+  EXPECT_TRUE(scheduler.poll(100).has_value());
+  EXPECT_FALSE(scheduler.poll(100).has_value());
+}
+
+TEST_F(CoverTrafficTest, HeartbeatsOnlyWhileNothingIsQueued) {
+  use_mode(obfuscation::DPIBypassMode::kIoTMimic);
+  auto scheduler = make_scheduler();
+
+  // Two minutes of data: longer than any heartbeat gap, yet no heartbeat.
+  const auto until = now_ + 120s;
+  while (now_ < until) {
+    if (const auto slot = scheduler.poll(80)) {
+      EXPECT_EQ(slot->kind, obfuscation::CoverSlotKind::kData);
+    }
+    now_ += 5ms;
+  }
+  EXPECT_EQ(scheduler.stats().heartbeat_slots, 0U);
+  EXPECT_EQ(scheduler.stats().heartbeats_replaced, 0U);
+
+  // Idle: nothing until the heartbeat is due.
+  EXPECT_FALSE(scheduler.poll(0).has_value());
+  const auto due = scheduler.next_wakeup(false);
+  EXPECT_GT(due, now_);
+  now_ = due;
+  const auto slot = scheduler.poll(0);
+  ASSERT_TRUE(slot.has_value());
+  EXPECT_EQ(slot->kind, obfuscation::CoverSlotKind::kHeartbeat);
+  EXPECT_FALSE(slot->heartbeat.empty());
+  EXPECT_GE(slot->size, slot->heartbeat.size() + kHeartbeatOverhead);
+  EXPECT_EQ(scheduler.stats().heartbeat_slots, 1U);
+}
+
+TEST_F(CoverTrafficTest, DataTakesTheSlotOfADueHeartbeat) {
+  use_mode(obfuscation::DPIBypassMode::kIoTMimic);
+  auto scheduler = make_scheduler();
+
+  now_ = scheduler.next_wakeup(false);
+  const auto slot = scheduler.poll(100);
+  ASSERT_TRUE(slot.has_value());
+  EXPECT_EQ(slot->kind, obfuscation::CoverSlotKind::kData);
+  EXPECT_EQ(scheduler.stats().heartbeats_replaced, 1U);
+  EXPECT_EQ(scheduler.stats().heartbeat_slots, 0U);
+
+  // The heartbeat is rescheduled, not sent late.
+  EXPECT_FALSE(scheduler.poll(0).has_value());
+  EXPECT_GT(scheduler.next_wakeup(false), now_);
+}
+
+TEST_F(CoverTrafficTest, SlotSizesFollowTheProfileClasses) {
+  use_mode(obfuscation::DPIBypassMode::kIoTMimic);
+  const auto& dist = profile_.padding_distribution;
+  auto scheduler = make_scheduler();
+
+  std::uint64_t padding = 0;
+  for (int i = 0; i < 500; ++i) {
+    now_ += profile_.cover_slot_interval;
+    const auto slot = scheduler.poll(200);
+    ASSERT_TRUE(slot.has_value());
+    // Padded to a drawn size that holds it, or to the smallest class that does.
+    EXPECT_GE(slot->size, 200U);
+    EXPECT_TRUE(slot->size <= dist.large_max) << slot->size;
+    if (slot->size > 200 && slot->size != dist.medium_max && slot->size != dist.large_max) {
+      EXPECT_GE(slot->size, dist.medium_min);
+    }
+    padding += slot->size - 200;
+  }
+  EXPECT_EQ(scheduler.stats().padding_bytes, padding);
+
+  // Larger than every class: sent as is.
+  now_ += profile_.cover_slot_interval;
+  const auto slot = scheduler.poll(1200);
+  ASSERT_TRUE(slot.has_value());
+  EXPECT_EQ(slot->size, 1200U);
+}
+
+TEST_F(CoverTrafficTest, TrickleKeepsSmallPacketsSmall) {
+  use_mode(obfuscation::DPIBypassMode::kTrickle);
+  ASSERT_TRUE(profile_.cover_traffic);
+  auto scheduler = make_scheduler();
+
+  for (int i = 0; i < 100; ++i) {
+    now_ += profile_.cover_slot_interval;
+    const auto slot = scheduler.poll(40);
+    ASSERT_TRUE(slot.has_value());
+    EXPECT_GE(slot->size, 40U);
+    EXPECT_LE(slot->size, profile_.padding_distribution.small_max);
+  }
+}
+
+}  // namespace veil::tests
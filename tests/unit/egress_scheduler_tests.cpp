@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "server/egress_scheduler.h"
+
+namespace veil::server::test {
+
+using namespace std::chrono_literals;
+
+class EgressSchedulerTest : public ::testing::Test {
+ protected:
+  using Clock = std::chrono::steady_clock;
+
+  std::function<Clock::time_point()> now_fn() {
+    return [this]() { return now_; };
+  }
+
+  // Drain up to max_packets and return the session order.
+  std::vector<std::uint64_t> drain(EgressScheduler& scheduler, std::size_t max_packets) {
+    std::vector<std::uint64_t> order;
+    scheduler.drain(
+        max_packets, [&](transport::UdpPacket&) { order.push_back(0); },
+        [&](std::uint64_t id, std::span<const std::uint8_t>) {
+          order.push_back(id);
+          return true;
+        });
+    return order;
+  }
+
+  static EgressSchedulerConfig with_quantum(std::size_t quantum_bytes) {
+    EgressSchedulerConfig config;
+    config.quantum_bytes = quantum_bytes;
+    return config;
+  }
+
+  static std::vector<std::uint8_t> packet(std::size_t size) {
+    return std::vector<std::uint8_t>(size, 0xAB);
+  }
+
+  Clock::time_point now_{Clock::now()};
+};
+
+TEST_F(EgressSchedulerTest, RoundRobinAcrossSessions) {
+  EgressScheduler scheduler(with_quantum(1000), now_fn());
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(scheduler.enqueue(1, packet(1000)));
+  }
+  ASSERT_TRUE(scheduler.enqueue(2, packet(1000)));
+  ASSERT_TRUE(scheduler.enqueue(2, packet(1000)));
+
+  // The bulk session does not send its backlog ahead of session 2.
+  EXPECT_EQ(drain(scheduler, 10), (std::vector<std::uint64_t>{1, 2, 1, 2, 1, 1}));
+  EXPECT_TRUE(scheduler.empty());
+  EXPECT_EQ(scheduler.stats().queued_bytes, 0U);
+}
+
+TEST_F(EgressSchedulerTest, DeficitSharesBytesNotPackets) {
+  EgressScheduler scheduler(with_quantum(1000), now_fn());
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_TRUE(scheduler.enqueue(1, packet(250)));
+  }
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(scheduler.enqueue(2, packet(1000)));
+  }
+
+  // Four small packets per turn match one large one.
+  EXPECT_EQ(drain(scheduler, 20),
+            (std::vector<std::uint64_t>{1, 1, 1, 1, 2, 1, 1, 1, 1, 2}));
+}
+
+TEST_F(EgressSchedulerTest, PriorityTrafficGoesFirst) {
+  EgressScheduler scheduler({}, now_fn());
+  ASSERT_TRUE(scheduler.enqueue(1, packet(100)));
+  scheduler.enqueue_priority(transport::UdpPacket{packet(50), {"10.0.0.1", 1}});
+
+  EXPECT_EQ(drain(scheduler, 10), (std::vector<std::uint64_t>{0, 1}));
+  EXPECT_EQ(scheduler.stats().priority_packets_sent, 1U);
+}
+
+TEST_F(EgressSchedulerTest, PriorityQueueIsBounded) {
+  EgressSchedulerConfig config;
+  config.max_priority_packets = 2;
+  EgressScheduler scheduler(config, now_fn());
+  EXPECT_TRUE(scheduler.enqueue_priority(transport::UdpPacket{packet(50), {"10.0.0.1", 1}}));
+  EXPECT_TRUE(scheduler.enqueue_priority(transport::UdpPacket{packet(50), {"10.0.0.1", 1}}));
+  EXPECT_FALSE(scheduler.enqueue_priority(transport::UdpPacket{packet(50), {"10.0.0.1", 1}}));
+  EXPECT_EQ(scheduler.stats().priority_packets_dropped, 1U);
+  EXPECT_EQ(drain(scheduler, 10), (std::vector<std::uint64_t>{0, 0}));
+}
+
+TEST_F(EgressSchedulerTest, SealedPacketsShareTheSessionTurn) {
+  EgressScheduler scheduler(with_quantum(1000), now_fn());
+  ASSERT_TRUE(scheduler.enqueue(1, packet(1000)));
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(scheduler.enqueue_sealed(1, transport::UdpPacket{packet(1000), {"10.0.0.1", 1}}));
+  }
+  ASSERT_TRUE(scheduler.enqueue(2, packet(1000)));
+
+  // A burst of retransmissions leads session 1's queue but takes one
+  // quantum per turn like its other traffic, so session 2 is not starved.
+  EXPECT_EQ(drain(scheduler, 10), (std::vector<std::uint64_t>{0, 2, 0, 0, 1}));
+  EXPECT_EQ(scheduler.stats().priority_packets_sent, 0U);
+  EXPECT_EQ(scheduler.stats().queued_bytes, 0U);
+}
+
+TEST_F(EgressSchedulerTest, SealedPacketsCountAgainstQueueAndQuota) {
+  utils::RateLimiterConfig limit;
+  limit.bandwidth_bytes_per_sec = 2000;
+  limit.burst_allowance_factor = 1.0;
+  EgressSchedulerConfig config;
+  config.max_queue_bytes = 3000;
+  config.session_rate_limit = limit;
+  EgressScheduler scheduler(config, now_fn());
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(scheduler.enqueue_sealed(1, transport::UdpPacket{packet(1000), {"10.0.0.1", 1}}));
+  }
+  EXPECT_FALSE(scheduler.enqueue_sealed(1, transport::UdpPacket{packet(1000), {"10.0.0.1", 1}}));
+  EXPECT_EQ(scheduler.stats().packets_dropped, 1U);
+
+  EXPECT_EQ(drain(scheduler, 10), (std::vector<std::uint64_t>{0, 0}));
+  now_ += 500ms;
+  EXPECT_EQ(drain(scheduler, 10), (std::vector<std::uint64_t>{0}));
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST_F(EgressSchedulerTest, InteractivePacketsLeadWithinTheSessionTurn) {
+  EgressScheduler scheduler(with_quantum(1000), now_fn());
+  ASSERT_TRUE(scheduler.enqueue(1, packet(1000)));
+  ASSERT_TRUE(scheduler.enqueue(1, packet(1000)));
+  ASSERT_TRUE(scheduler.enqueue(1, packet(500), true));
+  ASSERT_TRUE(scheduler.enqueue(2, packet(1000)));
+
+  std::vector<std::pair<std::uint64_t, std::size_t>> sent;
+  scheduler.drain(
+      10, [](transport::UdpPacket&) {},
+      [&](std::uint64_t id, std::span<const std::uint8_t> data) {
+        sent.emplace_back(id, data.size());
+        return true;
+      });
+
+  // The interactive packet jumps its own session's queue but still counts
+  // against that session's quantum, so session 2 is not held back.
+  const std::vector<std::pair<std::uint64_t, std::size_t>> expected{
+      {1, 500}, {2, 1000}, {1, 1000}, {1, 1000}};
+  EXPECT_EQ(sent, expected);
+}
+
+TEST_F(EgressSchedulerTest, BudgetStopsMidTurnAndResumes) {
+  EgressScheduler scheduler(with_quantum(3000), now_fn());
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(scheduler.enqueue(1, packet(1000)));
+  }
+  ASSERT_TRUE(scheduler.enqueue(2, packet(1000)));
+
+  EXPECT_EQ(drain(scheduler, 2), (std::vector<std::uint64_t>{1, 1}));
+  // Session 1 finishes its turn before session 2 is served.
+  EXPECT_EQ(drain(scheduler, 2), (std::vector<std::uint64_t>{1, 2}));
+}
+
+TEST_F(EgressSchedulerTest, FullQueueDrops) {
+  EgressSchedulerConfig config;
+  config.max_queue_bytes = 2000;
+  EgressScheduler scheduler(config, now_fn());
+  EXPECT_TRUE(scheduler.enqueue(1, packet(1000)));
+  EXPECT_TRUE(scheduler.enqueue(1, packet(1000)));
+  EXPECT_FALSE(scheduler.enqueue(1, packet(1000)));
+  // Other sessions are unaffected.
+  EXPECT_TRUE(scheduler.enqueue(2, packet(1000)));
+
+  EXPECT_EQ(scheduler.stats().packets_dropped, 1U);
+  EXPECT_EQ(scheduler.queued_bytes(1), 2000U);
+}
+
+TEST_F(EgressSchedulerTest, QuotaThrottlesOnlyTheBusySession) {
+  utils::RateLimiterConfig limit;
+  limit.bandwidth_bytes_per_sec = 2000;
+  limit.burst_allowance_factor = 1.0;
+  EgressSchedulerConfig config;
+  config.session_rate_limit = limit;
+  EgressScheduler scheduler(config, now_fn());
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(scheduler.enqueue(1, packet(1000)));
+  }
+
+  EXPECT_EQ(drain(scheduler, 10), (std::vector<std::uint64_t>{1, 1}));
+  EXPECT_GE(scheduler.stats().throttled_turns, 1U);
+
+  // A fresh session has its own quota.
+  ASSERT_TRUE(scheduler.enqueue(2, packet(1000)));
+  EXPECT_EQ(drain(scheduler, 10), (std::vector<std::uint64_t>{2}));
+
+  // Tokens refill with time; no penalty lockout.
+  now_ += 500ms;
+  EXPECT_EQ(drain(scheduler, 10), (std::vector<std::uint64_t>{1}));
+  now_ += 500ms;
+  EXPECT_EQ(drain(scheduler, 10), (std::vector<std::uint64_t>{1}));
+  EXPECT_TRUE(scheduler.empty());
+}
+
+TEST_F(EgressSchedulerTest, GoneSessionQueueDiscarded) {
+  EgressScheduler scheduler({}, now_fn());
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(scheduler.enqueue(1, packet(100)));
+  }
+  std::size_t calls = 0;
+  scheduler.drain(
+      10, [](transport::UdpPacket&) {},
+      [&](std::uint64_t, std::span<const std::uint8_t>) {
+        ++calls;
+        return false;
+      });
+  EXPECT_EQ(calls, 1U);
+  EXPECT_TRUE(scheduler.empty());
+  EXPECT_EQ(scheduler.stats().packets_dropped, 2U);
+}
+
+TEST_F(EgressSchedulerTest, PruneRemovesQueuedSessions) {
+  EgressScheduler scheduler({}, now_fn());
+  ASSERT_TRUE(scheduler.enqueue(1, packet(100)));
+  ASSERT_TRUE(scheduler.enqueue(2, packet(100)));
+
+  EXPECT_EQ(scheduler.prune([](std::uint64_t id) { return id == 1; }), 1U);
+  EXPECT_EQ(scheduler.queued_bytes(1), 0U);
+  EXPECT_EQ(drain(scheduler, 10), (std::vector<std::uint64_t>{2}));
+}
+
+}  // namespace veil::server::test
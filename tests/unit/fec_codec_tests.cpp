@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "transport/mux/fec_codec.h"
+#include "transport/mux/gf256.h"
+
+namespace veil::tests {
+
+using namespace std::chrono_literals;
+
+namespace {
+
+std::vector<std::uint8_t> make_packet(std::uint64_t sequence, std::size_t size) {
+  std::vector<std::uint8_t> packet(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    packet[i] = static_cast<std::uint8_t>(sequence * 31 + i * 7);
+  }
+  return packet;
+}
+
+}  // namespace
+
+TEST(Gf256Test, MultiplicationAndInverse) {
+  EXPECT_EQ(mux::gf256_mul(0, 0x53), 0);
+  EXPECT_EQ(mux::gf256_mul(1, 0x53), 0x53);
+  // x * x^7 = x^8 = x^4 + x^3 + x^2 + 1.
+  EXPECT_EQ(mux::gf256_mul(0x02, 0x80), 0x1d);
+  for (unsigned a = 1; a < 256; ++a) {
+    const auto value = static_cast<std::uint8_t>(a);
+    EXPECT_EQ(mux::gf256_mul(value, mux::gf256_inv(value)), 1);
+  }
+}
+
+TEST(Gf256Test, RegionKernelMatchesScalarProduct) {
+  // Odd length exercises the vector body and the scalar tail.
+  std::vector<std::uint8_t> src(1000 + 13);
+  std::vector<std::uint8_t> dst(src.size());
+  for (std::size_t i = 0; i < src.size(); ++i) {
+    src[i] = static_cast<std::uint8_t>(i * 13 + 5);
+    dst[i] = static_cast<std::uint8_t>(i * 3);
+  }
+  for (const std::uint8_t c : std::array<std::uint8_t, 5>{0x00, 0x01, 0x02, 0x8e, 0xff}) {
+    auto expected = dst;
+    for (std::size_t i = 0; i < src.size(); ++i) {
+      expected[i] ^= mux::gf256_mul(c, src[i]);
+    }
+    auto actual = dst;
+    mux::gf256_mul_add(actual.data(), src.data(), c, src.size());
+    EXPECT_EQ(actual, expected) << "c=" << static_cast<int>(c)
+                                << " kernel=" << mux::gf256_kernel_name();
+
+    auto scaled = src;
+    mux::gf256_mul_region(scaled.data(), c, scaled.size());
+    for (std::size_t i = 0; i < src.size(); ++i) {
+      ASSERT_EQ(scaled[i], mux::gf256_mul(c, src[i]));
+    }
+  }
+}
+
+class FecCodecTest : public ::testing::Test {
+ protected:
+  // Encode `count` packets from sequence 100 and return the repairs.
+  std::vector<mux::FecRepair> encode(std::size_t count) {
+    mux::FecEncoder encoder(config_);
+    std::vector<mux::FecRepair> repairs;
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto sequence = 100 + i;
+      packets_.push_back(make_packet(sequence, 50 + 37 * i));
+      auto closed = encoder.add(sequence, packets_.back(), now_);
+      repairs.insert(repairs.end(), closed.begin(), closed.end());
+    }
+    return repairs;
+  }
+
+  mux::FecConfig config_{.enabled = true, .block_size = 8, .min_repair_ratio = 0.25};
+  mux::FecEncoder::TimePoint now_{std::chrono::steady_clock::now()};
+  std::vector<std::vector<std::uint8_t>> packets_;
+};
+
+TEST_F(FecCodecTest, FullBlockEmitsRepairs) {
+  const auto repairs = encode(8);
+  ASSERT_EQ(repairs.size(), 2U);
+  for (const auto& repair : repairs) {
+    EXPECT_EQ(repair.base_sequence, 100U);
+    EXPECT_EQ(repair.source_mask, 0xFFU);
+    // Longest source plus its length prefix.
+    EXPECT_EQ(repair.symbol.size(), packets_.back().size() + 2);
+  }
+  EXPECT_EQ(repairs[0].index, 0);
+  EXPECT_EQ(repairs[1].index, 1);
+}
+
+TEST_F(FecCodecTest, RecoversAsManyLossesAsRepairs) {
+  const auto repairs = encode(8);
+  mux::FecDecoder decoder;
+  const std::set<std::size_t> lost{2, 7};
+  for (std::size_t i = 0; i < packets_.size(); ++i) {
+    if (lost.count(i) == 0) {
+      EXPECT_TRUE(decoder.on_source(100 + i, packets_[i]).empty());
+    }
+  }
+  EXPECT_TRUE(decoder.on_repair(repairs[1]).empty());
+  const auto recovered = decoder.on_repair(repairs[0]);
+  ASSERT_EQ(recovered.size(), 2U);
+  for (const auto& packet : recovered) {
+    ASSERT_EQ(lost.count(packet.sequence - 100), 1U);
+    EXPECT_EQ(packet.plaintext, packets_[packet.sequence - 100]);
+  }
+  EXPECT_EQ(decoder.recovered(), 2U);
+}
+
+TEST_F(FecCodecTest, LateSourceCompletesWaitingBlock) {
+  const auto repairs = encode(8);
+  mux::FecDecoder decoder;
+  for (std::size_t i = 0; i < 5; ++i) {
+    decoder.on_source(100 + i, packets_[i]);
+  }
+  // Three missing, two repairs: wait.
+  EXPECT_TRUE(decoder.on_repair(repairs[0]).empty());
+  EXPECT_TRUE(decoder.on_repair(repairs[1]).empty());
+
+  const auto recovered = decoder.on_source(105, packets_[5]);
+  ASSERT_EQ(recovered.size(), 2U);
+  EXPECT_EQ(recovered[0].sequence, 106U);
+  EXPECT_EQ(recovered[0].plaintext, packets_[6]);
+  EXPECT_EQ(recovered[1].sequence, 107U);
+  EXPECT_EQ(recovered[1].plaintext, packets_[7]);
+}
+
+TEST_F(FecCodecTest, TimeoutClosesPartialBlock) {
+  mux::FecEncoder encoder(config_);
+  const auto packet = make_packet(5, 100);
+  EXPECT_TRUE(encoder.add(5, packet, now_).empty());
+  EXPECT_TRUE(encoder.flush_expired(now_ + 10ms).empty());
+  const auto repairs = encoder.flush_expired(now_ + config_.block_timeout);
+  ASSERT_EQ(repairs.size(), 1U);
+
+  // A one-packet block's repair is the packet itself.
+  mux::FecDecoder decoder;
+  const auto recovered = decoder.on_repair(repairs[0]);
+  ASSERT_EQ(recovered.size(), 1U);
+  EXPECT_EQ(recovered[0].sequence, 5U);
+  EXPECT_EQ(recovered[0].plaintext, packet);
+}
+
+TEST_F(FecCodecTest, BlockClosesWhenSpanIsExceeded) {
+  mux::FecEncoder encoder(config_);
+  EXPECT_TRUE(encoder.add(0, make_packet(0, 10), now_).empty());
+  const auto repairs = encoder.add(mux::kFecMaxSpan, make_packet(1, 10), now_);
+  ASSERT_FALSE(repairs.empty());
+  EXPECT_EQ(repairs[0].source_mask, 1U);
+}
+
+TEST_F(FecCodecTest, RepairRatioFollowsReportedLoss) {
+  mux::FecEncoder encoder(config_);
+  EXPECT_EQ(encoder.repair_count(8), 2U);
+
+  for (int i = 0; i < 20; ++i) {
+    encoder.on_loss_report(mux::LossReport{80, 20});
+  }
+  EXPECT_NEAR(encoder.loss_rate(), 0.2, 0.01);
+  // 2 x 20% loss = 40% of 8 sources, rounded up.
+  EXPECT_EQ(encoder.repair_count(8), 4U);
+
+  for (int i = 0; i < 20; ++i) {
+    encoder.on_loss_report(mux::LossReport{100, 100});
+  }
+  // Capped at max_repair_ratio.
+  EXPECT_EQ(encoder.repair_count(8), 4U);
+}
+
+TEST_F(FecCodecTest, DecoderReportsLossBeforeRecovery) {
+  mux::FecDecoder decoder;
+  std::uint64_t sequence = 0;
+  // 8 blocks of 8 with one loss each.
+  for (int block = 0; block < 8; ++block) {
+    mux::FecEncoder encoder(config_);
+    std::vector<mux::FecRepair> repairs;
+    for (int i = 0; i < 8; ++i, ++sequence) {
+      const auto packet = make_packet(sequence, 64);
+      repairs = encoder.add(sequence, packet, now_);
+      if (i != 3) {
+        decoder.on_source(sequence, packet);
+      }
+    }
+    ASSERT_FALSE(repairs.empty());
+    EXPECT_EQ(decoder.on_repair(repairs[0]).size(), 1U);
+  }
+  const auto report = decoder.take_loss_report();
+  ASSERT_TRUE(report.has_value());
+  EXPECT_EQ(report->received, 56U);
+  EXPECT_EQ(report->lost, 8U);
+  EXPECT_FALSE(decoder.take_loss_report().has_value());
+}
+
+}  // namespace veil::tests
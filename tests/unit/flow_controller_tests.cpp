@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <limits>
+#include <optional>
+
+#include "transport/mux/mux_codec.h"
+#include "transport/session/flow_controller.h"
+
+namespace veil::tests {
+
+using namespace std::chrono_literals;
+
+class FlowControllerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    config_.connection_window.min_bytes = 10'000;
+    config_.connection_window.max_bytes = 100'000;
+    config_.max_stream_window = 8'000;
+  }
+
+  static std::size_t nothing_held(std::uint64_t /*stream_id*/) { return 0; }
+
+  transport::FlowController::TimePoint now_{std::chrono::steady_clock::now()};
+  transport::FlowControlConfig config_;
+};
+
+TEST_F(FlowControllerTest, UnlimitedUntilPeerAdvertises) {
+  transport::FlowController fc(config_, now_);
+  EXPECT_EQ(fc.send_credit(mux::kConnectionStream), std::numeric_limits<std::size_t>::max());
+  fc.on_data_sent(0, 1, 0, 50'000);
+  EXPECT_EQ(fc.send_credit(1), std::numeric_limits<std::size_t>::max());
+}
+
+TEST_F(FlowControllerTest, SentBytesCountAgainstWindowUntilAcknowledged) {
+  transport::FlowController fc(config_, now_);
+  fc.on_window_update(mux::WindowUpdate{mux::kConnectionStream, 0, 3'000});
+  fc.on_data_sent(0, 1, std::nullopt, 1'000);
+  fc.on_data_sent(1, 1, std::nullopt, 1'000);
+  EXPECT_EQ(fc.send_credit(mux::kConnectionStream), 1'000U);
+
+  // The peer has seen packet 0: its bytes no longer count.
+  fc.on_window_update(mux::WindowUpdate{mux::kConnectionStream, 1, 3'000});
+  EXPECT_EQ(fc.send_credit(mux::kConnectionStream), 2'000U);
+
+  // A stale update is ignored.
+  fc.on_window_update(mux::WindowUpdate{mux::kConnectionStream, 0, 500});
+  EXPECT_EQ(fc.send_credit(mux::kConnectionStream), 2'000U);
+}
+
+TEST_F(FlowControllerTest, StreamCreditIsBoundedByConnectionCredit) {
+  transport::FlowController fc(config_, now_);
+  fc.on_window_update(mux::WindowUpdate{mux::kConnectionStream, 0, 5'000});
+  fc.on_window_update(mux::WindowUpdate{4, 0, 2'000});
+  EXPECT_EQ(fc.send_credit(4), 2'000U);
+  // Streams without their own window see the connection credit.
+  EXPECT_EQ(fc.send_credit(9), 5'000U);
+
+  fc.on_data_sent(0, 4, 0, 1'500);
+  EXPECT_EQ(fc.send_credit(4), 500U);
+  EXPECT_EQ(fc.send_credit(9), 3'500U);
+}
+
+TEST_F(FlowControllerTest, BlockedNoticeSentOncePerRtt) {
+  transport::FlowController fc(config_, now_);
+  fc.on_window_update(mux::WindowUpdate{mux::kConnectionStream, 0, 1'000});
+  fc.on_data_sent(0, 1, std::nullopt, 1'000);
+  fc.on_blocked(1, 500);
+
+  auto frames = fc.take_control_frames(now_, 50ms, nothing_held);
+  ASSERT_EQ(frames.size(), 1U);
+  EXPECT_EQ(mux::parse_blocked(frames[0].control), mux::kConnectionStream);
+  EXPECT_TRUE(fc.take_control_frames(now_ + 10ms, 50ms, nothing_held).empty());
+  EXPECT_EQ(fc.take_control_frames(now_ + 50ms, 50ms, nothing_held).size(), 1U);
+
+  // Fresh credit clears the blocked state.
+  fc.on_window_update(mux::WindowUpdate{mux::kConnectionStream, 1, 1'000});
+  EXPECT_TRUE(fc.take_control_frames(now_ + 200ms, 50ms, nothing_held).empty());
+}
+
+TEST_F(FlowControllerTest, AdvertisesWindowOnceDataArrives) {
+  transport::FlowController fc(config_, now_);
+  EXPECT_TRUE(fc.take_control_frames(now_, 50ms, nothing_held).empty());
+
+  fc.on_data_received(0, 3, 0, 1'000, now_, 50ms);
+  const auto frames = fc.take_control_frames(now_, 50ms, nothing_held);
+  ASSERT_EQ(frames.size(), 2U);
+  for (const auto& frame : frames) {
+    const auto update = mux::parse_window_update(frame.control);
+    ASSERT_TRUE(update.has_value());
+    EXPECT_EQ(update->sequence, 1U);
+    if (update->stream_id == mux::kConnectionStream) {
+      EXPECT_EQ(update->window, config_.connection_window.min_bytes);
+    } else {
+      EXPECT_EQ(update->stream_id, 3U);
+      EXPECT_EQ(update->window, config_.max_stream_window);
+    }
+  }
+  // Nothing new to say until data flows again.
+  EXPECT_TRUE(fc.take_control_frames(now_ + 10ms, 50ms, nothing_held).empty());
+}
+
+TEST_F(FlowControllerTest, HeldBytesCloseTheWindow) {
+  transport::FlowController fc(config_, now_);
+  fc.on_data_received(0, 3, 0, 1'000, now_, 50ms);
+  const auto frames = fc.take_control_frames(now_, 50ms, [](std::uint64_t stream_id) {
+    return stream_id == mux::kConnectionStream ? std::size_t{4'000} : std::size_t{3'000};
+  });
+  ASSERT_EQ(frames.size(), 2U);
+  for (const auto& frame : frames) {
+    const auto update = mux::parse_window_update(frame.control);
+    ASSERT_TRUE(update.has_value());
+    EXPECT_EQ(update->window, update->stream_id == mux::kConnectionStream ? 6'000U : 5'000U);
+  }
+}
+
+TEST_F(FlowControllerTest, DropsShrinkAndPeerBlockedGrowsWindow) {
+  config_.connection_window.min_bytes = 1'000;
+  transport::FlowController fc(config_, now_);
+  // 80 KB in 100 ms at 100 ms RTT: 2 x BDP = 160 KB, capped at 100 KB.
+  fc.on_data_received(0, 1, std::nullopt, 80'000, now_ + 100ms, 100ms);
+  EXPECT_EQ(fc.receive_window(), 100'000U);
+
+  fc.on_receive_drop();
+  EXPECT_EQ(fc.receive_window(), 50'000U);
+
+  fc.on_peer_blocked(mux::kConnectionStream);
+  const auto frames = fc.take_control_frames(now_ + 100ms, 100ms, nothing_held);
+  EXPECT_EQ(fc.receive_window(), 100'000U);
+  ASSERT_FALSE(frames.empty());
+  EXPECT_EQ(mux::parse_window_update(frames[0].control)->window, 100'000U);
+}
+
+TEST_F(FlowControllerTest, DropsNeverShrinkBelowFloor) {
+  transport::FlowController fc(config_, now_);
+  for (int i = 0; i < 10; ++i) {
+    fc.on_receive_drop();
+  }
+  EXPECT_EQ(fc.receive_window(), config_.connection_window.min_bytes);
+}
+
+}  // namespace veil::tests
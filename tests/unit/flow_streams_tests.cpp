@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "transport/mux/flow_streams.h"
+
+namespace veil::tests {
+
+namespace {
+
+std::vector<std::uint8_t> make_ipv4_udp(std::uint16_t src_port, std::uint8_t dscp = 0) {
+  std::vector<std::uint8_t> packet{0x45, static_cast<std::uint8_t>(dscp << 2), 0, 28};
+  packet.resize(28);
+  packet[8] = 64;
+  packet[9] = 17;
+  packet[12] = 10;
+  packet[15] = 2;
+  packet[16] = 10;
+  packet[19] = 1;
+  packet[20] = static_cast<std::uint8_t>(src_port >> 8);
+  packet[21] = static_cast<std::uint8_t>(src_port);
+  packet[23] = 53;
+  return packet;
+}
+
+}  // namespace
+
+TEST(FlowStreamsTest, DscpSelectsPriorityBand) {
+  EXPECT_EQ(mux::priority_for_dscp(0), mux::StreamPriority::kNormal);
+  EXPECT_EQ(mux::priority_for_dscp(46), mux::StreamPriority::kInteractive);  // EF
+  EXPECT_EQ(mux::priority_for_dscp(34), mux::StreamPriority::kInteractive);  // AF41
+  EXPECT_EQ(mux::priority_for_dscp(48), mux::StreamPriority::kInteractive);  // CS6
+  EXPECT_EQ(mux::priority_for_dscp(10), mux::StreamPriority::kNormal);       // AF11
+  EXPECT_EQ(mux::priority_for_dscp(16), mux::StreamPriority::kNormal);       // CS2
+  EXPECT_EQ(mux::priority_for_dscp(8), mux::StreamPriority::kBulk);          // CS1
+  EXPECT_EQ(mux::priority_for_dscp(1), mux::StreamPriority::kBulk);          // LE
+}
+
+TEST(FlowStreamsTest, StreamIdCarriesBand) {
+  const auto id = mux::make_stream_id(mux::StreamPriority::kInteractive, 5);
+  EXPECT_EQ(mux::stream_priority(id), mux::StreamPriority::kInteractive);
+  EXPECT_EQ(mux::stream_priority(0), mux::StreamPriority::kNormal);
+  EXPECT_EQ(mux::stream_priority(static_cast<std::uint64_t>(9) << mux::kStreamBandShift),
+            mux::StreamPriority::kNormal);
+}
+
+TEST(FlowStreamsTest, FlowStaysOnOneStreamWithinBounds) {
+  mux::FlowStreamConfig config;
+  config.streams_per_band = 4;
+  config.hash_seed = 7;
+  const mux::FlowStreamMapper mapper(config);
+
+  std::set<std::uint64_t> streams;
+  for (std::uint16_t port = 1000; port < 1100; ++port) {
+    const auto stream = mapper.stream_for(make_ipv4_udp(port));
+    EXPECT_EQ(stream, mapper.stream_for(make_ipv4_udp(port)));
+    EXPECT_EQ(mux::stream_priority(stream), mux::StreamPriority::kNormal);
+    streams.insert(stream);
+  }
+  EXPECT_EQ(streams.size(), 4U);
+  EXPECT_LT(*streams.rbegin(), 4U);
+
+  const auto voice = mapper.stream_for(make_ipv4_udp(1000, 46));
+  EXPECT_EQ(mux::stream_priority(voice), mux::StreamPriority::kInteractive);
+}
+
+TEST(FlowStreamsTest, NonIpPacketsUseStreamZero) {
+  const mux::FlowStreamMapper mapper;
+  const std::vector<std::uint8_t> garbage{0x00, 0x01, 0x02};
+  EXPECT_EQ(mapper.stream_for(garbage), 0U);
+}
+
+}  // namespace veil::tests
@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "transport/queue/fq_codel_queue.h"
+#include "tun/ip_packet.h"
+
+namespace veil::tests {
+
+using namespace std::chrono_literals;
+
+namespace {
+
+std::vector<std::uint8_t> make_packet(std::uint16_t src_port, std::size_t size,
+                                      tun::Ecn ecn = tun::Ecn::kNotEct) {
+  // IPv4/UDP 10.0.0.2:src_port -> 10.0.0.1:80, padded to `size`.
+  std::vector<std::uint8_t> packet{0x45, static_cast<std::uint8_t>(ecn),
+                                   static_cast<std::uint8_t>(size >> 8),
+                                   static_cast<std::uint8_t>(size), 0, 0, 0, 0, 64, 17, 0, 0,
+                                   10, 0, 0, 2, 10, 0, 0, 1,
+                                   static_cast<std::uint8_t>(src_port >> 8),
+                                   static_cast<std::uint8_t>(src_port), 0, 80, 0, 0, 0, 0};
+  packet.resize(size);
+  return packet;
+}
+
+std::uint16_t src_port_of(const std::vector<std::uint8_t>& packet) {
+  return static_cast<std::uint16_t>((packet[20] << 8) | packet[21]);
+}
+
+}  // namespace
+
+class FqCodelQueueTest : public ::testing::Test {
+ protected:
+  FqCodelQueueTest() { config_.hash_seed = 0x5EED; }
+
+  transport::FqCodelQueue make_queue() {
+    return transport::FqCodelQueue(config_, [this] { return now_; });
+  }
+
+  transport::FqCodelConfig config_;
+  transport::FqCodelQueue::TimePoint now_{std::chrono::steady_clock::now()};
+};
+
+TEST_F(FqCodelQueueTest, EmptyQueueReturnsNothing) {
+  auto queue = make_queue();
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.dequeue().has_value());
+}
+
+TEST_F(FqCodelQueueTest, PreservesOrderWithinFlow) {
+  auto queue = make_queue();
+  for (std::size_t i = 0; i < 5; ++i) {
+    auto packet = make_packet(1000, 100);
+    packet[27] = static_cast<std::uint8_t>(i);
+    queue.enqueue(packet);
+  }
+  EXPECT_EQ(queue.backlog_packets(), 5U);
+  EXPECT_EQ(queue.backlog_bytes(), 500U);
+
+  for (std::size_t i = 0; i < 5; ++i) {
+    auto packet = queue.dequeue();
+    ASSERT_TRUE(packet.has_value());
+    EXPECT_EQ((*packet)[27], i);
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(FqCodelQueueTest, SparseFlowJumpsAheadOfBulkBacklog) {
+  auto queue = make_queue();
+  for (int i = 0; i < 50; ++i) {
+    queue.enqueue(make_packet(1000, 1000));
+  }
+  // The bulk flow uses up its first quantum.
+  ASSERT_TRUE(queue.dequeue().has_value());
+  ASSERT_TRUE(queue.dequeue().has_value());
+
+  queue.enqueue(make_packet(2000, 100));
+  auto next = queue.dequeue();
+  ASSERT_TRUE(next.has_value());
+  EXPECT_EQ(src_port_of(*next), 2000);
+}
+
+TEST_F(FqCodelQueueTest, BackloggedFlowsShareByBytes) {
+  auto queue = make_queue();
+  for (int i = 0; i < 40; ++i) {
+    queue.enqueue(make_packet(1000, 1500));
+    queue.enqueue(make_packet(2000, 300));
+    queue.enqueue(make_packet(2000, 300));
+    queue.enqueue(make_packet(2000, 300));
+    queue.enqueue(make_packet(2000, 300));
+    queue.enqueue(make_packet(2000, 300));
+  }
+
+  std::size_t bytes_a = 0;
+  std::size_t bytes_b = 0;
+  for (int i = 0; i < 60; ++i) {
+    auto packet = queue.dequeue();
+    ASSERT_TRUE(packet.has_value());
+    (src_port_of(*packet) == 1000 ? bytes_a : bytes_b) += packet->size();
+  }
+  const auto diff = bytes_a > bytes_b ? bytes_a - bytes_b : bytes_b - bytes_a;
+  EXPECT_LE(diff, 2 * config_.quantum_bytes);
+}
+
+TEST_F(FqCodelQueueTest, DropsWhenDelayStaysAboveTarget) {
+  config_.ecn = false;
+  auto queue = make_queue();
+  for (int i = 0; i < 100; ++i) {
+    queue.enqueue(make_packet(1000, 1000));
+  }
+
+  // Delay above target starts the clock; nothing is dropped within the
+  // first interval.
+  now_ += 10ms;
+  ASSERT_TRUE(queue.dequeue().has_value());
+  now_ += 50ms;
+  ASSERT_TRUE(queue.dequeue().has_value());
+  EXPECT_EQ(queue.stats().codel_drops, 0U);
+
+  now_ += 60ms;
+  ASSERT_TRUE(queue.dequeue().has_value());
+  EXPECT_EQ(queue.stats().codel_drops, 1U);
+
+  // Drops continue, faster, while the delay persists.
+  for (int i = 0; i < 10; ++i) {
+    now_ += 50ms;
+    queue.dequeue();
+  }
+  EXPECT_GT(queue.stats().codel_drops, 3U);
+  EXPECT_EQ(queue.stats().ecn_marks, 0U);
+}
+
+TEST_F(FqCodelQueueTest, NoDropsWhileDelayIsBelowTarget) {
+  config_.ecn = false;
+  auto queue = make_queue();
+  for (int i = 0; i < 200; ++i) {
+    queue.enqueue(make_packet(1000, 1000));
+    queue.enqueue(make_packet(1000, 1000));
+    now_ += 1ms;
+    ASSERT_TRUE(queue.dequeue().has_value());
+    ASSERT_TRUE(queue.dequeue().has_value());
+  }
+  EXPECT_EQ(queue.stats().codel_drops, 0U);
+}
+
+TEST_F(FqCodelQueueTest, MarksEcnCapablePacketsInsteadOfDropping) {
+  auto queue = make_queue();
+  for (int i = 0; i < 100; ++i) {
+    queue.enqueue(make_packet(1000, 1000, tun::Ecn::kEct0));
+  }
+
+  now_ += 10ms;
+  ASSERT_TRUE(queue.dequeue().has_value());
+  now_ += 110ms;
+  auto marked = queue.dequeue();
+  ASSERT_TRUE(marked.has_value());
+  EXPECT_EQ(tun::ecn_codepoint(*marked), tun::Ecn::kCe);
+  EXPECT_EQ(queue.stats().ecn_marks, 1U);
+  EXPECT_EQ(queue.stats().codel_drops, 0U);
+  EXPECT_EQ(queue.stats().dequeued, 2U);
+}
+
+TEST_F(FqCodelQueueTest, OverflowDropsFromFattestFlow) {
+  config_.limit_bytes = 10'000;
+  auto queue = make_queue();
+  for (int i = 0; i < 9; ++i) {
+    queue.enqueue(make_packet(1000, 1000));
+  }
+  queue.enqueue(make_packet(2000, 1000));
+  queue.enqueue(make_packet(2000, 1000));
+
+  EXPECT_EQ(queue.stats().overflow_drops, 1U);
+  EXPECT_LE(queue.backlog_bytes(), config_.limit_bytes);
+
+  int sparse = 0;
+  while (auto packet = queue.dequeue()) {
+    sparse += src_port_of(*packet) == 2000 ? 1 : 0;
+  }
+  EXPECT_EQ(sparse, 2);
+}
+
+TEST_F(FqCodelQueueTest, RttRetunesIntervalAndTarget) {
+  auto queue = make_queue();
+  queue.set_rtt(200ms);
+  EXPECT_EQ(queue.interval(), 200ms);
+  EXPECT_EQ(queue.target(), 10ms);
+
+  // Short paths keep the configured target.
+  queue.set_rtt(20ms);
+  EXPECT_EQ(queue.interval(), 20ms);
+  EXPECT_EQ(queue.target(), config_.target);
+
+  // An unmeasured RTT is clamped.
+  queue.set_rtt(0ms);
+  EXPECT_EQ(queue.interval(), 10ms);
+  queue.set_rtt(10s);
+  EXPECT_EQ(queue.interval(), 1s);
+}
+
+TEST_F(FqCodelQueueTest, NonIpPacketsShareOneQueue) {
+  auto queue = make_queue();
+  const std::vector<std::uint8_t> garbage{0x00, 0x01, 0x02};
+  queue.enqueue(garbage);
+  queue.enqueue(garbage);
+  EXPECT_EQ(queue.backlog_packets(), 2U);
+  EXPECT_EQ(*queue.dequeue(), garbage);
+}
+
+}  // namespace veil::tests
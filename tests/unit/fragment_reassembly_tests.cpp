@@ -29,4 +29,20 @@ TEST(FragmentReassemblyTests, RespectsLimit) {
   EXPECT_FALSE(r.push(1, mux::Fragment{1, {2, 3}, true}));
 }
 
+TEST(FragmentReassemblyTests, MemoryFootprintCountsIncompleteMessages) {
+  mux::FragmentReassembly r(2048);
+  EXPECT_EQ(r.memory_footprint().limit, 2048U);
+  EXPECT_TRUE(r.push(1, mux::Fragment{0, std::vector<std::uint8_t>(40, 1), false}));
+  EXPECT_TRUE(r.push(2, mux::Fragment{0, std::vector<std::uint8_t>(60, 2), false}));
+
+  auto footprint = r.memory_footprint();
+  EXPECT_EQ(footprint.in_use, 100U);
+  EXPECT_EQ(footprint.in_use, r.memory_usage());
+  EXPECT_GE(footprint.reserved, 100U + 2 * sizeof(mux::Fragment));
+
+  EXPECT_TRUE(r.push(1, mux::Fragment{40, {3}, true}));
+  ASSERT_TRUE(r.try_reassemble(1).has_value());
+  EXPECT_EQ(r.memory_footprint().in_use, 60U);
+}
+
 }  // namespace veil::tests
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "server/hairpin.h"
+
+namespace veil::tests {
+
+using server::HairpinConfig;
+using server::hairpin_allowed;
+using server::parse_hairpin_rule;
+
+namespace {
+
+constexpr std::uint32_t kClientA = 0x0A080002;  // 10.8.0.2
+constexpr std::uint32_t kClientB = 0x0A080003;  // 10.8.0.3
+constexpr std::uint32_t kClientC = 0x0A080012;  // 10.8.0.18
+
+HairpinConfig with_rules(std::initializer_list<std::pair<const char*, bool>> rules,
+                         bool default_allow) {
+  HairpinConfig config;
+  config.default_allow = default_allow;
+  for (const auto& [text, allow] : rules) {
+    auto rule = parse_hairpin_rule(text);
+    EXPECT_TRUE(rule.has_value()) << text;
+    if (rule) {
+      rule->allow = allow;
+      config.rules.push_back(*rule);
+    }
+  }
+  return config;
+}
+
+}  // namespace
+
+TEST(HairpinTest, ParsesRules) {
+  const auto rule = parse_hairpin_rule(" 10.8.0.0/28 -> any ");
+  ASSERT_TRUE(rule.has_value());
+  EXPECT_EQ(rule->source.address, 0x0A080000U);
+  EXPECT_EQ(rule->source.length, 28);
+  EXPECT_EQ(rule->destination.length, 0);
+
+  const auto bare = parse_hairpin_rule("10.8.0.2>10.8.0.3");
+  ASSERT_TRUE(bare.has_value());
+  EXPECT_TRUE(bare->source.contains(kClientA));
+  EXPECT_TRUE(bare->destination.contains(kClientB));
+
+  EXPECT_FALSE(parse_hairpin_rule("10.8.0.2").has_value());
+  EXPECT_FALSE(parse_hairpin_rule("10.8.0.2->").has_value());
+  EXPECT_FALSE(parse_hairpin_rule("bogus->any").has_value());
+}
+
+TEST(HairpinTest, DefaultAppliesWithoutRules) {
+  HairpinConfig config;
+  EXPECT_TRUE(hairpin_allowed(config, kClientA, kClientB));
+  config.default_allow = false;
+  EXPECT_FALSE(hairpin_allowed(config, kClientA, kClientB));
+}
+
+TEST(HairpinTest, FirstMatchingRuleWins) {
+  // Deny by default; A may reach everyone, but nobody may reach C, which
+  // takes precedence for A as it comes first.
+  const auto config = with_rules({{"any->10.8.0.18", false}, {"10.8.0.2->any", true}}, false);
+
+  EXPECT_TRUE(hairpin_allowed(config, kClientA, kClientB));
+  EXPECT_FALSE(hairpin_allowed(config, kClientA, kClientC));
+  EXPECT_FALSE(hairpin_allowed(config, kClientB, kClientA));
+  EXPECT_FALSE(hairpin_allowed(config, kClientB, kClientC));
+}
+
+TEST(HairpinTest, PrefixRulesMatchSubnets) {
+  // Clients in 10.8.0.0/28 may talk among themselves only.
+  const auto config = with_rules({{"10.8.0.0/28->10.8.0.0/28", true}}, false);
+
+  EXPECT_TRUE(hairpin_allowed(config, kClientA, kClientB));
+  EXPECT_FALSE(hairpin_allowed(config, kClientA, kClientC));
+  EXPECT_FALSE(hairpin_allowed(config, kClientC, kClientA));
+}
+
+}  // namespace veil::tests
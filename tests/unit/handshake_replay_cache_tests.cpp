@@ -203,6 +203,27 @@ TEST_F(HandshakeReplayCacheTest, ThreadSafety) {
   EXPECT_EQ(cache.size(), num_threads * iterations);
 }
 
+TEST_F(HandshakeReplayCacheTest, StatsCountLookupsAndReset) {
+  HandshakeReplayCache cache(100);
+  const auto key = make_key(0x07);
+
+  EXPECT_FALSE(cache.mark_and_check(1000, key));
+  EXPECT_TRUE(cache.mark_and_check(1000, key));
+  EXPECT_FALSE(cache.mark_and_check(1001, key));
+
+  auto stats = cache.stats();
+  EXPECT_EQ(stats.lookups, 3U);
+  // A single thread never finds the mutex held.
+  EXPECT_EQ(stats.contended, 0U);
+  EXPECT_EQ(stats.wait_time.count(), 0);
+
+  cache.reset_stats();
+  stats = cache.stats();
+  EXPECT_EQ(stats.lookups, 0U);
+  // Resetting counters leaves the entries alone.
+  EXPECT_EQ(cache.size(), 2U);
+}
+
 TEST_F(HandshakeReplayCacheTest, ZeroCapacityThrows) {
   EXPECT_THROW(HandshakeReplayCache(0), std::invalid_argument);
 }
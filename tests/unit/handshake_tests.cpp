@@ -3,10 +3,13 @@
 #include <array>
 #include <chrono>
 #include <cstdint>
+#include <memory>
 #include <optional>
+#include <stdexcept>
 #include <vector>
 
 #include "common/handshake/handshake_processor.h"
+#include "common/handshake/handshake_replay_cache.h"
 #include "common/utils/rate_limiter.h"
 
 namespace veil::tests {
@@ -91,6 +94,38 @@ TEST(HandshakeTests, RateLimiterDropsExcess) {
   EXPECT_FALSE(second.has_value());
 }
 
+TEST(HandshakeTests, SharedReplayCacheRejectsReplayOnOtherResponder) {
+  auto now = std::chrono::system_clock::now();
+  auto now_fn = [&]() { return now; };
+  auto steady_fn = [] { return std::chrono::steady_clock::now(); };
+  auto cache = std::make_shared<handshake::HandshakeReplayCache>();
+
+  handshake::HandshakeInitiator initiator(make_psk(), std::chrono::milliseconds(1000), now_fn);
+  handshake::HandshakeResponder first(make_psk(), std::chrono::milliseconds(1000),
+                                      utils::TokenBucket(10.0, std::chrono::milliseconds(1000),
+                                                         steady_fn),
+                                      cache, now_fn);
+  handshake::HandshakeResponder second(make_psk(), std::chrono::milliseconds(1000),
+                                       utils::TokenBucket(10.0, std::chrono::milliseconds(1000),
+                                                          steady_fn),
+                                       cache, now_fn);
+
+  const auto init_bytes = initiator.create_init();
+  EXPECT_TRUE(first.handle_init(init_bytes).has_value());
+  EXPECT_FALSE(second.handle_init(init_bytes).has_value());
+  EXPECT_EQ(&first.replay_cache(), &second.replay_cache());
+  EXPECT_EQ(cache->stats().lookups, 2U);
+}
+
+TEST(HandshakeTests, NullReplayCacheThrows) {
+  auto steady_fn = [] { return std::chrono::steady_clock::now(); };
+  EXPECT_THROW(handshake::HandshakeResponder(make_psk(), std::chrono::milliseconds(1000),
+                                             utils::TokenBucket(1.0, std::chrono::milliseconds(1000),
+                                                                steady_fn),
+                                             std::shared_ptr<handshake::HandshakeReplayCache>{}),
+               std::invalid_argument);
+}
+
 // DPI Resistance Tests - Issue #19
 // Verifies that encrypted handshake packets don't contain detectable signatures
 
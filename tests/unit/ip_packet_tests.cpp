@@ -0,0 +1,289 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "tun/ip_packet.h"
+
+namespace veil::tests {
+
+namespace {
+
+std::vector<std::uint8_t> make_ipv4_udp(std::uint16_t src_port, std::uint16_t dst_port,
+                                        std::uint8_t tos = 0) {
+  std::vector<std::uint8_t> packet(28, 0);
+  packet[0] = 0x45;
+  packet[1] = tos;
+  packet[3] = 28;
+  packet[8] = 64;
+  packet[9] = 17;
+  packet[12] = 10;
+  packet[15] = 2;
+  packet[16] = 10;
+  packet[19] = 1;
+  packet[20] = static_cast<std::uint8_t>(src_port >> 8);
+  packet[21] = static_cast<std::uint8_t>(src_port);
+  packet[22] = static_cast<std::uint8_t>(dst_port >> 8);
+  packet[23] = static_cast<std::uint8_t>(dst_port);
+  return packet;
+}
+
+std::vector<std::uint8_t> make_ipv6_tcp(std::uint16_t src_port, std::uint16_t dst_port,
+                                        std::uint8_t traffic_class = 0) {
+  std::vector<std::uint8_t> packet(60, 0);
+  packet[0] = static_cast<std::uint8_t>(0x60 | (traffic_class >> 4));
+  packet[1] = static_cast<std::uint8_t>(traffic_class << 4);
+  packet[6] = 6;
+  packet[7] = 64;
+  packet[8] = 0xFD;
+  packet[23] = 2;
+  packet[24] = 0xFD;
+  packet[39] = 1;
+  packet[40] = static_cast<std::uint8_t>(src_port >> 8);
+  packet[41] = static_cast<std::uint8_t>(src_port);
+  packet[42] = static_cast<std::uint8_t>(dst_port >> 8);
+  packet[43] = static_cast<std::uint8_t>(dst_port);
+  return packet;
+}
+
+bool ipv4_checksum_valid(const std::vector<std::uint8_t>& packet) {
+  std::uint32_t sum = 0;
+  for (std::size_t i = 0; i < 20; i += 2) {
+    sum += static_cast<std::uint32_t>((packet[i] << 8) | packet[i + 1]);
+  }
+  while ((sum >> 16) != 0) {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+  }
+  return sum == 0xFFFF;
+}
+
+}  // namespace
+
+TEST(IpPacketTest, ParsesIpv4UdpFlowKey) {
+  const auto packet = make_ipv4_udp(5000, 53);
+  const auto key = tun::parse_flow_key(packet);
+  ASSERT_TRUE(key.has_value());
+  EXPECT_EQ(key->ip_version, 4);
+  EXPECT_EQ(key->protocol, 17);
+  EXPECT_EQ(key->src_port, 5000);
+  EXPECT_EQ(key->dst_port, 53);
+  EXPECT_EQ(key->src[0], 10);
+  EXPECT_EQ(key->src[3], 2);
+  EXPECT_EQ(key->dst[3], 1);
+}
+
+TEST(IpPacketTest, ParsesIpv6TcpFlowKey) {
+  const auto packet = make_ipv6_tcp(40000, 443);
+  const auto key = tun::parse_flow_key(packet);
+  ASSERT_TRUE(key.has_value());
+  EXPECT_EQ(key->ip_version, 6);
+  EXPECT_EQ(key->protocol, 6);
+  EXPECT_EQ(key->src_port, 40000);
+  EXPECT_EQ(key->dst_port, 443);
+  EXPECT_EQ(key->src[0], 0xFD);
+  EXPECT_EQ(key->dst[15], 1);
+}
+
+TEST(IpPacketTest, LaterFragmentsHaveNoPorts) {
+  auto packet = make_ipv4_udp(5000, 53);
+  packet[7] = 0x10;  // Fragment offset 16 (x 8 bytes).
+  const auto key = tun::parse_flow_key(packet);
+  ASSERT_TRUE(key.has_value());
+  EXPECT_EQ(key->src_port, 0);
+  EXPECT_EQ(key->dst_port, 0);
+}
+
+TEST(IpPacketTest, RejectsTruncatedAndNonIpPackets) {
+  auto packet = make_ipv4_udp(5000, 53);
+  packet.resize(19);
+  EXPECT_FALSE(tun::parse_flow_key(packet).has_value());
+
+  auto ipv6 = make_ipv6_tcp(1, 2);
+  ipv6.resize(39);
+  EXPECT_FALSE(tun::parse_flow_key(ipv6).has_value());
+
+  const std::vector<std::uint8_t> garbage{0x00, 0x01, 0x02};
+  EXPECT_FALSE(tun::parse_flow_key(garbage).has_value());
+  EXPECT_FALSE(tun::parse_flow_key({}).has_value());
+}
+
+TEST(IpPacketTest, FlowHashDependsOnKeyAndSeed) {
+  const auto a = tun::parse_flow_key(make_ipv4_udp(5000, 53));
+  const auto a_again = tun::parse_flow_key(make_ipv4_udp(5000, 53));
+  const auto b = tun::parse_flow_key(make_ipv4_udp(5001, 53));
+  ASSERT_TRUE(a && a_again && b);
+  EXPECT_EQ(tun::flow_hash(*a, 1), tun::flow_hash(*a_again, 1));
+  EXPECT_NE(tun::flow_hash(*a, 1), tun::flow_hash(*b, 1));
+  EXPECT_NE(tun::flow_hash(*a, 1), tun::flow_hash(*a, 2));
+}
+
+TEST(IpPacketTest, ReadsAndSetsIpv4EcnWithChecksum) {
+  auto packet = make_ipv4_udp(5000, 53, 0xB8 | 0x02);  // EF + ECT(0).
+  EXPECT_EQ(tun::ecn_codepoint(packet), tun::Ecn::kEct0);
+
+  ASSERT_TRUE(tun::set_ecn_codepoint(packet, tun::Ecn::kCe));
+  EXPECT_EQ(tun::ecn_codepoint(packet), tun::Ecn::kCe);
+  EXPECT_EQ(packet[1] & 0xFC, 0xB8);  // DSCP untouched.
+  EXPECT_TRUE(ipv4_checksum_valid(packet));
+}
+
+TEST(IpPacketTest, ReadsAndSetsIpv6Ecn) {
+  auto packet = make_ipv6_tcp(1, 2, 0xB8 | 0x01);  // EF + ECT(1).
+  EXPECT_EQ(tun::ecn_codepoint(packet), tun::Ecn::kEct1);
+
+  ASSERT_TRUE(tun::set_ecn_codepoint(packet, tun::Ecn::kCe));
+  EXPECT_EQ(tun::ecn_codepoint(packet), tun::Ecn::kCe);
+  EXPECT_EQ(packet[0], 0x6B);
+  EXPECT_EQ(packet[1] & 0xCF, 0x80);
+}
+
+TEST(IpPacketTest, SetEcnRejectsNonIp) {
+  std::vector<std::uint8_t> garbage(40, 0);
+  EXPECT_FALSE(tun::set_ecn_codepoint(garbage, tun::Ecn::kCe));
+  EXPECT_EQ(tun::ecn_codepoint(garbage), tun::Ecn::kNotEct);
+}
+
+TEST(IpPacketTest, DecapsulationFollowsRfc6040) {
+  using tun::Ecn;
+  // Rows: inner codepoint; columns: outer Not-ECT, ECT(0), ECT(1), CE.
+  EXPECT_EQ(tun::decapsulated_ecn(Ecn::kNotEct, Ecn::kNotEct), Ecn::kNotEct);
+  EXPECT_EQ(tun::decapsulated_ecn(Ecn::kNotEct, Ecn::kEct0), Ecn::kNotEct);
+  EXPECT_EQ(tun::decapsulated_ecn(Ecn::kNotEct, Ecn::kEct1), Ecn::kNotEct);
+  EXPECT_FALSE(tun::decapsulated_ecn(Ecn::kNotEct, Ecn::kCe).has_value());
+
+  EXPECT_EQ(tun::decapsulated_ecn(Ecn::kEct0, Ecn::kNotEct), Ecn::kEct0);
+  EXPECT_EQ(tun::decapsulated_ecn(Ecn::kEct0, Ecn::kEct0), Ecn::kEct0);
+  EXPECT_EQ(tun::decapsulated_ecn(Ecn::kEct0, Ecn::kEct1), Ecn::kEct1);
+  EXPECT_EQ(tun::decapsulated_ecn(Ecn::kEct0, Ecn::kCe), Ecn::kCe);
+
+  EXPECT_EQ(tun::decapsulated_ecn(Ecn::kEct1, Ecn::kEct0), Ecn::kEct1);
+  EXPECT_EQ(tun::decapsulated_ecn(Ecn::kEct1, Ecn::kCe), Ecn::kCe);
+
+  EXPECT_EQ(tun::decapsulated_ecn(Ecn::kCe, Ecn::kNotEct), Ecn::kCe);
+  EXPECT_EQ(tun::decapsulated_ecn(Ecn::kCe, Ecn::kEct1), Ecn::kCe);
+}
+
+TEST(IpPacketTest, AppliesOuterCeToInnerPacket) {
+  auto ect = make_ipv4_udp(5000, 53, 0x02);
+  ASSERT_TRUE(tun::apply_outer_ecn(ect, tun::Ecn::kCe));
+  EXPECT_EQ(tun::ecn_codepoint(ect), tun::Ecn::kCe);
+  EXPECT_TRUE(ipv4_checksum_valid(ect));
+
+  auto ipv6 = make_ipv6_tcp(1, 2, 0x01);
+  ASSERT_TRUE(tun::apply_outer_ecn(ipv6, tun::Ecn::kCe));
+  EXPECT_EQ(tun::ecn_codepoint(ipv6), tun::Ecn::kCe);
+
+  // A CE mark on a packet whose sender did not negotiate ECN means drop.
+  auto not_ect = make_ipv4_udp(5000, 53);
+  EXPECT_FALSE(tun::apply_outer_ecn(not_ect, tun::Ecn::kCe));
+
+  // Unmarked outer headers leave the inner packet alone.
+  auto plain = make_ipv4_udp(5000, 53);
+  const auto before = plain;
+  EXPECT_TRUE(tun::apply_outer_ecn(plain, tun::Ecn::kEct0));
+  EXPECT_EQ(plain, before);
+}
+
+TEST(IpPacketTest, ReadsIpv4Addresses) {
+  const auto packet = make_ipv4_udp(5000, 53);
+  EXPECT_EQ(tun::ipv4_source(packet), 0x0A000002U);
+  EXPECT_EQ(tun::ipv4_destination(packet), 0x0A000001U);
+
+  EXPECT_FALSE(tun::ipv4_destination(make_ipv6_tcp(1, 2)).has_value());
+  const std::vector<std::uint8_t> truncated(packet.begin(), packet.begin() + 19);
+  EXPECT_FALSE(tun::ipv4_source(truncated).has_value());
+}
+
+TEST(IpPacketTest, ParsesIpv4Prefixes) {
+  const auto subnet = tun::parse_ipv4_prefix("10.8.0.77/24");
+  ASSERT_TRUE(subnet.has_value());
+  EXPECT_EQ(subnet->address, 0x0A080000U);
+  EXPECT_EQ(subnet->length, 24);
+  EXPECT_TRUE(subnet->contains(0x0A0800FEU));
+  EXPECT_FALSE(subnet->contains(0x0A080100U));
+
+  const auto host = tun::parse_ipv4_prefix("10.8.0.5");
+  ASSERT_TRUE(host.has_value());
+  EXPECT_EQ(host->length, 32);
+  EXPECT_TRUE(host->contains(0x0A080005U));
+  EXPECT_FALSE(host->contains(0x0A080006U));
+
+  const auto any = tun::parse_ipv4_prefix("any");
+  ASSERT_TRUE(any.has_value());
+  EXPECT_TRUE(any->contains(0xFFFFFFFFU));
+  EXPECT_EQ(tun::parse_ipv4_prefix("0.0.0.0/0"), any);
+
+  for (const char* bad : {"", "10.8.0", "10.8.0.256", "10.8.0.1/33", "10.8.0.1/", "10.8.0.1.2",
+                          "10.8.0.x", "10.8.0.1 /24"}) {
+    EXPECT_FALSE(tun::parse_ipv4_prefix(bad).has_value()) << bad;
+  }
+}
+
+TEST(IpPacketTest, ParsesIpPrefixesOfBothFamilies) {
+  const auto v4 = tun::parse_ip_prefix("192.168.10.77/24");
+  ASSERT_TRUE(v4.has_value());
+  EXPECT_EQ(v4->version, 4);
+  EXPECT_EQ(v4->length, 24);
+  EXPECT_EQ(tun::format_ip_prefix(*v4), "192.168.10.0/24");
+  EXPECT_EQ(*v4, tun::to_ip_prefix(*tun::parse_ipv4_prefix("192.168.10.0/24")));
+
+  const auto v6 = tun::parse_ip_prefix("fd00:1::ff/64");
+  ASSERT_TRUE(v6.has_value());
+  EXPECT_EQ(v6->version, 6);
+  EXPECT_EQ(v6->length, 64);
+  EXPECT_EQ(tun::format_ip_prefix(*v6), "fd00:1::/64");
+  EXPECT_EQ(tun::parse_ip_prefix("fd00::1")->length, 128);
+
+  EXPECT_TRUE(v6->covers(*tun::parse_ip_prefix("fd00:1::1:0/112")));
+  EXPECT_FALSE(v6->covers(*tun::parse_ip_prefix("fd00::/16")));
+  EXPECT_FALSE(v6->covers(*v4));
+  EXPECT_TRUE(tun::parse_ip_prefix("10.0.0.0/8")->covers(*tun::parse_ip_prefix("10.1.2.3")));
+
+  for (const char* bad : {"", "any", "fd00::/129", "fd00::1::2", "10.0.0.1/33", "fd00::/"}) {
+    EXPECT_FALSE(tun::parse_ip_prefix(bad).has_value()) << bad;
+  }
+}
+
+TEST(IpPacketTest, ReadsDestinationAddressOfBothFamilies) {
+  const auto v4 = make_ipv4_udp(1000, 53);
+  const auto v4_dst = tun::destination_address(v4);
+  ASSERT_EQ(v4_dst.size(), 4U);
+  EXPECT_EQ(v4_dst[0], 10);
+  EXPECT_EQ(v4_dst[3], 1);
+
+  const auto v6 = make_ipv6_tcp(1000, 443);
+  const auto v6_dst = tun::destination_address(v6);
+  ASSERT_EQ(v6_dst.size(), 16U);
+  EXPECT_EQ(v6_dst[0], 0xFD);
+  EXPECT_EQ(v6_dst[15], 1);
+
+  EXPECT_TRUE(tun::destination_address(std::span(v6).first(39)).empty());
+  const std::vector<std::uint8_t> other(40, 0x50);
+  EXPECT_TRUE(tun::destination_address(other).empty());
+}
+
+TEST(IpPacketTest, PrefixListRoundTrip) {
+  const std::vector<tun::IpPrefix> prefixes{*tun::parse_ip_prefix("192.168.10.0/24"),
+                                            *tun::parse_ip_prefix("fd00:1::/64")};
+  const auto encoded = tun::encode_ip_prefixes(prefixes);
+  EXPECT_EQ(encoded.size(), 2U + 4U + 2U + 16U);
+  const auto decoded = tun::decode_ip_prefixes(encoded);
+  ASSERT_TRUE(decoded.has_value());
+  EXPECT_EQ(*decoded, prefixes);
+
+  // Withdrawing every route is an empty announcement.
+  const auto empty = tun::decode_ip_prefixes({});
+  ASSERT_TRUE(empty.has_value());
+  EXPECT_TRUE(empty->empty());
+
+  auto payload = encoded;
+  payload.pop_back();
+  EXPECT_FALSE(tun::decode_ip_prefixes(payload).has_value());
+  payload = encoded;
+  payload[1] = 33;
+  EXPECT_FALSE(tun::decode_ip_prefixes(payload).has_value());
+  payload[0] = 5;
+  EXPECT_FALSE(tun::decode_ip_prefixes(payload).has_value());
+}
+
+}  // namespace veil::tests
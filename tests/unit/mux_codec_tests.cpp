@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <cstdint>
+#include <span>
 #include <vector>
 
 #include "transport/mux/mux_codec.h"
@@ -29,6 +30,20 @@ TEST(MuxCodecTests, DataFrameWithFin) {
   EXPECT_TRUE(decoded->data.fin);
 }
 
+TEST(MuxCodecTests, DataFrameFragmentFlag) {
+  auto frame = mux::make_data_frame(1, (5ULL << 32) | 2, true, {0x01});
+  frame.data.fragment = true;
+  auto decoded = mux::MuxCodec::decode(mux::MuxCodec::encode(frame));
+  ASSERT_TRUE(decoded.has_value());
+  EXPECT_TRUE(decoded->data.fragment);
+  EXPECT_TRUE(decoded->data.fin);
+  EXPECT_EQ(decoded->data.sequence, (5ULL << 32) | 2);
+
+  auto plain = mux::MuxCodec::decode(mux::MuxCodec::encode(mux::make_data_frame(1, 7, false, {})));
+  ASSERT_TRUE(plain.has_value());
+  EXPECT_FALSE(plain->data.fragment);
+}
+
 TEST(MuxCodecTests, AckFrameRoundTrip) {
   auto frame = mux::make_ack_frame(7, 200, 0xDEADBEEF);
   auto encoded = mux::MuxCodec::encode(frame);
@@ -99,6 +114,66 @@ TEST(MuxCodecTests, EmptyDataFramePayload) {
   EXPECT_TRUE(decoded->data.payload.empty());
 }
 
+TEST(MuxCodecTests, WindowUpdateRoundTrip) {
+  const mux::WindowUpdate update{7, 1234, 65536};
+  auto decoded = mux::MuxCodec::decode(mux::MuxCodec::encode(mux::make_window_update_frame(update)));
+  ASSERT_TRUE(decoded.has_value());
+  ASSERT_EQ(decoded->kind, mux::FrameKind::kControl);
+  auto parsed = mux::parse_window_update(decoded->control);
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(parsed->stream_id, 7U);
+  EXPECT_EQ(parsed->sequence, 1234U);
+  EXPECT_EQ(parsed->window, 65536U);
+  EXPECT_FALSE(mux::parse_blocked(decoded->control).has_value());
+}
+
+TEST(MuxCodecTests, BlockedRoundTrip) {
+  auto decoded =
+      mux::MuxCodec::decode(mux::MuxCodec::encode(mux::make_blocked_frame(mux::kConnectionStream)));
+  ASSERT_TRUE(decoded.has_value());
+  auto parsed = mux::parse_blocked(decoded->control);
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(*parsed, mux::kConnectionStream);
+
+  // Malformed payloads are not flow-control frames.
+  EXPECT_FALSE(mux::parse_blocked(mux::ControlFrame{2, {1, 2, 3}}).has_value());
+  EXPECT_FALSE(mux::parse_window_update(mux::ControlFrame{1, {1, 2, 3}}).has_value());
+}
+
+TEST(MuxCodecTests, FecFramesRoundTrip) {
+  const mux::FecRepair repair{42, 0xF0F0, 3, {9, 8, 7, 6}};
+  auto decoded = mux::MuxCodec::decode(mux::MuxCodec::encode(mux::make_fec_repair_frame(repair)));
+  ASSERT_TRUE(decoded.has_value());
+  auto parsed = mux::parse_fec_repair(decoded->control);
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(parsed->base_sequence, 42U);
+  EXPECT_EQ(parsed->source_mask, 0xF0F0U);
+  EXPECT_EQ(parsed->index, 3);
+  EXPECT_EQ(parsed->symbol, repair.symbol);
+
+  decoded = mux::MuxCodec::decode(mux::MuxCodec::encode(mux::make_loss_report_frame({90, 10})));
+  ASSERT_TRUE(decoded.has_value());
+  auto report = mux::parse_loss_report(decoded->control);
+  ASSERT_TRUE(report.has_value());
+  EXPECT_EQ(report->received, 90U);
+  EXPECT_EQ(report->lost, 10U);
+}
+
+TEST(MuxCodecTests, AckFrequencyRoundTrip) {
+  const mux::AckFrequency request{7, 16, std::chrono::milliseconds(12)};
+  const auto decoded =
+      mux::MuxCodec::decode(mux::MuxCodec::encode(mux::make_ack_frequency_frame(request)));
+  ASSERT_TRUE(decoded.has_value());
+  const auto parsed = mux::parse_ack_frequency(decoded->control);
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(parsed->sequence, 7U);
+  EXPECT_EQ(parsed->packet_threshold, 16U);
+  EXPECT_EQ(parsed->max_ack_delay, std::chrono::milliseconds(12));
+
+  EXPECT_FALSE(mux::parse_ack_frequency(mux::make_ack_frequency_frame({8, 0}).control).has_value());
+  EXPECT_FALSE(mux::parse_loss_report(decoded->control).has_value());
+}
+
 TEST(MuxCodecTests, EmptyControlFramePayload) {
   auto frame = mux::make_control_frame(0x00, {});
   auto encoded = mux::MuxCodec::encode(frame);
@@ -116,4 +191,17 @@ TEST(MuxCodecTests, LargeStreamIdAndSequence) {
   EXPECT_EQ(decoded->data.sequence, 0x123456789ABCDEF0ULL);
 }
 
+TEST(MuxCodecTests, FrameSizeSkipsPadding) {
+  auto encoded = mux::MuxCodec::encode(mux::make_data_frame(3, 4, false, {1, 2, 3}));
+  const auto size = encoded.size();
+  encoded.resize(size + 40, 0);
+  ASSERT_EQ(mux::MuxCodec::frame_size(encoded), size);
+  EXPECT_FALSE(mux::MuxCodec::decode(encoded).has_value());
+  EXPECT_TRUE(mux::MuxCodec::decode(std::span(encoded).first(size)).has_value());
+
+  const auto heartbeat = mux::MuxCodec::encode(mux::make_heartbeat_frame(1, 2, {7, 7}));
+  EXPECT_EQ(mux::MuxCodec::frame_size(heartbeat), heartbeat.size());
+  EXPECT_FALSE(mux::MuxCodec::frame_size(std::span(heartbeat).first(5)).has_value());
+}
+
 }  // namespace veil::tests
@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "transport/impairment/network_impairment.h"
+
+namespace veil::transport::test {
+
+using namespace std::chrono_literals;
+
+namespace {
+std::vector<std::uint8_t> packet(std::uint8_t tag, std::size_t size = 100) {
+  return std::vector<std::uint8_t>(size, tag);
+}
+}  // namespace
+
+class NetworkImpairmentTest : public ::testing::Test {
+ protected:
+  NetworkImpairment::TimePoint now_{NetworkImpairment::Clock::now()};
+};
+
+TEST_F(NetworkImpairmentTest, PassThroughByDefault) {
+  NetworkImpairment link;
+  EXPECT_EQ(link.submit(packet(1), now_), 1u);
+  EXPECT_EQ(link.submit(packet(2), now_), 1u);
+
+  auto out = link.collect(now_);
+  ASSERT_EQ(out.size(), 2u);
+  EXPECT_EQ(out[0][0], 1);
+  EXPECT_EQ(out[1][0], 2);
+  EXPECT_EQ(link.in_flight(), 0u);
+  EXPECT_EQ(link.stats().packets_delivered, 2u);
+  EXPECT_EQ(link.stats().bytes_delivered, 200u);
+}
+
+TEST_F(NetworkImpairmentTest, FixedDelay) {
+  ImpairmentConfig config;
+  config.delay = 10ms;
+  NetworkImpairment link(config);
+
+  link.submit(packet(1), now_);
+  EXPECT_TRUE(link.collect(now_ + 9ms).empty());
+  ASSERT_TRUE(link.next_delivery().has_value());
+  EXPECT_EQ(*link.next_delivery(), now_ + 10ms);
+  EXPECT_EQ(link.collect(now_ + 10ms).size(), 1u);
+}
+
+TEST_F(NetworkImpairmentTest, JitterStaysInRange) {
+  ImpairmentConfig config;
+  config.delay = 10ms;
+  config.jitter = 5ms;
+  NetworkImpairment link(config);
+
+  for (int i = 0; i < 200; ++i) {
+    link.submit(packet(1), now_);
+  }
+  EXPECT_TRUE(link.collect(now_ + 10ms - 1us).empty());
+  EXPECT_EQ(link.collect(now_ + 15ms).size(), 200u);
+}
+
+TEST_F(NetworkImpairmentTest, RandomLossRate) {
+  ImpairmentConfig config;
+  config.loss_rate = 0.2;
+  config.seed = 1234;
+  NetworkImpairment link(config);
+
+  for (int i = 0; i < 10000; ++i) {
+    link.submit(packet(1, 10), now_);
+  }
+  const auto dropped = link.stats().dropped_random;
+  EXPECT_GT(dropped, 1800u);
+  EXPECT_LT(dropped, 2200u);
+  EXPECT_EQ(link.collect(now_).size(), 10000u - dropped);
+}
+
+TEST_F(NetworkImpairmentTest, SameSeedSameLossPattern) {
+  ImpairmentConfig config;
+  config.loss_rate = 0.3;
+  config.seed = 99;
+  NetworkImpairment a(config);
+  NetworkImpairment b(config);
+
+  for (int i = 0; i < 500; ++i) {
+    EXPECT_EQ(a.submit(packet(1, 10), now_), b.submit(packet(1, 10), now_));
+  }
+}
+
+TEST_F(NetworkImpairmentTest, Duplication) {
+  ImpairmentConfig config;
+  config.duplicate_rate = 1.0;
+  NetworkImpairment link(config);
+
+  EXPECT_EQ(link.submit(packet(7), now_), 2u);
+  auto out = link.collect(now_);
+  ASSERT_EQ(out.size(), 2u);
+  EXPECT_EQ(out[0], out[1]);
+  EXPECT_EQ(link.stats().duplicated, 1u);
+}
+
+TEST_F(NetworkImpairmentTest, ReorderHoldsPacketBack) {
+  ImpairmentConfig config;
+  config.reorder_rate = 1.0;
+  config.reorder_delay = 5ms;
+  NetworkImpairment link(config);
+
+  link.submit(packet(1), now_);
+  EXPECT_TRUE(link.collect(now_ + 4ms).empty());
+  EXPECT_EQ(link.collect(now_ + 5ms).size(), 1u);
+  EXPECT_EQ(link.stats().reordered, 1u);
+}
+
+TEST_F(NetworkImpairmentTest, ReorderedPacketIsOvertaken) {
+  ImpairmentConfig config;
+  config.reorder_rate = 0.5;
+  config.reorder_delay = 5ms;
+  config.seed = 3;
+  NetworkImpairment link(config);
+
+  for (std::uint8_t i = 0; i < 50; ++i) {
+    link.submit(packet(i), now_ + std::chrono::milliseconds(i));
+  }
+  auto out = link.collect(now_ + 1s);
+  ASSERT_EQ(out.size(), 50u);
+  bool out_of_order = false;
+  for (std::size_t i = 1; i < out.size(); ++i) {
+    if (out[i][0] < out[i - 1][0]) {
+      out_of_order = true;
+    }
+  }
+  EXPECT_TRUE(out_of_order);
+  EXPECT_GT(link.stats().reordered, 0u);
+}
+
+TEST_F(NetworkImpairmentTest, BandwidthSerializesBursts) {
+  ImpairmentConfig config;
+  config.bandwidth_bps = 8'000'000;  // 1 byte per microsecond.
+  NetworkImpairment link(config);
+
+  for (int i = 0; i < 10; ++i) {
+    link.submit(packet(1, 1000), now_);
+  }
+  // Each 1000-byte packet occupies the link for 1 ms.
+  EXPECT_EQ(link.collect(now_ + 1ms).size(), 1u);
+  EXPECT_EQ(link.collect(now_ + 5ms).size(), 4u);
+  EXPECT_EQ(link.collect(now_ + 10ms).size(), 5u);
+}
+
+TEST_F(NetworkImpairmentTest, QueueLimitTailDrops) {
+  ImpairmentConfig config;
+  config.bandwidth_bps = 8'000'000;
+  config.queue_limit_bytes = 3000;
+  NetworkImpairment link(config);
+
+  std::size_t accepted = 0;
+  for (int i = 0; i < 10; ++i) {
+    accepted += link.submit(packet(1, 1000), now_);
+  }
+  EXPECT_EQ(accepted, 3u);
+  EXPECT_EQ(link.stats().dropped_queue, 7u);
+
+  // Once the queue drains, packets are accepted again.
+  EXPECT_EQ(link.submit(packet(1, 1000), now_ + 3ms), 1u);
+}
+
+TEST_F(NetworkImpairmentTest, GilbertElliottProducesBursts) {
+  ImpairmentConfig config;
+  config.burst_loss.enabled = true;
+  config.burst_loss.p_good_to_bad = 0.01;
+  config.burst_loss.p_bad_to_good = 0.2;
+  config.burst_loss.loss_in_good = 0.0;
+  config.burst_loss.loss_in_bad = 1.0;
+  config.seed = 5;
+  NetworkImpairment link(config);
+
+  std::size_t bursts = 0;
+  std::size_t longest = 0;
+  std::size_t run = 0;
+  for (int i = 0; i < 20000; ++i) {
+    if (link.submit(packet(1, 10), now_) == 0) {
+      if (run == 0) {
+        ++bursts;
+      }
+      longest = std::max(longest, ++run);
+    } else {
+      run = 0;
+    }
+  }
+
+  // Stationary loss is p_gb / (p_gb + p_bg) ~= 4.8%, in bursts of ~5.
+  const auto dropped = link.stats().dropped_burst;
+  EXPECT_GT(dropped, 600u);
+  EXPECT_LT(dropped, 1400u);
+  EXPECT_EQ(link.stats().dropped_random, 0u);
+  ASSERT_GT(bursts, 0u);
+  EXPECT_GT(static_cast<double>(dropped) / static_cast<double>(bursts), 3.0);
+  EXPECT_GE(longest, 10u);
+}
+
+}  // namespace veil::transport::test
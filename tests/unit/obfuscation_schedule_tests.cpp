@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "common/obfuscation/obfuscation_profile.h"
+#include "common/obfuscation/obfuscation_schedule.h"
+
+namespace veil::tests {
+
+namespace {
+
+obfuscation::ObfuscationProfile make_profile(obfuscation::DPIBypassMode mode) {
+  auto profile = obfuscation::create_dpi_mode_profile(mode);
+  for (std::size_t i = 0; i < profile.profile_seed.size(); ++i) {
+    profile.profile_seed[i] = static_cast<std::uint8_t>(i * 7 + 3);
+  }
+  return profile;
+}
+
+void expect_matches_direct(const obfuscation::ObfuscationProfile& profile,
+                           const obfuscation::ScheduleEntry& entry, std::uint64_t sequence) {
+  EXPECT_EQ(entry.jitter, obfuscation::compute_timing_jitter_advanced(profile, sequence)) << sequence;
+  EXPECT_EQ(entry.padding_size, obfuscation::compute_advanced_padding_size(profile, sequence)) << sequence;
+  EXPECT_EQ(entry.padding_class, obfuscation::compute_padding_class(profile, sequence)) << sequence;
+  EXPECT_EQ(entry.prefix_size, obfuscation::compute_prefix_size(profile, sequence)) << sequence;
+}
+
+}  // namespace
+
+TEST(ObfuscationScheduleTest, TableMatchesDirectComputationInEveryMode) {
+  for (const auto mode : {obfuscation::DPIBypassMode::kIoTMimic, obfuscation::DPIBypassMode::kQUICLike,
+                          obfuscation::DPIBypassMode::kRandomNoise, obfuscation::DPIBypassMode::kTrickle,
+                          obfuscation::DPIBypassMode::kCustom}) {
+    const auto profile = make_profile(mode);
+    obfuscation::ObfuscationSchedule schedule(profile, 64);
+    for (std::uint64_t sequence = 0; sequence < 1000; ++sequence) {
+      if (schedule.needs_refill()) {
+        schedule.refill();
+      }
+      expect_matches_direct(profile, schedule.at(sequence), sequence);
+    }
+    EXPECT_EQ(schedule.stats().misses, 0U);
+    EXPECT_EQ(schedule.stats().hits, 1000U);
+  }
+}
+
+TEST(ObfuscationScheduleTest, BothEndsDeriveIdenticalTables) {
+  // Client and server build their profiles separately from the shared seed.
+  const auto client_profile = make_profile(obfuscation::DPIBypassMode::kIoTMimic);
+  const auto server_profile = make_profile(obfuscation::DPIBypassMode::kIoTMimic);
+  obfuscation::ObfuscationSchedule client(client_profile, 128);
+  obfuscation::ObfuscationSchedule server(server_profile, 32);
+  client.refill();
+  for (std::uint64_t sequence = 0; sequence < 500; ++sequence) {
+    if (server.needs_refill()) {
+      server.refill();
+    }
+    if (client.needs_refill()) {
+      client.refill();
+    }
+    const auto a = client.at(sequence);
+    const auto b = server.at(sequence);
+    EXPECT_EQ(a.jitter, b.jitter);
+    EXPECT_EQ(a.padding_size, b.padding_size);
+    EXPECT_EQ(a.padding_class, b.padding_class);
+    EXPECT_EQ(a.prefix_size, b.prefix_size);
+  }
+}
+
+TEST(ObfuscationScheduleTest, LookupsPastTheTableAreComputedDirectly) {
+  const auto profile = make_profile(obfuscation::DPIBypassMode::kQUICLike);
+  obfuscation::ObfuscationSchedule schedule(profile, 16);
+
+  // Nothing filled yet: every lookup is a miss with the same values.
+  for (std::uint64_t sequence = 0; sequence < 4; ++sequence) {
+    expect_matches_direct(profile, schedule.at(sequence), sequence);
+  }
+  EXPECT_EQ(schedule.stats().misses, 4U);
+
+  schedule.refill();
+  EXPECT_EQ(schedule.stats().entries_filled, 16U);
+  EXPECT_FALSE(schedule.needs_refill());
+  expect_matches_direct(profile, schedule.at(10), 10);
+  EXPECT_EQ(schedule.stats().hits, 1U);
+
+  // A jump far ahead misses once; the next refill restarts from there.
+  expect_matches_direct(profile, schedule.at(1'000'000), 1'000'000);
+  EXPECT_EQ(schedule.stats().misses, 5U);
+  EXPECT_TRUE(schedule.needs_refill());
+  schedule.refill();
+  expect_matches_direct(profile, schedule.at(1'000'001), 1'000'001);
+  EXPECT_EQ(schedule.stats().hits, 2U);
+}
+
+}  // namespace veil::tests
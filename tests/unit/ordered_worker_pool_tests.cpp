@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "common/utils/ordered_worker_pool.h"
+#include "common/utils/spsc_ring.h"
+
+namespace veil::utils::tests {
+
+using namespace std::chrono_literals;
+
+TEST(SpscRingTest, RoundsCapacityAndRefusesWhenFull) {
+  SpscRing<int> ring(5);
+  EXPECT_EQ(ring.capacity(), 8U);
+  for (int i = 0; i < 8; ++i) {
+    int value = i;
+    EXPECT_TRUE(ring.try_push(std::move(value)));
+  }
+  int extra = 99;
+  EXPECT_FALSE(ring.try_push(std::move(extra)));
+  EXPECT_EQ(ring.size(), 8U);
+
+  EXPECT_EQ(ring.pop(), 0);
+  std::vector<int> batch;
+  EXPECT_EQ(ring.pop_batch(batch, 4), 4U);
+  EXPECT_EQ(batch, (std::vector<int>{1, 2, 3, 4}));
+  EXPECT_EQ(ring.pop_batch(batch, 10), 3U);
+  EXPECT_TRUE(ring.empty());
+  EXPECT_FALSE(ring.pop().has_value());
+}
+
+TEST(SpscRingTest, KeepsOrderAcrossThreads) {
+  constexpr std::uint64_t kCount = 200000;
+  SpscRing<std::uint64_t> ring(64);
+  std::thread producer([&ring] {
+    for (std::uint64_t i = 0; i < kCount;) {
+      auto value = i;
+      if (ring.try_push(std::move(value))) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  std::uint64_t expected = 0;
+  std::vector<std::uint64_t> batch;
+  while (expected < kCount) {
+    batch.clear();
+    if (ring.pop_batch(batch, 16) == 0) {
+      std::this_thread::yield();
+    }
+    for (const auto value : batch) {
+      ASSERT_EQ(value, expected);
+      ++expected;
+    }
+  }
+  producer.join();
+}
+
+TEST(OrderedWorkerPoolTest, ReturnsJobsInSubmissionOrder) {
+  struct Job {
+    std::uint64_t index{0};
+    std::uint64_t result{0};
+  };
+  std::atomic<int> notifications{0};
+  OrderedWorkerPool<Job> pool(
+      4, 32,
+      [](Job& job) {
+        // Uneven work so workers finish out of order.
+        if (job.index % 7 == 0) {
+          std::this_thread::sleep_for(50us);
+        }
+        job.result = job.index * 3;
+      },
+      [&notifications] { notifications.fetch_add(1); });
+  EXPECT_EQ(pool.workers(), 4U);
+
+  constexpr std::uint64_t kCount = 5000;
+  std::uint64_t next_submit = 0;
+  std::uint64_t next_collect = 0;
+  const auto deadline = std::chrono::steady_clock::now() + 10s;
+  while (next_collect < kCount && std::chrono::steady_clock::now() < deadline) {
+    while (next_submit < kCount && pool.try_submit(Job{next_submit, 0})) {
+      ++next_submit;
+    }
+    const auto collected = pool.collect([&next_collect](Job&& job) {
+      EXPECT_EQ(job.index, next_collect);
+      EXPECT_EQ(job.result, job.index * 3);
+      ++next_collect;
+    });
+    if (collected == 0) {
+      std::this_thread::yield();
+    }
+  }
+  EXPECT_EQ(next_collect, kCount);
+  EXPECT_EQ(pool.in_flight(), 0U);
+  EXPECT_GT(notifications.load(), 0);
+}
+
+TEST(OrderedWorkerPoolTest, RefusesJobsBeyondCapacity) {
+  std::atomic<bool> release{false};
+  OrderedWorkerPool<int> pool(1, 4, [&release](int&) {
+    while (!release.load()) {
+      std::this_thread::yield();
+    }
+  });
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(pool.try_submit(int{i}));
+  }
+  EXPECT_FALSE(pool.try_submit(4));
+  EXPECT_EQ(pool.in_flight(), 4U);
+
+  release.store(true);
+  std::vector<int> collected;
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (collected.size() < 4 && std::chrono::steady_clock::now() < deadline) {
+    if (pool.collect([&collected](int&& value) { collected.push_back(value); }) == 0) {
+      std::this_thread::yield();
+    }
+  }
+  EXPECT_EQ(collected, (std::vector<int>{0, 1, 2, 3}));
+  EXPECT_FALSE(pool.ready());
+  EXPECT_TRUE(pool.try_submit(5));
+}
+
+}  // namespace veil::utils::tests
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "common/obfuscation/obfuscation_profile.h"
+#include "transport/queue/packet_pacer.h"
+
+namespace veil::tests {
+
+using namespace std::chrono_literals;
+
+class PacketPacerTest : public ::testing::Test {
+ protected:
+  transport::PacketPacer make_pacer(const obfuscation::ObfuscationProfile* profile = nullptr) {
+    return transport::PacketPacer(config_, profile, [this] { return now_; });
+  }
+
+  // 1 MB/s: a 1000-byte packet every millisecond.
+  transport::PacerConfig config_{.rate_bytes_per_sec = 1'000'000, .horizon = 5ms};
+  transport::PacketPacer::TimePoint now_{std::chrono::steady_clock::now()};
+};
+
+TEST_F(PacketPacerTest, SpacesPacketsAtTheRate) {
+  auto pacer = make_pacer();
+  EXPECT_EQ(pacer.schedule(1000), now_);
+  EXPECT_EQ(pacer.schedule(1000), now_ + 1ms);
+  EXPECT_EQ(pacer.schedule(500), now_ + 2ms);
+  EXPECT_EQ(pacer.schedule(1000), now_ + 2500us);
+}
+
+TEST_F(PacketPacerTest, StopsAtTheHorizon) {
+  auto pacer = make_pacer();
+  int scheduled = 0;
+  while (pacer.can_schedule()) {
+    pacer.schedule(1000);
+    ++scheduled;
+  }
+  // Departures now .. now + 5 ms.
+  EXPECT_EQ(scheduled, 6);
+  EXPECT_EQ(pacer.next_schedule_time(), now_ + 1ms);
+
+  now_ += 1ms;
+  EXPECT_TRUE(pacer.can_schedule());
+}
+
+TEST_F(PacketPacerTest, IdleTimeEarnsNoBurst) {
+  auto pacer = make_pacer();
+  pacer.schedule(1000);
+  now_ += 1s;
+  EXPECT_EQ(pacer.schedule(1000), now_);
+  EXPECT_EQ(pacer.schedule(1000), now_ + 1ms);
+}
+
+TEST_F(PacketPacerTest, JitterDelaysWithoutReorderingOrSlowing) {
+  obfuscation::ObfuscationProfile profile;
+  profile.profile_seed.fill(0x42);
+  profile.max_timing_jitter_ms = 20;
+  auto pacer = make_pacer(&profile);
+
+  bool jittered = false;
+  auto previous = now_;
+  for (int i = 0; i < 100; ++i) {
+    const auto departure = pacer.schedule(1000);
+    const auto paced = now_ + std::chrono::milliseconds(i);
+    EXPECT_GE(departure, previous);
+    EXPECT_GE(departure, paced);
+    EXPECT_LE(departure, paced + 20ms);
+    jittered |= departure > paced;
+    previous = departure;
+  }
+  EXPECT_TRUE(jittered);
+}
+
+TEST(PacingWheelTest, ReleasesPacketsWhenDue) {
+  const auto start = std::chrono::steady_clock::now();
+  transport::PacingWheel wheel(250us, 64);
+  EXPECT_FALSE(wheel.next_departure().has_value());
+
+  for (std::uint8_t i = 0; i < 4; ++i) {
+    wheel.push(transport::UdpPacket{{i}, {}, 0}, start + std::chrono::milliseconds(i));
+  }
+  EXPECT_EQ(wheel.size(), 4U);
+  ASSERT_TRUE(wheel.next_departure().has_value());
+  EXPECT_LE(*wheel.next_departure(), start);
+  EXPECT_GT(*wheel.next_departure(), start - 250us);
+
+  std::vector<transport::UdpPacket> out;
+  wheel.pop_due(start + 1500us, out);
+  ASSERT_EQ(out.size(), 2U);
+  EXPECT_EQ(out[0].data[0], 0);
+  EXPECT_EQ(out[1].data[0], 1);
+
+  wheel.pop_due(start + 10ms, out);
+  ASSERT_EQ(out.size(), 4U);
+  EXPECT_EQ(out[3].data[0], 3);
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(PacingWheelTest, FarDeparturesWaitInLastSlot) {
+  const auto start = std::chrono::steady_clock::now();
+  transport::PacingWheel wheel(1ms, 8);
+  wheel.push(transport::UdpPacket{{1}, {}, 0}, start);
+  wheel.push(transport::UdpPacket{{2}, {}, 0}, start + 1s);
+
+  std::vector<transport::UdpPacket> out;
+  wheel.pop_due(start + 6ms, out);
+  EXPECT_EQ(out.size(), 1U);
+  wheel.pop_due(start + 8ms, out);
+  EXPECT_EQ(out.size(), 2U);
+}
+
+}  // namespace veil::tests
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "common/metrics/perf_baseline.h"
+
+namespace veil::metrics::test {
+
+namespace {
+MetricSamples samples(const char* name, Direction direction, std::vector<double> values) {
+  return MetricSamples{name, "", direction, std::move(values)};
+}
+}  // namespace
+
+TEST(PerfBaselineTest, StudentTCriticalMatchesTables) {
+  EXPECT_NEAR(student_t_critical(0.95, 1.0), 12.706, 0.01);
+  EXPECT_NEAR(student_t_critical(0.95, 4.0), 2.776, 0.01);
+  EXPECT_NEAR(student_t_critical(0.95, 10.0), 2.228, 0.01);
+  EXPECT_NEAR(student_t_critical(0.99, 30.0), 2.750, 0.01);
+  EXPECT_NEAR(student_t_critical(0.95, 1e6), 1.960, 0.001);
+}
+
+TEST(PerfBaselineTest, DescribeComputesConfidenceInterval) {
+  const std::vector<double> values{10.0, 12.0, 14.0};
+  const auto stats = describe(values);
+  EXPECT_EQ(stats.count, 3u);
+  EXPECT_DOUBLE_EQ(stats.mean, 12.0);
+  EXPECT_DOUBLE_EQ(stats.stddev, 2.0);
+  // t(0.975, 2) = 4.303, so the half width is 4.303 * 2 / sqrt(3).
+  EXPECT_NEAR(stats.ci_high - stats.mean, 4.97, 0.05);
+  EXPECT_NEAR(stats.mean - stats.ci_low, 4.97, 0.05);
+}
+
+TEST(PerfBaselineTest, NoisyDifferenceIsNotARegression) {
+  const auto base = samples("throughput_mbps", Direction::kHigherIsBetter,
+                            {800.0, 900.0, 700.0, 850.0, 750.0});
+  const auto current = samples("throughput_mbps", Direction::kHigherIsBetter,
+                               {720.0, 880.0, 650.0, 800.0, 700.0});
+  const auto result = compare_metric(base, current);
+  EXPECT_TRUE(result.significance_tested);
+  EXPECT_LT(result.change_percent, -5.0);
+  EXPECT_LT(result.change_ci_low_percent, 0.0);
+  EXPECT_GT(result.change_ci_high_percent, 0.0);
+  EXPECT_EQ(result.verdict, Verdict::kUnchanged);
+}
+
+TEST(PerfBaselineTest, ConsistentDropIsARegression) {
+  const auto base = samples("throughput_mbps", Direction::kHigherIsBetter,
+                            {800.0, 805.0, 795.0, 802.0, 798.0});
+  const auto current = samples("throughput_mbps", Direction::kHigherIsBetter,
+                               {700.0, 705.0, 695.0, 702.0, 698.0});
+  const auto result = compare_metric(base, current);
+  EXPECT_EQ(result.verdict, Verdict::kRegressed);
+  EXPECT_NEAR(result.change_percent, -12.5, 0.01);
+  EXPECT_LT(result.change_ci_high_percent, 0.0);
+}
+
+TEST(PerfBaselineTest, LowerIsBetterFlipsTheVerdict) {
+  const auto base = samples("p99_ms", Direction::kLowerIsBetter, {10.0, 10.1, 9.9, 10.0});
+  const auto slower = samples("p99_ms", Direction::kLowerIsBetter, {12.0, 12.1, 11.9, 12.0});
+  const auto faster = samples("p99_ms", Direction::kLowerIsBetter, {8.0, 8.1, 7.9, 8.0});
+  EXPECT_EQ(compare_metric(base, slower).verdict, Verdict::kRegressed);
+  EXPECT_EQ(compare_metric(base, faster).verdict, Verdict::kImproved);
+}
+
+TEST(PerfBaselineTest, SignificantButSmallChangeIsWithinTolerance) {
+  const auto base = samples("rate", Direction::kHigherIsBetter, {100.0, 100.1, 99.9, 100.0});
+  const auto current = samples("rate", Direction::kHigherIsBetter, {98.0, 98.1, 97.9, 98.0});
+  const auto result = compare_metric(base, current);
+  EXPECT_LT(result.change_ci_high_percent, 0.0);
+  EXPECT_EQ(result.verdict, Verdict::kUnchanged);
+
+  ComparisonConfig strict;
+  strict.tolerance = 0.01;
+  EXPECT_EQ(compare_metric(base, current, strict).verdict, Verdict::kRegressed);
+}
+
+TEST(PerfBaselineTest, SingleRunsFallBackToTolerance) {
+  const auto base = samples("rate", Direction::kHigherIsBetter, {100.0});
+  const auto current = samples("rate", Direction::kHigherIsBetter, {80.0});
+  const auto result = compare_metric(base, current);
+  EXPECT_FALSE(result.significance_tested);
+  EXPECT_EQ(result.verdict, Verdict::kRegressed);
+}
+
+TEST(PerfBaselineTest, RoundTripsThroughJson) {
+  PerfBaseline baseline;
+  baseline.set(samples("throughput_mbps", Direction::kHigherIsBetter, {800.0, 810.5}));
+  baseline.set(samples("handshake_p99_ms", Direction::kLowerIsBetter, {1.25}));
+  baseline.set(samples("throughput_mbps", Direction::kHigherIsBetter, {820.0, 830.0, 825.0}));
+  ASSERT_EQ(baseline.metrics().size(), 2u);
+
+  const auto restored = deserialize_baseline(serialize_baseline(baseline));
+  ASSERT_TRUE(restored.has_value());
+  const auto* throughput = restored->find("throughput_mbps");
+  ASSERT_NE(throughput, nullptr);
+  EXPECT_EQ(throughput->values, (std::vector<double>{820.0, 830.0, 825.0}));
+  EXPECT_EQ(throughput->direction, Direction::kHigherIsBetter);
+  const auto* latency = restored->find("handshake_p99_ms");
+  ASSERT_NE(latency, nullptr);
+  EXPECT_EQ(latency->direction, Direction::kLowerIsBetter);
+  EXPECT_DOUBLE_EQ(latency->values.at(0), 1.25);
+}
+
+TEST(PerfBaselineTest, RejectsMalformedBaselines) {
+  EXPECT_FALSE(deserialize_baseline("not json").has_value());
+  EXPECT_FALSE(deserialize_baseline(R"({"version": 2, "metrics": {}})").has_value());
+  EXPECT_FALSE(deserialize_baseline(R"({"version": 1, "metrics": {"x": {}}})").has_value());
+  EXPECT_FALSE(
+      deserialize_baseline(R"({"version": 1, "metrics": {"x": {"direction": "up", "samples": []}}})")
+          .has_value());
+}
+
+TEST(PerfBaselineTest, CompareReportsMissingMetrics) {
+  PerfBaseline baseline;
+  baseline.set(samples("a", Direction::kHigherIsBetter, {1.0, 1.0}));
+  PerfBaseline current;
+  current.set(samples("a", Direction::kHigherIsBetter, {1.0, 1.0}));
+  current.set(samples("b", Direction::kHigherIsBetter, {2.0, 2.0}));
+
+  const auto comparisons = baseline.compare(current);
+  ASSERT_EQ(comparisons.size(), 2u);
+  EXPECT_EQ(comparisons[0].verdict, Verdict::kUnchanged);
+  EXPECT_EQ(comparisons[1].name, "b");
+  EXPECT_EQ(comparisons[1].verdict, Verdict::kNoBaseline);
+}
+
+}  // namespace veil::metrics::test
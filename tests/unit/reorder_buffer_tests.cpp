@@ -34,4 +34,27 @@ TEST(ReorderBufferTests, RespectsBufferLimit) {
   EXPECT_FALSE(buf.push(2, {1, 2}));
 }
 
+TEST(ReorderBufferTests, SkipsPastGap) {
+  mux::ReorderBuffer buf(1);
+  EXPECT_TRUE(buf.push(4, {4}));
+  EXPECT_TRUE(buf.push(6, {6}));
+  EXPECT_EQ(buf.first_buffered(), 4U);
+
+  buf.skip_to(*buf.first_buffered());
+  EXPECT_EQ(buf.next_expected(), 4U);
+  auto v4 = buf.pop_next();
+  ASSERT_TRUE(v4.has_value());
+  EXPECT_EQ(v4->at(0), 4);
+  EXPECT_FALSE(buf.pop_next().has_value());
+
+  // Skipping backwards does nothing; skipping past entries drops them.
+  buf.skip_to(2);
+  EXPECT_EQ(buf.next_expected(), 5U);
+  buf.skip_to(7);
+  EXPECT_TRUE(buf.empty());
+  EXPECT_EQ(buf.buffered_bytes(), 0U);
+  EXPECT_FALSE(buf.first_buffered().has_value());
+  EXPECT_FALSE(buf.push(6, {6}));
+}
+
 }  // namespace veil::tests
@@ -240,4 +240,27 @@ TEST(RetransmitBufferTests, MinMaxRtoClamping) {
   EXPECT_LE(buffer.current_rto().count(), 500);
 }
 
+TEST(RetransmitBufferTests, MemoryFootprintTracksPendingPackets) {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  auto now_fn = [&]() { return now; };
+
+  mux::RetransmitConfig config;
+  config.max_buffer_bytes = 4096;
+  mux::RetransmitBuffer buffer(config, now_fn);
+  EXPECT_EQ(buffer.memory_footprint().reserved, 0U);
+  EXPECT_EQ(buffer.memory_footprint().limit, 4096U);
+
+  buffer.insert(1, std::vector<std::uint8_t>(100, 0xAA));
+  buffer.insert(2, std::vector<std::uint8_t>(50, 0xBB));
+  auto footprint = buffer.memory_footprint();
+  EXPECT_EQ(footprint.in_use, 150U);
+  // Node overhead comes on top of the payload.
+  EXPECT_GT(footprint.reserved, footprint.in_use);
+
+  buffer.acknowledge_cumulative(2);
+  footprint = buffer.memory_footprint();
+  EXPECT_EQ(footprint.in_use, 0U);
+  EXPECT_EQ(footprint.reserved, 0U);
+}
+
 }  // namespace veil::tests
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "server/route_table.h"
+
+namespace veil::tests {
+
+using server::RouteTable;
+
+namespace {
+
+tun::IpPrefix prefix(const char* text) {
+  const auto parsed = tun::parse_ip_prefix(text);
+  EXPECT_TRUE(parsed.has_value()) << text;
+  return parsed.value_or(tun::IpPrefix{});
+}
+
+std::optional<std::uint64_t> lookup(const RouteTable& table, const char* address) {
+  const auto host = prefix(address);
+  return table.lookup(std::span(host.address.data(), host.address_size()));
+}
+
+}  // namespace
+
+TEST(RouteTableTest, LongestPrefixWins) {
+  RouteTable table;
+  table.insert(prefix("10.8.0.0/16"), 1);
+  table.insert(prefix("10.8.0.5"), 2);
+  table.insert(prefix("10.8.0.0/28"), 3);
+  table.insert(prefix("192.168.10.0/24"), 4);
+
+  EXPECT_EQ(lookup(table, "10.8.0.5"), 2U);
+  EXPECT_EQ(lookup(table, "10.8.0.6"), 3U);
+  EXPECT_EQ(lookup(table, "10.8.0.16"), 1U);
+  EXPECT_EQ(lookup(table, "10.8.200.1"), 1U);
+  EXPECT_EQ(lookup(table, "192.168.10.77"), 4U);
+  EXPECT_FALSE(lookup(table, "192.168.11.1").has_value());
+  EXPECT_FALSE(lookup(table, "fd00::1").has_value());
+  EXPECT_EQ(table.size(), 4U);
+}
+
+TEST(RouteTableTest, RemovalFallsBackToCoveringPrefix) {
+  RouteTable table;
+  table.insert(prefix("10.0.0.0/8"), 1);
+  table.insert(prefix("10.8.0.0/24"), 2);
+  table.insert(prefix("10.8.0.128/25"), 3);
+
+  EXPECT_TRUE(table.erase(prefix("10.8.0.128/25")));
+  EXPECT_EQ(lookup(table, "10.8.0.200"), 2U);
+  EXPECT_TRUE(table.erase(prefix("10.8.0.0/24")));
+  EXPECT_EQ(lookup(table, "10.8.0.200"), 1U);
+  EXPECT_FALSE(table.erase(prefix("10.8.0.0/24")));
+
+  // Re-adding reuses the freed state.
+  table.insert(prefix("10.8.0.0/24"), 5);
+  EXPECT_EQ(lookup(table, "10.8.0.200"), 5U);
+  EXPECT_TRUE(table.erase(prefix("10.0.0.0/8")));
+  EXPECT_FALSE(lookup(table, "10.9.0.1").has_value());
+  EXPECT_EQ(table.find(prefix("10.8.0.0/24")), 5U);
+}
+
+TEST(RouteTableTest, InsertReplacesTarget) {
+  RouteTable table;
+  table.insert(prefix("fd00:1::/64"), 1);
+  table.insert(prefix("fd00:1::/64"), 2);
+  EXPECT_EQ(table.size(), 1U);
+  EXPECT_EQ(lookup(table, "fd00:1::abcd"), 2U);
+}
+
+TEST(RouteTableTest, FindsOverlapsInBothDirections) {
+  RouteTable table;
+  table.insert(prefix("192.168.0.0/16"), 1);
+  table.insert(prefix("10.8.0.5"), 2);
+  table.insert(prefix("fd00:1::/64"), 1);
+
+  EXPECT_EQ(table.find_overlap(prefix("192.168.7.0/24"), 2), 1U);
+  EXPECT_EQ(table.find_overlap(prefix("192.0.0.0/8"), 2), 1U);
+  EXPECT_EQ(table.find_overlap(prefix("192.168.0.0/16"), 2), 1U);
+  EXPECT_EQ(table.find_overlap(prefix("10.8.0.0/24"), 1), 2U);
+  EXPECT_EQ(table.find_overlap(prefix("fd00::/16"), 2), 1U);
+  // The excepted target's own routes and disjoint prefixes do not count.
+  EXPECT_EQ(table.find_overlap(prefix("192.168.7.0/24"), 1), std::nullopt);
+  EXPECT_EQ(table.find_overlap(prefix("192.169.0.0/16"), 2), std::nullopt);
+  EXPECT_EQ(table.find_overlap(prefix("10.8.0.6"), 1), std::nullopt);
+  EXPECT_EQ(table.find_overlap(prefix("fd00:2::/64"), 2), std::nullopt);
+}
+
+TEST(RouteTableTest, RoutesIpv6) {
+  RouteTable table;
+  table.insert(prefix("fd00::/8"), 1);
+  table.insert(prefix("fd00:1::/64"), 2);
+  table.insert(prefix("fd00:1::7"), 3);
+
+  EXPECT_EQ(lookup(table, "fd00:1::7"), 3U);
+  EXPECT_EQ(lookup(table, "fd00:1::8"), 2U);
+  EXPECT_EQ(lookup(table, "fd00:2::1"), 1U);
+  EXPECT_FALSE(lookup(table, "2001:db8::1").has_value());
+  EXPECT_FALSE(lookup(table, "10.0.0.1").has_value());
+}
+
+TEST(RouteTableTest, FreesMemoryWithRoutes) {
+  RouteTable table;
+  EXPECT_EQ(table.memory_footprint().reserved, 0U);
+  table.insert(prefix("fd00:1:2:3:4:5:6:7"), 1);
+  const auto loaded = table.memory_footprint().reserved;
+  EXPECT_GT(loaded, 0U);
+  table.insert(prefix("10.1.2.3"), 2);
+  EXPECT_TRUE(table.erase(prefix("fd00:1:2:3:4:5:6:7")));
+  EXPECT_TRUE(table.erase(prefix("10.1.2.3")));
+  EXPECT_EQ(table.memory_footprint().reserved, 0U);
+}
+
+TEST(RouteTableTest, MatchesLinearScanUnderChurn) {
+  std::mt19937 rng(7);
+  RouteTable table;
+  struct Route {
+    std::uint32_t address;
+    std::uint8_t length;
+    std::uint64_t target;
+  };
+  std::vector<Route> routes;
+
+  const auto to_prefix = [](std::uint32_t address, std::uint8_t length) {
+    return tun::to_ip_prefix(tun::Ipv4Prefix{address, length});
+  };
+  // Addresses in a small space so prefixes nest and collide.
+  const auto random_route = [&rng](std::uint64_t target) {
+    const auto length = static_cast<std::uint8_t>(8 + rng() % 25);
+    tun::Ipv4Prefix p{0x0A000000U | (static_cast<std::uint32_t>(rng()) & 0x00FF0F0FU), length};
+    return Route{p.address & p.mask(), length, target};
+  };
+
+  for (std::uint64_t step = 1; step <= 2000; ++step) {
+    if (routes.empty() || rng() % 3 != 0) {
+      const auto route = random_route(step);
+      table.insert(to_prefix(route.address, route.length), route.target);
+      std::erase_if(routes, [&route](const Route& r) {
+        return r.address == route.address && r.length == route.length;
+      });
+      routes.push_back(route);
+    } else {
+      const auto victim = rng() % routes.size();
+      ASSERT_TRUE(table.erase(to_prefix(routes[victim].address, routes[victim].length)));
+      routes.erase(routes.begin() + static_cast<std::ptrdiff_t>(victim));
+    }
+
+    for (int probe = 0; probe < 8; ++probe) {
+      const std::uint32_t address = 0x0A000000U | (static_cast<std::uint32_t>(rng()) & 0x00FF0F0FU);
+      std::optional<std::uint64_t> expected;
+      int best = -1;
+      for (const auto& r : routes) {
+        if (tun::Ipv4Prefix{r.address, r.length}.contains(address) && r.length > best) {
+          best = r.length;
+          expected = r.target;
+        }
+      }
+      const std::array<std::uint8_t, 4> bytes{
+          static_cast<std::uint8_t>(address >> 24), static_cast<std::uint8_t>(address >> 16),
+          static_cast<std::uint8_t>(address >> 8), static_cast<std::uint8_t>(address)};
+      ASSERT_EQ(table.lookup(bytes), expected) << "step " << step;
+    }
+  }
+  ASSERT_EQ(table.size(), routes.size());
+}
+
+}  // namespace veil::tests
@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "transport/sim/event_queue.h"
+#include "transport/sim/session_simulator.h"
+
+namespace veil::sim::test {
+
+using namespace std::chrono_literals;
+
+TEST(EventQueueTest, RunsEventsInTimeThenScheduleOrder) {
+  VirtualClock clock;
+  EventQueue events(clock);
+  const auto start = clock.now();
+  std::vector<int> order;
+
+  events.schedule_at(start + 20ms, [&] { order.push_back(3); });
+  events.schedule_at(start + 10ms, [&] { order.push_back(1); });
+  events.schedule_at(start + 10ms, [&] { order.push_back(2); });
+
+  EXPECT_EQ(events.run_until(start + 15ms), 2u);
+  EXPECT_EQ(clock.now(), start + 15ms);
+  EXPECT_EQ(events.run_until(start + 1s), 1u);
+  EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+  EXPECT_EQ(events.events_processed(), 3u);
+}
+
+TEST(EventQueueTest, ClockAdvancesToEventTime) {
+  VirtualClock clock;
+  EventQueue events(clock);
+  const auto start = clock.now();
+  const auto system_start = clock.system_now();
+  auto steady = clock.steady_fn();
+
+  VirtualClock::TimePoint seen;
+  events.schedule_after(250ms, [&] {
+    seen = steady();
+    // Events scheduled from a callback run after it, never in the past.
+    events.schedule_at(start, [] {});
+  });
+  ASSERT_TRUE(events.run_next());
+  EXPECT_EQ(seen, start + 250ms);
+  EXPECT_EQ(clock.system_now() - system_start, 250ms);
+  ASSERT_TRUE(events.next_event_time().has_value());
+  EXPECT_EQ(*events.next_event_time(), start + 250ms);
+}
+
+class SessionSimulatorTest : public ::testing::Test {
+ protected:
+  static SimulationConfig small_config() {
+    SimulationConfig config;
+    config.sessions = 20;
+    config.duration = 2s;
+    config.drain = 2s;
+    config.session_ramp = 200ms;
+    config.traffic.uplink_rate = 20.0;
+    config.traffic.downlink_rate = 50.0;
+    config.traffic.message_size = 500;
+    config.uplink.delay = 10ms;
+    config.downlink.delay = 10ms;
+    return config;
+  }
+};
+
+TEST_F(SessionSimulatorTest, CleanNetworkDeliversEverything) {
+  const auto result = run_simulation(small_config());
+
+  EXPECT_EQ(result.sessions_established, 20u);
+  EXPECT_EQ(result.handshake_attempts, 20u);
+  for (const auto* dir : {&result.uplink, &result.downlink}) {
+    EXPECT_GT(dir->messages_offered, 0u);
+    EXPECT_EQ(dir->messages_delivered, dir->messages_offered);
+    EXPECT_EQ(dir->bytes_delivered, dir->messages_delivered * 500u);
+    EXPECT_EQ(dir->wire_packets_lost, 0u);
+    EXPECT_GT(dir->acks_sent, 0u);
+    // One-way delay is 10 ms and nothing queues.
+    EXPECT_NEAR(dir->latency.p50_ms, 10.0, 0.001);
+    EXPECT_NEAR(dir->latency.max_ms, 10.0, 0.001);
+  }
+  EXPECT_EQ(result.virtual_time, 4s);
+}
+
+TEST_F(SessionSimulatorTest, SameSeedSameResult) {
+  auto config = small_config();
+  config.uplink.loss_rate = 0.05;
+  config.downlink.loss_rate = 0.05;
+  config.downlink.jitter = 5ms;
+  config.seed = 77;
+
+  const auto a = run_simulation(config);
+  const auto b = run_simulation(config);
+  EXPECT_EQ(a.events_processed, b.events_processed);
+  EXPECT_EQ(a.handshake_attempts, b.handshake_attempts);
+  EXPECT_EQ(a.downlink.messages_delivered, b.downlink.messages_delivered);
+  EXPECT_EQ(a.downlink.retransmits, b.downlink.retransmits);
+  EXPECT_EQ(a.downlink.wire_packets_lost, b.downlink.wire_packets_lost);
+  EXPECT_DOUBLE_EQ(a.downlink.latency.p99_ms, b.downlink.latency.p99_ms);
+  EXPECT_EQ(a.uplink.acks_sent, b.uplink.acks_sent);
+
+  config.seed = 78;
+  const auto c = run_simulation(config);
+  EXPECT_NE(a.downlink.wire_packets_lost, c.downlink.wire_packets_lost);
+}
+
+TEST_F(SessionSimulatorTest, LossTriggersRetransmitsAndHandshakeRetries) {
+  auto config = small_config();
+  config.uplink.loss_rate = 0.2;
+  config.downlink.loss_rate = 0.2;
+  config.handshake_timeout = 100ms;
+
+  const auto result = run_simulation(config);
+  EXPECT_EQ(result.sessions_established, 20u);
+  EXPECT_GT(result.handshake_attempts, 20u);
+  EXPECT_GT(result.downlink.wire_packets_lost, 0u);
+  EXPECT_GT(result.downlink.retransmits, 0u);
+  EXPECT_LT(result.downlink.messages_delivered, result.downlink.messages_offered);
+}
+
+TEST_F(SessionSimulatorTest, FecRecoversLossWithoutWaitingForRetransmits) {
+  auto plain = small_config();
+  plain.downlink.loss_rate = 0.05;
+  auto fec = plain;
+  fec.transport.fec.enabled = true;
+
+  const auto without = run_simulation(plain);
+  const auto with = run_simulation(fec);
+  EXPECT_GT(with.downlink.wire_packets_lost, 0u);
+  EXPECT_GT(with.downlink.messages_delivered, without.downlink.messages_delivered);
+  // Repairs go out when a block times out, well within one retransmit
+  // timeout.
+  EXPECT_LT(with.downlink.latency.p99_ms,
+            static_cast<double>(fec.transport.retransmit_config.initial_rtt.count()));
+}
+
+TEST_F(SessionSimulatorTest, DelayedAcksReduceAckCount) {
+  auto eager = small_config();
+  eager.ack.ack_every_n_packets = 1;
+  auto lazy = small_config();
+  lazy.ack.ack_every_n_packets = 8;
+  lazy.ack.max_pending_acks = 8;
+  lazy.ack.max_ack_delay = 200ms;
+
+  const auto eager_result = run_simulation(eager);
+  const auto lazy_result = run_simulation(lazy);
+  EXPECT_EQ(eager_result.downlink.acks_sent, eager_result.downlink.messages_delivered);
+  EXPECT_LT(lazy_result.downlink.acks_sent * 4, eager_result.downlink.acks_sent);
+}
+
+TEST_F(SessionSimulatorTest, AckFrequencyCutsAcksAtHighRate) {
+  auto fixed = small_config();
+  fixed.sessions = 4;
+  fixed.traffic.downlink_rate = 2000.0;
+  fixed.traffic.poisson = false;
+  auto adaptive = fixed;
+  adaptive.transport.ack_frequency.enabled = true;
+
+  const auto fixed_result = run_simulation(fixed);
+  const auto adaptive_result = run_simulation(adaptive);
+  EXPECT_EQ(adaptive_result.downlink.messages_delivered, adaptive_result.downlink.messages_offered);
+  EXPECT_EQ(adaptive_result.downlink.retransmits, 0u);
+  // About 40 packets per 20 ms RTT: a threshold of 8 instead of 2.
+  EXPECT_LT(adaptive_result.downlink.acks_sent * 3, fixed_result.downlink.acks_sent);
+}
+
+TEST_F(SessionSimulatorTest, SharedBottleneckLimitsGoodput) {
+  auto config = small_config();
+  config.traffic.downlink_rate = 500.0;  // 20 x 500 x 500 B = 40 Mbit/s offered.
+  config.traffic.poisson = false;
+  config.shared_downlink.bandwidth_bps = 10'000'000;
+  config.shared_downlink.queue_limit_bytes = 64 * 1024;
+
+  const auto result = run_simulation(config);
+  EXPECT_GT(result.downlink.wire_packets_lost, 0u);
+  EXPECT_LT(result.downlink.goodput_bps, 11e6);
+  EXPECT_GT(result.downlink.goodput_bps, 5e6);
+}
+
+TEST_F(SessionSimulatorTest, WindowLimitsQueueAtSender) {
+  auto config = small_config();
+  config.sessions = 1;
+  config.traffic.downlink_rate = 1000.0;
+  config.traffic.poisson = false;
+  config.sender.max_in_flight = 4;
+  config.sender.max_queued_messages = 100;
+
+  // 4 packets per 20 ms round trip is ~200 msg/s, far below the offered rate.
+  const auto result = run_simulation(config);
+  EXPECT_GT(result.downlink.messages_dropped_sender, 0u);
+  EXPECT_GT(result.downlink.latency.p50_ms, 50.0);
+}
+
+TEST_F(SessionSimulatorTest, PacingSpacesPackets) {
+  auto config = small_config();
+  config.sessions = 1;
+  config.traffic.downlink_rate = 200.0;
+  config.traffic.poisson = false;
+  config.sender.pacing_rate_bps = 400'000;  // ~550 B packets take ~11 ms each.
+
+  const auto result = run_simulation(config);
+  EXPECT_GT(result.downlink.latency.p50_ms, 100.0);
+  EXPECT_LT(result.downlink.goodput_bps, 400'000.0);
+}
+
+TEST_F(SessionSimulatorTest, GoodputTimelineCoversRun) {
+  auto config = small_config();
+  config.sample_interval = 500ms;
+
+  const auto result = run_simulation(config);
+  ASSERT_EQ(result.downlink.goodput_timeline_bps.size(), 8u);
+  double total_bits = 0.0;
+  for (const auto bps : result.downlink.goodput_timeline_bps) {
+    total_bits += bps * 0.5;
+  }
+  EXPECT_DOUBLE_EQ(total_bits, static_cast<double>(result.downlink.bytes_delivered) * 8.0);
+}
+
+}  // namespace veil::sim::test
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <optional>
+#include <span>
+#include <vector>
 
 #include "server/session_table.h"
 
@@ -15,7 +18,7 @@ class SessionTableTest : public ::testing::Test {
 
   TimePoint now() { return current_time_; }
 
-  void advance_time(std::chrono::seconds seconds) { current_time_ += seconds; }
+  void advance_time(Clock::duration duration) { current_time_ += duration; }
 
   TimePoint current_time_;
 };
@@ -68,6 +71,68 @@ TEST_F(SessionTableTest, FindByTunnelIp) {
   auto* session = table.find_by_tunnel_ip("10.8.0.10");
   ASSERT_NE(session, nullptr);
   EXPECT_EQ(session->tunnel_ip, "10.8.0.10");
+
+  // The packet path looks sessions up by address as read from the header.
+  EXPECT_EQ(table.find_by_tunnel_ip(std::uint32_t{0x0A08000A}), session);
+  EXPECT_EQ(session->tunnel_ip_v4, 0x0A08000AU);
+  EXPECT_EQ(table.find_by_tunnel_ip(std::uint32_t{0x0A080009}), nullptr);
+}
+
+TEST_F(SessionTableTest, RoutesSubnetsByLongestPrefix) {
+  SessionTable table(10, std::chrono::seconds(300), "10.8.0.2", "10.8.0.10",
+                     [this]() { return now(); });
+  const auto first = table.create_session(
+      transport::UdpEndpoint{"192.168.1.100", 12345},
+      std::make_unique<transport::TransportSession>(handshake::HandshakeSession{},
+                                                    transport::TransportSessionConfig{}));
+  const auto second = table.create_session(
+      transport::UdpEndpoint{"192.168.1.101", 12345},
+      std::make_unique<transport::TransportSession>(handshake::HandshakeSession{},
+                                                    transport::TransportSessionConfig{}));
+  ASSERT_TRUE(first.has_value() && second.has_value());
+
+  const std::vector<tun::IpPrefix> wide{*tun::parse_ip_prefix("192.168.0.0/16"),
+                                        *tun::parse_ip_prefix("fd00:1::/64"),
+                                        // Overlaps the IP pool.
+                                        *tun::parse_ip_prefix("10.8.0.0/24")};
+  EXPECT_EQ(table.set_routes(*first, wide), 2U);
+  const std::vector<tun::IpPrefix> narrow{// A slice of the first session's subnet.
+                                          *tun::parse_ip_prefix("192.168.7.0/24"),
+                                          // Already routed to the first session.
+                                          *tun::parse_ip_prefix("fd00:1::/64"),
+                                          // Around the first session's subnet.
+                                          *tun::parse_ip_prefix("192.0.0.0/8"),
+                                          *tun::parse_ip_prefix("fd00::/16"),
+                                          // Disjoint.
+                                          *tun::parse_ip_prefix("192.169.7.0/24")};
+  EXPECT_EQ(table.set_routes(*second, narrow), 1U);
+
+  const auto session_for = [&table](const char* address) -> std::optional<std::uint64_t> {
+    const auto prefix = tun::parse_ip_prefix(address);
+    auto* session =
+        table.find_by_destination(std::span(prefix->address).first(prefix->address_size()));
+    return session != nullptr ? std::optional(session->session_id) : std::nullopt;
+  };
+  EXPECT_EQ(session_for("192.168.3.4"), *first);
+  EXPECT_EQ(session_for("192.168.7.4"), *first);
+  EXPECT_EQ(session_for("192.169.7.4"), *second);
+  EXPECT_EQ(session_for("fd00:1::5"), *first);
+  EXPECT_EQ(session_for("10.8.0.10"), *first);
+  EXPECT_EQ(session_for("10.8.0.9"), *second);
+  EXPECT_EQ(session_for("172.16.0.1"), std::nullopt);
+  EXPECT_EQ(table.find_by_tunnel_ip(std::uint32_t{0xC0A80304}), nullptr);
+
+  // Replacing a session's routes withdraws those it no longer announces,
+  // and removing a session withdraws the rest.
+  EXPECT_EQ(table.set_routes(*first, std::span(wide).subspan(1, 1)), 1U);
+  EXPECT_EQ(session_for("192.168.3.4"), std::nullopt);
+  EXPECT_EQ(session_for("192.169.7.4"), *second);
+  // With the /16 withdrawn, the slice no longer overlaps anything.
+  EXPECT_EQ(table.set_routes(*second, std::span(narrow).first(1)), 1U);
+  EXPECT_EQ(session_for("192.168.7.4"), *second);
+  EXPECT_TRUE(table.remove_session(*second));
+  EXPECT_EQ(session_for("192.168.7.4"), std::nullopt);
+  EXPECT_EQ(session_for("fd00:1::5"), *first);
 }
 
 TEST_F(SessionTableTest, RemoveSession) {
@@ -263,4 +328,147 @@ TEST_F(SessionTableTest, Statistics) {
   EXPECT_EQ(table.stats().sessions_timed_out, 1u);
 }
 
+TEST_F(SessionTableTest, MemoryFootprintCoversSessions) {
+  SessionTable table(10, std::chrono::seconds(300), "10.8.0.2", "10.8.0.10",
+                     [this]() { return now(); });
+  const auto empty = table.memory_footprint();
+
+  transport::TransportSessionConfig config;
+  auto session_id = table.create_session(
+      transport::UdpEndpoint{"192.168.1.100", 12345},
+      std::make_unique<transport::TransportSession>(handshake::HandshakeSession{}, config));
+  ASSERT_TRUE(session_id.has_value());
+
+  const auto one = table.memory_footprint();
+  EXPECT_GE(one.reserved - empty.reserved,
+            sizeof(ClientSession) + sizeof(transport::TransportSession));
+  EXPECT_GE(one.limit, config.reorder_buffer_size + config.fragment_buffer_size +
+                           config.retransmit_config.max_buffer_bytes);
+}
+
+TEST_F(SessionTableTest, UpdateMemoryUsageFeedsLifecycles) {
+  SessionTable table(10, std::chrono::seconds(300), "10.8.0.2", "10.8.0.10",
+                     [this]() { return now(); });
+  auto tracked = table.create_session(
+      transport::UdpEndpoint{"192.168.1.100", 12345},
+      std::make_unique<transport::TransportSession>(handshake::HandshakeSession{},
+                                                    transport::TransportSessionConfig{}));
+  auto untracked = table.create_session(
+      transport::UdpEndpoint{"192.168.1.101", 12345},
+      std::make_unique<transport::TransportSession>(handshake::HandshakeSession{},
+                                                    transport::TransportSessionConfig{}));
+  ASSERT_TRUE(tracked.has_value());
+  ASSERT_TRUE(untracked.has_value());
+
+  session::SessionLifecycleConfig lifecycle_config;
+  lifecycle_config.max_memory_per_session = 1;
+  session::SessionLifecycleManager lifecycles(lifecycle_config, [this]() { return now(); });
+  std::size_t exceeded = 0;
+  session::SessionLifecycleCallbacks callbacks;
+  callbacks.on_memory_exceeded = [&](std::uint64_t, std::size_t, std::size_t) { ++exceeded; };
+  lifecycles.set_default_callbacks(callbacks);
+  auto& lifecycle = lifecycles.create_session(*tracked);
+
+  EXPECT_EQ(table.update_memory_usage(lifecycles), 1U);
+  EXPECT_GE(lifecycle.stats().current_memory, sizeof(ClientSession));
+  EXPECT_EQ(exceeded, 1U);
+}
+
+TEST_F(SessionTableTest, HibernateIdleReleasesTransportUntilWoken) {
+  SessionTable table(10, std::chrono::seconds(300), "10.8.0.2", "10.8.0.10",
+                     [this]() { return now(); });
+  auto idle_id = table.create_session(
+      transport::UdpEndpoint{"192.168.1.100", 12345},
+      std::make_unique<transport::TransportSession>(handshake::HandshakeSession{},
+                                                    transport::TransportSessionConfig{}));
+  auto busy_id = table.create_session(
+      transport::UdpEndpoint{"192.168.1.101", 12345},
+      std::make_unique<transport::TransportSession>(handshake::HandshakeSession{},
+                                                    transport::TransportSessionConfig{}));
+  ASSERT_TRUE(idle_id.has_value());
+  ASSERT_TRUE(busy_id.has_value());
+
+  // Unacknowledged data keeps a session awake.
+  auto* busy = table.find_by_id(*busy_id);
+  std::vector<std::uint8_t> data{0x01, 0x02};
+  ASSERT_FALSE(busy->transport->encrypt_data(data).empty());
+
+  EXPECT_EQ(table.hibernate_idle(std::chrono::seconds(60)), 0U);
+  advance_time(std::chrono::seconds(60));
+  const auto before = table.memory_footprint();
+  EXPECT_EQ(table.hibernate_idle(std::chrono::seconds(60)), 1U);
+  EXPECT_EQ(table.stats().hibernated_sessions, 1U);
+  EXPECT_LT(table.memory_footprint().reserved, before.reserved);
+
+  auto* idle = table.find_by_id(*idle_id);
+  ASSERT_NE(idle, nullptr);
+  EXPECT_EQ(idle->transport, nullptr);
+  ASSERT_NE(idle->hibernated, nullptr);
+  ASSERT_NE(busy->transport, nullptr);
+
+  EXPECT_TRUE(table.wake(*idle, transport::TransportSessionConfig{}));
+  EXPECT_NE(idle->transport, nullptr);
+  EXPECT_EQ(idle->hibernated, nullptr);
+  EXPECT_FALSE(table.wake(*idle, transport::TransportSessionConfig{}));
+  EXPECT_EQ(table.stats().hibernated_sessions, 0U);
+  EXPECT_EQ(table.stats().sessions_hibernated, 1U);
+}
+
+TEST_F(SessionTableTest, RefreshLetsIdleBufferLimitsDecay) {
+  SessionTable table(10, std::chrono::seconds(300), "10.8.0.2", "10.8.0.10",
+                     [this]() { return now(); });
+  transport::TransportSessionConfig config;
+  config.adaptive_buffers = true;
+  auto id = table.create_session(transport::UdpEndpoint{"192.168.1.100", 12345},
+                                 std::make_unique<transport::TransportSession>(
+                                     handshake::HandshakeSession{}, config,
+                                     [this]() { return now(); }));
+  ASSERT_TRUE(id.has_value());
+  auto* session = table.find_by_id(*id);
+
+  // 1 MB in 100 ms raises the limit well above the floor.
+  std::vector<std::uint8_t> data(1000, 0x42);
+  for (int i = 0; i < 1000; ++i) {
+    static_cast<void>(session->transport->encrypt_data(data, 0, false));
+  }
+  advance_time(std::chrono::milliseconds(100));
+  static_cast<void>(session->transport->encrypt_data(data, 0, false));
+  ASSERT_GT(session->transport->buffer_limit(), config.buffer_sizing.min_bytes);
+
+  // No traffic and no hibernation: the cleanup tick alone brings it down.
+  for (int i = 0; i < 30; ++i) {
+    advance_time(std::chrono::seconds(1));
+    table.refresh_buffer_limits();
+  }
+  EXPECT_EQ(session->transport->buffer_limit(), config.buffer_sizing.min_bytes);
+}
+
+TEST_F(SessionTableTest, CleanupTracksActivityAfterRemovals) {
+  SessionTable table(10, std::chrono::seconds(300), "10.8.0.2", "10.8.0.10",
+                     [this]() { return now(); });
+  std::vector<std::uint64_t> ids;
+  for (std::uint16_t port = 1000; port < 1004; ++port) {
+    auto id = table.create_session(
+        transport::UdpEndpoint{"192.168.1.100", port},
+        std::make_unique<transport::TransportSession>(handshake::HandshakeSession{},
+                                                      transport::TransportSessionConfig{}));
+    ASSERT_TRUE(id.has_value());
+    ids.push_back(*id);
+  }
+
+  // Removing from the middle moves the last session's activity slot.
+  ASSERT_TRUE(table.remove_session(ids[1]));
+  EXPECT_EQ(table.get_all_sessions().size(), 3u);
+
+  advance_time(std::chrono::seconds(200));
+  table.update_activity(ids[3]);
+  advance_time(std::chrono::seconds(200));
+
+  EXPECT_EQ(table.cleanup_expired(), 2u);
+  EXPECT_EQ(table.find_by_id(ids[0]), nullptr);
+  EXPECT_EQ(table.find_by_id(ids[2]), nullptr);
+  ASSERT_NE(table.find_by_id(ids[3]), nullptr);
+  EXPECT_EQ(table.get_all_sessions().size(), 1u);
+}
+
 }  // namespace veil::server::test
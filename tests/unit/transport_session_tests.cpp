@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <cstdint>
+#include <thread>
 #include <vector>
 
 #include "common/handshake/handshake_processor.h"
@@ -567,4 +568,355 @@ TEST_F(TransportSessionTest, DifferentSessionsProduceDifferentObfuscation) {
       << "Different sessions should produce different obfuscated sequences";
 }
 
+TEST_F(TransportSessionTest, EncryptedAckClearsSenderInFlight) {
+  auto now_fn = [this]() { return steady_now_; };
+
+  transport::TransportSession client(client_handshake_, {}, now_fn);
+  transport::TransportSession server(server_handshake_, {}, now_fn);
+
+  std::vector<std::uint8_t> data{0x01, 0x02, 0x03};
+  for (int i = 0; i < 3; ++i) {
+    for (const auto& pkt : client.encrypt_data(data, 0, false)) {
+      ASSERT_TRUE(server.decrypt_packet(pkt).has_value());
+    }
+  }
+  EXPECT_EQ(client.packets_in_flight(), 3U);
+
+  const auto ack_packet = server.encrypt_ack(0);
+  auto frames = client.decrypt_packet(ack_packet);
+  ASSERT_TRUE(frames.has_value());
+  ASSERT_EQ(frames->size(), 1U);
+  ASSERT_EQ((*frames)[0].kind, mux::FrameKind::kAck);
+  EXPECT_EQ((*frames)[0].ack.ack, 2U);
+
+  client.process_ack((*frames)[0].ack);
+  EXPECT_EQ(client.packets_in_flight(), 0U);
+
+  // ACK packets are not retransmitted.
+  EXPECT_EQ(server.packets_in_flight(), 0U);
+}
+
+TEST_F(TransportSessionTest, MemoryFootprintFollowsBufferedData) {
+  auto now_fn = [this]() { return steady_now_; };
+
+  transport::TransportSessionConfig config;
+  transport::TransportSession client(client_handshake_, config, now_fn);
+
+  const auto idle = client.memory_footprint();
+  EXPECT_EQ(idle.in_use, idle.limit - config.reorder_buffer_size -
+                             config.fragment_buffer_size -
+                             config.retransmit_config.max_buffer_bytes);
+  EXPECT_GE(idle.limit, config.reorder_buffer_size + config.fragment_buffer_size +
+                            config.retransmit_config.max_buffer_bytes);
+
+  // Sent data stays in the retransmit buffer until acknowledged.
+  std::vector<std::uint8_t> plaintext(500, 0x42);
+  ASSERT_EQ(client.encrypt_data(plaintext, 0, false).size(), 1U);
+  const auto busy = client.memory_footprint();
+  EXPECT_GT(busy.in_use, idle.in_use);
+  EXPECT_GT(busy.reserved, idle.reserved);
+}
+
+TEST_F(TransportSessionTest, HibernatedSessionResumesWithReplayState) {
+  auto now_fn = [this]() { return steady_now_; };
+
+  transport::TransportSession client(client_handshake_, {}, now_fn);
+  auto server = std::make_unique<transport::TransportSession>(server_handshake_,
+                                                              transport::TransportSessionConfig{}, now_fn);
+
+  std::vector<std::uint8_t> data{0x01, 0x02, 0x03};
+  const auto first = client.encrypt_data(data, 0, false);
+  ASSERT_EQ(first.size(), 1U);
+  ASSERT_TRUE(server->decrypt_packet(first[0]).has_value());
+
+  // Unacknowledged data blocks hibernation.
+  ASSERT_EQ(server->encrypt_data(data, 0, false).size(), 1U);
+  EXPECT_FALSE(server->can_hibernate());
+  mux::AckFrame ack{.stream_id = 0, .ack = 0, .bitmap = 0};
+  server->process_ack(ack);
+  ASSERT_TRUE(server->can_hibernate());
+
+  const auto send_sequence = server->send_sequence();
+  auto hibernated = server->hibernate();
+  server.reset();
+  EXPECT_LT(hibernated.memory_footprint().reserved + sizeof(transport::HibernatedSession),
+            sizeof(transport::TransportSession));
+
+  transport::TransportSession woken(std::move(hibernated), {}, now_fn);
+  EXPECT_EQ(woken.send_sequence(), send_sequence);
+  EXPECT_EQ(woken.stats().packets_received, 1U);
+
+  // The replay window survives, and new traffic flows both ways.
+  EXPECT_FALSE(woken.decrypt_packet(first[0]).has_value());
+  const auto second = client.encrypt_data(data, 0, false);
+  ASSERT_TRUE(woken.decrypt_packet(second[0]).has_value());
+  for (const auto& pkt : woken.encrypt_data(data, 0, false)) {
+    EXPECT_TRUE(client.decrypt_packet(pkt).has_value());
+  }
+}
+
+TEST_F(TransportSessionTest, AdaptiveBuffersStartAtFloorAndGrow) {
+  auto now_fn = [this]() { return steady_now_; };
+
+  transport::TransportSessionConfig config;
+  config.adaptive_buffers = true;
+  transport::TransportSession client(client_handshake_, config, now_fn);
+  EXPECT_EQ(client.buffer_limit(), config.buffer_sizing.min_bytes);
+
+  // 1 MB in 100 ms at the default 100 ms RTT estimate: BDP x 2 = 2 MB, so
+  // the limit rises to the configured ceiling.
+  std::vector<std::uint8_t> data(1000, 0x42);
+  for (int i = 0; i < 1000; ++i) {
+    static_cast<void>(client.encrypt_data(data, 0, false));
+  }
+  steady_now_ += 100ms;
+  static_cast<void>(client.encrypt_data(data, 0, false));
+  EXPECT_EQ(client.buffer_limit(), std::min(config.buffer_sizing.max_bytes,
+                                            config.retransmit_config.max_buffer_bytes));
+}
+
+TEST_F(TransportSessionTest, CountsOuterEcnCodepoints) {
+  auto now_fn = [this]() { return steady_now_; };
+  transport::TransportSession server(server_handshake_, {}, now_fn);
+
+  server.record_outer_ecn(0x00);
+  server.record_outer_ecn(0x01);
+  server.record_outer_ecn(0x02);
+  server.record_outer_ecn(0x03);
+  server.record_outer_ecn(0x03);
+
+  EXPECT_EQ(server.stats().ecn_ect_received, 2U);
+  EXPECT_EQ(server.stats().ecn_ce_received, 2U);
+}
+
+TEST_F(TransportSessionTest, OrderedDeliveryHoldsOnlyTheStreamWithAGap) {
+  auto now_fn = [this]() { return steady_now_; };
+  transport::TransportSessionConfig config;
+  config.ordered_delivery = true;
+  transport::TransportSession client(client_handshake_, config, now_fn);
+  transport::TransportSession server(server_handshake_, config, now_fn);
+
+  const std::vector<std::uint8_t> a1{0xA1};
+  const std::vector<std::uint8_t> a2{0xA2};
+  const std::vector<std::uint8_t> b1{0xB1};
+  const auto pkt_a1 = client.encrypt_data(a1, 1, false);
+  const auto pkt_a2 = client.encrypt_data(a2, 1, false);
+  const auto pkt_b1 = client.encrypt_data(b1, 2, false);
+
+  // A2 arrives ahead of A1 and is held; B1 on another stream is not.
+  auto frames = server.decrypt_packet(pkt_a2[0]);
+  ASSERT_TRUE(frames.has_value());
+  EXPECT_TRUE(frames->empty());
+  frames = server.decrypt_packet(pkt_b1[0]);
+  ASSERT_TRUE(frames.has_value());
+  ASSERT_EQ(frames->size(), 1U);
+  EXPECT_EQ((*frames)[0].data.payload, b1);
+
+  // A1 fills the gap and releases A2 behind it.
+  frames = server.decrypt_packet(pkt_a1[0]);
+  ASSERT_TRUE(frames.has_value());
+  ASSERT_EQ(frames->size(), 2U);
+  EXPECT_EQ((*frames)[0].data.payload, a1);
+  EXPECT_EQ((*frames)[1].data.payload, a2);
+  EXPECT_EQ((*frames)[1].data.stream_id, 1U);
+}
+
+TEST_F(TransportSessionTest, StalledStreamReleasedAfterReorderTimeout) {
+  auto now_fn = [this]() { return steady_now_; };
+  transport::TransportSessionConfig config;
+  config.ordered_delivery = true;
+  config.reorder_timeout = 50ms;
+  transport::TransportSession client(client_handshake_, config, now_fn);
+  transport::TransportSession server(server_handshake_, config, now_fn);
+
+  const std::vector<std::uint8_t> data{0x01};
+  static_cast<void>(client.encrypt_data(data, 1, false));  // Lost.
+  const auto second = client.encrypt_data(data, 1, false);
+  ASSERT_TRUE(server.decrypt_packet(second[0]).has_value());
+
+  steady_now_ += 40ms;
+  EXPECT_TRUE(server.release_stalled_frames().empty());
+  steady_now_ += 20ms;
+  const auto released = server.release_stalled_frames();
+  ASSERT_EQ(released.size(), 1U);
+  EXPECT_EQ(released[0].data.sequence, 1U);
+  EXPECT_EQ(server.stats().reorder_gaps_skipped, 1U);
+
+  // The late frame is still delivered, out of order.
+  const auto third = client.encrypt_data(data, 1, false);
+  const auto frames = server.decrypt_packet(third[0]);
+  ASSERT_TRUE(frames.has_value());
+  EXPECT_EQ(frames->size(), 1U);
+}
+
+TEST_F(TransportSessionTest, FragmentedMessagesBypassOrdering) {
+  auto now_fn = [this]() { return steady_now_; };
+  transport::TransportSessionConfig config;
+  config.ordered_delivery = true;
+  config.max_fragment_size = 100;
+  transport::TransportSession client(client_handshake_, config, now_fn);
+  transport::TransportSession server(server_handshake_, config, now_fn);
+
+  std::vector<std::uint8_t> data(250, 0x42);
+  const auto packets = client.encrypt_data(data, 1, false);
+  ASSERT_GT(packets.size(), 1U);
+  for (auto it = packets.rbegin(); it != packets.rend(); ++it) {
+    const auto frames = server.decrypt_packet(*it);
+    ASSERT_TRUE(frames.has_value());
+    ASSERT_EQ(frames->size(), 1U);
+    EXPECT_TRUE((*frames)[0].data.fragment);
+  }
+}
+
+TEST_F(TransportSessionTest, HibernationKeepsStreamSequences) {
+  auto now_fn = [this]() { return steady_now_; };
+  transport::TransportSessionConfig config;
+  config.ordered_delivery = true;
+  transport::TransportSession client(client_handshake_, config, now_fn);
+  auto server = std::make_unique<transport::TransportSession>(server_handshake_, config, now_fn);
+
+  const std::vector<std::uint8_t> data{0x01};
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(server->decrypt_packet(client.encrypt_data(data, 1, false)[0])->size(), 1U);
+  }
+  ASSERT_TRUE(server->can_hibernate());
+  transport::TransportSession woken(server->hibernate(), config, now_fn);
+  server.reset();
+
+  // Stream 1 continues at sequence 3 rather than waiting for 0.
+  const auto frames = woken.decrypt_packet(client.encrypt_data(data, 1, false)[0]);
+  ASSERT_TRUE(frames.has_value());
+  ASSERT_EQ(frames->size(), 1U);
+  EXPECT_EQ((*frames)[0].data.sequence, 3U);
+  EXPECT_EQ(woken.stats().reorder_gaps_skipped, 0U);
+}
+
+TEST_F(TransportSessionTest, FecRecoversLostPacketWithoutRetransmit) {
+  auto now_fn = [this]() { return steady_now_; };
+  transport::TransportSessionConfig config;
+  config.fec.enabled = true;
+  config.fec.block_size = 4;
+  transport::TransportSession client(client_handshake_, config, now_fn);
+  transport::TransportSession server(server_handshake_, {}, now_fn);
+
+  std::vector<std::vector<std::uint8_t>> delivered;
+  // The first block starts the server's decoder; the second loses a packet.
+  for (std::uint8_t i = 0; i < 8; ++i) {
+    const std::vector<std::uint8_t> payload(100 + i, i);
+    const auto packets = client.encrypt_data(payload, 0, false);
+    // Every fourth message fills a block: its data, then one repair.
+    ASSERT_EQ(packets.size(), i % 4 == 3 ? 2U : 1U);
+    for (std::size_t p = 0; p < packets.size(); ++p) {
+      if (i == 5 && p == 0) {
+        continue;
+      }
+      auto frames = server.decrypt_packet(packets[p]);
+      ASSERT_TRUE(frames.has_value());
+      for (const auto& frame : *frames) {
+        ASSERT_EQ(frame.kind, mux::FrameKind::kData);
+        delivered.push_back(frame.data.payload);
+      }
+    }
+  }
+
+  ASSERT_EQ(delivered.size(), 8U);
+  EXPECT_EQ(delivered.back(), std::vector<std::uint8_t>(105, 5));
+  EXPECT_EQ(client.stats().fec_repairs_sent, 2U);
+  EXPECT_EQ(server.stats().fec_repairs_received, 2U);
+  EXPECT_EQ(server.stats().fec_recovered, 1U);
+  // The rebuilt packet (sequence 6) is acknowledged like a received one.
+  const auto ack = server.generate_ack(0);
+  EXPECT_EQ(ack.ack, 8U);
+  EXPECT_NE(ack.bitmap & 0x2U, 0U);
+}
+
+TEST_F(TransportSessionTest, PaddedDataAndHeartbeatsLookAlike) {
+  auto now_fn = [this]() { return steady_now_; };
+  transport::TransportSession client(client_handshake_, {}, now_fn);
+  transport::TransportSession server(server_handshake_, {}, now_fn);
+
+  const std::vector<std::uint8_t> payload(30, 0x5a);
+  const auto data = client.encrypt_data(payload, 0, false, 120);
+  ASSERT_EQ(data.size(), 1U);
+  const std::vector<std::uint8_t> telemetry{1, 2, 3, 4};
+  const auto heartbeat = client.encrypt_heartbeat(telemetry, 9, 120);
+  EXPECT_EQ(data[0].size(), heartbeat.size());
+  EXPECT_EQ(client.stats().heartbeats_sent, 1U);
+  EXPECT_EQ(client.stats().padding_bytes_sent,
+            (120 - mux::MuxCodec::kDataHeaderSize - payload.size()) +
+                (120 - mux::MuxCodec::kHeartbeatHeaderSize - telemetry.size()));
+
+  auto frames = server.decrypt_packet(data[0]);
+  ASSERT_TRUE(frames.has_value());
+  ASSERT_EQ(frames->size(), 1U);
+  EXPECT_EQ((*frames)[0].data.payload, payload);
+
+  frames = server.decrypt_packet(heartbeat);
+  ASSERT_TRUE(frames.has_value());
+  ASSERT_EQ(frames->size(), 1U);
+  EXPECT_EQ((*frames)[0].kind, mux::FrameKind::kHeartbeat);
+  EXPECT_EQ((*frames)[0].heartbeat.sequence, 9U);
+  EXPECT_EQ((*frames)[0].heartbeat.payload, telemetry);
+
+  // A pad size smaller than the frame adds nothing.
+  const auto unpadded = client.encrypt_data(payload, 0, false, 10);
+  EXPECT_EQ(unpadded[0].size(), client.encrypt_data(payload, 0, false)[0].size());
+}
+
+TEST_F(TransportSessionTest, AeadJobsRunOnOtherThreadsAndFinishInOrder) {
+  auto now_fn = [this]() { return steady_now_; };
+  transport::TransportSession client(client_handshake_, {}, now_fn);
+  transport::TransportSession server(server_handshake_, {}, now_fn);
+
+  std::vector<transport::AeadJob> seals;
+  for (std::uint8_t i = 0; i < 8; ++i) {
+    auto jobs = client.prepare_data(std::vector<std::uint8_t>(100, i), 0, false);
+    ASSERT_EQ(jobs.size(), 1U);
+    seals.push_back(std::move(jobs[0]));
+  }
+  // Sealed in reverse on another thread, finished in order.
+  std::thread([&seals] {
+    for (auto it = seals.rbegin(); it != seals.rend(); ++it) {
+      it->run();
+    }
+  }).join();
+  std::vector<std::vector<std::uint8_t>> packets;
+  for (auto& job : seals) {
+    EXPECT_TRUE(job.ok);
+    packets.push_back(client.finish_seal(std::move(job)));
+  }
+  EXPECT_EQ(client.packets_in_flight(), packets.size());
+
+  // The receive side: replay checks when prepared, so a duplicate never
+  // reaches a worker.
+  std::vector<transport::AeadJob> opens;
+  for (const auto& packet : packets) {
+    auto job = server.prepare_open(packet);
+    ASSERT_TRUE(job.has_value());
+    opens.push_back(std::move(*job));
+  }
+  EXPECT_FALSE(server.prepare_open(packets[3]).has_value());
+  EXPECT_EQ(server.stats().packets_dropped_replay, 1U);
+
+  opens[5].packet.back() ^= 0x01;
+  std::thread([&opens] {
+    for (auto& job : opens) {
+      job.run();
+    }
+  }).join();
+  for (std::size_t i = 0; i < opens.size(); ++i) {
+    auto frames = server.finish_open(std::move(opens[i]));
+    if (i == 5) {
+      EXPECT_FALSE(frames.has_value());
+      continue;
+    }
+    ASSERT_TRUE(frames.has_value());
+    ASSERT_EQ(frames->size(), 1U);
+    EXPECT_EQ((*frames)[0].data.payload,
+              std::vector<std::uint8_t>(100, static_cast<std::uint8_t>(i)));
+  }
+  EXPECT_EQ(server.stats().packets_received, 7U);
+  EXPECT_EQ(server.stats().packets_dropped_decrypt, 1U);
+}
+
 }  // namespace veil::tests
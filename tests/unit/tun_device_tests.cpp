@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
+#include <array>
+#include <cstdint>
 #include <system_error>
+#include <vector>
 
 #include "tun/tun_device.h"
 
@@ -156,4 +161,59 @@ TEST_F(TunDeviceUnitTest, OpenWithoutRoot) {
   }
 }
 
+TEST_F(TunDeviceUnitTest, VirtualDeviceRoundTrip) {
+  TunConfig config;
+  config.device_name = "vtest0";
+  config.virtual_device = true;
+
+  TunDevice device;
+  std::error_code ec;
+  ASSERT_TRUE(device.open(config, ec)) << ec.message();
+  EXPECT_TRUE(device.is_virtual());
+  EXPECT_GE(device.peer_fd(), 0);
+  EXPECT_EQ(device.device_name(), "vtest0");
+
+  // Device -> peer preserves packet boundaries.
+  const std::vector<std::uint8_t> first{0x45, 0x00, 0x01};
+  const std::vector<std::uint8_t> second{0x45, 0x00, 0x02, 0x03};
+  ASSERT_TRUE(device.write(first, ec));
+  ASSERT_TRUE(device.write(second, ec));
+  std::array<std::uint8_t, 64> buf{};
+  EXPECT_EQ(::read(device.peer_fd(), buf.data(), buf.size()), 3);
+  EXPECT_EQ(::read(device.peer_fd(), buf.data(), buf.size()), 4);
+
+  // Peer -> device.
+  ASSERT_EQ(::write(device.peer_fd(), second.data(), second.size()), 4);
+  EXPECT_EQ(device.read_into(buf, ec), 4);
+  EXPECT_EQ(buf[3], 0x03);
+  EXPECT_EQ(device.read_into(buf, ec), 0);  // Nothing pending.
+
+  // Link configuration is a no-op.
+  EXPECT_TRUE(device.set_mtu(1280, ec));
+  EXPECT_TRUE(device.set_up(false, ec));
+
+  EXPECT_EQ(device.stats().packets_written, 2u);
+  EXPECT_EQ(device.stats().packets_read, 1u);
+
+  device.close();
+  EXPECT_FALSE(device.is_open());
+  EXPECT_FALSE(device.is_virtual());
+}
+
+TEST_F(TunDeviceUnitTest, VirtualDeviceMove) {
+  TunConfig config;
+  config.virtual_device = true;
+
+  TunDevice device1;
+  std::error_code ec;
+  ASSERT_TRUE(device1.open(config, ec));
+  const int peer = device1.peer_fd();
+
+  TunDevice device2(std::move(device1));
+  EXPECT_EQ(device2.peer_fd(), peer);
+  // NOLINTNEXTLINE(bugprone-use-after-move)
+  EXPECT_EQ(device1.peer_fd(), -1);
+  EXPECT_EQ(device2.device_name(), "vtun");
+}
+
 }  // namespace veil::tun::test
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <system_error>
 #include <thread>
+#include <vector>
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -27,6 +28,7 @@ TEST(UdpSocketTests, SendAndReceiveLoopback) {
   socklen_t len = sizeof(addr);
   ASSERT_EQ(::getsockname(server.fd(), reinterpret_cast<sockaddr*>(&addr), &len), 0);
   const auto port = ntohs(addr.sin_port);
+  EXPECT_EQ(server.local_port(), port);
 
   transport::UdpSocket client;
   if (!client.open(0, false, ec)) {
@@ -50,4 +52,127 @@ TEST(UdpSocketTests, SendAndReceiveLoopback) {
   EXPECT_TRUE(received);
 }
 
+TEST(UdpSocketTests, CarriesOuterEcnCodepoints) {
+  transport::UdpSocket server;
+  std::error_code ec;
+  if (!server.open(0, false, ec)) {
+    if (ec == std::errc::operation_not_permitted) {
+      GTEST_SKIP() << "UDP sockets not permitted in this environment";
+    }
+    FAIL() << ec.message();
+  }
+  ASSERT_TRUE(server.enable_ecn(ec)) << ec.message();
+  EXPECT_TRUE(server.ecn_enabled());
+
+  transport::UdpSocket client;
+  ASSERT_TRUE(client.open(0, false, ec)) << ec.message();
+  EXPECT_FALSE(client.ecn_enabled());
+
+  transport::UdpEndpoint server_ep{"127.0.0.1", server.local_port()};
+  const std::vector<std::uint8_t> payload{1, 2, 3};
+  ASSERT_TRUE(client.send(payload, server_ep, ec)) << ec.message();
+  ASSERT_TRUE(client.send(payload, server_ep, 0x02, ec)) << ec.message();
+  const std::vector<transport::UdpPacket> batch{
+      transport::UdpPacket{payload, server_ep, 0x01},
+      transport::UdpPacket{payload, server_ep, 0x03},
+  };
+  ASSERT_TRUE(client.send_batch(batch, ec)) << ec.message();
+
+  std::vector<std::uint8_t> codepoints;
+  for (int i = 0; i < 10 && codepoints.size() < 4; ++i) {
+    server.poll(
+        [&](const transport::UdpPacket& pkt) {
+          EXPECT_EQ(pkt.data, payload);
+          codepoints.push_back(pkt.ecn);
+        },
+        100, ec);
+  }
+  EXPECT_EQ(codepoints, (std::vector<std::uint8_t>{0x00, 0x02, 0x01, 0x03}));
+}
+
+TEST(UdpSocketTests, SendsWithDepartureTimes) {
+  transport::UdpSocket server;
+  std::error_code ec;
+  if (!server.open(0, false, ec)) {
+    if (ec == std::errc::operation_not_permitted) {
+      GTEST_SKIP() << "UDP sockets not permitted in this environment";
+    }
+    FAIL() << ec.message();
+  }
+  transport::UdpSocket client;
+  ASSERT_TRUE(client.open(0, false, ec)) << ec.message();
+  if (!client.enable_txtime(ec)) {
+    GTEST_SKIP() << "SO_TXTIME not supported: " << ec.message();
+  }
+  EXPECT_TRUE(client.txtime_enabled());
+
+  // Loopback has no fq qdisc, so the times are accepted but not enforced.
+  transport::UdpEndpoint server_ep{"127.0.0.1", server.local_port()};
+  const auto now = std::chrono::steady_clock::now();
+  ASSERT_TRUE(client.send(transport::UdpPacket{{1}, server_ep, 0x02, now}, ec)) << ec.message();
+  const std::vector<transport::UdpPacket> batch{
+      transport::UdpPacket{{2}, server_ep, 0, now + std::chrono::microseconds(100)},
+      transport::UdpPacket{{3}, server_ep, 0x01, now + std::chrono::microseconds(200)},
+  };
+  ASSERT_TRUE(client.send_batch(batch, ec)) << ec.message();
+
+  std::vector<std::uint8_t> received;
+  for (int i = 0; i < 10 && received.size() < 3; ++i) {
+    server.poll([&](const transport::UdpPacket& pkt) { received.push_back(pkt.data[0]); }, 100,
+                ec);
+  }
+  EXPECT_EQ(received, (std::vector<std::uint8_t>{1, 2, 3}));
+}
+
+TEST(UdpSocketTests, CoalescesBatchesWithGso) {
+  transport::UdpSocket server;
+  std::error_code ec;
+  if (!server.open(0, false, ec)) {
+    if (ec == std::errc::operation_not_permitted) {
+      GTEST_SKIP() << "UDP sockets not permitted in this environment";
+    }
+    FAIL() << ec.message();
+  }
+  transport::UdpSocket other;
+  ASSERT_TRUE(other.open(0, false, ec)) << ec.message();
+  transport::UdpSocket client;
+  ASSERT_TRUE(client.open(0, false, ec)) << ec.message();
+  if (!client.enable_gso(ec)) {
+    GTEST_SKIP() << "UDP GSO not supported: " << ec.message();
+  }
+  EXPECT_TRUE(client.gso_enabled());
+
+  // Runs to one peer are segmented back into the original datagrams: a
+  // shorter datagram ends a run, and another peer or ECN codepoint starts
+  // a new one.
+  const transport::UdpEndpoint server_ep{"127.0.0.1", server.local_port()};
+  const transport::UdpEndpoint other_ep{"127.0.0.1", other.local_port()};
+  std::vector<transport::UdpPacket> batch;
+  for (std::uint8_t i = 0; i < 5; ++i) {
+    batch.push_back(transport::UdpPacket{std::vector<std::uint8_t>(100, i), server_ep});
+  }
+  batch.push_back(transport::UdpPacket{std::vector<std::uint8_t>(40, 5), server_ep});
+  batch.push_back(transport::UdpPacket{std::vector<std::uint8_t>(100, 6), server_ep});
+  batch.push_back(transport::UdpPacket{std::vector<std::uint8_t>(100, 7), other_ep});
+  batch.push_back(transport::UdpPacket{std::vector<std::uint8_t>(100, 8), server_ep, 0x02});
+  ASSERT_TRUE(client.send_batch(batch, ec)) << ec.message();
+
+  std::vector<std::vector<std::uint8_t>> received;
+  for (int i = 0; i < 20 && received.size() < 8; ++i) {
+    server.poll([&](const transport::UdpPacket& pkt) { received.push_back(pkt.data); }, 100, ec);
+  }
+  std::vector<std::vector<std::uint8_t>> expected;
+  for (const auto& packet : batch) {
+    if (packet.remote == server_ep) {
+      expected.push_back(packet.data);
+    }
+  }
+  EXPECT_EQ(received, expected);
+
+  bool other_received = false;
+  other.poll([&](const transport::UdpPacket& pkt) { other_received = pkt.data == batch[7].data; },
+             100, ec);
+  EXPECT_TRUE(other_received);
+}
+
 }  // namespace veil::tests